@@ -0,0 +1,20 @@
+#version 430
+
+#include "../fragments/fs_common_inputs.glsl"
+
+// We output a single color to the color buffer
+layout(location = 0) out vec4 frag_color;
+
+#include "../fragments/frame_uniforms.glsl"
+
+// Used by materials while their own shader is still compiling (see Material::SetFallbackShader), so
+// this needs to stay cheap to compile, and can't rely on any material parameters
+void main() {
+	vec3 normal = normalize(inNormal);
+	vec3 toCamera = normalize(u_CamPos.xyz - inWorldPos);
+
+	// Simple headlight shading, so that the shape of the object is still visible
+	float diffuse = max(dot(normal, toCamera), 0.0) * 0.8 + 0.2;
+
+	frag_color = vec4(inColor * diffuse, 1.0);
+}
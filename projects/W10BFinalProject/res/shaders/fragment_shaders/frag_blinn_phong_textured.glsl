@@ -1,5 +1,11 @@
 #version 430
 
+// Keywords, these are defined by the variant of the shader that a material selects (see Shader::DeclareKeywords)
+//   TOON_SHADING           - Quantizes the result into u_Steps bands for a cel shaded look
+//   ENVIRONMENT_REFLECTION - Blends in the reflected environment map, using the shininess as the reflectivity
+//   SPECULAR_MAP           - Reads the shininess from the red channel of s_Specular instead of u_Shininess
+//   MAX_LIGHTS             - Lowers the number of lights that get evaluated (see multiple_point_lights.glsl)
+
 #include "../fragments/fs_common_inputs.glsl"
 
 // We output a single color to the color buffer
@@ -9,15 +15,21 @@ layout(location = 0) out vec4 frag_color;
 /////////////// Instance Level Uniforms ////////////////////////
 ////////////////////////////////////////////////////////////////
 
+// Textures can't be stored in a uniform block, so they are declared on their own
+uniform sampler2D s_Diffuse;
+#ifdef SPECULAR_MAP
+uniform sampler2D s_Specular;
+#endif
+
 // Represents a collection of attributes that would define a material
 // For instance, you can think of this like material settings in 
-// Unity
-struct Material {
-	sampler2D Diffuse;
-	float     Shininess;
+// Unity. Materials pack these into a buffer (see Material::MATERIAL_UBO_BINDING)
+layout (std140, binding = 3) uniform b_MaterialUniforms {
+    float u_Shininess;
+#ifdef TOON_SHADING
+    int   u_Steps;
+#endif
 };
-// Create a uniform for the material
-uniform Material u_Material;
 
 ////////////////////////////////////////////////////////////////
 ///////////// Application Level Uniforms ///////////////////////
@@ -36,14 +48,31 @@ void main() {
 	// Normalize our input normal
 	vec3 normal = normalize(inNormal);
 
+#ifdef SPECULAR_MAP
+	float shininess = texture(s_Specular, inUV).r;
+#else
+	float shininess = u_Shininess;
+#endif
+
 	// Use the lighting calculation that we included from our partial file
-	vec3 lightAccumulation = CalcAllLightContribution(inWorldPos, normal, u_CamPos.xyz, u_Material.Shininess);
+	vec3 lightAccumulation = CalcAllLightContribution(inWorldPos, normal, u_CamPos.xyz, shininess);
 
 	// Get the albedo from the diffuse / albedo map
-	vec4 textureColor = texture(u_Material.Diffuse, inUV);
+	vec4 textureColor = texture(s_Diffuse, inUV);
 
 	// combine for the final result
 	vec3 result = lightAccumulation  * inColor * textureColor.rgb;
 
+#ifdef ENVIRONMENT_REFLECTION
+	vec3 toEye = normalize(u_CamPos.xyz - inWorldPos);
+	vec3 environmentDir = reflect(-toEye, normal);
+	result = mix(result, SampleEnvironmentMap(environmentDir), shininess);
+#endif
+
+#ifdef TOON_SHADING
+    // Simple way to create cel shading effect
+    result = round(result * u_Steps) / u_Steps;
+#endif
+
 	frag_color = vec4(result, textureColor.a);
-}
\ No newline at end of file
+}
@@ -5,16 +5,16 @@
 // We output a single color to the color buffer
 layout(location = 0) out vec4 frag_color;
 
+// Textures can't be stored in a uniform block, so they are declared on their own
+uniform sampler2D s_Diffuse;
+
 // Represents a collection of attributes that would define a material
 // For instance, you can think of this like material settings in 
-// Unity
-struct Material {
-	sampler2D Diffuse;
-	float     Shininess;
-    float     Threshold;
+// Unity. Materials pack these into a buffer (see Material::MATERIAL_UBO_BINDING)
+layout (std140, binding = 3) uniform b_MaterialUniforms {
+    float u_Shininess;
+    float u_Threshold;
 };
-// Create a uniform for the material
-uniform Material u_Material;
 
 #include "../fragments/multiple_point_lights.glsl"
 #include "../fragments/frame_uniforms.glsl"
@@ -22,9 +22,9 @@ uniform Material u_Material;
 // https://learnopengl.com/Advanced-Lighting/Advanced-Lighting
 void main() {
 	// Get the albedo from the diffuse / albedo map
-	vec4 textureColor = texture(u_Material.Diffuse, inUV);
+	vec4 textureColor = texture(s_Diffuse, inUV);
 
-    if (textureColor.a < u_Material.Threshold) {
+    if (textureColor.a < u_Threshold) {
         discard;
     }
 
@@ -32,7 +32,7 @@ void main() {
 	vec3 normal = normalize(inNormal);
 
 	// Use the lighting calculation that we included from our partial file
-	vec3 lightAccumulation = CalcAllLightContribution(inWorldPos, normal, u_CamPos.xyz, u_Material.Shininess);
+	vec3 lightAccumulation = CalcAllLightContribution(inWorldPos, normal, u_CamPos.xyz, u_Shininess);
 
 
 	// combine for the final result
@@ -9,15 +9,37 @@ layout (std140, binding = 0) uniform b_FrameLevelUniforms {
     // The position of the camera in world space
     uniform vec4  u_CamPos;
     // The time in seconds since the start of the application
-    uniform float u_Time;    
+    uniform float u_Time;
 };
 
-// Stores uniforms that change every object/instance
-layout (std140, binding = 1) uniform b_InstanceLevelUniforms {
+// The most instances that can be drawn in a single draw call, must match
+// InstancedRenderer::MAX_INSTANCES_PER_DRAW
+#define MAX_INSTANCES 64
+
+// Stores the uniforms for a single object/instance
+struct InstanceData {
     // Complete MVP
-    uniform mat4 u_ModelViewProjection;
+    mat4 ModelViewProjection;
     // Just the model transform, we'll do worldspace lighting
-    uniform mat4 u_Model;
+    mat4 Model;
     // Normal Matrix for transforming normals
-    uniform mat4 u_NormalMatrix;
-};
\ No newline at end of file
+    mat4 NormalMatrix;
+    // Custom per-instance parameters
+    vec4 Params;
+};
+
+// Stores the uniforms for every object/instance in the current draw call
+layout (std140, binding = 1) uniform b_InstanceLevelUniforms {
+    InstanceData u_Instances[MAX_INSTANCES];
+};
+
+// The index of the current instance in u_Instances. gl_InstanceID does not include the base
+// instance of multi-draw commands, so we add it from the attribute declared in vs_common.glsl
+#define INSTANCE_INDEX (gl_InstanceID + int(inInstanceBase))
+
+// Shorthands for the current instance's data, these use gl_InstanceID so
+// are only available in vertex shaders
+#define u_ModelViewProjection (u_Instances[INSTANCE_INDEX].ModelViewProjection)
+#define u_Model               (u_Instances[INSTANCE_INDEX].Model)
+#define u_NormalMatrix        (u_Instances[INSTANCE_INDEX].NormalMatrix)
+#define u_InstanceParams      (u_Instances[INSTANCE_INDEX].Params)
\ No newline at end of file
@@ -9,8 +9,14 @@
  * vec3 lighting = CalculateAllLightContribution(inWorldPos, normal, u_CamPos);
 */
 
-// The maximum number of lights the shader supports, increasing this will lower performance!
-#define MAX_LIGHTS 10
+// The number of lights in the light block, must match Scene::MAX_LIGHTS
+#define LIGHT_BLOCK_SIZE 10
+
+// The maximum number of lights the shader evaluates, increasing this will lower performance!
+// Shader variants can define a lower value, which lets the light loop be unrolled
+#ifndef MAX_LIGHTS
+#define MAX_LIGHTS LIGHT_BLOCK_SIZE
+#endif
 
 // Represents a single light source
 struct Light {
@@ -28,7 +34,7 @@ layout (std140, binding = 2) uniform b_LightBlock {
     vec4  AmbientColAndNumLights;
 
     // Our array of all lights
-    Light Lights[MAX_LIGHTS];
+    Light Lights[LIGHT_BLOCK_SIZE];
 
     // The rotation of the skybox/environment map
 	mat3  EnvironmentRotation;
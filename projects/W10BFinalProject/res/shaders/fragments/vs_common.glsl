@@ -4,6 +4,8 @@ layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec3 inNormal;
 layout(location = 3) in vec2 inUV;
+// The base instance of the draw, only fed by geometry arena VAOs, and 0 for everything else
+layout(location = 15) in float inInstanceBase;
 
 // Standard vertex shader outputs
 layout(location = 0) out vec3 outWorldPos;
@@ -1,92 +1,49 @@
 #include "BounceBehaviour.h"
 #include "Gameplay/Components/ComponentManager.h"
 #include "Gameplay/GameObject.h"
+#include "Gameplay/Physics/ContactEvents.h"
 
 
 BounceBehaviour::BounceBehaviour() :
 	IComponent(),
 	gameObj(nullptr),
 	rigidOBJ(nullptr),
-	isInCollision(false)
+	isInCollision(false),
+	reflectionVelocity(glm::vec3(0.0f)),
+	repelVelocity(glm::vec3(0.0f)),
+	bounciness(0.5f)
 { }
 BounceBehaviour::~BounceBehaviour() = default;
 
-void BounceBehaviour::OnEnteredTrigger(const std::shared_ptr<Gameplay::Physics::TriggerVolume>&trigger)
+void BounceBehaviour::OnCollisionBegin(const Gameplay::Physics::Collision& collision)
 {
-	printf("OnEnteredTrigger\n");
-	if (rigidOBJ && gameObj->Name == "Puck") {
+	if (rigidOBJ && collision.Other->GetGameObject()->Name == "Edge") {
 		isInCollision = true;
 
-		glm::vec3 rigiVelo = rigidOBJ->GetVelocity();
-		rigiVelo.z = 0.0f;
-
-		glm::vec3 edgeVec;
-		glm::vec3 forwVec = glm::vec3(0.0f, 1.0f, 0.0f); // forward normal
-		glm::quat rot = trigger->GetGameObject()->GetRotation(); // rotation angle of the edge
-		edgeVec = glm::vec3(glm::vec4(forwVec, 1.0) * rot); // rotate normal
-		edgeVec.x *= -1.0f; // turn inside
+		// Normal of the edge, pointing back towards the table
+		glm::vec3 edgeVec = collision.GetNormal();
 		edgeVec.z = 0.0f;
-
-		float speed = glm::length(rigiVelo);
-
-		rigiVelo = glm::normalize(rigiVelo);
-		edgeVec = glm::normalize(edgeVec);
-
-		glm::vec3 refVelo = glm::reflect(rigiVelo, edgeVec);
-		refVelo.z = 0.0f;
-
-		refVelo *= speed * 0.5f;
-
-		rigidOBJ->resetVelocity();
-		rigidOBJ->ApplyImpulse(refVelo);
-		reflectionVelocity = refVelo;
-		repelVelocity = glm::normalize(refVelo) * 10.0f;
+		if (glm::length(edgeVec) > 0.0f) {
+			repelVelocity = glm::normalize(edgeVec) * 10.0f;
+		}
 	}
 }
 
-void BounceBehaviour::OnLeavingTrigger(const std::shared_ptr<Gameplay::Physics::TriggerVolume>&trigger)
+void BounceBehaviour::OnCollisionEnd(const Gameplay::Physics::Collision& collision)
 {
-
-	//rigidOBJ->resetVelocity();
-	//rigidOBJ->ApplyImpulse(reflectionVelocity);
-	isInCollision = false;
-	printf("OnLeavingTrigger\n");
-}
-
-void BounceBehaviour::OnTriggerVolumeEntered(const std::shared_ptr<Gameplay::Physics::RigidBody>&trigger) {
-	/* // This part works weird. So it is removed.
-	if (gameObj->Name == "Edge") {
-		std::cout << "EDGE BOUNCE" << std::endl;
-
-		glm::vec3 edgeVec;
-		glm::vec3 forwVec = glm::vec3(0.0f, 1.0f, 0.0f);
-		glm::quat rot = trigger->GetGameObject()->GetRotation();
-		edgeVec = glm::vec3(glm::vec4(forwVec, 1.0) * rot);
-		edgeVec.x *= -1.0f;
-		edgeVec.z = 0.0f;
-		edgeVec = glm::normalize(edgeVec);
-
-		float speed = 5.0f;
-
-		glm::vec3 repelVelo = edgeVec * speed;
-
-		trigger->resetVelocity();
-		trigger->ApplyImpulse(repelVelo);
+	if (collision.Other->GetGameObject()->Name == "Edge") {
+		isInCollision = false;
 	}
-	*/
-	printf("OnTriggerVolumeEntered\n");
-}
-
-void BounceBehaviour::OnTriggerVolumeLeaving(const std::shared_ptr<Gameplay::Physics::RigidBody>&trigger)
-{
-	printf("OnTriggerVolumeLeaving\n");
-
 }
 
 void BounceBehaviour::Awake() {
 	gameObj = GetGameObject();
 	if (gameObj->Name == "Puck") {
 		rigidOBJ = GetComponent<Gameplay::Physics::RigidBody>();
+		// The solver bounces us off the edges, the edges have their own restitution as well
+		rigidOBJ->SetRestitution(bounciness);
+		// We need the contact normals to know which way the edges push us
+		rigidOBJ->SetEventFlags(rigidOBJ->GetEventFlags() | PhysicsEventFlags::Contacts);
 	}
 
 }
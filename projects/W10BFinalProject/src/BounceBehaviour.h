@@ -1,9 +1,7 @@
 #pragma once
 #include "Gameplay/Components/IComponent.h"
-#include "Gameplay/Physics/TriggerVolume.h"
 #include "Gameplay/Components/RenderComponent.h"
-#include "Gameplay/Physics/TriggerVolume.h"
-//#include "Gameplay/Physics/RigidBody.h"
+#include "Gameplay/Physics/RigidBody.h"
 
 class BounceBehaviour : public Gameplay::IComponent {
 public:
@@ -16,19 +14,17 @@ public:
 	bool isInCollision;
 	glm::vec3 reflectionVelocity;
 	glm::vec3 repelVelocity;
+	// How much of the impact the puck keeps when rebounding off an edge, used as the puck's restitution
+	float bounciness;
 
 	/// <summary>
 	/// Overide
-	/// Bounce behaviour on onEnteredTrigger
+	/// Tracks when the puck hits an edge, the bounce itself is resolved by the solver using our restitution
 	/// </summary>
-	/// <param name="trigger"></param>
-	virtual void OnEnteredTrigger(const std::shared_ptr<Gameplay::Physics::TriggerVolume>& trigger) override;
+	/// <param name="collision"></param>
+	virtual void OnCollisionBegin(const Gameplay::Physics::Collision& collision) override;
 
-	virtual void OnLeavingTrigger(const std::shared_ptr<Gameplay::Physics::TriggerVolume>& trigger) override;
-
-	virtual void OnTriggerVolumeEntered(const std::shared_ptr<Gameplay::Physics::RigidBody>& trigger) override;
-
-	virtual void OnTriggerVolumeLeaving(const std::shared_ptr<Gameplay::Physics::RigidBody>& trigger) override;
+	virtual void OnCollisionEnd(const Gameplay::Physics::Collision& collision) override;
 
 
 
@@ -98,6 +98,21 @@ namespace Gameplay {
 		return _viewProjection;
 	}
 
+	void Camera::ScreenPointToRay(const glm::vec2& screenPos, const glm::vec2& screenSize, glm::vec3& outOrigin, glm::vec3& outEnd) const {
+		// Convert to normalized device coordinates, remembering that screen Y goes down
+		glm::vec2 ndc = glm::vec2(
+			(screenPos.x / screenSize.x) * 2.0f - 1.0f,
+			1.0f - (screenPos.y / screenSize.y) * 2.0f
+		);
+
+		// Un-project the point on the near and far planes
+		glm::mat4 inverseViewProj = glm::inverse(GetViewProjection());
+		glm::vec4 nearPoint = inverseViewProj * glm::vec4(ndc, -1.0f, 1.0f);
+		glm::vec4 farPoint  = inverseViewProj * glm::vec4(ndc,  1.0f, 1.0f);
+		outOrigin = glm::vec3(nearPoint) / nearPoint.w;
+		outEnd    = glm::vec3(farPoint) / farPoint.w;
+	}
+
 	const glm::mat4& Camera::__CalculateProjection() const
 	{
 		if (_isProjectionDirty) {
@@ -81,6 +81,15 @@ namespace Gameplay {
 		/// </summary>
 		const glm::mat4& GetViewProjection() const;
 
+		/// <summary>
+		/// Converts a point on the screen into a ray in world space, ex: for mouse picking
+		/// </summary>
+		/// <param name="screenPos">The point on the screen in pixels, with the origin in the top left</param>
+		/// <param name="screenSize">The size of the screen in pixels</param>
+		/// <param name="outOrigin">Will store the origin of the ray, on the near plane</param>
+		/// <param name="outEnd">Will store the end of the ray, on the far plane</param>
+		void ScreenPointToRay(const glm::vec2& screenPos, const glm::vec2& screenSize, glm::vec3& outOrigin, glm::vec3& outEnd) const;
+
 	protected:
 		float _nearPlane;
 		float _farPlane;
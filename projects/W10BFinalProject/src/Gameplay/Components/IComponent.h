@@ -14,6 +14,7 @@ namespace Gameplay {
 	namespace Physics {
 		class TriggerVolume;
 		class RigidBody;
+		class Collision;
 	}
 
 	/// <summary>
@@ -65,6 +66,25 @@ namespace Gameplay {
 		/// <param name="body"></param>
 		virtual void OnTriggerVolumeLeaving(const std::shared_ptr<Physics::RigidBody>& body) {};
 
+		/// <summary>
+		/// Invoked when a physics object attached to the parent gameobject starts touching another
+		/// physics object. Only invoked if the physics object has subscribed to PhysicsEventFlags::Contacts
+		/// </summary>
+		/// <param name="collision">The collision info, only valid for the duration of the call</param>
+		virtual void OnCollisionBegin(const Physics::Collision& /*collision*/) {};
+		/// <summary>
+		/// Invoked each physics step while a physics object attached to the parent gameobject is still touching
+		/// another physics object. Only invoked if the physics object has subscribed to PhysicsEventFlags::Contacts
+		/// </summary>
+		/// <param name="collision">The collision info, only valid for the duration of the call</param>
+		virtual void OnCollisionStay(const Physics::Collision& /*collision*/) {};
+		/// <summary>
+		/// Invoked when a physics object attached to the parent gameobject stops touching another physics
+		/// object. Only invoked if the physics object has subscribed to PhysicsEventFlags::Contacts
+		/// </summary>
+		/// <param name="collision">The collision info, will not contain any contact points</param>
+		virtual void OnCollisionEnd(const Physics::Collision& /*collision*/) {};
+
 		/// <summary>
 		/// Invoked when a component has been added to a game object, note that this function
 		/// should only perform local setup (i.e never look for game objects or other components)
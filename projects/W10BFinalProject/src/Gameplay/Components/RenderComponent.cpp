@@ -1,18 +1,29 @@
 #include "Gameplay/Components/RenderComponent.h"
 
 #include "Utils/ResourceManager/ResourceManager.h"
+#include "Utils/ImGuiHelper.h"
+#include "Utils/JsonGlmHelpers.h"
+#include "Gameplay/GameObject.h"
 
 
 RenderComponent::RenderComponent(const Gameplay::MeshResource::Sptr& mesh, const Gameplay::Material::Sptr& material) :
 	_mesh(mesh), 
 	_material(material), 
-	_meshBuilderParams(std::vector<MeshBuilderParam>()) 
+	_meshBuilderParams(std::vector<MeshBuilderParam>()),
+	_lodBias(1.0f),
+	_lodHysteresis(0.1f),
+	_currentLod(0),
+	_instanceParams(0.0f)
 { }
 
 RenderComponent::RenderComponent() : 
 	_mesh(nullptr), 
 	_material(nullptr), 
-	_meshBuilderParams(std::vector<MeshBuilderParam>())
+	_meshBuilderParams(std::vector<MeshBuilderParam>()),
+	_lodBias(1.0f),
+	_lodHysteresis(0.1f),
+	_currentLod(0),
+	_instanceParams(0.0f)
 { }
 
 void RenderComponent::SetMesh(const Gameplay::MeshResource::Sptr& mesh) {
@@ -35,10 +46,52 @@ const Gameplay::Material::Sptr& RenderComponent::GetMaterial() const {
 	return _material;
 }
 
+VertexArrayObject::Sptr RenderComponent::SelectLod(const glm::vec3& cameraPos, const glm::mat4& projection) {
+	if (_mesh == nullptr) {
+		return nullptr;
+	}
+
+	int lodCount = _mesh->GetLodCount();
+	if (lodCount <= 1) {
+		_currentLod = 0;
+		return _mesh->Mesh;
+	}
+
+	// Find the bounding sphere in world space, using the largest scale axis for the radius
+	const glm::mat4& transform = GetGameObject()->GetTransform();
+	glm::vec3 center = transform * glm::vec4(_mesh->BoundsCenter, 1.0f);
+	float scale = glm::max(glm::length(glm::vec3(transform[0])), glm::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+	float radius = _mesh->BoundsRadius * scale;
+
+	// Projected size of the sphere as a fraction of the screen height, note that orthographic
+	// projections have a 1 in the bottom right, and are not affected by distance
+	float screenSize = radius * projection[1][1];
+	if (projection[3][3] != 1.0f) {
+		screenSize /= glm::max(glm::length(center - cameraPos), 0.0001f);
+	}
+	screenSize *= _lodBias;
+
+	// Step towards lower detail while we're comfortably below the next level's threshold, then towards higher
+	// detail while we're comfortably above our current level's threshold
+	int level = glm::clamp(_currentLod, 0, lodCount - 1);
+	while (level + 1 < lodCount && screenSize < _mesh->Lods[level].ScreenSize * (1.0f - _lodHysteresis)) {
+		level++;
+	}
+	while (level > 0 && screenSize > _mesh->Lods[level - 1].ScreenSize * (1.0f + _lodHysteresis)) {
+		level--;
+	}
+	_currentLod = level;
+
+	return _mesh->GetLodMesh(_currentLod);
+}
+
 nlohmann::json RenderComponent::ToJson() const {
 	nlohmann::json result;
 	result["mesh"] = _mesh ? _mesh->GetGUID().str() : "null";
 	result["material"] = _material ? _material->GetGUID().str() : "null";
+	result["lod_bias"] = _lodBias;
+	result["lod_hysteresis"] = _lodHysteresis;
+	result["instance_params"] = GlmToJson(_instanceParams);
 	return result;
 }
 
@@ -46,6 +99,11 @@ RenderComponent::Sptr RenderComponent::FromJson(const nlohmann::json& data) {
 	RenderComponent::Sptr result = std::make_shared<RenderComponent>();
 	result->_mesh = ResourceManager::Get<Gameplay::MeshResource>(Guid(data["mesh"].get<std::string>()));
 	result->_material = ResourceManager::Get<Gameplay::Material>(Guid(data["material"].get<std::string>()));
+	result->_lodBias = JsonGet(data, "lod_bias", result->_lodBias);
+	result->_lodHysteresis = JsonGet(data, "lod_hysteresis", result->_lodHysteresis);
+	if (data.contains("instance_params")) {
+		result->_instanceParams = ParseJsonVec4(data["instance_params"]);
+	}
 
 	return result;
 }
@@ -54,6 +112,10 @@ void RenderComponent::RenderImGui() {
 	ImGui::Text("Indexed:   %s", GetMesh() != nullptr ? (_mesh->Mesh->GetIndexBuffer() != nullptr ? "true" : "false") : "N/A");
 	ImGui::Text("Triangles: %d", GetMesh() != nullptr ? (_mesh->Mesh->GetElementCount() / 3) : 0);
 	ImGui::Text("Source:    %s", (_mesh == nullptr || _mesh->Filename.empty()) ? "Generated" : _mesh->Filename.c_str());
+	ImGui::Text("LOD:       %d / %d", _currentLod, _mesh != nullptr ? _mesh->GetLodCount() : 0);
+	LABEL_LEFT(ImGui::DragFloat, "LOD Bias      ", &_lodBias, 0.01f, 0.0f);
+	LABEL_LEFT(ImGui::DragFloat, "LOD Hysteresis", &_lodHysteresis, 0.01f, 0.0f, 1.0f);
+	LABEL_LEFT(ImGui::DragFloat4, "Params        ", &_instanceParams.x, 0.01f);
 	ImGui::Separator();
 	ImGui::Text("Material:  %s", _material != nullptr ? _material->Name.c_str() : "NULL");
 }
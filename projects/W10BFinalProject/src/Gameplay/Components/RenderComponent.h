@@ -42,6 +42,34 @@ public:
 	/// <param name="mat">The material for this object</param>
 	void SetMaterial(const Gameplay::Material::Sptr& mat);
 
+	/// <summary>
+	/// Selects the level of detail to render based on the projected size of the mesh's bounding sphere on
+	/// screen. Switching between levels requires the size to cross the threshold by the hysteresis ratio, which
+	/// prevents objects from flickering between levels when sitting near a threshold
+	/// </summary>
+	/// <param name="cameraPos">The position of the camera in world space</param>
+	/// <param name="projection">The camera's projection matrix</param>
+	/// <returns>The VAO for the selected level of detail</returns>
+	VertexArrayObject::Sptr SelectLod(const glm::vec3& cameraPos, const glm::mat4& projection);
+	/// <summary>
+	/// Gets the level of detail that was last selected by SelectLod, where 0 is full detail
+	/// </summary>
+	int GetCurrentLod() const { return _currentLod; }
+
+	/// <summary>
+	/// Sets the multiplier applied to the object's screen size when selecting LODs, values greater than 1
+	/// will keep higher detail levels for longer
+	/// </summary>
+	void SetLodBias(float value) { _lodBias = value; }
+	float GetLodBias() const { return _lodBias; }
+
+	/// <summary>
+	/// Sets the custom parameters that are passed to the shader alongside this object's transform, shaders
+	/// can read them from u_InstanceParams
+	/// </summary>
+	void SetInstanceParams(const glm::vec4& value) { _instanceParams = value; }
+	const glm::vec4& GetInstanceParams() const { return _instanceParams; }
+
 	// Inherited from IComponent
 
 	virtual void RenderImGui() override;
@@ -57,4 +85,13 @@ protected:
 
 	// If we want to use MeshFactory, we can populate this list
 	std::vector<MeshBuilderParam> _meshBuilderParams;
+
+	// Multiplier for the screen size when selecting LODs
+	float _lodBias;
+	// The ratio that the screen size must pass a threshold by before we switch levels
+	float _lodHysteresis;
+	// The level of detail that was selected last frame
+	int   _currentLod;
+	// Custom parameters for the shader, stored with the instance data
+	glm::vec4 _instanceParams;
 };
\ No newline at end of file
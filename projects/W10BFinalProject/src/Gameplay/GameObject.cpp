@@ -24,7 +24,8 @@ namespace Gameplay {
 		_scale(ONE),
 		_transform(MAT4_IDENTITY),
 		_inverseTransform(MAT4_IDENTITY),
-		_isTransformDirty(true)
+		_isTransformDirty(true),
+		_transformVersion(0)
 	{ }
 
 	void GameObject::_RecalcTransform() const
@@ -67,9 +68,20 @@ namespace Gameplay {
 		}
 	}
 
+	void GameObject::OnCollision(const Physics::Collision& collision) {
+		for (auto& component : _components) {
+			switch (collision.Type) {
+				case ContactEventType::Begin: component->OnCollisionBegin(collision); break;
+				case ContactEventType::Stay:  component->OnCollisionStay(collision);  break;
+				case ContactEventType::End:   component->OnCollisionEnd(collision);   break;
+			}
+		}
+	}
+
 	void GameObject::SetPostion(const glm::vec3& position) {
 		_position = position;
 		_isTransformDirty = true;
+		_transformVersion++;
 	}
 
 	const glm::vec3& GameObject::GetPosition() const {
@@ -79,6 +91,7 @@ namespace Gameplay {
 	void GameObject::SetRotation(const glm::quat& value) {
 		_rotation = value;
 		_isTransformDirty = true;
+		_transformVersion++;
 	}
 
 	const glm::quat& GameObject::GetRotation() const {
@@ -88,6 +101,7 @@ namespace Gameplay {
 	void GameObject::SetRotation(const glm::vec3& eulerAngles) {
 		_rotation = glm::quat(glm::radians(eulerAngles));
 		_isTransformDirty = true;
+		_transformVersion++;
 	}
 
 	glm::vec3 GameObject::GetRotationEuler() const {
@@ -97,6 +111,7 @@ namespace Gameplay {
 	void GameObject::SetScale(const glm::vec3& value) {
 		_scale = value;
 		_isTransformDirty = true;
+		_transformVersion++;
 	}
 
 	const glm::vec3& GameObject::GetScale() const {
@@ -114,6 +129,10 @@ namespace Gameplay {
 		return _inverseTransform;
 	}
 
+	uint32_t GameObject::GetTransformVersion() const {
+		return _transformVersion;
+	}
+
 	Scene* GameObject::GetScene() const {
 		return _scene;
 	}
@@ -219,7 +238,9 @@ namespace Gameplay {
 			}
 
 			// Render position label
-			_isTransformDirty |= LABEL_LEFT(ImGui::DragFloat3, "Position", &_position.x, 0.01f);
+			if (LABEL_LEFT(ImGui::DragFloat3, "Position", &_position.x, 0.01f)) {
+				SetPostion(_position);
+			}
 			
 			// Get the ImGui storage state so we can avoid gimbal locking issues by storing euler angles in the editor
 			glm::vec3 euler = GetRotationEuler();
@@ -245,7 +266,9 @@ namespace Gameplay {
 			}
 			
 			// Draw the scale
-			_isTransformDirty |= LABEL_LEFT(ImGui::DragFloat3, "Scale   ", &_scale.x, 0.01f, 0.0f);
+			if (LABEL_LEFT(ImGui::DragFloat3, "Scale   ", &_scale.x, 0.01f, 0.0f)) {
+				SetScale(_scale);
+			}
 
 			ImGui::Separator();
 			ImGui::TextUnformatted("Components");
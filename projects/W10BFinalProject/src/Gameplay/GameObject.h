@@ -19,6 +19,7 @@ namespace Gameplay {
 	namespace Physics {
 		class TriggerVolume;
 		class RigidBody;
+		class Collision;
 	}
 
 	/// <summary>
@@ -64,6 +65,13 @@ namespace Gameplay {
 		/// <param name="body">The body that has left our trigger volume</param>
 		void OnTriggerVolumeLeaving(const std::shared_ptr<Physics::RigidBody>& body);
 
+		/// <summary>
+		/// Invoked when a physics object attached to this game object (if any) that has subscribed
+		/// to contact events begins, continues, or stops touching another physics object
+		/// </summary>
+		/// <param name="collision">The collision info, only valid for the duration of the call</param>
+		void OnCollision(const Physics::Collision& collision);
+
 		/// <summary>
 		/// Sets the game object's world position
 		/// </summary>
@@ -115,6 +123,13 @@ namespace Gameplay {
 		/// </summary>
 		const glm::mat4& GetInverseTransform() const;
 
+		/// <summary>
+		/// Gets a counter that goes up every time the object's position, rotation or scale is
+		/// changed, so that other systems can cheaply tell if the object has moved since they
+		/// last looked at it
+		/// </summary>
+		uint32_t GetTransformVersion() const;
+
 		/// <summary>
 		/// Returns a pointer to the scene that this GameObject belongs to
 		/// </summary>
@@ -226,6 +241,8 @@ namespace Gameplay {
 		mutable glm::mat4 _transform;
 		mutable glm::mat4 _inverseTransform;
 		mutable bool _isTransformDirty;
+		// Incremented whenever the position, rotation or scale changes
+		uint32_t _transformVersion;
 
 		// The components that this game object has attached to it
 		std::vector<IComponent::Sptr> _components;
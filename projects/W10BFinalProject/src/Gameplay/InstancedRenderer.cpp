@@ -0,0 +1,199 @@
+#include "Gameplay/InstancedRenderer.h"
+
+#include <algorithm>
+
+namespace Gameplay {
+	InstancedRenderer::InstancedRenderer(int binding) :
+		_binding(binding),
+		_viewProjection(1.0f),
+		_items(),
+		_batches(),
+		// Room for a few hundred objects a frame to start with, the buffer will grow if we need more
+		_instanceBuffer(std::make_shared<UniformRingBuffer>(256 * sizeof(InstanceData), MAX_INSTANCES_PER_DRAW * sizeof(InstanceData))),
+		_stats(),
+		_multiDrawEnabled(true),
+		_commandBuffer(nullptr),
+		_retiredCommandBuffers(),
+		_pendingBatch(),
+		_pendingInstances(),
+		_pendingCommands()
+	{
+		_instanceBuffer->EnableStreaming();
+		// Multi-draw commands are written straight into mapped memory, so we need streaming buffers for them
+		if (StreamingBuffer::IsSupported()) {
+			_commandBuffer = std::make_shared<StreamingBuffer>(BufferType::DrawIndirect, 1024 * sizeof(DrawElementsIndirectCommand));
+		}
+	}
+
+	void InstancedRenderer::Begin(const glm::mat4& viewProjection) {
+		_viewProjection = viewProjection;
+		_items.clear();
+	}
+
+	void InstancedRenderer::Submit(const Material::Sptr& material, const VertexArrayObject::Sptr& mesh, const glm::mat4& transform, const glm::vec4& params) {
+		DrawItem item;
+		item.Mat = material.get();
+		item.Mesh = mesh.get();
+		item.Arena = (_multiDrawEnabled && _commandBuffer != nullptr) ? GeometryArena::Find(mesh.get(), item.Range) : nullptr;
+
+		// Meshes with quantized positions need to be mapped back into object space first, normals are unaffected
+		glm::mat4 model = transform * mesh->GetDequantizeTransform();
+		item.Instance.Model = model;
+		item.Instance.ModelViewProjection = _viewProjection * model;
+		item.Instance.NormalMatrix = glm::mat3(glm::transpose(glm::inverse(transform)));
+		item.Instance.Params = params;
+		_items.push_back(item);
+	}
+
+	void InstancedRenderer::Flush() {
+		_stats = InstancedRenderStats();
+		_retiredCommandBuffers.clear();
+		if (_items.empty()) {
+			return;
+		}
+
+		// Sorting by material first means we only switch shaders when we have to, sorting by arena next
+		// keeps everything that can share a multi-draw together, and sorting by mesh within those puts all
+		// of the copies of a mesh next to each other
+		std::sort(_items.begin(), _items.end(), [](const DrawItem& a, const DrawItem& b) {
+			if (a.Mat != b.Mat) {
+				return a.Mat < b.Mat;
+			}
+			return a.Arena != b.Arena ? a.Arena < b.Arena : a.Mesh < b.Mesh;
+		});
+
+		// Pack every group's instance data into the ring buffer, and upload it all at once
+		_instanceBuffer->BeginFrame();
+		_batches.clear();
+		size_t groupStart = 0;
+		for (size_t ix = 1; ix <= _items.size(); ix++) {
+			// Keep going until we hit the end of the group
+			if (ix < _items.size() && _items[ix].Mat == _items[groupStart].Mat && _items[ix].Mesh == _items[groupStart].Mesh) {
+				continue;
+			}
+			if (_items[groupStart].Arena != nullptr) {
+				_AddToMultiDraw(groupStart, ix);
+			} else {
+				_CloseMultiDraw();
+				_BuildBatches(groupStart, ix);
+			}
+			groupStart = ix;
+		}
+		_CloseMultiDraw();
+		_instanceBuffer->Upload();
+
+		Material* currentMat = nullptr;
+		bool hasMultiDraws = false;
+		for (const DrawBatch& batch : _batches) {
+			// If the material has changed, we need to bind the new shader and set up our material data
+			// Materials whose shaders are still compiling will give us the fallback shader instead
+			if (batch.Mat != currentMat) {
+				currentMat = batch.Mat;
+				currentMat->GetActiveShader()->Bind();
+				currentMat->Apply();
+			}
+
+			_instanceBuffer->BindRange(_binding, batch.Offset);
+			if (batch.Arena != nullptr) {
+				batch.Arena->GetVao()->Bind();
+				glBindBuffer(GL_DRAW_INDIRECT_BUFFER, batch.CommandBuffer);
+				glMultiDrawElementsIndirect(GL_TRIANGLES, (GLenum)batch.Arena->GetIndexType(), (const void*)batch.CommandOffset, batch.CommandCount, 0);
+				_stats.MultiDrawCommands += batch.CommandCount;
+				hasMultiDraws = true;
+			} else {
+				batch.Mesh->DrawInstanced(batch.Count);
+			}
+			_stats.DrawCalls++;
+			_stats.Instances += batch.Count;
+		}
+
+		if (hasMultiDraws) {
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+			VertexArrayObject::Unbind();
+		}
+	}
+
+	void InstancedRenderer::_BuildBatches(size_t begin, size_t end) {
+		while (begin < end) {
+			// Large groups get split into as many draws as it takes to fit in the shader's block
+			const int count = static_cast<int>(std::min(end - begin, static_cast<size_t>(MAX_INSTANCES_PER_DRAW)));
+
+			DrawBatch batch = DrawBatch();
+			batch.Mat = _items[begin].Mat;
+			batch.Mesh = _items[begin].Mesh;
+			batch.Count = count;
+			InstanceData* instances = static_cast<InstanceData*>(_instanceBuffer->Allocate(count * sizeof(InstanceData), batch.Offset));
+			for (int ix = 0; ix < count; ix++) {
+				instances[ix] = _items[begin + ix].Instance;
+			}
+			_batches.push_back(batch);
+			begin += count;
+		}
+	}
+
+	void InstancedRenderer::_AddToMultiDraw(size_t begin, size_t end) {
+		const DrawItem& first = _items[begin];
+		if (!_pendingCommands.empty() && (_pendingBatch.Mat != first.Mat || _pendingBatch.Arena != first.Arena)) {
+			_CloseMultiDraw();
+		}
+
+		while (begin < end) {
+			// All of a multi-draw's instances need to fit in the shader's block, so large groups may be split
+			// over several multi-draws
+			if (_pendingInstances.size() >= MAX_INSTANCES_PER_DRAW) {
+				_CloseMultiDraw();
+			}
+			if (_pendingCommands.empty()) {
+				_pendingBatch = DrawBatch();
+				_pendingBatch.Mat = first.Mat;
+				_pendingBatch.Arena = first.Arena;
+			}
+
+			const size_t count = std::min(end - begin, MAX_INSTANCES_PER_DRAW - _pendingInstances.size());
+			DrawElementsIndirectCommand command;
+			command.Count = first.Range.IndexCount;
+			command.InstanceCount = static_cast<GLuint>(count);
+			command.FirstIndex = first.Range.FirstIndex;
+			command.BaseVertex = first.Range.BaseVertex;
+			// The shader adds the base instance to gl_InstanceID to find the instance data
+			command.BaseInstance = static_cast<GLuint>(_pendingInstances.size());
+			_pendingCommands.push_back(command);
+
+			for (size_t ix = 0; ix < count; ix++) {
+				_pendingInstances.push_back(_items[begin + ix].Instance);
+			}
+			begin += count;
+		}
+	}
+
+	void InstancedRenderer::_CloseMultiDraw() {
+		if (_pendingCommands.empty()) {
+			return;
+		}
+
+		DrawBatch batch = _pendingBatch;
+		batch.Count = static_cast<int>(_pendingInstances.size());
+		void* instances = _instanceBuffer->Allocate(_pendingInstances.size() * sizeof(InstanceData), batch.Offset);
+		memcpy(instances, _pendingInstances.data(), _pendingInstances.size() * sizeof(InstanceData));
+
+		const size_t size = _pendingCommands.size() * sizeof(DrawElementsIndirectCommand);
+		void* commands = _commandBuffer->Allocate(size, sizeof(GLuint), batch.CommandOffset);
+		if (commands == nullptr) {
+			// Earlier batches still point at the old buffer, so it needs to stay alive until they're drawn
+			size_t capacity = _commandBuffer->GetRegionSize() * 2;
+			while (capacity < size) {
+				capacity *= 2;
+			}
+			_retiredCommandBuffers.push_back(_commandBuffer);
+			_commandBuffer = std::make_shared<StreamingBuffer>(BufferType::DrawIndirect, capacity);
+			commands = _commandBuffer->Allocate(size, sizeof(GLuint), batch.CommandOffset);
+		}
+		memcpy(commands, _pendingCommands.data(), size);
+		batch.CommandBuffer = _commandBuffer->GetHandle();
+		batch.CommandCount = static_cast<int>(_pendingCommands.size());
+		_batches.push_back(batch);
+
+		_pendingCommands.clear();
+		_pendingInstances.clear();
+	}
+}
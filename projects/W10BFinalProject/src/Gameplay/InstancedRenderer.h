@@ -0,0 +1,138 @@
+#pragma once
+#include <vector>
+#include <GLM/glm.hpp>
+
+#include "Graphics/VertexArrayObject.h"
+#include "Graphics/UniformRingBuffer.h"
+#include "Graphics/StreamingBuffer.h"
+#include "Graphics/GeometryArena.h"
+#include "Gameplay/Material.h"
+
+namespace Gameplay {
+	/// <summary>
+	/// The per-instance data for a single object, matches the InstanceData structure
+	/// from fragments/frame_uniforms.glsl
+	/// </summary>
+	struct InstanceData {
+		// Complete MVP
+		glm::mat4 ModelViewProjection;
+		// Just the model transform, we'll do worldspace lighting
+		glm::mat4 Model;
+		// Normal Matrix for transforming normals
+		glm::mat4 NormalMatrix;
+		// Free for shaders to use however they like (ex: tints, wind offsets)
+		glm::vec4 Params;
+	};
+
+	/// <summary>
+	/// The number of draws and instances that the renderer issued in a frame
+	/// </summary>
+	struct InstancedRenderStats {
+		int DrawCalls = 0;
+		int Instances = 0;
+		// The number of meshes drawn through multi-draw indirect commands
+		int MultiDrawCommands = 0;
+	};
+
+	/// <summary>
+	/// Collects the objects to draw for a frame, and groups any that share a mesh and material
+	/// so that they can be drawn with a single instanced draw call
+	///
+	/// Meshes that live in a geometry arena go one step further, every mesh in the arena that
+	/// shares a material is drawn with a single glMultiDrawElementsIndirect call
+	/// </summary>
+	class InstancedRenderer {
+	public:
+		typedef std::shared_ptr<InstancedRenderer> Sptr;
+
+		/// <summary>
+		/// The most instances that can be drawn in a single call, must match MAX_INSTANCES
+		/// in fragments/frame_uniforms.glsl. 64 instances keeps us under the 16KB UBO
+		/// size that every GL implementation supports
+		/// </summary>
+		inline static const int MAX_INSTANCES_PER_DRAW = 64;
+
+		/// <summary>
+		/// Creates a new instanced renderer
+		/// </summary>
+		/// <param name="binding">The UBO binding slot that instance data will be bound to</param>
+		InstancedRenderer(int binding);
+
+		/// <summary>
+		/// Clears out the draws from the last frame and starts collecting new ones
+		/// </summary>
+		/// <param name="viewProjection">The camera's view projection matrix for this frame</param>
+		void Begin(const glm::mat4& viewProjection);
+		/// <summary>
+		/// Adds an object to be drawn at the end of the frame
+		/// </summary>
+		/// <param name="material">The material to draw the object with</param>
+		/// <param name="mesh">The VAO to draw</param>
+		/// <param name="transform">The object's world transform</param>
+		/// <param name="params">The custom per-instance parameters</param>
+		void Submit(const Material::Sptr& material, const VertexArrayObject::Sptr& mesh, const glm::mat4& transform, const glm::vec4& params = glm::vec4(0.0f));
+		/// <summary>
+		/// Sorts the submitted objects by material and mesh, then draws each group with as few
+		/// instanced draw calls as possible. All of the instance data for the frame is uploaded
+		/// at once, and each draw binds it's own slot of the ring buffer
+		/// </summary>
+		void Flush();
+
+		/// <summary>
+		/// Gets the stats from the last call to Flush
+		/// </summary>
+		const InstancedRenderStats& GetStats() const { return _stats; }
+
+		/// <summary>
+		/// Sets whether meshes in geometry arenas should be drawn with multi-draw indirect
+		/// </summary>
+		void SetMultiDrawEnabled(bool value) { _multiDrawEnabled = value; }
+		bool IsMultiDrawEnabled() const { return _multiDrawEnabled; }
+
+	protected:
+		struct DrawItem {
+			Material*                 Mat;
+			VertexArrayObject*        Mesh;
+			// The arena that the mesh lives in, or nullptr if it must be drawn on it's own
+			GeometryArena*            Arena;
+			GeometryArena::MeshRange  Range;
+			InstanceData              Instance;
+		};
+
+		// A single draw call, pointing at it's slot in the ring buffer. Multi-draws have an arena and
+		// point at their commands, everything else draws a single mesh
+		struct DrawBatch {
+			Material*          Mat;
+			VertexArrayObject* Mesh;
+			int                Count;
+			size_t             Offset;
+			GeometryArena*     Arena;
+			GLuint             CommandBuffer;
+			size_t             CommandOffset;
+			int                CommandCount;
+		};
+
+		int                        _binding;
+		glm::mat4                  _viewProjection;
+		std::vector<DrawItem>      _items;
+		std::vector<DrawBatch>     _batches;
+		UniformRingBuffer::Sptr    _instanceBuffer;
+		InstancedRenderStats       _stats;
+
+		bool                       _multiDrawEnabled;
+		StreamingBuffer::Sptr      _commandBuffer;
+		// Command buffers that were outgrown, kept alive until the draws using them are issued
+		std::vector<StreamingBuffer::Sptr> _retiredCommandBuffers;
+		// The multi-draw that is being built, closed off when the material or arena changes, or it's full
+		DrawBatch                  _pendingBatch;
+		std::vector<InstanceData>  _pendingInstances;
+		std::vector<DrawElementsIndirectCommand> _pendingCommands;
+
+		// Writes the instance data for a single mesh and material into the ring buffer, split into batches
+		void _BuildBatches(size_t begin, size_t end);
+		// Adds the commands for a single mesh and material to the pending multi-draw
+		void _AddToMultiDraw(size_t begin, size_t end);
+		// Writes the pending multi-draw's instances and commands out, and adds it to the batches
+		void _CloseMultiDraw();
+	};
+}
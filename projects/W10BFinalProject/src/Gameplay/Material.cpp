@@ -5,23 +5,78 @@
 #include "Graphics/Texture2D.h"
 #include "Logging.h"
 #include "Utils/ImGuiHelper.h"
+#include <algorithm>
 
 namespace Gameplay {
 
 	Material::Material(const Shader::Sptr& shader) :
 		IResource(),
 		_shader(shader),
-		_uniforms(std::unordered_map<std::string, UniformData>())
-	{ }
+		_program(nullptr),
+		_keywords(),
+		_uniforms(std::unordered_map<std::string, UniformData>()),
+		_textures(),
+		_programUniforms(),
+		_layoutDirty(true),
+		_programUniformsDirty(true),
+		_blockData(),
+		_blockBuffer(nullptr),
+		_blockDirty(false),
+		_resolved(false),
+		_pendingValues(),
+		_pendingParameters()
+	{
+		_SelectVariant();
+	}
 
 	Material::Material() :
 		IResource(),
 		_shader(nullptr),
-		_uniforms(std::unordered_map<std::string, UniformData>())
+		_program(nullptr),
+		_keywords(),
+		_uniforms(std::unordered_map<std::string, UniformData>()),
+		_textures(),
+		_programUniforms(),
+		_layoutDirty(true),
+		_programUniformsDirty(true),
+		_blockData(),
+		_blockBuffer(nullptr),
+		_blockDirty(false),
+		_resolved(false),
+		_pendingValues(),
+		_pendingParameters()
 	{ }
 
+	Material::~Material() {
+		// Make sure a new material at the same address doesn't think it's values are still in the program
+		for (auto& [shader, owner] : __ProgramUniformOwners) {
+			if (owner == this) {
+				owner = nullptr;
+			}
+		}
+	}
+
 	void Material::Set(const std::string& name, ShaderDataType type, const void* value, size_t arraySize)
 	{
+		if (!_resolved) {
+			// We can't look up the uniform until the shader is done, so hold on to the value until then
+			if (_IsShaderPending()) {
+				PendingValue pending;
+				pending.Name = name;
+				pending.Type = type;
+				pending.ArraySize = arraySize;
+				if (type == ShaderDataType::None) {
+					pending.Texture = *reinterpret_cast<const ITexture::Sptr*>(value);
+				} else {
+					const uint8_t* bytes = reinterpret_cast<const uint8_t*>(value);
+					pending.Data.assign(bytes, bytes + ShaderDataTypeSize(type) * arraySize);
+				}
+				_pendingValues.push_back(pending);
+				return;
+			}
+			_ResolveUniforms();
+		}
+
 		// Try and find the matching uniform
 		UniformData& uniform = _GetUniform(name);
 
@@ -38,13 +93,21 @@ namespace Gameplay {
 			// Types match, we're good to go
 			else {
 				// if it's an array, copy all the elements
+				// Variants may have smaller arrays than the values we were given, so we clamp to the uniform's size
 				if (uniform.ArraySize > 1) {
-					memcpy(uniform.ArrayBlock, value, ShaderDataTypeSize(type) * arraySize);
+					memcpy(uniform.ArrayBlock, value, ShaderDataTypeSize(type) * std::min(arraySize, uniform.ArraySize));
 				} 
 				// if it's just a value, copy the value
 				else {
 					memcpy(uniform.Value, value, ShaderDataTypeSize(type));
 				}
+
+				// Block values get packed now so that Apply only needs to upload them
+				if (uniform.BlockOffset != -1) {
+					_PackUniform(uniform);
+				} else {
+					_programUniformsDirty = true;
+				}
 			}
 		}
 		// We couldn't find that uniform, log a warning
@@ -57,34 +120,82 @@ namespace Gameplay {
 		return _shader;
 	}
 
+	const Shader::Sptr& Material::GetActiveShader() const {
+		if (_program != nullptr && !_program->IsReady() && __FallbackShader != nullptr) {
+			return __FallbackShader;
+		}
+		return _program;
+	}
+
+	void Material::SetKeyword(const std::string& keyword, bool enabled) {
+		auto it = std::find(_keywords.begin(), _keywords.end(), keyword);
+		if (enabled == (it != _keywords.end())) {
+			return;
+		}
+
+		if (enabled) {
+			if (_shader != nullptr && _shader->GetKeywordMask(keyword) == 0) {
+				LOG_WARN("Keyword \"{}\" is not declared by the shader for material \"{}\"", keyword, Name);
+			}
+			_keywords.push_back(keyword);
+		} else {
+			_keywords.erase(it);
+		}
+		_SelectVariant();
+	}
+
+	bool Material::IsKeywordEnabled(const std::string& keyword) const {
+		return std::find(_keywords.begin(), _keywords.end(), keyword) != _keywords.end();
+	}
+
 	void Material::Apply() {
-		if (_shader != nullptr) {
-			// Skip the reserved # of texture slots
-			int textureSlot = RESERVED_TEXTURE_SLOTS;
-			
-			// Iterate over the uniforms map
-			for (auto&[name, data] : _uniforms) {
-				// The typecode is basically the underlying type of the uniform
-				// ex: float, matrix, texture, etc...
-				ShaderDataTypecode typeCode = GetShaderDataTypeCode(data.Type);
-
-				// If the uniform is a texture, we try and bind it, then move to the next slot
-				if (typeCode == ShaderDataTypecode::Texture) {
-					ITexture::Sptr texture = data.TextureAsset;
-					if (texture != nullptr) {
-						texture->Bind(textureSlot);
-					} else {
-						ITexture::Unbind(textureSlot);
-					}
-					// Send the slot to the shader
-					_shader->SetUniform(data.Location, data.Type, &textureSlot);
-					textureSlot++;
-				}
-				// The uniform is a plain ol' value type, send it in
-				else {
-					_shader->SetUniform(data.Location, data.Type, data.ArraySize > 1 ? data.ArrayBlock : data.Value, data.ArraySize);
-				}
+		if (_program == nullptr) {
+			return;
+		}
+
+		// The fallback shader doesn't use any material state, so there's nothing to apply until our shader is done
+		if (!_resolved) {
+			if (_IsShaderPending()) {
+				return;
+			}
+			_ResolveUniforms();
+		}
+
+		if (_layoutDirty) {
+			_RebuildLayout();
+		}
+
+		// Textures remember what's bound to each unit, so ones that are already bound get skipped
+		for (const TextureBinding& binding : _textures) {
+			const ITexture::Sptr& texture = binding.Uniform->TextureAsset;
+			if (texture != nullptr) {
+				texture->Bind(binding.Slot);
+			} else {
+				ITexture::Unbind(binding.Slot);
+			}
+		}
+
+		// Sampler units and uniforms outside of the block are stored in the program, so we only need to
+		// send them if they've changed, or if another material has overwritten them since
+		const Material*& owner = __ProgramUniformOwners[_program.get()];
+		if (_programUniformsDirty || owner != this) {
+			for (TextureBinding& binding : _textures) {
+				_program->SetUniform(binding.Uniform->Location, binding.Uniform->Type, &binding.Slot);
+			}
+			for (UniformData* data : _programUniforms) {
+				_program->SetUniform(data->Location, data->Type, data->ArraySize > 1 ? data->ArrayBlock : data->Value, data->ArraySize);
+			}
+			owner = this;
+			_programUniformsDirty = false;
+		}
+
+		// Everything else lives in the material block, which is only re-uploaded after a value was set
+		if (_blockBuffer != nullptr) {
+			if (_blockDirty) {
+				_blockBuffer->LoadData(_blockData.data(), 1, _blockData.size());
+				_blockDirty = false;
 			}
+			_blockBuffer->Bind(MATERIAL_UBO_BINDING);
 		}
 	}
 
@@ -92,10 +203,28 @@ namespace Gameplay {
 		ImGui::PushID(this);
 
 		if (ImGui::CollapsingHeader(Name.c_str())) {
+			// Toggling a keyword switches variants, and moves our values over to the new variant
+			if (_shader != nullptr) {
+				for (const std::string& keyword : _shader->GetKeywords()) {
+					bool enabled = IsKeywordEnabled(keyword);
+					if (ImGui::Checkbox(keyword.c_str(), &enabled)) {
+						SetKeyword(keyword, enabled);
+					}
+				}
+			}
+
+			if (!_resolved && _IsShaderPending()) {
+				ImGui::Text("Waiting on shader to compile...");
+			}
+
 			// Draw all of our valid uniforms
 			for (auto&[key, value] : _uniforms) {
-				if (value.Location != -2) {
-					value.RenderImGui();
+				if (value.Location != -2 && value.RenderImGui()) {
+					if (value.BlockOffset != -1) {
+						_PackUniform(value);
+					} else {
+						_programUniformsDirty = true;
+					}
 				}
 			}
 
@@ -118,26 +247,32 @@ namespace Gameplay {
 		result->OverrideGUID(Guid(data["guid"]));
 		result->Name = data["name"].get<std::string>();
 		result->_shader = ResourceManager::Get<Shader>(Guid(data["shader"]));
+		if (data.contains("keywords") && data["keywords"].is_array()) {
+			result->_keywords = data["keywords"].get<std::vector<std::string>>();
+		}
 
-		// material specific parameters'
+		// material specific parameters', these need the shader's uniforms so they may have to wait for it to compile
 		if (data.contains("parameters") && data["parameters"].is_object()) {
-			// Iterate over all objects
-			for (auto& [key, value] : data["parameters"].items()) {
-				// Try loading a uniform from the blob, if successful, store it
-				Material::UniformData uniform = Material::UniformData::FromJson(value, key, result->_shader);
-				if (uniform.Location != -2) {
-					result->_uniforms[key] = uniform;
-				}
-			}
+			result->_pendingParameters = data["parameters"];
 		}
+		result->_SelectVariant();
 		return result;
 	}
 
 	nlohmann::json Material::ToJson() const { 
+		// Our parameters are only stored in a form we can save once the shader is done
+		if (!_resolved && _IsShaderPending()) {
+			_program->WaitForCompile();
+		}
+		if (!_resolved) {
+			const_cast<Material*>(this)->_ResolveUniforms();
+		}
+
 		nlohmann::json result ={
 			{ "guid", GetGUID().str() },
 			{ "name", Name },
 			{ "shader", _shader ? _shader->GetGUID().str() : "null" },
+			{ "keywords", _keywords },
 			{ "parameters", nlohmann::json() }
 		};
 
@@ -153,17 +288,180 @@ namespace Gameplay {
 	{
 		UniformData& data = _uniforms[name];
 		if (data.Location == -2) {
-			Shader::UniformInfo uniform;
-			if (_shader->FindUniform(name, &uniform)) {
-				data = UniformData(name, _shader);
-			} else {
+			data = UniformData(name, _program);
+			if (data.Type == ShaderDataType::None) {
 				data.Location = -1;
 			}
+			_layoutDirty = true;
 		}
 		return data;
 	}
 
-	void Material::UniformData::RenderImGui() {
+	bool Material::_IsShaderPending() const {
+		return _program != nullptr && _program->GetStatus() == ShaderStatus::Compiling;
+	}
+
+	void Material::_ResolveUniforms() {
+		_resolved = true;
+		_InitBlock();
+
+		for (auto& [key, value] : _pendingParameters.items()) {
+			// Try loading a uniform from the blob, if successful, store it
+			Material::UniformData uniform = Material::UniformData::FromJson(value, key, _program);
+			if (uniform.Location != -2) {
+				_uniforms[key] = uniform;
+				_layoutDirty = true;
+			}
+		}
+		_pendingParameters = nlohmann::json();
+
+		// Fill in the material block with the values we just loaded
+		for (auto& [key, uniform] : _uniforms) {
+			_PackUniform(uniform);
+		}
+
+		// Values that were set in code go last, since they were set after the material was loaded
+		for (const PendingValue& pending : _pendingValues) {
+			if (pending.Type == ShaderDataType::None) {
+				Set(pending.Name, pending.Type, &pending.Texture, 1);
+			} else {
+				Set(pending.Name, pending.Type, pending.Data.data(), pending.ArraySize);
+			}
+		}
+		_pendingValues.clear();
+	}
+
+	void Material::_SelectVariant() {
+		Shader::Sptr program = nullptr;
+		if (_shader != nullptr) {
+			Shader::KeywordMask mask = 0;
+			for (const std::string& keyword : _keywords) {
+				mask |= _shader->GetKeywordMask(keyword);
+			}
+			program = _shader->GetVariant(mask);
+		}
+		if (program == _program && _program != nullptr) {
+			return;
+		}
+
+		// Uniform locations and block offsets are different in every variant, so the values we already
+		// have need to be looked up again, just like values that were set before the shader was ready
+		if (_resolved) {
+			for (auto& [name, uniform] : _uniforms) {
+				if (uniform.Type == ShaderDataType::None) {
+					continue;
+				}
+				PendingValue pending;
+				pending.Name = name;
+				pending.ArraySize = uniform.ArraySize > 1 ? uniform.ArraySize : 1;
+				if (uniform.IsTextureResource()) {
+					pending.Type = ShaderDataType::None;
+					pending.Texture = uniform.TextureAsset;
+				} else {
+					pending.Type = uniform.Type;
+					const uint8_t* bytes = uniform.ArraySize > 1 ? (const uint8_t*)uniform.ArrayBlock : uniform.Value;
+					pending.Data.assign(bytes, bytes + ShaderDataTypeSize(uniform.Type) * pending.ArraySize);
+				}
+				_pendingValues.push_back(pending);
+			}
+		}
+		_uniforms.clear();
+		_textures.clear();
+		_programUniforms.clear();
+		_layoutDirty = true;
+		_programUniformsDirty = true;
+		_resolved = false;
+
+		_program = program;
+		if (!_IsShaderPending()) {
+			_ResolveUniforms();
+		}
+	}
+
+	void Material::_InitBlock() {
+		_blockData.clear();
+		_blockBuffer = nullptr;
+		_blockDirty = false;
+
+		if (_program != nullptr) {
+			const Shader::UniformBlockInfo* block = _program->FindUniformBlock(MATERIAL_BLOCK_NAME);
+			if (block != nullptr && block->SizeInBytes > 0) {
+				_blockData.resize(block->SizeInBytes, 0);
+				_blockBuffer = std::make_shared<AbstractUniformBuffer>(block->SizeInBytes);
+				_blockDirty = true;
+			}
+		}
+	}
+
+	void Material::_PackUniform(const UniformData& uniform) {
+		if (uniform.BlockOffset == -1 || _blockData.empty()) {
+			return;
+		}
+
+		const uint8_t* source = uniform.ArraySize > 1 ? (const uint8_t*)uniform.ArrayBlock : uniform.Value;
+		const size_t elementSize = ShaderDataTypeSize(uniform.Type);
+		const ShaderDataTypecode typeCode = GetShaderDataTypeCode(uniform.Type);
+		const int count = uniform.ArraySize > 1 ? (int)uniform.ArraySize : 1;
+
+		for (int ix = 0; ix < count; ix++) {
+			const uint8_t* element = source + elementSize * ix;
+			uint8_t* dest = _blockData.data() + uniform.BlockOffset + (size_t)uniform.ArrayStride * ix;
+
+			// Matrix columns are padded out in std140, so we copy them one at a time
+			if (typeCode == ShaderDataTypecode::Matrix || typeCode == ShaderDataTypecode::MatrixD) {
+				const uint32_t columns = ((uint32_t)uniform.Type & ShaderDataType_Size2Mask) >> 3;
+				const size_t columnSize = elementSize / columns;
+				LOG_ASSERT(dest + uniform.MatrixStride * (columns - 1) + columnSize <= _blockData.data() + _blockData.size(), "Uniform \"{}\" is outside of the material block", uniform.Name);
+				for (uint32_t c = 0; c < columns; c++) {
+					memcpy(dest + (size_t)uniform.MatrixStride * c, element + columnSize * c, columnSize);
+				}
+			}
+			// Bools are a single byte on our side, but 4 bytes in a block
+			else if (typeCode == ShaderDataTypecode::Bool) {
+				const uint32_t components = ShaderDataTypeComponentCount(uniform.Type);
+				LOG_ASSERT(dest + components * sizeof(uint32_t) <= _blockData.data() + _blockData.size(), "Uniform \"{}\" is outside of the material block", uniform.Name);
+				for (uint32_t c = 0; c < components; c++) {
+					uint32_t value = element[c] ? 1 : 0;
+					memcpy(dest + sizeof(uint32_t) * c, &value, sizeof(uint32_t));
+				}
+			}
+			else {
+				LOG_ASSERT(dest + elementSize <= _blockData.data() + _blockData.size(), "Uniform \"{}\" is outside of the material block", uniform.Name);
+				memcpy(dest, element, elementSize);
+			}
+		}
+		_blockDirty = true;
+	}
+
+	void Material::_RebuildLayout() {
+		_textures.clear();
+		_programUniforms.clear();
+
+		for (auto& [name, data] : _uniforms) {
+			if (data.Type == ShaderDataType::None || data.Location < 0) {
+				continue;
+			}
+			if (data.IsTextureResource()) {
+				_textures.push_back({ &data, 0 });
+			} else if (data.BlockOffset == -1) {
+				_programUniforms.push_back(&data);
+			}
+		}
+
+		// Hand out units in location order, after the reserved slots
+		std::sort(_textures.begin(), _textures.end(), [](const TextureBinding& a, const TextureBinding& b) {
+			return a.Uniform->Location < b.Uniform->Location;
+		});
+		for (size_t ix = 0; ix < _textures.size(); ix++) {
+			_textures[ix].Slot = RESERVED_TEXTURE_SLOTS + (int)ix;
+		}
+
+		_layoutDirty = false;
+		_programUniformsDirty = true;
+	}
+
+	bool Material::UniformData::RenderImGui() {
+		bool changed = false;
 		ImGui::PushID(Name.c_str());
 
 		// Will store names for fields
@@ -218,7 +516,7 @@ namespace Gameplay {
 				case ShaderDataTypecode::Bool:
 					for (int e = 0; e < numElements; e++) {
 						ImGui::PushID(e);
-						ImGui::Checkbox("", ((bool*)elem) + e);
+						changed |= ImGui::Checkbox("", ((bool*)elem) + e);
 						if (e < numElements - 1) { ImGui::SameLine(); }
 						ImGui::PopID();
 					}
@@ -226,7 +524,7 @@ namespace Gameplay {
 				case ShaderDataTypecode::Float:
 					for (int e = 0; e < numElements; e++) {
 						ImGui::PushID(e);
-						ImGui::DragFloat("", ((float*)elem) + e, 0.1f);
+						changed |= ImGui::DragFloat("", ((float*)elem) + e, 0.1f);
 						if (e < numElements - 1) { ImGui::SameLine(); }
 						ImGui::PopID();
 					}
@@ -234,7 +532,7 @@ namespace Gameplay {
 				case ShaderDataTypecode::Double:
 					for (int e = 0; e < numElements; e++) {
 						ImGui::PushID(e);
-						ImGui::DragScalar("", ImGuiDataType_Double, ((double*)elem) + e, 0.1f);
+						changed |= ImGui::DragScalar("", ImGuiDataType_Double, ((double*)elem) + e, 0.1f);
 						if (e < numElements - 1) { ImGui::SameLine(); }
 						ImGui::PopID();
 					}
@@ -242,7 +540,7 @@ namespace Gameplay {
 				case ShaderDataTypecode::Int:
 					for (int e = 0; e < numElements; e++) {
 						ImGui::PushID(e);
-						ImGui::DragScalar("", ImGuiDataType_S32, ((int*)elem) + e, 0.1f);
+						changed |= ImGui::DragScalar("", ImGuiDataType_S32, ((int*)elem) + e, 0.1f);
 						if (e < numElements - 1) { ImGui::SameLine(); }
 						ImGui::PopID();
 					}
@@ -250,7 +548,7 @@ namespace Gameplay {
 				case ShaderDataTypecode::Uint:
 					for (int e = 0; e < numElements; e++) {
 						ImGui::PushID(e);
-						ImGui::DragScalar("", ImGuiDataType_U32, ((int*)elem) + e, 0.1f);
+						changed |= ImGui::DragScalar("", ImGuiDataType_U32, ((int*)elem) + e, 0.1f);
 						if (e < numElements - 1) { ImGui::SameLine(); }
 						ImGui::PopID();
 					}
@@ -270,6 +568,8 @@ namespace Gameplay {
 			ImGui::Unindent();
 		}
 		ImGui::PopID();
+
+		return changed;
 	}
 
 	////////////////////////////////////////////////////////////////
@@ -307,6 +607,28 @@ namespace Gameplay {
 			if (ArraySize > 1) {
 				ArrayBlock = malloc(ShaderDataTypeSize(Type) * ArraySize);
 			}
+			return;
+		}
+
+		// Otherwise it may be a member of the material block, where location is it's offset in the block
+		const Shader::UniformBlockInfo* block = shader != nullptr ? shader->FindUniformBlock(MATERIAL_BLOCK_NAME) : nullptr;
+		if (block != nullptr) {
+			for (const Shader::UniformInfo& member : block->SubUniforms) {
+				if (member.Name == uniformName) {
+					Name = uniformName;
+					Location = -1;
+					BlockOffset = member.Location;
+					ArrayStride = member.ArrayStride;
+					MatrixStride = member.MatrixStride;
+					Type = member.Type;
+					ArraySize = member.ArraySize;
+
+					if (ArraySize > 1) {
+						ArrayBlock = malloc(ShaderDataTypeSize(Type) * ArraySize);
+					}
+					return;
+				}
+			}
 		}
 	}
 
@@ -315,6 +637,9 @@ namespace Gameplay {
 	{
 		Name = other.Name;
 		Location = other.Location;
+		BlockOffset = other.BlockOffset;
+		ArrayStride = other.ArrayStride;
+		MatrixStride = other.MatrixStride;
 		ArraySize = other.ArraySize;
 		Type = other.Type;
 
@@ -333,10 +658,13 @@ namespace Gameplay {
 	Material::UniformData::UniformData(UniformData&& other) :
 		TextureAsset(nullptr) 
 	{
-		Name      = other.Name;
-		Location  = other.Location;
-		ArraySize = other.ArraySize;
-		Type      = other.Type;
+		Name         = other.Name;
+		Location     = other.Location;
+		BlockOffset  = other.BlockOffset;
+		ArrayStride  = other.ArrayStride;
+		MatrixStride = other.MatrixStride;
+		ArraySize    = other.ArraySize;
+		Type         = other.Type;
 
 		if (GetShaderDataTypeCode(Type) == ShaderDataTypecode::Texture) {
 			TextureAsset = other.TextureAsset;
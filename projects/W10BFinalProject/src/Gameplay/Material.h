@@ -1,7 +1,9 @@
 #pragma once
 #include <memory>
+#include <vector>
 #include "Graphics/Shader.h"
 #include "Graphics/ITexture.h"
+#include "Graphics/UniformBuffer.h"
 
 namespace Gameplay {
 	/// <summary>
@@ -18,6 +20,15 @@ namespace Gameplay {
 		/// as the environment map. We'll specify a number of reserved slots here
 		/// </summary>
 		static const int RESERVED_TEXTURE_SLOTS = 2;
+		/// <summary>
+		/// The uniform block that materials pack their non-texture parameters into, shaders should
+		/// declare it as a std140 block bound to MATERIAL_UBO_BINDING
+		/// </summary>
+		static constexpr const char* MATERIAL_BLOCK_NAME = "b_MaterialUniforms";
+		/// <summary>
+		/// The UBO binding slot for material parameter blocks
+		/// </summary>
+		static const int MATERIAL_UBO_BINDING = 3;
 
 		/// <summary>
 		/// A human readable name for the material
@@ -33,6 +44,7 @@ namespace Gameplay {
 		/// </summary>
 		/// <param name="shader">The shader for the material</param>
 		Material(const Shader::Sptr& shader);
+		virtual ~Material();
 
 		/// <summary>
 		/// Sets a material parameter with the given name and type
@@ -59,10 +71,39 @@ namespace Gameplay {
 		/// Gets the shader that this material is using
 		/// </summary>
 		const Shader::Sptr& GetShader() const;
+		/// <summary>
+		/// Gets the shader that should be bound when drawing with this material. This is the variant of
+		/// our shader for our keywords, or the fallback shader until that variant has finished compiling
+		/// </summary>
+		const Shader::Sptr& GetActiveShader() const;
+
+		/// <summary>
+		/// Enables or disables a keyword, which selects the variant of the shader that the material
+		/// draws with. The keyword must be declared by the shader (see Shader::DeclareKeywords)
+		/// Parameters that have already been set are kept when the variant changes
+		/// </summary>
+		/// <param name="keyword">The keyword to enable or disable</param>
+		/// <param name="enabled">True if the keyword should be enabled</param>
+		void SetKeyword(const std::string& keyword, bool enabled = true);
+		/// <summary>
+		/// Returns true if the given keyword is enabled for this material
+		/// </summary>
+		bool IsKeywordEnabled(const std::string& keyword) const;
+		/// <summary>
+		/// Gets all of the keywords that are enabled for this material
+		/// </summary>
+		const std::vector<std::string>& GetKeywords() const { return _keywords; }
+
+		/// <summary>
+		/// Sets the shader that materials will draw with while their own shader is compiling, this
+		/// should not be part of a compile batch, and can't rely on any material parameters
+		/// </summary>
+		static void SetFallbackShader(const Shader::Sptr& shader) { __FallbackShader = shader; }
+		static const Shader::Sptr& GetFallbackShader() { return __FallbackShader; }
 
 		/// <summary>
 		/// Handles applying this material's state to the OpenGL pipeline
-		/// Will bind the shader, update material uniforms, and bind textures
+		/// Will bind textures and the material's parameter block, re-uploading only what has changed
 		/// </summary>
 		virtual void Apply();
 
@@ -95,6 +136,11 @@ namespace Gameplay {
 			std::string    Name;
 			// Location of the uniform within the shader
 			int            Location = -2;
+			// Offset of the uniform within the material block, or -1 if it's not in the block
+			int            BlockOffset = -1;
+			// Byte strides between array elements and matrix columns within the material block
+			int            ArrayStride = 0;
+			int            MatrixStride = 0;
 			union {
 				// A space to store non-array values, can store up to a dmat4
 				uint8_t        Value[128];
@@ -128,7 +174,8 @@ namespace Gameplay {
 			/// <summary>
 			/// Renders GUI for this uniform
 			/// </summary>
-			void RenderImGui();
+			/// <returns>True if the value was modified</returns>
+			bool RenderImGui();
 
 			/// <summary>
 			/// Converts this uniform into a JSON representation
@@ -169,11 +216,72 @@ namespace Gameplay {
 		/// </summary>
 		Shader::Sptr    _shader;
 		/// <summary>
+		/// The variant of the shader for our keywords, this is what our uniforms are looked up in
+		/// </summary>
+		Shader::Sptr    _program;
+		/// <summary>
+		/// The keywords that are enabled for this material
+		/// </summary>
+		std::vector<std::string> _keywords;
+		/// <summary>
 		/// The uniforms that the material will be modifying
 		/// </summary>
 		std::unordered_map<std::string, UniformData> _uniforms;
 
+		// A texture uniform and the unit that it gets bound to
+		struct TextureBinding {
+			UniformData* Uniform;
+			int          Slot;
+		};
+		// Texture uniforms sorted by location, so that materials sharing a shader use the same units
+		std::vector<TextureBinding> _textures;
+		// Uniforms that live in the program rather than the material block
+		std::vector<UniformData*>   _programUniforms;
+		// Set when uniforms are added, and the lists above need to be rebuilt
+		bool                        _layoutDirty;
+		// Set when a program uniform or texture unit has changed, and needs to be re-sent
+		bool                        _programUniformsDirty;
+
+		// CPU side copy of the material block, laid out to match the shader's introspected std140 layout
+		std::vector<uint8_t>        _blockData;
+		AbstractUniformBuffer::Sptr _blockBuffer;
+		// Set when _blockData has changed since the last upload
+		bool                        _blockDirty;
+
+		// Program uniforms are shared by all materials using a shader, so we track which material last
+		// sent it's values to each shader
+		inline static std::unordered_map<const Shader*, const Material*> __ProgramUniformOwners;
+
+		inline static Shader::Sptr __FallbackShader = nullptr;
+
+		// A value that was set before the shader finished compiling, and we knew what it's uniforms are
+		struct PendingValue {
+			std::string          Name;
+			ShaderDataType       Type;
+			std::vector<uint8_t> Data;
+			size_t               ArraySize;
+			// Textures are set without a type, so we hold on to the texture itself
+			ITexture::Sptr       Texture;
+		};
+		// Set once we've looked up our uniforms in the shader, which has to wait for it to finish compiling
+		bool                      _resolved;
+		std::vector<PendingValue> _pendingValues;
+		// Parameters loaded from JSON that are waiting on the shader
+		nlohmann::json            _pendingParameters;
+
 		UniformData& _GetUniform(const std::string& name);
+		// Returns true if our shader is still being compiled
+		bool _IsShaderPending() const;
+		// Sets up the material block and applies any values that were waiting on the shader
+		void _ResolveUniforms();
+		// Picks the shader variant for our keywords, and moves our values over to it
+		void _SelectVariant();
+		// Creates the material block for the current shader, if it has one
+		void _InitBlock();
+		// Copies a uniform's value into the material block
+		void _PackUniform(const UniformData& uniform);
+		// Rebuilds the texture and program uniform lists
+		void _RebuildLayout();
 
 	};
 }
\ No newline at end of file
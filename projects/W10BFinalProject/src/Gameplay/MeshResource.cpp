@@ -2,24 +2,60 @@
 #include <filesystem>
 
 #include "Utils/ObjLoader.h"
+#include "Utils/MeshOptimizer.h"
+#include "Graphics/GeometryArena.h"
 
 namespace Gameplay {
+	namespace {
+		// 64 bit FNV-1a, used for hashing the mesh geometry
+		uint64_t HashBytes(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull) {
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+			for (size_t ix = 0; ix < size; ix++) {
+				hash = (hash ^ bytes[ix]) * 0x100000001b3ull;
+			}
+			return hash;
+		}
+	}
+
 	MeshResource::MeshResource() :
 		IResource(),
 		Filename(""),
 		MeshBuilderParams(std::vector<MeshBuilderParam>()),
+		Optimization(MeshOptimizationSettings()),
+		Format(VertexFormat::Full),
+		LodSettings(MeshLodSettings()),
+		KeepGeometry(true),
 		Mesh(nullptr),
-		BulletTriMesh(nullptr)
+		Lods(std::vector<MeshLod>()),
+		BoundsCenter(glm::vec3(0.0f)),
+		BoundsRadius(0.0f),
+		BulletTriMesh(nullptr),
+		_geometry(nullptr),
+		_geometryRef(),
+		_geometryHash(0)
 	{ }
 
-	MeshResource::MeshResource(const std::string& filename) :
+	MeshResource::MeshResource(const std::string& filename, const MeshOptimizationSettings& optimization, VertexFormat format, const MeshLodSettings& lods) :
 		IResource(),
 		Filename(filename),
 		MeshBuilderParams(std::vector<MeshBuilderParam>()),
+		Optimization(optimization),
+		Format(format),
+		LodSettings(lods),
+		KeepGeometry(true),
 		Mesh(nullptr),
-		BulletTriMesh(nullptr)
+		Lods(std::vector<MeshLod>()),
+		BoundsCenter(glm::vec3(0.0f)),
+		BoundsRadius(0.0f),
+		BulletTriMesh(nullptr),
+		_geometry(nullptr),
+		_geometryRef(),
+		_geometryHash(0)
 	{
-		Mesh = ObjLoader::LoadFromFile(filename);
+		MeshBuilder<VertexPosNormTexCol> mesh;
+		if (ObjLoader::LoadMeshData(filename, mesh)) {
+			_Bake(mesh);
+		}
 	}
 
 	MeshResource::~MeshResource() = default;
@@ -36,12 +72,24 @@ namespace Gameplay {
 		} else {
 			result["filename"] = Filename.empty() ? "null" : Filename;
 		}
+		result["optimization"] = Optimization.ToJson();
+		result["vertex_format"] = ~Format;
+		result["lods"] = LodSettings.ToJson();
+		result["keep_geometry"] = KeepGeometry;
 		return result;
 	}
 
 	MeshResource::Sptr MeshResource::FromJson(const nlohmann::json & blob)
 	{
 		MeshResource::Sptr result = std::make_shared<MeshResource>();
+		if (blob.contains("optimization") && blob["optimization"].is_object()) {
+			result->Optimization = MeshOptimizationSettings::FromJson(blob["optimization"]);
+		}
+		result->Format = JsonParseEnum(VertexFormat, blob, "vertex_format", VertexFormat::Full);
+		if (blob.contains("lods") && blob["lods"].is_object()) {
+			result->LodSettings = MeshLodSettings::FromJson(blob["lods"]);
+		}
+		result->KeepGeometry = JsonGet(blob, "keep_geometry", result->KeepGeometry);
 		if (blob.contains("params") && blob["params"].is_array()) {
 			std::vector<nlohmann::json> meshbuilderParams = blob["params"].get<std::vector<nlohmann::json>>();
 			MeshBuilder<VertexPosNormTexCol> mesh;
@@ -50,14 +98,17 @@ namespace Gameplay {
 				result->MeshBuilderParams.push_back(p);
 				MeshFactory::AddParameterized(mesh, p);
 			}
-			result->Mesh = mesh.Bake();
+			result->_Bake(mesh);
 		} else {
 			result->Filename = JsonGet<std::string>(blob, "filename", "null");
 			if (result->Filename != "null" && std::filesystem::exists(result->Filename)) {
 				#ifdef OPTIMIZED_OBJ_LOADER
 				result->Mesh = OptimizedObjLoader::LoadFromFile(result->Filename);
 				#else
-				result->Mesh = ObjLoader::LoadFromFile(result->Filename);
+				MeshBuilder<VertexPosNormTexCol> mesh;
+				if (ObjLoader::LoadMeshData(result->Filename, mesh)) {
+					result->_Bake(mesh);
+				}
 				#endif
 
 			}
@@ -70,7 +121,159 @@ namespace Gameplay {
 		for (auto& param : MeshBuilderParams) {
 			MeshFactory::AddParameterized(mesh, param);
 		}
-		Mesh = mesh.Bake();
+		_Bake(mesh);
+	}
+
+	int MeshResource::GetLodCount() const {
+		return Mesh == nullptr ? 0 : 1 + static_cast<int>(Lods.size());
+	}
+
+	const VertexArrayObject::Sptr& MeshResource::GetLodMesh(int level) const {
+		return (level <= 0 || Lods.size() == 0) ? Mesh : Lods[std::min(level, (int)Lods.size()) - 1].Mesh;
+	}
+
+	MeshGeometry::Sptr MeshResource::GetGeometry() {
+		if (_geometry != nullptr) {
+			return _geometry;
+		}
+
+		// Someone else may still be holding on to the geometry from a previous request
+		MeshGeometry::Sptr result = _geometryRef.lock();
+		if (result != nullptr) {
+			return result;
+		}
+
+		// Re-create the mesh data from our source, making sure to run the same optimization pass
+		// so that the vertex order matches what was uploaded
+		MeshBuilder<VertexPosNormTexCol> mesh;
+		if (MeshBuilderParams.size() > 0) {
+			for (auto& param : MeshBuilderParams) {
+				MeshFactory::AddParameterized(mesh, param);
+			}
+		} else if (Filename.empty() || !ObjLoader::LoadMeshData(Filename, mesh)) {
+			LOG_WARN("Unable to regenerate geometry for mesh resource, no source data is available");
+			return nullptr;
+		}
+		if (Optimization.Enabled) {
+			mesh.Optimize(Optimization);
+		}
+
+		result = _ExtractGeometry(mesh);
+		_geometryRef = result;
+		return result;
+	}
+
+	uint64_t MeshResource::GetGeometryHash() const {
+		return _geometryHash;
+	}
+
+	MeshGeometry::Sptr MeshResource::_ExtractGeometry(const MeshBuilder<VertexPosNormTexCol>& mesh) {
+		std::shared_ptr<MeshGeometry> result = std::make_shared<MeshGeometry>();
+		result->Positions.reserve(mesh.GetVertexCount());
+		for (size_t ix = 0; ix < mesh.GetVertexCount(); ix++) {
+			result->Positions.push_back(mesh.GetVertexDataPtr()[ix].Position);
+		}
+		if (mesh.GetIndexCount() > 0) {
+			result->Indices.assign(mesh.GetIndexDataPtr(), mesh.GetIndexDataPtr() + mesh.GetIndexCount());
+		} else {
+			result->Indices.resize(mesh.GetVertexCount());
+			for (size_t ix = 0; ix < result->Indices.size(); ix++) {
+				result->Indices[ix] = static_cast<uint32_t>(ix);
+			}
+		}
+		result->Hash = HashBytes(result->Positions.data(), result->Positions.size() * sizeof(glm::vec3));
+		result->Hash = HashBytes(result->Indices.data(), result->Indices.size() * sizeof(uint32_t), result->Hash);
+		return result;
+	}
+
+	void MeshResource::_Bake(MeshBuilder<VertexPosNormTexCol>& mesh) {
+		Lods.clear();
+		_geometry = nullptr;
+		_geometryRef.reset();
+		_geometryHash = 0;
+		if (mesh.GetVertexCount() == 0) {
+			Mesh = nullptr;
+			return;
+		}
+
+		// Optimize up front so that the vertex order is final before we generate our LOD index buffers
+		if (Optimization.Enabled) {
+			mesh.Optimize(Optimization);
+		}
+
+		// Keep a CPU copy of the final geometry, other systems (ex: physics) can borrow this instead of
+		// reading back from the GPU
+		MeshGeometry::Sptr geometry = _ExtractGeometry(mesh);
+		_geometryRef = geometry;
+		_geometryHash = geometry->Hash;
+		if (KeepGeometry) {
+			_geometry = geometry;
+		}
+		const std::vector<glm::vec3>& positions = geometry->Positions;
+
+		// Calculate the bounding sphere, used for selecting LODs at runtime
+		glm::vec3 min = positions[0];
+		glm::vec3 max = min;
+		for (const glm::vec3& pos : positions) {
+			min = glm::min(min, pos);
+			max = glm::max(max, pos);
+		}
+		BoundsCenter = (min + max) / 2.0f;
+		BoundsRadius = 0.0f;
+		for (const glm::vec3& pos : positions) {
+			BoundsRadius = glm::max(BoundsRadius, glm::length(pos - BoundsCenter));
+		}
+
+		// Upload the full detail mesh, we've already run the optimization pass
+		MeshOptimizationSettings bakeSettings = Optimization;
+		bakeSettings.Enabled = false;
+		Mesh = mesh.Bake(bakeSettings, Format);
+		// Copy the mesh into the shared buffers as well, so it can be drawn with multi-draw indirect
+		GeometryArena::Register(Mesh);
+
+		// LODs need indices to simplify
+		if (LodSettings.LevelCount <= 0 || mesh.GetIndexCount() == 0) {
+			return;
+		}
+
+		std::vector<uint32_t> previous(mesh.GetIndexDataPtr(), mesh.GetIndexDataPtr() + mesh.GetIndexCount());
+		const VertexArrayObject::VertexBufferBinding* vertices = Mesh->GetBufferBinding(AttribUsage::Position);
+		float screenSize = LodSettings.ScreenSizeStart;
+
+		for (int level = 1; level <= LodSettings.LevelCount; level++) {
+			size_t target = static_cast<size_t>((previous.size() / 3) * LodSettings.Reduction) * 3;
+			float error = 0.0f;
+			std::vector<uint32_t> indices = MeshSimplifier::Simplify(positions, previous, target, LodSettings.MaxError * BoundsRadius, &error);
+
+			// If we failed to remove any triangles, further levels would just be copies
+			if (indices.size() == 0 || indices.size() >= previous.size()) {
+				break;
+			}
+
+			if (Optimization.Enabled && Optimization.OptimizeVertexCache) {
+				MeshOptimizer::OptimizeVertexCache(indices.data(), indices.size(), positions.size(), Optimization.CacheSize);
+			}
+
+			// LODs share the vertex buffer with the full detail mesh, and only need a new index buffer. Since
+			// the layout is the same they also share the GL VAO, so switching LODs only swaps the index buffer
+			VertexArrayObject::Sptr vao = VertexArrayObject::Create();
+			vao->AddVertexBuffer(vertices->Buffer, vertices->Attributes);
+			vao->SetIndexBuffer(MeshBuilder<VertexPosNormTexCol>::BakeIndices(indices.data(), indices.size(), positions.size()));
+			vao->SetVDecl(Mesh->GetVDecl());
+			vao->SetDequantizeTransform(Mesh->GetDequantizeTransform());
+			GeometryArena::Register(vao);
+
+			MeshLod lod;
+			lod.Mesh = vao;
+			lod.ScreenSize = screenSize;
+			lod.Error = error;
+			Lods.push_back(lod);
+
+			LOG_TRACE("Generated LOD {} for mesh \"{}\" ({} -> {} triangles, error {})", level, Filename, previous.size() / 3, indices.size() / 3, error);
+
+			previous.swap(indices);
+			screenSize *= 0.5f;
+		}
 	}
 
 	void MeshResource::AddParam(const MeshBuilderParam & param) {
@@ -2,11 +2,38 @@
 #include "Utils/ResourceManager/IResource.h"
 #include "Graphics/VertexArrayObject.h"
 #include "Utils/MeshFactory.h"
+#include "Utils/MeshSimplifier.h"
 
 // bullet triangle mesh pre-declaration
 class btTriangleMesh;
 
 namespace Gameplay {
+	/// <summary>
+	/// An immutable CPU-side copy of a mesh's geometry, allowing systems like physics to access
+	/// the mesh without reading back from OpenGL. Shared between all consumers of a mesh
+	/// </summary>
+	struct MeshGeometry {
+		typedef std::shared_ptr<const MeshGeometry> Sptr;
+
+		/// <summary>
+		/// The object space positions of the mesh's vertices
+		/// </summary>
+		std::vector<glm::vec3> Positions;
+		/// <summary>
+		/// The triangle list indices into Positions, non-indexed meshes will have sequential indices
+		/// </summary>
+		std::vector<uint32_t>  Indices;
+		/// <summary>
+		/// A hash of the positions and indices, can be used to key data that is derived from the geometry
+		/// </summary>
+		uint64_t               Hash = 0;
+
+		/// <summary>
+		/// Gets the number of triangles in the geometry
+		/// </summary>
+		size_t GetTriangleCount() const { return Indices.size() / 3; }
+	};
+
 	/// <summary>
 	/// A mesh resource contains information on how to generate a VAO at runtime
 	/// It can either load a VAO from a file, or generate one using the mesh 
@@ -16,13 +43,28 @@ namespace Gameplay {
 	public:
 		typedef std::shared_ptr<MeshResource> Sptr;
 
+		/// <summary>
+		/// A reduced detail version of the mesh, sharing the vertex buffer of the full detail mesh
+		/// </summary>
+		struct MeshLod {
+			// The VAO for rendering this level
+			VertexArrayObject::Sptr Mesh;
+			// The projected screen size (as a fraction of the screen height) below which this level is used
+			float                   ScreenSize;
+			// The maximum error introduced by simplification, in object space units
+			float                   Error;
+		};
+
 		// Default constructor
 		MeshResource();
 		/// <summary>
 		/// Constructor for loading from file
 		/// </summary>
 		/// <param name="filename"></param>
-		MeshResource(const std::string& filename);
+		/// <param name="optimization">The optimization settings to apply when loading the mesh</param>
+		/// <param name="format">The vertex layout to upload the mesh with</param>
+		/// <param name="lods">The settings for generating a level of detail chain for the mesh</param>
+		MeshResource(const std::string& filename, const MeshOptimizationSettings& optimization = MeshOptimizationSettings(), VertexFormat format = VertexFormat::Full, const MeshLodSettings& lods = MeshLodSettings());
 
 		virtual ~MeshResource();
 
@@ -35,11 +77,41 @@ namespace Gameplay {
 		/// The mesh builder parameters if this mesh resource is created at runtime
 		/// </summary>
 		std::vector<MeshBuilderParam>   MeshBuilderParams;
+		/// <summary>
+		/// The settings for the optimization pass that is run before the mesh is uploaded
+		/// </summary>
+		MeshOptimizationSettings        Optimization;
+		/// <summary>
+		/// The vertex layout that the mesh is uploaded with, packed formats use less memory and bandwidth
+		/// at the cost of precision
+		/// </summary>
+		VertexFormat                    Format;
+		/// <summary>
+		/// The settings for generating the level of detail chain for this mesh
+		/// </summary>
+		MeshLodSettings                 LodSettings;
+		/// <summary>
+		/// True if the CPU-side geometry should be kept around after the mesh is uploaded. If false,
+		/// GetGeometry will regenerate it from the source file or parameters when requested
+		/// </summary>
+		bool                            KeepGeometry;
 
 		/// <summary>
 		/// The VAO for rendering this mesh in OpenGL
 		/// </summary>
 		VertexArrayObject::Sptr         Mesh;
+		/// <summary>
+		/// The reduced detail levels for the mesh, ordered from most to least detailed
+		/// </summary>
+		std::vector<MeshLod>            Lods;
+		/// <summary>
+		/// The center of the mesh's bounding sphere, in object space
+		/// </summary>
+		glm::vec3                       BoundsCenter;
+		/// <summary>
+		/// The radius of the mesh's bounding sphere, in object space
+		/// </summary>
+		float                           BoundsRadius;
 
 
 		/// <summary>
@@ -61,9 +133,52 @@ namespace Gameplay {
 		/// <param name="param">The parameter to add</param>
 		void AddParam(const MeshBuilderParam& param);
 
+		/// <summary>
+		/// Gets the number of levels of detail for this mesh, including the full detail mesh
+		/// </summary>
+		int GetLodCount() const;
+		/// <summary>
+		/// Gets the VAO for the given level of detail, where 0 is the full detail mesh. Levels
+		/// past the end of the chain will return the lowest detail level
+		/// </summary>
+		/// <param name="level">The level of detail to get</param>
+		const VertexArrayObject::Sptr& GetLodMesh(int level) const;
+
+		/// <summary>
+		/// Gets the CPU-side copy of this mesh's geometry, regenerating it from the mesh's source if it
+		/// was not kept. The result is shared with any other systems that are still holding on to it
+		/// </summary>
+		/// <returns>The geometry of the mesh, or nullptr if it could not be generated</returns>
+		MeshGeometry::Sptr GetGeometry();
+		/// <summary>
+		/// Gets the hash of this mesh's geometry, calculated when the mesh was baked. Unlike GetGeometry, this
+		/// never needs to regenerate the geometry, so it can be used to look up cached data cheaply
+		/// </summary>
+		/// <returns>The hash of the geometry, or 0 if the mesh has not been baked</returns>
+		uint64_t GetGeometryHash() const;
+
 		// Inherited from IResource
 
 		virtual nlohmann::json ToJson() const override;
 		static MeshResource::Sptr FromJson(const nlohmann::json& blob);
+
+	protected:
+		/// <summary>
+		/// Runs the optimization pass, uploads the mesh, and generates the LOD chain
+		/// </summary>
+		/// <param name="mesh">The mesh data to bake</param>
+		void _Bake(MeshBuilder<VertexPosNormTexCol>& mesh);
+		/// <summary>
+		/// Copies the positions and indices out of a mesh
+		/// </summary>
+		/// <param name="mesh">The mesh to copy the geometry from</param>
+		static MeshGeometry::Sptr _ExtractGeometry(const MeshBuilder<VertexPosNormTexCol>& mesh);
+
+		// Only set if KeepGeometry is true
+		MeshGeometry::Sptr           _geometry;
+		// Allows us to share the geometry with other systems, even if we aren't keeping it
+		std::weak_ptr<const MeshGeometry> _geometryRef;
+		// The hash of the geometry from the last bake, kept even if the geometry itself isn't
+		uint64_t                     _geometryHash;
 	};
 }
\ No newline at end of file
@@ -21,6 +21,11 @@ namespace Gameplay::Physics {
 		return new btBoxShape(btVector3(_extents.x, _extents.y, _extents.z));
 	}
 
+	bool BoxCollider::GetShapeParameters(glm::vec4& outParams) const {
+		outParams = glm::vec4(_extents, 0.0f);
+		return true;
+	}
+
 	void BoxCollider::FromJson(const nlohmann::json& data) {
 		_extents = ParseJsonVec3(data["extents"]);
 	}
@@ -35,6 +35,11 @@ namespace Gameplay::Physics {
 		return new btCapsuleShapeZ(_radius, _height);
 	}
 
+	bool CapsuleCollider::GetShapeParameters(glm::vec4& outParams) const {
+		outParams = glm::vec4(_radius, _height, 0.0f, 0.0f);
+		return true;
+	}
+
 
 	CapsuleCollider* CapsuleCollider::SetRadius(float value) {
 		_radius = value;
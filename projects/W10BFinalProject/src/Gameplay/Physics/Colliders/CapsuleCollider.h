@@ -25,6 +25,7 @@ namespace Gameplay::Physics {
 
 	protected:
 		virtual btCollisionShape* CreateShape() const override;
+		virtual bool GetShapeParameters(glm::vec4& outParams) const override;
 
 	private:
 		float _radius;
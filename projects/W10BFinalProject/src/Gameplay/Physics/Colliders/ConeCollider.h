@@ -42,6 +42,7 @@ namespace Gameplay::Physics {
 
 	protected:
 		virtual btCollisionShape* CreateShape() const override;
+		virtual bool GetShapeParameters(glm::vec4& outParams) const override;
 
 	private:
 		float _radius;
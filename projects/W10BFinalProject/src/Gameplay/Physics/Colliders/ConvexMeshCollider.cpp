@@ -1,13 +1,27 @@
 #include "ConvexMeshCollider.h"
-#include <BulletCollision/CollisionShapes/btShapeHull.h>
 
 #include "Gameplay/GameObject.h"
 #include "Gameplay/MeshResource.h"
 #include "Gameplay/Components/RenderComponent.h"
 
 #include "Utils/GlmBulletConversions.h"
+#include "Utils/ImGuiHelper.h"
 
 namespace Gameplay::Physics {
+	namespace {
+		// A compound of hulls that owns it's children, so that the whole thing can be shared through the
+		// CollisionShapeCache and deleted in one go when the last collider lets go of it
+		class HullCompoundShape : public btCompoundShape {
+		public:
+			HullCompoundShape(int initialChildCapacity) : btCompoundShape(true, initialChildCapacity) { }
+			virtual ~HullCompoundShape() {
+				for (int ix = 0; ix < getNumChildShapes(); ix++) {
+					delete getChildShape(ix);
+				}
+			}
+		};
+	}
+
 	ConvexMeshCollider::Sptr ConvexMeshCollider::Create() {
 		return std::shared_ptr<ConvexMeshCollider>(new ConvexMeshCollider());
 	}
@@ -16,28 +30,46 @@ namespace Gameplay::Physics {
 
 	ConvexMeshCollider::ConvexMeshCollider() :
 		ICollider(ColliderType::ConvexMesh),
-		_triMesh(nullptr)
+		_hullSettings(ConvexHullSettings()),
+		_hulls(nullptr),
+		_mesh()
 	{ }
 
 	btCollisionShape* ConvexMeshCollider::CreateShape() const {
-		// https://pybullet.org/Bullet/phpBB3/viewtopic.php?t=4513
-		if (_triMesh == nullptr) {
+		if (_hulls == nullptr || _hulls->Hulls.empty()) {
 			return nullptr;
 		}
-		btConvexShape* result = new btConvexTriangleMeshShape(_triMesh);
 
-		// The hull shape will calculate the convex hull that contains our shape
-		//btShapeHull* hull = new btShapeHull(result);
-		//float margin = result->getMargin();
-		//bool build = hull->buildHull(margin);
-		//if (!build) {
-		//	LOG_WARN("Failed to build hull for convex mesh");
-		//}
-		//delete hull;
+		// Bullet copies the points into the shape, so the hulls themselves can stay shared
+		auto makeHull = [](const std::vector<glm::vec3>& points) {
+			return new btConvexHullShape(&points[0].x, static_cast<int>(points.size()), sizeof(glm::vec3));
+		};
 
+		// The common case, no need to go through a compound shape
+		if (_hulls->Hulls.size() == 1) {
+			return makeHull(_hulls->Hulls[0]);
+		}
+
+		// Our mesh was decomposed into multiple hulls, so we group them together
+		btCompoundShape* result = new HullCompoundShape(static_cast<int>(_hulls->Hulls.size()));
+		btTransform identity;
+		identity.setIdentity();
+		for (const std::vector<glm::vec3>& points : _hulls->Hulls) {
+			result->addChildShape(identity, makeHull(points));
+		}
 		return result;
 	}
 
+	bool ConvexMeshCollider::GetShapeParameters(glm::vec4& outParams) const {
+		// The hulls fully describe the shape, so they're identified by the shape source instead
+		outParams = glm::vec4(0.0f);
+		return _hulls != nullptr && !_hulls->Hulls.empty();
+	}
+
+	uint64_t ConvexMeshCollider::GetShapeSource() const {
+		return _hulls != nullptr ? _hulls->Key : 0;
+	}
+
 	void ConvexMeshCollider::Awake(GameObject* context)
 	{
 		// Get the components from the gameobject that we'll need to generate the mesh
@@ -55,119 +87,61 @@ namespace Gameplay::Physics {
 			mesh = mesh->ColliderMeshData;
 		}
 
-		// We've already calculated the mesh, use existing
-		if (mesh->BulletTriMesh != nullptr) {
-			_triMesh = mesh->BulletTriMesh.get();
-		}
-		// We need to calculate the triangle mesh from the mesh data
-		else {
-			// Get the VAO from the mesh and make sure it exists
-			VertexArrayObject::Sptr vao = mesh->Mesh;
-			if (vao == nullptr) {
-				LOG_WARN("Mesh resource not fully configured!");
-				return;
-			}
-
-			// Get the vertex declaration from the VAO so we can pull out positions
-			const VertexArrayObject::VertexDeclaration& VDecl = vao->GetVDecl();
-			if (VDecl.size() == 0) {
-				LOG_WARN("Mesh does not have a vertex declaration, unable to determine position elements");
-				return;
-			}
+		_mesh = mesh;
+		_RebuildHulls();
+	}
 
-			// Get the attribute for positions from the vertex declaration
-			auto& it = std::find_if(VDecl.begin(), VDecl.end(), [](const BufferAttribute& attrib) {
-				return attrib.Usage == AttribUsage::Position;
-			});
-			if (it == VDecl.end()) {
-				LOG_WARN("Mesh vertex declaration does not have a position element");
-				return;
-			}
-			BufferAttribute posAttrib = *it;
-
-			// Get the VBO that contains our data about the position elements
-			const auto* vertBuff = vao->GetBufferBinding(AttribUsage::Position);
-			if (vertBuff != nullptr) {
-				// Shorthand our buffers
-				IndexBuffer::Sptr indexBuff = vao->GetIndexBuffer();
-				VertexBuffer::Sptr vertexBuff = vertBuff->Buffer;
-
-				// Create the bullet physics triangle mesh
-				_triMesh = new btTriangleMesh();
-
-				// Helper for extracting an int from a raw index buffer datastore
-				auto getBufferIndex = [](IndexBuffer::Sptr buff, uint8_t* dataStore, int offset) {
-					switch (buff->GetElementType())
-					{
-						case IndexType::UByte:
-							return (int)*(dataStore + offset);
-						case IndexType::UShort:
-							return (int)*(reinterpret_cast<uint16_t*>(dataStore) + offset);
-						case IndexType::UInt:
-							return (int)*(reinterpret_cast<uint32_t*>(dataStore) + offset);
-						case IndexType::Unknown:
-						default:
-							return 0;
-					}
-				};
-
-				// Allocate some space to read data from OpenGL and read our buffer data back into CPU memory
-				uint8_t* vertexStore = reinterpret_cast<uint8_t*>(malloc(vertexBuff->GetTotalSize()));
-				glGetNamedBufferSubData(vertexBuff->GetHandle(), 0, vertexBuff->GetTotalSize(), vertexStore);
-				_triMesh->preallocateVertices(vao->GetVertexCount());
-
-				// If our data is indexed, we use the index buffer to add our triangles
-				if (indexBuff != nullptr) {
-					// Allocate and read space for the indices
-					uint8_t* indexStore = reinterpret_cast<uint8_t*>(malloc(indexBuff->GetTotalSize()));
-					glGetNamedBufferSubData(indexBuff->GetHandle(), 0, indexBuff->GetTotalSize(), indexStore);
-
-					// Iterate over index triangles
-					for (int ix = 0; ix < indexBuff->GetElementCount(); ix+=3) {
-						// Extract index from the raw data
-						int i1 = getBufferIndex(indexBuff, indexStore, ix);
-						int i2 = getBufferIndex(indexBuff, indexStore, ix + 1);
-						int i3 = getBufferIndex(indexBuff, indexStore, ix + 2);
-
-						// Find the positions for the indices
-						glm::vec3 p1 = *reinterpret_cast<glm::vec3*>(vertexStore + (i1 * posAttrib.Stride) + posAttrib.Offset);
-						glm::vec3 p2 = *reinterpret_cast<glm::vec3*>(vertexStore + (i2 * posAttrib.Stride) + posAttrib.Offset);
-						glm::vec3 p3 = *reinterpret_cast<glm::vec3*>(vertexStore + (i3 * posAttrib.Stride) + posAttrib.Offset);
-
-						// Add the triangle
-						_triMesh->addTriangle(ToBt(p1), ToBt(p2), ToBt(p3));
-					}
-			
-					// Free the data we copied the indices into
-					free(indexStore);
+	void ConvexMeshCollider::_RebuildHulls() {
+		MeshResource::Sptr mesh = _mesh.lock();
+		if (mesh == nullptr) {
+			return;
+		}
 
-				}
-				// We only have vertex data, create triangles sequentially
-				else {
-					// Iterate over triangles, and add each to the mesh
-					for (int ix = 0; ix < vertexBuff->GetElementCount(); ix+=3) {
-						glm::vec3 p1 = *reinterpret_cast<glm::vec3*>(vertexStore + ((ix + 0) * posAttrib.Stride) + posAttrib.Offset);
-						glm::vec3 p2 = *reinterpret_cast<glm::vec3*>(vertexStore + ((ix + 1) * posAttrib.Stride) + posAttrib.Offset);
-						glm::vec3 p3 = *reinterpret_cast<glm::vec3*>(vertexStore + ((ix + 2) * posAttrib.Stride) + posAttrib.Offset);
-						_triMesh->addTriangle(ToBt(p1), ToBt(p2), ToBt(p3));
-					}
-				}
+		// The hull cache will share hulls between all colliders using this mesh, and will only borrow
+		// the geometry if nobody has built these hulls yet
+		_hulls = ConvexHullCache::Get(mesh, _hullSettings);
+		if (_hulls == nullptr) {
+			LOG_WARN("Mesh resource not fully configured!");
+		}
+		_isDirty = true;
+	}
 
-				// free our vertex store data
-				free(vertexStore);
+	const ConvexHullSettings& ConvexMeshCollider::GetHullSettings() const {
+		return _hullSettings;
+	}
 
-				// Store the bullet tri mesh in the MeshResource in case we want it later
-				mesh->BulletTriMesh = std::shared_ptr<btTriangleMesh>(_triMesh);
-			}
-		}
+	void ConvexMeshCollider::SetHullSettings(const ConvexHullSettings& value) {
+		_hullSettings = value;
+		_RebuildHulls();
 	}
 
 	void ConvexMeshCollider::FromJson(const nlohmann::json& data) {
+		if (data.contains("hull") && data["hull"].is_object()) {
+			_hullSettings = ConvexHullSettings::FromJson(data["hull"]);
+		}
 	}
 
 	void ConvexMeshCollider::ToJson(nlohmann::json& blob) const {
+		blob["hull"] = _hullSettings.ToJson();
 	}
 
 	void ConvexMeshCollider::DrawImGui() {
+		bool changed = false;
+		changed |= LABEL_LEFT(ImGui::DragInt, "Max Verts", &_hullSettings.MaxVertices, 1.0f, 0, 255);
+		changed |= LABEL_LEFT(ImGui::Checkbox, "Decompose", &_hullSettings.Decompose);
+		if (_hullSettings.Decompose) {
+			changed |= LABEL_LEFT(ImGui::DragInt, "Max Hulls", &_hullSettings.MaxHulls, 1.0f, 1, 64);
+			changed |= LABEL_LEFT(ImGui::DragFloat, "Concavity", &_hullSettings.MaxConcavity, 0.01f, 0.0f, 1.0f);
+		}
+		if (_hulls != nullptr) {
+			size_t vertexCount = 0;
+			for (const auto& hull : _hulls->Hulls) {
+				vertexCount += hull.size();
+			}
+			ImGui::Text("%d hull(s), %d vertices", (int)_hulls->Hulls.size(), (int)vertexCount);
+		}
+		if (changed) {
+			_RebuildHulls();
+		}
 	}
-}
+}
\ No newline at end of file
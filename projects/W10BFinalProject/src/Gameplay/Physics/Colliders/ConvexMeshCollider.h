@@ -1,10 +1,13 @@
 #pragma once
 
 #include "Gameplay/Physics/ICollider.h"
+#include "Gameplay/Physics/ConvexHullCache.h"
 
 namespace Gameplay::Physics {
 	/// <summary>
-	/// A complex collider type that allows us to construct collision hulls from arbitrary convex meshes
+	/// A complex collider type that allows us to construct collision hulls from arbitrary meshes. The
+	/// mesh is simplified down to one or more convex hulls, which are shared with any other colliders
+	/// that use the same mesh
 	/// </summary>
 	class ConvexMeshCollider final : public ICollider {
 	public:
@@ -12,6 +15,16 @@ namespace Gameplay::Physics {
 		static ConvexMeshCollider::Sptr Create();
 		virtual ~ConvexMeshCollider();
 
+		/// <summary>
+		/// Gets the settings used to build the hulls for this collider
+		/// </summary>
+		const ConvexHullSettings& GetHullSettings() const;
+		/// <summary>
+		/// Updates the settings used to build the hulls for this collider, and marks it as dirty
+		/// </summary>
+		/// <param name="value">The new hull settings</param>
+		void SetHullSettings(const ConvexHullSettings& value);
+
 		// Inherited from ICollider
 		virtual void Awake(GameObject* context) override;
 		virtual void DrawImGui() override;
@@ -19,9 +32,18 @@ namespace Gameplay::Physics {
 		virtual void FromJson(const nlohmann::json& data) override;
 
 	protected:
-		btTriangleMesh* _triMesh;
+		ConvexHullSettings  _hullSettings;
+		ConvexHullSet::Sptr _hulls;
+		// The mesh we're building hulls for, so we can rebuild if the settings change
+		std::weak_ptr<MeshResource> _mesh;
+
 		ConvexMeshCollider();
 
+		void _RebuildHulls();
+
 		virtual btCollisionShape* CreateShape() const override;
+		// Our shapes are shared with every other collider using the same set of hulls
+		virtual bool GetShapeParameters(glm::vec4& outParams) const override;
+		virtual uint64_t GetShapeSource() const override;
 	};
 }
\ No newline at end of file
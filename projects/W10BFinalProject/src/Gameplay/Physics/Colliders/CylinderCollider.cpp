@@ -33,6 +33,11 @@ namespace Gameplay::Physics {
 		return new btCylinderShapeZ(ToBt(_extents));
 	}
 
+	bool CylinderCollider::GetShapeParameters(glm::vec4& outParams) const {
+		outParams = glm::vec4(_extents, 0.0f);
+		return true;
+	}
+
 	CylinderCollider* CylinderCollider::SetHalfExtents(const glm::vec3 & value) {
 		_extents = value;
 		_isDirty = true;
@@ -22,6 +22,7 @@ namespace Gameplay::Physics {
 
 	protected:
 		virtual btCollisionShape* CreateShape() const override;
+		virtual bool GetShapeParameters(glm::vec4& outParams) const override;
 
 	private:
 		glm::vec3 _extents;
@@ -31,6 +31,11 @@ namespace Gameplay::Physics {
 		return new btStaticPlaneShape(btVector3(_normal.x, _normal.y, _normal.z), 0.0f);
 	}
 
+	bool PlaneCollider::GetShapeParameters(glm::vec4& outParams) const {
+		outParams = glm::vec4(_normal, 0.0f);
+		return true;
+	}
+
 	const glm::vec3& PlaneCollider::GetNormal() const {
 		return _normal;
 	}
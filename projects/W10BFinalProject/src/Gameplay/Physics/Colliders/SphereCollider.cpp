@@ -18,6 +18,11 @@ namespace Gameplay::Physics {
 		return new btSphereShape(_radius);
 	}
 
+	bool SphereCollider::GetShapeParameters(glm::vec4& outParams) const {
+		outParams = glm::vec4(_radius, 0.0f, 0.0f, 0.0f);
+		return true;
+	}
+
 	SphereCollider* SphereCollider::SetRadius(float value) {
 		_radius = value;
 		_isDirty = true;
@@ -0,0 +1,70 @@
+#include "TriangleMeshCollider.h"
+
+#include "Gameplay/GameObject.h"
+#include "Gameplay/MeshResource.h"
+#include "Gameplay/Components/RenderComponent.h"
+#include "Gameplay/Physics/RigidBody.h"
+
+#include "Utils/ImGuiHelper.h"
+
+namespace Gameplay::Physics {
+	TriangleMeshCollider::Sptr TriangleMeshCollider::Create() {
+		return std::shared_ptr<TriangleMeshCollider>(new TriangleMeshCollider());
+	}
+
+	TriangleMeshCollider::~TriangleMeshCollider() = default;
+
+	TriangleMeshCollider::TriangleMeshCollider() :
+		ICollider(ColliderType::ConcaveMesh),
+		_bvh(nullptr)
+	{ }
+
+	btCollisionShape* TriangleMeshCollider::CreateShape() const {
+		if (_bvh == nullptr) {
+			return nullptr;
+		}
+		// The scaled shape lets us share the BVH between colliders, our scale gets applied by PhysicsBase
+		return new btScaledBvhTriangleMeshShape(_bvh->Shape, btVector3(1.0f, 1.0f, 1.0f));
+	}
+
+	void TriangleMeshCollider::Awake(GameObject* context)
+	{
+		// Get the components from the gameobject that we'll need to generate the mesh
+		RenderComponent::Sptr renderer = context->Get<RenderComponent>();
+		MeshResource::Sptr mesh = (renderer != nullptr ? renderer->GetMeshResource() : nullptr);
+
+		// If we have no mesh, we can't create a collider for it!
+		if (mesh == nullptr) {
+			LOG_WARN("Mesh collider attached to gameobject without a mesh!");
+			return;
+		}
+
+		// If we have an explicit collider, grab that instead
+		if (mesh->ColliderMeshData != nullptr) {
+			mesh = mesh->ColliderMeshData;
+		}
+
+		RigidBody::Sptr body = context->Get<RigidBody>();
+		if (body != nullptr && body->GetType() == RigidBodyType::Dynamic) {
+			LOG_WARN("Triangle mesh colliders are not supported on dynamic bodies, use a convex mesh collider instead");
+		}
+
+		_bvh = TriangleMeshCache::Get(mesh);
+		if (_bvh == nullptr) {
+			LOG_WARN("Mesh resource not fully configured!");
+		}
+		_isDirty = true;
+	}
+
+	void TriangleMeshCollider::FromJson(const nlohmann::json& /*data*/) {
+	}
+
+	void TriangleMeshCollider::ToJson(nlohmann::json& /*blob*/) const {
+	}
+
+	void TriangleMeshCollider::DrawImGui() {
+		if (_bvh != nullptr && _bvh->Mesh != nullptr) {
+			ImGui::Text("%d triangles", _bvh->Mesh->getNumTriangles());
+		}
+	}
+}
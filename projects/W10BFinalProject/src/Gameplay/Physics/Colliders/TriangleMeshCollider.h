@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Gameplay/Physics/ICollider.h"
+#include "Gameplay/Physics/TriangleMeshCache.h"
+
+namespace Gameplay::Physics {
+	/// <summary>
+	/// A collider that uses a mesh's triangles directly, allowing for concave shapes. The BVH for the mesh
+	/// is shared with any other colliders using the same mesh, regardless of their scale.
+	///
+	/// Note that bullet only supports triangle meshes on static and kinematic bodies
+	/// </summary>
+	class TriangleMeshCollider final : public ICollider {
+	public:
+		typedef std::shared_ptr<TriangleMeshCollider> Sptr;
+		static TriangleMeshCollider::Sptr Create();
+		virtual ~TriangleMeshCollider();
+
+		// Inherited from ICollider
+		virtual void Awake(GameObject* context) override;
+		virtual void DrawImGui() override;
+		virtual void ToJson(nlohmann::json& blob) const override;
+		virtual void FromJson(const nlohmann::json& data) override;
+
+	protected:
+		TriangleMeshBvh::Sptr _bvh;
+
+		TriangleMeshCollider();
+
+		virtual btCollisionShape* CreateShape() const override;
+	};
+}
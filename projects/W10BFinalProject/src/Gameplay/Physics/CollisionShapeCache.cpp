@@ -0,0 +1,60 @@
+#include "Gameplay/Physics/CollisionShapeCache.h"
+
+#include "Utils/GlmBulletConversions.h"
+
+namespace Gameplay::Physics {
+	std::unordered_map<CollisionShapeCache::ShapeKey, std::weak_ptr<btCollisionShape>, CollisionShapeCache::ShapeKeyHash> CollisionShapeCache::_shapes;
+	size_t CollisionShapeCache::_pruneThreshold = 64;
+
+	size_t CollisionShapeCache::ShapeKeyHash::operator()(const ShapeKey& key) const {
+		size_t result = std::hash<int>()((int)key.Type);
+		auto combine = [&](float value) {
+			result ^= std::hash<float>()(value) + 0x9e3779b9 + (result << 6) + (result >> 2);
+		};
+		for (int ix = 0; ix < 4; ix++) {
+			combine(key.Params[ix]);
+		}
+		result ^= std::hash<uint64_t>()(key.Source) + 0x9e3779b9 + (result << 6) + (result >> 2);
+		for (int ix = 0; ix < 3; ix++) {
+			combine(key.Scale[ix]);
+		}
+		return result;
+	}
+
+	std::shared_ptr<btCollisionShape> CollisionShapeCache::Get(ColliderType type, const glm::vec4& params, const glm::vec3& scale, const ShapeFactory& factory, uint64_t source) {
+		ShapeKey key = { type, params, source, scale };
+
+		// If there's already a live shape that matches, share it
+		std::weak_ptr<btCollisionShape>& entry = _shapes[key];
+		std::shared_ptr<btCollisionShape> result = entry.lock();
+		if (result != nullptr) {
+			return result;
+		}
+
+		btCollisionShape* shape = factory();
+		if (shape == nullptr) {
+			return nullptr;
+		}
+		shape->setLocalScaling(ToBt(scale));
+		result = std::shared_ptr<btCollisionShape>(shape);
+		entry = result;
+
+		// Sweep out any shapes that are no longer in use, doubling the threshold each time keeps this amortized
+		if (_shapes.size() > _pruneThreshold) {
+			for (auto it = _shapes.begin(); it != _shapes.end();) {
+				it = it->second.expired() ? _shapes.erase(it) : std::next(it);
+			}
+			_pruneThreshold = std::max<size_t>(_shapes.size() * 2, 64);
+		}
+
+		return result;
+	}
+
+	size_t CollisionShapeCache::GetShapeCount() {
+		size_t result = 0;
+		for (const auto& kvp : _shapes) {
+			result += kvp.second.expired() ? 0 : 1;
+		}
+		return result;
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <functional>
+#include <unordered_map>
+
+#include "Gameplay/Physics/ICollider.h"
+
+namespace Gameplay::Physics {
+	/// <summary>
+	/// Interns bullet collision shapes by their type, parameters and scale, so that colliders with the same
+	/// shape can share a single btCollisionShape. Shapes are freed once the last collider using them releases them
+	/// </summary>
+	class CollisionShapeCache {
+	public:
+		typedef std::function<btCollisionShape*()> ShapeFactory;
+
+		/// <summary>
+		/// Gets a shape matching the given description, creating it if no matching shape is alive
+		/// </summary>
+		/// <param name="type">The type of collider the shape is for</param>
+		/// <param name="params">The parameters that describe the shape (ex: box extents)</param>
+		/// <param name="scale">The local scaling to apply to the shape</param>
+		/// <param name="factory">Creates the unscaled shape if it's not in the cache</param>
+		/// <param name="source">Identifies any shared data the shape is built from that doesn't fit in the parameters (ex: a set of hulls), 0 for none</param>
+		/// <returns>The shared shape, which should not be modified</returns>
+		static std::shared_ptr<btCollisionShape> Get(ColliderType type, const glm::vec4& params, const glm::vec3& scale, const ShapeFactory& factory, uint64_t source = 0);
+
+		/// <summary>
+		/// Gets the number of unique shapes that are currently alive in the cache
+		/// </summary>
+		static size_t GetShapeCount();
+
+	protected:
+		CollisionShapeCache() = default;
+		~CollisionShapeCache() = default;
+
+		struct ShapeKey {
+			ColliderType Type;
+			glm::vec4    Params;
+			uint64_t     Source;
+			glm::vec3    Scale;
+
+			bool operator ==(const ShapeKey& other) const {
+				return Type == other.Type && Params == other.Params && Source == other.Source && Scale == other.Scale;
+			}
+		};
+		struct ShapeKeyHash {
+			size_t operator()(const ShapeKey& key) const;
+		};
+
+		static std::unordered_map<ShapeKey, std::weak_ptr<btCollisionShape>, ShapeKeyHash> _shapes;
+		// The size the cache has to grow to before we sweep out expired shapes
+		static size_t _pruneThreshold;
+	};
+}
@@ -0,0 +1,262 @@
+#include "Gameplay/Physics/ContactEvents.h"
+
+#include <algorithm>
+
+#include "Gameplay/Physics/PhysicsBase.h"
+#include "Utils/GlmBulletConversions.h"
+
+namespace Gameplay::Physics {
+	ContactEventDispatcher::ContactEventDispatcher() :
+		_current(),
+		_previous(),
+		_events(),
+		_points()
+	{ }
+
+	void ContactEventDispatcher::ProcessWorld(btCollisionWorld* world) {
+		_current.clear();
+		_events.clear();
+		_points.clear();
+
+		// Every pair of bodies that bullet found to be touching has a manifold in the dispatcher,
+		// including pairs involving ghost objects, so we only need a single pass over them
+		btDispatcher* dispatcher = world->getDispatcher();
+		const int numManifolds = dispatcher->getNumManifolds();
+		for (int ix = 0; ix < numManifolds; ix++) {
+			const btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(ix);
+			if (manifold->getNumContacts() == 0) {
+				continue;
+			}
+
+			const btCollisionObject* a = manifold->getBody0();
+			const btCollisionObject* b = manifold->getBody1();
+
+			// Skip pairs where neither body cares about events
+			PhysicsEventFlags flagsA = GetEventFlags(a);
+			PhysicsEventFlags flagsB = GetEventFlags(b);
+			if (flagsA == PhysicsEventFlags::None && flagsB == PhysicsEventFlags::None) {
+				continue;
+			}
+
+			// Order the pair by broadphase ID so that the key is the same regardless of which
+			// order bullet gives us the bodies in
+			uint32_t idA = static_cast<uint32_t>(a->getBroadphaseHandle()->m_uniqueId);
+			uint32_t idB = static_cast<uint32_t>(b->getBroadphaseHandle()->m_uniqueId);
+			const bool swapped = idB < idA;
+			if (swapped) {
+				std::swap(a, b);
+				std::swap(idA, idB);
+				std::swap(flagsA, flagsB);
+			}
+
+			ContactPair pair;
+			pair.Key = (static_cast<uint64_t>(idA) << 32) | idB;
+			pair.FlagsA = flagsA;
+			pair.FlagsB = flagsB;
+			pair.FirstPoint = 0;
+			pair.NumPoints = 0;
+			pair.ObjectA = a;
+			pair.ObjectB = b;
+			pair.Manifold = manifold;
+			pair.Swapped = swapped;
+			_current.push_back(pair);
+		}
+
+		// Compound shapes can result in multiple manifolds for a pair, so we merge them into a single pair, and
+		// gather the contact points for the pairs that want them
+		std::sort(_current.begin(), _current.end());
+		size_t numMerged = 0;
+		for (size_t ix = 0; ix < _current.size(); ) {
+			ContactPair& pair = _current[numMerged++];
+			pair = _current[ix];
+			pair.FirstPoint = _points.size();
+
+			const bool wantsPoints = ((pair.FlagsA | pair.FlagsB) & PhysicsEventFlags::Contacts) != PhysicsEventFlags::None;
+			for (; ix < _current.size() && _current[ix].Key == pair.Key; ix++) {
+				if (wantsPoints) {
+					_GatherPoints(_current[ix].Manifold, _current[ix].Swapped);
+				}
+			}
+			pair.NumPoints = _points.size() - pair.FirstPoint;
+		}
+		_current.resize(numMerged);
+
+		// Both lists are sorted, so we can walk them together to find pairs that started, stayed, or ended.
+		// Ended pairs are stored at the end of the current list so that we can keep referring to them by index
+		const size_t numCurrent = _current.size();
+		size_t prevIx = 0;
+		for (size_t ix = 0; ix < numCurrent; ix++) {
+			while (prevIx < _previous.size() && _previous[prevIx].Key < _current[ix].Key) {
+				_events.push_back({ ContactEventType::End, _current.size() });
+				_current.push_back(_previous[prevIx++]);
+				_current.back().NumPoints = 0;
+			}
+
+			// Always look the bodies up from this step's objects, the previous step's objects may have been destroyed
+			_current[ix].BodyA = _GetComponent(_current[ix].ObjectA);
+			_current[ix].BodyB = _GetComponent(_current[ix].ObjectB);
+
+			if (prevIx < _previous.size() && _previous[prevIx].Key == _current[ix].Key) {
+				// Broadphase IDs can be handed out again once a body is removed, so a matching key only means
+				// that the pair stayed if it's still between the same two bodies
+				const ContactPair& previous = _previous[prevIx++];
+				if (_IsSameBody(previous.BodyA, _current[ix].BodyA) && _IsSameBody(previous.BodyB, _current[ix].BodyB)) {
+					_events.push_back({ ContactEventType::Stay, ix });
+					continue;
+				}
+				_events.push_back({ ContactEventType::End, _current.size() });
+				_current.push_back(previous);
+				_current.back().NumPoints = 0;
+			}
+			_events.push_back({ ContactEventType::Begin, ix });
+		}
+		while (prevIx < _previous.size()) {
+			_events.push_back({ ContactEventType::End, _current.size() });
+			_current.push_back(_previous[prevIx++]);
+			_current.back().NumPoints = 0;
+		}
+
+		// Send end events first, so that an object moving from one trigger to another will leave before it enters
+		std::stable_sort(_events.begin(), _events.end(), [](const ContactEvent& a, const ContactEvent& b) {
+			return _GetEventOrder(a.Type) < _GetEventOrder(b.Type);
+		});
+		for (const ContactEvent& event : _events) {
+			_Dispatch(event.Type, _current[event.Pair]);
+		}
+
+		// The ended pairs are no longer touching, so they don't get carried into the next step
+		_current.resize(numCurrent);
+		_previous.swap(_current);
+	}
+
+	void ContactEventDispatcher::Clear() {
+		_current.clear();
+		_previous.clear();
+		_events.clear();
+		_points.clear();
+	}
+
+	size_t ContactEventDispatcher::GetPairCount() const {
+		return _previous.size();
+	}
+
+	void ContactEventDispatcher::SetEventFlags(btCollisionObject* object, PhysicsEventFlags flags) {
+		object->setUserIndex2(*flags);
+	}
+
+	PhysicsEventFlags ContactEventDispatcher::GetEventFlags(const btCollisionObject* object) {
+		// Bullet defaults the user index to -1, which we treat as not being subscribed to anything
+		int flags = object->getUserIndex2();
+		return flags > 0 ? static_cast<PhysicsEventFlags>(flags) : PhysicsEventFlags::None;
+	}
+
+	int ContactEventDispatcher::_GetEventOrder(ContactEventType type) {
+		switch (type) {
+			case ContactEventType::End:   return 0;
+			case ContactEventType::Begin: return 1;
+			default:                      return 2;
+		}
+	}
+
+	void ContactEventDispatcher::_GatherPoints(const btPersistentManifold* manifold, bool swapped) {
+		for (int ix = 0; ix < manifold->getNumContacts(); ix++) {
+			const btManifoldPoint& point = manifold->getContactPoint(ix);
+
+			// Bullet's normal points from the second body in the manifold towards the first
+			ContactPoint result;
+			if (swapped) {
+				result.Position      = ToGlm(point.getPositionWorldOnB());
+				result.OtherPosition = ToGlm(point.getPositionWorldOnA());
+				result.Normal        = -ToGlm(point.m_normalWorldOnB);
+			} else {
+				result.Position      = ToGlm(point.getPositionWorldOnA());
+				result.OtherPosition = ToGlm(point.getPositionWorldOnB());
+				result.Normal        = ToGlm(point.m_normalWorldOnB);
+			}
+			result.Depth   = -point.getDistance();
+			result.Impulse = point.getAppliedImpulse();
+			_points.push_back(result);
+		}
+	}
+
+	bool ContactEventDispatcher::_IsSameBody(const std::weak_ptr<PhysicsBase>& a, const std::weak_ptr<PhysicsBase>& b) {
+		return !a.owner_before(b) && !b.owner_before(a);
+	}
+
+	std::weak_ptr<PhysicsBase> ContactEventDispatcher::_GetComponent(const btCollisionObject* object) {
+		// Our physics objects store a weak pointer to their component in the user pointer
+		std::weak_ptr<IComponent>* component = reinterpret_cast<std::weak_ptr<IComponent>*>(object->getUserPointer());
+		if (component == nullptr) {
+			return std::weak_ptr<PhysicsBase>();
+		}
+		return std::dynamic_pointer_cast<PhysicsBase>(component->lock());
+	}
+
+	void ContactEventDispatcher::_Dispatch(ContactEventType type, const ContactPair& pair) {
+		// Hold on to both bodies while we invoke the events, in case one of the handlers deletes an object
+		PhysicsBase::Sptr bodyA = pair.BodyA.lock();
+		PhysicsBase::Sptr bodyB = pair.BodyB.lock();
+		if (bodyA == nullptr || bodyB == nullptr) {
+			return;
+		}
+
+		if ((pair.FlagsA & PhysicsEventFlags::Overlap) != PhysicsEventFlags::None) {
+			bodyA->OnContactEvent(type, bodyB);
+		}
+		if ((pair.FlagsB & PhysicsEventFlags::Overlap) != PhysicsEventFlags::None) {
+			bodyB->OnContactEvent(type, bodyA);
+		}
+
+		const ContactPoint* points = pair.NumPoints > 0 ? &_points[pair.FirstPoint] : nullptr;
+		if ((pair.FlagsA & PhysicsEventFlags::Contacts) != PhysicsEventFlags::None) {
+			bodyA->OnCollision(Collision(type, bodyB, points, pair.NumPoints, false));
+		}
+		if ((pair.FlagsB & PhysicsEventFlags::Contacts) != PhysicsEventFlags::None) {
+			bodyB->OnCollision(Collision(type, bodyA, points, pair.NumPoints, true));
+		}
+	}
+
+	Collision::Collision(ContactEventType type, const std::shared_ptr<PhysicsBase>& other, const ContactPoint* points, size_t pointCount, bool flipped) :
+		Type(type),
+		Other(other),
+		_points(points),
+		_pointCount(pointCount),
+		_flipped(flipped)
+	{ }
+
+	size_t Collision::GetPointCount() const {
+		return _pointCount;
+	}
+
+	ContactPoint Collision::GetPoint(size_t index) const {
+		ContactPoint result = _points[index];
+		if (_flipped) {
+			std::swap(result.Position, result.OtherPosition);
+			result.Normal = -result.Normal;
+		}
+		return result;
+	}
+
+	glm::vec3 Collision::GetNormal() const {
+		glm::vec3 weighted = glm::vec3(0.0f);
+		glm::vec3 average  = glm::vec3(0.0f);
+		for (size_t ix = 0; ix < _pointCount; ix++) {
+			weighted += _points[ix].Normal * _points[ix].Impulse;
+			average  += _points[ix].Normal;
+		}
+		// If the solver didn't apply any impulses (ex: for triggers), fall back to the plain average
+		glm::vec3 result = glm::dot(weighted, weighted) > 0.0f ? weighted : average;
+		if (glm::dot(result, result) > 0.0f) {
+			result = glm::normalize(result);
+		}
+		return _flipped ? -result : result;
+	}
+
+	float Collision::GetTotalImpulse() const {
+		float result = 0.0f;
+		for (size_t ix = 0; ix < _pointCount; ix++) {
+			result += _points[ix].Impulse;
+		}
+		return result;
+	}
+}
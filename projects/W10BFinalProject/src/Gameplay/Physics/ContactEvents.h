@@ -0,0 +1,181 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <GLM/glm.hpp>
+#include <EnumToString.h>
+#include <btBulletCollisionCommon.h>
+
+/// <summary>
+/// The stages of two bodies touching or overlapping
+/// </summary>
+ENUM(ContactEventType, int,
+	// The bodies started touching this step
+	Begin = 0,
+	// The bodies were touching last step, and are still touching
+	Stay  = 1,
+	// The bodies were touching last step, and no longer are
+	End   = 2
+);
+
+/// <summary>
+/// The physics events that a body has subscribed to, bodies that have not subscribed to any
+/// events are skipped entirely by the event pipeline
+/// </summary>
+ENUM_FLAGS(PhysicsEventFlags, int,
+	None    = 0,
+	// Begin, stay and end events for the bodies that we are touching or overlapping
+	Overlap  = 1,
+	// Begin, stay and end events with contact points, normals and impulses for the bodies we are touching
+	Contacts = 2
+);
+
+namespace Gameplay::Physics {
+	class PhysicsBase;
+
+	/// <summary>
+	/// A single point of contact between two bodies, as seen from one of the bodies
+	/// </summary>
+	struct ContactPoint {
+		// The position of the contact on our body, in world space
+		glm::vec3 Position;
+		// The position of the contact on the other body, in world space
+		glm::vec3 OtherPosition;
+		// The contact normal in world space, pointing from the other body towards ours
+		glm::vec3 Normal;
+		// How far the bodies are overlapping at this point, positive when they are penetrating
+		float     Depth;
+		// The impulse that the solver applied at this point during the last step
+		float     Impulse;
+	};
+
+	/// <summary>
+	/// Describes a collision between two bodies for a physics step. The contact points are stored in
+	/// a buffer that is re-used between steps, so the collision is only valid during the callback it was passed to
+	/// </summary>
+	class Collision {
+	public:
+		Collision(ContactEventType type, const std::shared_ptr<PhysicsBase>& other, const ContactPoint* points, size_t pointCount, bool flipped);
+
+		/// <summary>
+		/// Whether the collision began, stayed, or ended this step
+		/// </summary>
+		ContactEventType             Type;
+		/// <summary>
+		/// The other body in the collision
+		/// </summary>
+		std::shared_ptr<PhysicsBase> Other;
+
+		/// <summary>
+		/// Gets the number of contact points in the collision, this is always 0 for end events
+		/// </summary>
+		size_t GetPointCount() const;
+		/// <summary>
+		/// Gets the contact point at the given index
+		/// </summary>
+		/// <param name="index">The index of the point, should be less than GetPointCount</param>
+		ContactPoint GetPoint(size_t index) const;
+
+		/// <summary>
+		/// Gets the average contact normal pointing from the other body towards ours, weighted by the
+		/// impulse applied at each point
+		/// </summary>
+		glm::vec3 GetNormal() const;
+		/// <summary>
+		/// Gets the total impulse applied to resolve the collision during the last step
+		/// </summary>
+		float GetTotalImpulse() const;
+
+	protected:
+		const ContactPoint* _points;
+		size_t              _pointCount;
+		// Points are stored as seen from the first body in the pair, so the second body sees them flipped
+		bool                _flipped;
+	};
+
+	/// <summary>
+	/// Gathers the pairs of touching bodies from a physics world's contact manifolds once per step, and
+	/// dispatches begin, stay and end events to the bodies that have subscribed to them
+	/// </summary>
+	class ContactEventDispatcher {
+	public:
+		ContactEventDispatcher();
+		~ContactEventDispatcher() = default;
+
+		/// <summary>
+		/// Collects this step's contacts from the world and invokes the events for any subscribed bodies,
+		/// should be called once after each step of the world
+		/// </summary>
+		/// <param name="world">The world to collect contacts from</param>
+		void ProcessWorld(btCollisionWorld* world);
+
+		/// <summary>
+		/// Forgets about all pairs that are currently touching without invoking any end events
+		/// </summary>
+		void Clear();
+
+		/// <summary>
+		/// Gets the number of pairs that were touching during the last step
+		/// </summary>
+		size_t GetPairCount() const;
+
+		/// <summary>
+		/// Stores our event subscriptions in a bullet object, so that we can filter pairs without
+		/// needing to look up the component
+		/// </summary>
+		static void SetEventFlags(btCollisionObject* object, PhysicsEventFlags flags);
+		/// <summary>
+		/// Gets the event subscriptions from a bullet object
+		/// </summary>
+		static PhysicsEventFlags GetEventFlags(const btCollisionObject* object);
+
+	protected:
+		/// <summary>
+		/// Two bodies that were touching, A is always the body that was added to the broadphase first
+		/// </summary>
+		struct ContactPair {
+			// The unique IDs of the two bodies, used for sorting
+			uint64_t Key;
+			// Looked up from the bullet objects every step. We hold weak references so that we can safely send
+			// end events for bodies that have been destroyed
+			std::weak_ptr<PhysicsBase> BodyA;
+			std::weak_ptr<PhysicsBase> BodyB;
+			// The events that each body is subscribed to
+			PhysicsEventFlags FlagsA;
+			PhysicsEventFlags FlagsB;
+			// The range of points in our contact buffer for this step
+			size_t FirstPoint;
+			size_t NumPoints;
+			// The bullet objects, only valid during the step that the pair was gathered in
+			const btCollisionObject*     ObjectA;
+			const btCollisionObject*     ObjectB;
+			const btPersistentManifold*  Manifold;
+			// True if body A is the second body in the manifold
+			bool                         Swapped;
+
+			bool operator <(const ContactPair& other) const { return Key < other.Key; }
+		};
+
+		struct ContactEvent {
+			ContactEventType Type;
+			size_t           Pair;
+		};
+
+		std::vector<ContactPair>  _current;
+		std::vector<ContactPair>  _previous;
+		std::vector<ContactEvent> _events;
+		// Stores the contact points for every pair that wants them, re-used between steps to avoid allocations
+		std::vector<ContactPoint> _points;
+
+		// Copies the contact points from a manifold into our buffer, as seen from body A
+		void _GatherPoints(const btPersistentManifold* manifold, bool swapped);
+
+		void _Dispatch(ContactEventType type, const ContactPair& pair);
+
+		// Gets the sorting order for an event type, so that end events are sent first
+		static int _GetEventOrder(ContactEventType type);
+		// Gets the physics component from a bullet object
+		static std::weak_ptr<PhysicsBase> _GetComponent(const btCollisionObject* object);
+		// Checks whether two references point to the same body, even if that body has been destroyed
+		static bool _IsSameBody(const std::weak_ptr<PhysicsBase>& a, const std::weak_ptr<PhysicsBase>& b);
+	};
+}
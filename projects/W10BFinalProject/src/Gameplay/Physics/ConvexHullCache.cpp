@@ -0,0 +1,151 @@
+#include "Gameplay/Physics/ConvexHullCache.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+#include "Logging.h"
+
+namespace Gameplay::Physics {
+	namespace {
+		// Identifies our hull files, and lets us ignore files from older versions of the format
+		const uint32_t HULL_FILE_MAGIC   = 0x4C4C5548; // "HULL"
+		const uint32_t HULL_FILE_VERSION = 1;
+
+		// Mixes the raw bytes of a value into a 64 bit FNV-1a hash. Unlike std::hash, this gives the same
+		// result with every compiler and standard library, so it's safe to use for our file names
+		template <typename T>
+		void HashCombine(uint64_t& hash, const T& value) {
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+			for (size_t ix = 0; ix < sizeof(T); ix++) {
+				hash = (hash ^ bytes[ix]) * 0x100000001b3ull;
+			}
+		}
+	}
+
+	std::string ConvexHullCache::CacheDirectory = "cache/hulls/";
+	std::unordered_map<uint64_t, ConvexHullSet::Sptr> ConvexHullCache::_hulls;
+
+	ConvexHullSet::Sptr ConvexHullCache::Get(const MeshResource::Sptr& mesh, const ConvexHullSettings& settings) {
+		if (mesh == nullptr) {
+			return nullptr;
+		}
+
+		// Meshes that weren't baked by the resource (ex: the optimized OBJ loader) have no stored hash,
+		// so we have to fall back to hashing their geometry
+		MeshGeometry::Sptr geometry = nullptr;
+		uint64_t geometryHash = mesh->GetGeometryHash();
+		if (geometryHash == 0) {
+			geometry = mesh->GetGeometry();
+			if (geometry == nullptr) {
+				return nullptr;
+			}
+			geometryHash = geometry->Hash;
+		}
+
+		// If another collider has already requested these hulls, share them
+		uint64_t key = _GetKey(geometryHash, settings);
+		auto it = _hulls.find(key);
+		if (it != _hulls.end()) {
+			return it->second;
+		}
+
+		std::stringstream filename;
+		filename << CacheDirectory << std::hex << std::setw(16) << std::setfill('0') << key << ".hull";
+
+		// Try loading from disk before we go to the effort of building the hulls
+		ConvexHullSet::Sptr result = _LoadFromFile(filename.str(), key);
+		if (result == nullptr) {
+			// Only now do we need the geometry, which may mean re-loading the mesh if it wasn't kept
+			if (geometry == nullptr) {
+				geometry = mesh->GetGeometry();
+			}
+			if (geometry == nullptr) {
+				return nullptr;
+			}
+			std::shared_ptr<ConvexHullSet> hulls = std::make_shared<ConvexHullSet>();
+			hulls->Key = key;
+			for (ConvexHullResult& hull : ConvexHull::Decompose(geometry->Positions, geometry->Indices, settings)) {
+				hulls->Hulls.push_back(std::move(hull.Vertices));
+			}
+			LOG_TRACE("Built {} convex hull(s) for mesh {:016x}", hulls->Hulls.size(), geometry->Hash);
+			_SaveToFile(filename.str(), key, *hulls);
+			result = hulls;
+		}
+
+		_hulls[key] = result;
+		return result;
+	}
+
+	void ConvexHullCache::Clear() {
+		_hulls.clear();
+	}
+
+	uint64_t ConvexHullCache::_GetKey(uint64_t geometryHash, const ConvexHullSettings& settings) {
+		uint64_t result = geometryHash;
+		HashCombine(result, settings.MaxVertices);
+		HashCombine(result, settings.Decompose);
+		// The rest of the settings only matter when decomposing
+		if (settings.Decompose) {
+			HashCombine(result, settings.MaxHulls);
+			HashCombine(result, settings.MaxConcavity);
+		}
+		return result;
+	}
+
+	ConvexHullSet::Sptr ConvexHullCache::_LoadFromFile(const std::string& filename, uint64_t key) {
+		std::ifstream file(filename, std::ios::in | std::ios::binary);
+		if (!file.is_open()) {
+			return nullptr;
+		}
+
+		uint32_t magic = 0, version = 0, hullCount = 0;
+		uint64_t fileKey = 0;
+		file.read(reinterpret_cast<char*>(&magic), sizeof(uint32_t));
+		file.read(reinterpret_cast<char*>(&version), sizeof(uint32_t));
+		file.read(reinterpret_cast<char*>(&fileKey), sizeof(uint64_t));
+		file.read(reinterpret_cast<char*>(&hullCount), sizeof(uint32_t));
+		if (!file || magic != HULL_FILE_MAGIC || version != HULL_FILE_VERSION || fileKey != key) {
+			LOG_WARN("Ignoring out of date or invalid hull cache file \"{}\"", filename);
+			return nullptr;
+		}
+
+		std::shared_ptr<ConvexHullSet> result = std::make_shared<ConvexHullSet>();
+		result->Key = key;
+		result->Hulls.resize(hullCount);
+		for (std::vector<glm::vec3>& hull : result->Hulls) {
+			uint32_t vertexCount = 0;
+			file.read(reinterpret_cast<char*>(&vertexCount), sizeof(uint32_t));
+			hull.resize(vertexCount);
+			file.read(reinterpret_cast<char*>(hull.data()), vertexCount * sizeof(glm::vec3));
+		}
+		if (!file) {
+			LOG_WARN("Hull cache file \"{}\" is truncated, rebuilding", filename);
+			return nullptr;
+		}
+		return result;
+	}
+
+	void ConvexHullCache::_SaveToFile(const std::string& filename, uint64_t key, const ConvexHullSet& hulls) {
+		std::error_code error;
+		std::filesystem::create_directories(std::filesystem::path(filename).parent_path(), error);
+
+		std::ofstream file(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			LOG_WARN("Failed to open hull cache file \"{}\" for writing", filename);
+			return;
+		}
+
+		uint32_t hullCount = static_cast<uint32_t>(hulls.Hulls.size());
+		file.write(reinterpret_cast<const char*>(&HULL_FILE_MAGIC), sizeof(uint32_t));
+		file.write(reinterpret_cast<const char*>(&HULL_FILE_VERSION), sizeof(uint32_t));
+		file.write(reinterpret_cast<const char*>(&key), sizeof(uint64_t));
+		file.write(reinterpret_cast<const char*>(&hullCount), sizeof(uint32_t));
+		for (const std::vector<glm::vec3>& hull : hulls.Hulls) {
+			uint32_t vertexCount = static_cast<uint32_t>(hull.size());
+			file.write(reinterpret_cast<const char*>(&vertexCount), sizeof(uint32_t));
+			file.write(reinterpret_cast<const char*>(hull.data()), vertexCount * sizeof(glm::vec3));
+		}
+	}
+}
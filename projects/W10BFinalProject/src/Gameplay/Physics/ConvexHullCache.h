@@ -0,0 +1,59 @@
+#pragma once
+#include <unordered_map>
+
+#include "Gameplay/MeshResource.h"
+#include "Utils/ConvexHull.h"
+
+namespace Gameplay::Physics {
+	/// <summary>
+	/// The set of convex hulls that approximate a mesh, shared between all colliders using the same mesh and settings
+	/// </summary>
+	struct ConvexHullSet {
+		typedef std::shared_ptr<const ConvexHullSet> Sptr;
+
+		/// <summary>
+		/// The points that make up each hull, in object space
+		/// </summary>
+		std::vector<std::vector<glm::vec3>> Hulls;
+		/// <summary>
+		/// The key that the hulls are cached under, combining the mesh's geometry hash and the hull settings
+		/// </summary>
+		uint64_t                            Key = 0;
+	};
+
+	/// <summary>
+	/// Builds and stores convex hulls for meshes. Hulls are kept in memory so that colliders can share them,
+	/// and written to disk so that they don't need to be re-built the next time the game is run
+	/// </summary>
+	class ConvexHullCache {
+	public:
+		/// <summary>
+		/// The directory that hull files are stored in
+		/// </summary>
+		static std::string CacheDirectory;
+
+		/// <summary>
+		/// Gets the hulls for the given mesh, loading them from disk or building them if needed. Hulls are
+		/// keyed on the mesh's geometry hash, so the geometry is only requested if the hulls need building
+		/// </summary>
+		/// <param name="mesh">The mesh to get the hulls for</param>
+		/// <param name="settings">The settings to use for building the hulls</param>
+		/// <returns>The hulls for the mesh, or nullptr if the mesh has no geometry</returns>
+		static ConvexHullSet::Sptr Get(const MeshResource::Sptr& mesh, const ConvexHullSettings& settings);
+
+		/// <summary>
+		/// Removes all the hulls stored in memory, hulls that are still in use by colliders will not be freed
+		/// </summary>
+		static void Clear();
+
+	protected:
+		ConvexHullCache() = default;
+		~ConvexHullCache() = default;
+
+		static std::unordered_map<uint64_t, ConvexHullSet::Sptr> _hulls;
+
+		static uint64_t _GetKey(uint64_t geometryHash, const ConvexHullSettings& settings);
+		static ConvexHullSet::Sptr _LoadFromFile(const std::string& filename, uint64_t key);
+		static void _SaveToFile(const std::string& filename, uint64_t key, const ConvexHullSet& hulls);
+	};
+}
@@ -5,6 +5,9 @@
 
 // Utils
 #include "Utils/GlmDefines.h"
+#include "Utils/GlmBulletConversions.h"
+
+#include "Gameplay/Physics/CollisionShapeCache.h"
 
 // Collider Types
 #include "Gameplay/Physics/Colliders/BoxCollider.h"
@@ -14,6 +17,7 @@
 #include "Gameplay/Physics/Colliders/ConeCollider.h"
 #include "Gameplay/Physics/Colliders/CylinderCollider.h"
 #include "Gameplay/Physics/Colliders/ConvexMeshCollider.h"
+#include "Gameplay/Physics/Colliders/TriangleMeshCollider.h"
 
 namespace Gameplay::Physics {
 	const char* ColliderTypeComboNames = "Plane\0Box\0Sphere\0Capsule\0Cone\0Cylinder\0Convex Mesh\0Concave Mesh\0Terrain\0";
@@ -21,6 +25,8 @@ namespace Gameplay::Physics {
 	ICollider::ICollider(ColliderType type) :
 		_type(type),
 		_shape(nullptr),
+		_sharedShape(nullptr),
+		_isDirty(true),
 		_position(glm::vec3(0.0f)),
 		_rotation(glm::vec3(0.0f)),
 		_scale(glm::vec3(1.0f)),
@@ -28,10 +34,7 @@ namespace Gameplay::Physics {
 	{ }
 
 	ICollider::~ICollider() {
-		if (_shape != nullptr) {
-			delete _shape;
-			_shape = nullptr;
-		}
+		_ReleaseShape();
 	}
 
 	ColliderType ICollider::GetType() const {
@@ -45,6 +48,41 @@ namespace Gameplay::Physics {
 		return _shape;
 	}
 
+	btCollisionShape* ICollider::_AcquireShape(const glm::vec3& scale, bool allowShared) {
+		_ReleaseShape();
+
+		glm::vec4 params;
+		if (allowShared && GetShapeParameters(params)) {
+			_sharedShape = CollisionShapeCache::Get(_type, params, scale, [this]() { return CreateShape(); }, GetShapeSource());
+			_shape = _sharedShape.get();
+		} else {
+			_shape = CreateShape();
+			if (_shape != nullptr) {
+				_shape->setLocalScaling(ToBt(scale));
+			}
+		}
+		return _shape;
+	}
+
+	bool ICollider::_RescaleShape(const glm::vec3& scale) {
+		// Shared shapes are in use by other colliders, so we can't touch them
+		if (_shape == nullptr || _sharedShape != nullptr) {
+			return false;
+		}
+		_shape->setLocalScaling(ToBt(scale));
+		return true;
+	}
+
+	void ICollider::_ReleaseShape() {
+		// Shared shapes will be deleted once the last collider using them lets go
+		if (_sharedShape != nullptr) {
+			_sharedShape = nullptr;
+		} else if (_shape != nullptr) {
+			delete _shape;
+		}
+		_shape = nullptr;
+	}
+
 	ICollider* ICollider::SetPosition(const glm::vec3& value) {
 		_position = value;
 		_isDirty  = true;
@@ -89,7 +127,7 @@ namespace Gameplay::Physics {
 			case ColliderType::Cone:        return ConeCollider::Create();
 			case ColliderType::Cylinder:    return CylinderCollider::Create();
 			case ColliderType::ConvexMesh:  return ConvexMeshCollider::Create();
-			case ColliderType::ConcaveMesh: throw std::runtime_error("Collider type not supported!"); return nullptr;
+			case ColliderType::ConcaveMesh: return TriangleMeshCollider::Create();
 			case ColliderType::Terrain:     throw std::runtime_error("Collider type not supported!"); return nullptr;
 			case ColliderType::Unknown:
 			default:
@@ -28,7 +28,7 @@ ENUM(ColliderType, int,
 	 Cylinder  = 6,
 	 // Convex meshes have no inward faces, ie no caves
 	 ConvexMesh = 7,
-	 // Concave meshes can have inward faces (NOT IMPLEMENTED)
+	 // Concave meshes can have inward faces, only supported on static and kinematic bodies
 	 ConcaveMesh = 8,
 	 // Used for creating terrain colliders,
 	 // much more complex than the other colliders (NOT IMPLEMENTED)
@@ -146,6 +146,8 @@ namespace Gameplay::Physics {
 		ColliderType _type;
 		// Stores shape, note that mutable lets us modify in const functions
 		mutable btCollisionShape* _shape;
+		// If our shape came from the CollisionShapeCache, this keeps it alive while we're using it
+		std::shared_ptr<btCollisionShape> _sharedShape;
 		mutable bool _isDirty;
 
 		ICollider(ColliderType type);
@@ -156,6 +158,21 @@ namespace Gameplay::Physics {
 		/// <returns>A btCollisionShape allocated with new</returns>
 		virtual btCollisionShape* CreateShape() const = 0;
 
+		/// <summary>
+		/// Gets the parameters that fully describe this collider's shape, allowing colliders with identical
+		/// parameters to share a single bullet shape. Colliders that can't be described this way (ex: meshes)
+		/// should return false
+		/// </summary>
+		/// <param name="outParams">Will receive the shape's parameters</param>
+		/// <returns>True if the shape can be shared, false if not</returns>
+		virtual bool GetShapeParameters(glm::vec4& /*outParams*/) const { return false; }
+		/// <summary>
+		/// Gets an ID for any shared data that this collider's shape is built from, for shapes that can't be
+		/// fully described by their parameters (ex: convex hulls). Only used if GetShapeParameters returns true
+		/// </summary>
+		/// <returns>The ID of the data the shape is built from, or 0 if the parameters describe the shape</returns>
+		virtual uint64_t GetShapeSource() const { return 0; }
+
 	private:
 		// Allow RigidBody to access protected and private members
 		friend class PhysicsBase;
@@ -165,5 +182,23 @@ namespace Gameplay::Physics {
 		glm::vec3 _rotation;
 		glm::vec3 _scale;
 		Guid      _guid;
+
+		/// <summary>
+		/// Gets or creates the shape for this collider with the given scale applied, shapes that
+		/// can be shared will come from the CollisionShapeCache
+		/// </summary>
+		/// <param name="scale">The total scale to apply to the shape</param>
+		/// <param name="allowShared">False to always create a shape of our own, even if it could be shared</param>
+		btCollisionShape* _AcquireShape(const glm::vec3& scale, bool allowShared = true);
+		/// <summary>
+		/// Changes the scale of our current shape in place, only possible if the shape is not shared
+		/// </summary>
+		/// <param name="scale">The total scale to apply to the shape</param>
+		/// <returns>True if the shape was rescaled, false if it needs to be re-acquired instead</returns>
+		bool _RescaleShape(const glm::vec3& scale);
+		/// <summary>
+		/// Deletes or releases our shape, depending on where it came from
+		/// </summary>
+		void _ReleaseShape();
 	};
 }
\ No newline at end of file
@@ -0,0 +1,234 @@
+#include "Gameplay/Physics/PhysicsBackend.h"
+
+#include <algorithm>
+#include <mutex>
+#include <BulletCollision/CollisionDispatch/btGhostObject.h>
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
+
+#include "Logging.h"
+#include "Utils/ThreadPool.h"
+#include "Utils/ImGuiHelper.h"
+#include "Utils/JsonGlmHelpers.h"
+#include "Utils/GlmBulletConversions.h"
+
+namespace Gameplay::Physics {
+	bool PhysicsSettings::operator==(const PhysicsSettings& other) const {
+		return !RequiresRebuild(other) && AsyncStep == other.AsyncStep;
+	}
+
+	bool PhysicsSettings::RequiresRebuild(const PhysicsSettings& other) const {
+		return !(
+			Multithreaded  == other.Multithreaded &&
+			Broadphase     == other.Broadphase &&
+			WorldMin       == other.WorldMin &&
+			WorldMax       == other.WorldMax &&
+			MaxAxisObjects == other.MaxAxisObjects
+		);
+	}
+
+	bool PhysicsSettings::DrawImGui() {
+		bool result = false;
+		result |= LABEL_LEFT(ImGui::Checkbox, "Multithreaded", &Multithreaded);
+		result |= LABEL_LEFT(ImGui::Checkbox, "Async Step   ", &AsyncStep);
+
+		ImGui::TextUnformatted("Broadphase");
+		ImGui::SameLine();
+		if (ImGui::BeginCombo("##Broadphase", (~Broadphase).c_str())) {
+			for (BroadphaseType type : { BroadphaseType::Dbvt, BroadphaseType::AxisSweep }) {
+				if (ImGui::Selectable((~type).c_str(), type == Broadphase)) {
+					result |= type != Broadphase;
+					Broadphase = type;
+				}
+			}
+			ImGui::EndCombo();
+		}
+
+		// The bounds only matter for the axis sweep broadphase. Changes rebuild the world, so we
+		// only report them once enter is pressed instead of on every keystroke
+		if (Broadphase == BroadphaseType::AxisSweep) {
+			result |= LABEL_LEFT(ImGui::InputFloat3, "World Min", &WorldMin.x, "%.1f", ImGuiInputTextFlags_EnterReturnsTrue);
+			result |= LABEL_LEFT(ImGui::InputFloat3, "World Max", &WorldMax.x, "%.1f", ImGuiInputTextFlags_EnterReturnsTrue);
+			result |= LABEL_LEFT(ImGui::InputInt, "Max Objects", &MaxAxisObjects, 1, 100, ImGuiInputTextFlags_EnterReturnsTrue);
+		}
+		return result;
+	}
+
+	PhysicsSettings PhysicsSettings::FromJson(const nlohmann::json& blob) {
+		PhysicsSettings result;
+		result.Multithreaded  = JsonGet(blob, "multithreaded", result.Multithreaded);
+		result.Broadphase     = JsonParseEnum(BroadphaseType, blob, "broadphase", result.Broadphase);
+		result.MaxAxisObjects = JsonGet(blob, "max_axis_objects", result.MaxAxisObjects);
+		result.AsyncStep      = JsonGet(blob, "async_step", result.AsyncStep);
+		if (blob.contains("world_min")) {
+			result.WorldMin = ParseJsonVec3(blob["world_min"]);
+		}
+		if (blob.contains("world_max")) {
+			result.WorldMax = ParseJsonVec3(blob["world_max"]);
+		}
+		return result;
+	}
+
+	nlohmann::json PhysicsSettings::ToJson() const {
+		return {
+			{ "multithreaded",    Multithreaded },
+			{ "broadphase",       ~Broadphase },
+			{ "world_min",        GlmToJson(WorldMin) },
+			{ "world_max",        GlmToJson(WorldMax) },
+			{ "max_axis_objects", MaxAxisObjects },
+			{ "async_step",       AsyncStep }
+		};
+	}
+
+	ThreadPoolTaskScheduler& ThreadPoolTaskScheduler::Get() {
+		static ThreadPoolTaskScheduler instance(ThreadPool::Get());
+		return instance;
+	}
+
+	ThreadPoolTaskScheduler::ThreadPoolTaskScheduler(ThreadPool& pool) :
+		btITaskScheduler("ThreadPool"),
+		_pool(pool),
+		_numThreads(0)
+	{
+		_numThreads = getMaxNumThreads();
+	}
+
+	int ThreadPoolTaskScheduler::getMaxNumThreads() const {
+		// Bullet keeps per-thread data in fixed size arrays, so we can't hand it more threads than that
+		return std::min(_pool.GetThreadCount(), static_cast<int>(BT_MAX_THREAD_COUNT));
+	}
+
+	int ThreadPoolTaskScheduler::getNumThreads() const {
+		return _numThreads;
+	}
+
+	void ThreadPoolTaskScheduler::setNumThreads(int numThreads) {
+		_numThreads = std::clamp(numThreads, 1, getMaxNumThreads());
+	}
+
+	void ThreadPoolTaskScheduler::parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body) {
+		const int count = iEnd - iBegin;
+		if (_numThreads <= 1 || count <= grainSize) {
+			body.forLoop(iBegin, iEnd);
+			return;
+		}
+		_pool.ParallelFor(count, _GetGrainSize(count, grainSize), [&](int begin, int end, int) {
+			body.forLoop(iBegin + begin, iBegin + end);
+		});
+	}
+
+	btScalar ThreadPoolTaskScheduler::parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body) {
+		const int count = iEnd - iBegin;
+		if (_numThreads <= 1 || count <= grainSize) {
+			return body.sumLoop(iBegin, iEnd);
+		}
+		// There's only a handful of batches, so a lock per batch is fine here
+		btScalar result = 0.0f;
+		std::mutex mutex;
+		_pool.ParallelFor(count, _GetGrainSize(count, grainSize), [&](int begin, int end, int) {
+			btScalar sum = body.sumLoop(iBegin + begin, iBegin + end);
+			std::lock_guard<std::mutex> lock(mutex);
+			result += sum;
+		});
+		return result;
+	}
+
+	int ThreadPoolTaskScheduler::_GetGrainSize(int count, int grainSize) const {
+		return std::max(grainSize, (count + _numThreads - 1) / _numThreads);
+	}
+
+	PhysicsBackend::PhysicsBackend(const PhysicsSettings& settings) :
+		_settings(settings),
+		_collisionConfig(nullptr),
+		_collisionDispatcher(nullptr),
+		_broadphaseInterface(nullptr),
+		_constraintSolver(nullptr),
+		_ghostCallback(nullptr),
+		_world(nullptr)
+	{
+		// Bullet reads the scheduler when building the dispatcher and the solver pool, as well as when
+		// stepping, so it must be set before we create any of them
+		ThreadPoolTaskScheduler& scheduler = ThreadPoolTaskScheduler::Get();
+		if (_settings.Multithreaded) {
+			btSetTaskScheduler(&scheduler);
+			#if !BT_THREADSAFE
+			LOG_WARN("Bullet was built without BT_THREADSAFE, the multithreaded physics world will step on a single thread");
+			#endif
+
+			// The multithreaded world tends to keep more manifolds and algorithms alive at once, so
+			// give the pools more room to avoid falling back to the (locked) heap
+			btDefaultCollisionConstructionInfo constructionInfo;
+			constructionInfo.m_defaultMaxPersistentManifoldPoolSize = 32768;
+			constructionInfo.m_defaultMaxCollisionAlgorithmPoolSize = 32768;
+			_collisionConfig = new btDefaultCollisionConfiguration(constructionInfo);
+			_collisionDispatcher = new btCollisionDispatcherMt(_collisionConfig);
+		} else {
+			_collisionConfig = new btDefaultCollisionConfiguration();
+			_collisionDispatcher = new btCollisionDispatcher(_collisionConfig);
+		}
+
+		switch (_settings.Broadphase) {
+			case BroadphaseType::AxisSweep:
+			{
+				const int maxObjects = std::clamp(_settings.MaxAxisObjects, 1, 32766);
+				_broadphaseInterface = new btAxisSweep3(ToBt(_settings.WorldMin), ToBt(_settings.WorldMax), static_cast<unsigned short>(maxObjects));
+				break;
+			}
+			case BroadphaseType::Dbvt:
+			default:
+				_broadphaseInterface = new btDbvtBroadphase();
+				break;
+		}
+		_ghostCallback = new btGhostPairCallback();
+		_broadphaseInterface->getOverlappingPairCache()->setInternalGhostPairCallback(_ghostCallback);
+
+		if (_settings.Multithreaded) {
+			btConstraintSolverPoolMt* solverPool = new btConstraintSolverPoolMt(scheduler.getNumThreads());
+			_constraintSolver = solverPool;
+			_world = new btDiscreteDynamicsWorldMt(
+				_collisionDispatcher,
+				_broadphaseInterface,
+				solverPool,
+				nullptr,
+				_collisionConfig
+			);
+		} else {
+			_constraintSolver = new btSequentialImpulseConstraintSolver();
+			_world = new btDiscreteDynamicsWorld(
+				_collisionDispatcher,
+				_broadphaseInterface,
+				_constraintSolver,
+				_collisionConfig
+			);
+		}
+
+		// Only recalculate the bounds of objects that are awake, bodies that game code moves are woken up
+		// and have their bounds updated when the transform is pushed in PhysicsPreStep
+		_world->setForceUpdateAllAabbs(false);
+	}
+
+	PhysicsBackend::~PhysicsBackend() {
+		delete _world;
+		delete _constraintSolver;
+		delete _broadphaseInterface;
+		delete _ghostCallback;
+		delete _collisionDispatcher;
+		delete _collisionConfig;
+	}
+
+	const PhysicsSettings& PhysicsBackend::GetSettings() const {
+		return _settings;
+	}
+
+	btDynamicsWorld* PhysicsBackend::GetWorld() const {
+		return _world;
+	}
+
+	btBroadphaseInterface* PhysicsBackend::GetBroadphase() const {
+		return _broadphaseInterface;
+	}
+
+	btDbvtBroadphase* PhysicsBackend::GetDbvtBroadphase() const {
+		return _settings.Broadphase == BroadphaseType::Dbvt ? static_cast<btDbvtBroadphase*>(_broadphaseInterface) : nullptr;
+	}
+}
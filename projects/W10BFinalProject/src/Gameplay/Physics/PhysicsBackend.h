@@ -0,0 +1,154 @@
+#pragma once
+#include <memory>
+#include <GLM/glm.hpp>
+#include <json.hpp>
+#include <btBulletDynamicsCommon.h>
+#include <LinearMath/btThreads.h>
+
+#include <EnumToString.h>
+
+class btDbvtBroadphase;
+class btGhostPairCallback;
+class ThreadPool;
+
+/// <summary>
+/// The broadphase algorithms that a physics world can use to find pairs of objects that may be touching
+/// </summary>
+ENUM(BroadphaseType, int,
+	// Dynamic AABB tree, handles moving objects and unbounded worlds well
+	Dbvt      = 0,
+	// Sweep and prune along all 3 axes, can be faster when there are lots of objects in a known area
+	AxisSweep = 1
+);
+
+namespace Gameplay::Physics {
+	/// <summary>
+	/// Configures how a scene builds it's bullet physics world
+	/// </summary>
+	struct PhysicsSettings {
+		/// <summary>
+		/// True to use bullet's multithreaded dynamics world, which runs the collision dispatch
+		/// and island solving on the shared thread pool
+		/// </summary>
+		bool           Multithreaded  = false;
+		/// <summary>
+		/// The broadphase to use for finding potential collision pairs
+		/// </summary>
+		BroadphaseType Broadphase     = BroadphaseType::Dbvt;
+		/// <summary>
+		/// The bounds of the world, only used by the axis sweep broadphase. Objects outside
+		/// of these bounds will be clamped to the edges, and will be much slower
+		/// </summary>
+		glm::vec3      WorldMin       = glm::vec3(-500.0f);
+		glm::vec3      WorldMax       = glm::vec3(500.0f);
+		/// <summary>
+		/// The maximum number of objects that the axis sweep broadphase can hold, at most 32766
+		/// </summary>
+		int            MaxAxisObjects = 16384;
+		/// <summary>
+		/// True to step the world as a job on the shared thread pool while the frame renders. Objects will see the
+		/// results of the step at the start of the next frame, so everything lags a frame behind
+		/// </summary>
+		bool           AsyncStep      = false;
+
+		bool operator ==(const PhysicsSettings& other) const;
+		bool operator !=(const PhysicsSettings& other) const { return !(*this == other); }
+
+		/// <summary>
+		/// Checks whether a world built with these settings would be built differently with another set
+		/// </summary>
+		/// <param name="other">The settings to compare against</param>
+		/// <returns>True if the world needs to be rebuilt to switch to the other settings</returns>
+		bool RequiresRebuild(const PhysicsSettings& other) const;
+
+		/// <summary>
+		/// Draws the editor controls for the settings
+		/// </summary>
+		/// <returns>True if any of the settings were changed</returns>
+		bool DrawImGui();
+
+		static PhysicsSettings FromJson(const nlohmann::json& blob);
+		nlohmann::json ToJson() const;
+	};
+
+	/// <summary>
+	/// Lets bullet's parallel loops run on one of our thread pools. Bullet only has one task scheduler
+	/// for the whole program, so this should be installed with btSetTaskScheduler before stepping a
+	/// multithreaded world
+	///
+	/// Note that bullet only calls into the scheduler when the bullet libraries were built with
+	/// BT_THREADSAFE, otherwise the multithreaded world will step everything on the calling thread
+	/// </summary>
+	class ThreadPoolTaskScheduler : public btITaskScheduler {
+	public:
+		/// <summary>
+		/// Gets the task scheduler for the shared thread pool
+		/// </summary>
+		static ThreadPoolTaskScheduler& Get();
+
+		ThreadPoolTaskScheduler(ThreadPool& pool);
+		virtual ~ThreadPoolTaskScheduler() = default;
+
+		// Implementation of btITaskScheduler
+
+		virtual int getMaxNumThreads() const override;
+		virtual int getNumThreads() const override;
+		virtual void setNumThreads(int numThreads) override;
+		virtual void parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body) override;
+		virtual btScalar parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body) override;
+
+	protected:
+		ThreadPool& _pool;
+		int         _numThreads;
+
+		// Makes sure bullet doesn't get split into more batches than it has threads
+		int _GetGrainSize(int count, int grainSize) const;
+	};
+
+	/// <summary>
+	/// Owns all of the bullet objects that make up a dynamics world, built according to a set of physics
+	/// settings. Destroying the backend destroys the world, so any objects should be removed from the
+	/// world first
+	/// </summary>
+	class PhysicsBackend {
+	public:
+		PhysicsBackend(const PhysicsSettings& settings);
+		~PhysicsBackend();
+
+		PhysicsBackend(const PhysicsBackend& other) = delete;
+		PhysicsBackend& operator=(const PhysicsBackend& other) = delete;
+
+		/// <summary>
+		/// Gets the settings that the world was built with
+		/// </summary>
+		const PhysicsSettings& GetSettings() const;
+		/// <summary>
+		/// Gets the dynamics world
+		/// </summary>
+		btDynamicsWorld* GetWorld() const;
+		/// <summary>
+		/// Gets the world's broadphase
+		/// </summary>
+		btBroadphaseInterface* GetBroadphase() const;
+		/// <summary>
+		/// Gets the world's broadphase if it's a DBVT broadphase, otherwise returns nullptr
+		/// </summary>
+		btDbvtBroadphase* GetDbvtBroadphase() const;
+
+	protected:
+		PhysicsSettings           _settings;
+
+		// Our bullet physics configuration
+		btCollisionConfiguration* _collisionConfig;
+		// Handles dispatching collisions between objects
+		btCollisionDispatcher*    _collisionDispatcher;
+		// Provides rough broadphase (AABB) checks to improve performance
+		btBroadphaseInterface*    _broadphaseInterface;
+		// Resolves contraints (ex: hinge constraints, angle axis, etc...)
+		btConstraintSolver*       _constraintSolver;
+		// this is what allows us to get our pairs from the trigger volumes
+		btGhostPairCallback*      _ghostCallback;
+		// The world that all the above is plugged in to
+		btDynamicsWorld*          _world;
+	};
+}
@@ -12,17 +12,21 @@ int PhysicsBase::_editorSelectedColliderType = 0;
 	PhysicsBase::PhysicsBase() : 
 		IComponent(),
 		_scene(nullptr),
-		_colliders(std::vector<ICollider::Sptr>()),
 		_shape(nullptr),
+		_compound(nullptr),
+		_colliders(std::vector<ICollider::Sptr>()),
 		_isShapeDirty(true),
 		_collisionGroup(0x01),
 		_collisionMask(0xFFFFFFFF),
-		_prevScale(glm::vec3(1.0f))
+		_eventFlags(PhysicsEventFlags::None),
+		_prevScale(glm::vec3(1.0f)),
+		_rescaleCount(0),
+		_syncedTransformVersion(0)
 	{ }
 
 	PhysicsBase::~PhysicsBase() {
 		if (_scene != nullptr) {
-			delete _shape;
+			delete _compound;
 		}
 	}
 
@@ -137,6 +141,22 @@ int PhysicsBase::_editorSelectedColliderType = 0;
 		return _collisionMask;
 	}
 
+	void PhysicsBase::SetEventFlags(PhysicsEventFlags value) {
+		_eventFlags = value;
+		btCollisionObject* object = _GetCollisionObject();
+		if (object != nullptr) {
+			ContactEventDispatcher::SetEventFlags(object, _eventFlags);
+		}
+	}
+
+	PhysicsEventFlags PhysicsBase::GetEventFlags() const {
+		return _eventFlags;
+	}
+
+	void PhysicsBase::OnCollision(const Collision& collision) {
+		GetGameObject()->OnCollision(collision);
+	}
+
 	ICollider::Sptr PhysicsBase::AddCollider(const ICollider::Sptr& collider) {
 		if (_scene != nullptr) {
 			collider->Awake(GetGameObject());
@@ -147,59 +167,91 @@ int PhysicsBase::_editorSelectedColliderType = 0;
 	}
 
 	void PhysicsBase::RemoveCollider(const ICollider::Sptr& collider) {
-		auto& it = std::find(_colliders.begin(), _colliders.end(), collider);
+		// Hold on to the collider, since the reference may be to an element in our list
+		ICollider::Sptr removed = collider;
+		auto& it = std::find(_colliders.begin(), _colliders.end(), removed);
 		if (it != _colliders.end()) {
-			if (collider->GetShape() != nullptr) {
-				_shape->removeChildShape(collider->GetShape());
-				_isShapeDirty = true;
-			}
 			_colliders.erase(it);
+			_isShapeDirty = true;
+
+			// Rebuild right away, since bullet may still be using the collider's shape
+			if (_shape != nullptr) {
+				_RebuildShape();
+			}
 		}
 	}
 
 
-	void PhysicsBase::_AddColliderToShape(ICollider* collider) {
-		// Create the bullet collision shape from the collider
-		btCollisionShape* newShape = collider->CreateShape();
-		collider->_shape = newShape;
+	void PhysicsBase::_RebuildShape(bool rescale) {
+		glm::vec3 scale = GetGameObject()->GetScale();
 
-		// If the shape actually exists
-		if (newShape != nullptr) {
-			// We convert our shape parameters to a bullet transform
-			btTransform transform;
-			transform.setIdentity();
-			transform.setOrigin(ToBt(collider->_position));
-			transform.setRotation(ToBt(glm::quat(glm::radians(collider->_rotation))));
-			newShape->setLocalScaling(ToBt(collider->_scale));
+		// Empty out the compound first, since colliders may be about to delete their shapes
+		if (_compound != nullptr) {
+			for (int ix = _compound->getNumChildShapes() - 1; ix >= 0; ix--) {
+				_compound->removeChildShapeByIndex(ix);
+			}
+		}
 
-			// Add the shape to the compound shape
-			_shape->addChildShape(transform, newShape);
+		// Shapes may be shared between colliders, so rather than scaling the shape after the fact, each
+		// collider gets a shape with both it's scale and our object's scale already applied. Objects that
+		// keep changing scale would create a new shared shape every time, so they get their own shapes instead
+		const bool allowShared = _rescaleCount < __SharedRescaleLimit;
+		bool shapesChanged = false;
+		for (auto& collider : _colliders) {
+			const glm::vec3 colliderScale = collider->_scale * scale;
+			if (collider->_isDirty || collider->_shape == nullptr || (rescale && !collider->_RescaleShape(colliderScale))) {
+				collider->_AcquireShape(colliderScale, allowShared);
+				shapesChanged = true;
+			}
+			collider->_isDirty = false;
+		}
 
-			// Remove any existing collision manifolds, so that our body can properly be updated with it's new shape
-			if (_scene != nullptr) {
-				_scene->GetPhysicsWorld()->getBroadphase()->getOverlappingPairCache()->cleanProxyFromPairs(_GetBroadphaseHandle(), _scene->GetPhysicsWorld()->getDispatcher());
+		// If we only have a single collider sitting at our origin, the compound would just be an extra
+		// layer to traverse for every collision pair, so we hand bullet the collider's shape directly
+		if (_colliders.size() == 1 && _colliders[0]->_shape != nullptr &&
+			_colliders[0]->_position == glm::vec3(0.0f) && _colliders[0]->_rotation == glm::vec3(0.0f)) {
+			_shape = _colliders[0]->_shape;
+		} else {
+			if (_compound == nullptr) {
+				_compound = new btCompoundShape(true, static_cast<int>(_colliders.size()));
 			}
+			for (auto& collider : _colliders) {
+				if (collider->_shape != nullptr) {
+					// We convert our shape parameters to a bullet transform, scaling the offset ourselves
+					btTransform transform;
+					transform.setIdentity();
+					transform.setOrigin(ToBt(collider->_position * scale));
+					transform.setRotation(ToBt(glm::quat(glm::radians(collider->_rotation))));
+					_compound->addChildShape(transform, collider->_shape);
+				}
+			}
+			_shape = _compound;
+		}
 
-			// Our inertia has changed, so flag mass as dirty so it's recalculated
-			_isShapeDirty = true;
+		// If our bullet object exists, give it the new shape
+		btCollisionObject* object = _GetCollisionObject();
+		if (object != nullptr) {
+			object->setCollisionShape(_shape);
+
+			// Remove any existing collision manifolds, so that our body can properly be updated with it's new shape.
+			// Shapes that were only rescaled in place can keep their manifolds
+			if (shapesChanged) {
+				_scene->GetPhysicsWorld()->getBroadphase()->getOverlappingPairCache()->cleanProxyFromPairs(_GetBroadphaseHandle(), _scene->GetPhysicsWorld()->getDispatcher());
+			}
 		}
 	}
 
 	bool PhysicsBase::_HandleShapeDirty() {
-		bool wasDirty = false;
+		bool wasDirty = _isShapeDirty;
 		for (auto& collider : _colliders) {
-			if (collider->_isDirty) {
-				// If the collider already had a shape, delete it
-				if (collider->_shape != nullptr) {
-					_shape->removeChildShape(collider->_shape);
-					delete collider->_shape;
-				}
-				_AddColliderToShape(collider.get());
-				collider->_isDirty = false;
-				wasDirty = true;
-			}
+			wasDirty |= collider->_isDirty;
 		}
 
+		// Our inertia will need to be recalculated if our shape has changed
+		if (wasDirty) {
+			_RebuildShape();
+			_isShapeDirty = false;
+		}
 		return wasDirty;
 	}
 
@@ -224,9 +276,9 @@ int PhysicsBase::_editorSelectedColliderType = 0;
 		transform.setOrigin(ToBt(context->GetPosition()));	 
 		transform.setRotation(ToBt(context->GetRotation()));
 		if (context->GetScale() != _prevScale) {
-			_shape->setLocalScaling(ToBt(context->GetScale()));
-			_scene->GetPhysicsWorld()->getBroadphase()->getOverlappingPairCache()->cleanProxyFromPairs(_GetBroadphaseHandle(), _scene->GetPhysicsWorld()->getDispatcher());
 			_prevScale = context->GetScale();
+			_rescaleCount++;
+			_RebuildShape(true);
 		}
 	}
 
@@ -237,4 +289,12 @@ int PhysicsBase::_editorSelectedColliderType = 0;
 		context->SetPostion(ToGlm(transform.getOrigin()));
 		context->SetRotation(ToGlm(transform.getRotation()));
 	}
+
+	bool PhysicsBase::_HasGameObjectMoved() const {
+		return GetGameObject()->GetTransformVersion() != _syncedTransformVersion;
+	}
+
+	void PhysicsBase::_MarkTransformSynced() {
+		_syncedTransformVersion = GetGameObject()->GetTransformVersion();
+	}
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include "Gameplay/Components/IComponent.h"
 #include "Gameplay/Physics/ICollider.h"
+#include "Gameplay/Physics/ContactEvents.h"
 
 class btTransform;
 
@@ -8,6 +9,21 @@ namespace Gameplay {
 	class Scene;
 
 	namespace Physics {
+		/// <summary>
+		/// Counts how many physics objects had their transforms exchanged with their game objects
+		/// around a physics step, and how many were skipped because nothing had moved
+		/// </summary>
+		struct TransformSyncStats {
+			// Objects whose transforms were sent to bullet because game code moved them
+			int Pushed      = 0;
+			// Objects that game code didn't move, so bullet was left alone
+			int PushSkipped = 0;
+			// Bodies whose transforms were copied back to their game objects after the step
+			int Pulled      = 0;
+			// Bodies that bullet didn't move, because they were asleep, static or kinematic
+			int PullSkipped = 0;
+		};
+
 		/// <summary>
 		/// Provides a base class for physics components, including shape generation and utilities
 		/// for converting to and from Bullet transforms
@@ -55,10 +71,36 @@ namespace Gameplay {
 			/// </summary>
 			int GetCollisionMask() const;
 
+			/// <summary>
+			/// Sets which physics events this object will receive via OnContactEvent. Objects
+			/// that are not subscribed to any events are skipped by the scene's event pipeline
+			/// </summary>
+			/// <param name="value">The new event flags for the object</param>
+			void SetEventFlags(PhysicsEventFlags value);
+			/// <summary>
+			/// Gets the physics events that this object is subscribed to
+			/// </summary>
+			PhysicsEventFlags GetEventFlags() const;
+
+			/// <summary>
+			/// Invoked by the scene after a physics step for each object we are touching or overlapping,
+			/// if we have subscribed to overlap events
+			/// </summary>
+			/// <param name="type">Whether the contact began, stayed, or ended this step</param>
+			/// <param name="other">The other physics object in the contact</param>
+			virtual void OnContactEvent(ContactEventType /*type*/, const std::shared_ptr<PhysicsBase>& /*other*/) { }
+			/// <summary>
+			/// Invoked by the scene after a physics step for each object we are touching, if we have
+			/// subscribed to contact events. By default this forwards the collision to our gameobject's components
+			/// </summary>
+			/// <param name="collision">The collision info, only valid for the duration of the call</param>
+			virtual void OnCollision(const Collision& collision);
+
 			/// <summary>
 			/// Adds a new collider to this rigidbody.
 			/// Multiple colliders can be added to a rigidbody, as internally it
-			/// uses a compound shape collider
+			/// uses a compound shape collider. A single collider with no offset
+			/// will skip the compound shape
 			/// </summary>
 			/// <param name="collider">The collider to add to this body</param>
 			/// <returns></returns>
@@ -75,13 +117,15 @@ namespace Gameplay {
 			/// handles body initialization, shape changes, mass changes, etc...
 			/// </summary>
 			/// <param name="dt">The time in seconds since the last frame</param>
-			virtual void PhysicsPreStep(float dt) = 0;
+			/// <returns>True if our game object had moved, and it's transform was sent to bullet</returns>
+			virtual bool PhysicsPreStep(float dt) = 0;
 			/// <summary>
 			/// Invoked for each RigidBody after the physics world is stepped forward a frame,
-			/// handles copying transform to the OpenGL state
+			/// handles copying transform to the OpenGL state. Objects that bullet never moves don't need to override this
 			/// </summary>
 			/// <param name="dt">The time in seconds since the last frame</param>
-			virtual void PhysicsPostStep(float dt) = 0;
+			/// <returns>True if bullet moved the object, and the transform was copied to our game object</returns>
+			virtual bool PhysicsPostStep(float /*dt*/) { return false; }
 
 			// Delete awake to ensure derived classes override it
 
@@ -89,8 +133,11 @@ namespace Gameplay {
 		protected:
 			Scene*        _scene;
 
-			// Stores the bullet shape associated with the physics object
-			btCompoundShape* _shape;
+			// Stores the bullet shape associated with the physics object, this is either our compound
+			// shape, or our only collider's shape if it has no offset
+			btCollisionShape* _shape;
+			// The compound shape that holds our colliders, only used if we need it
+			btCompoundShape*  _compound;
 
 			// List of colliders and whether they have been changed
 			std::vector<ICollider::Sptr> _colliders;
@@ -101,7 +148,17 @@ namespace Gameplay {
 			int _collisionMask;
 			mutable bool _isGroupMaskDirty;
 
+			// The events this object wants to receive, also stored in the bullet object
+			PhysicsEventFlags _eventFlags;
+
 			glm::vec3 _prevScale;
+			// How many times our game object's scale has changed, once an object has been rescaled a few times
+			// we stop sharing it's shapes and scale them in place instead, to avoid filling the shape cache
+			uint32_t  _rescaleCount;
+			inline static const uint32_t __SharedRescaleLimit = 3;
+
+			// The version of our game object's transform that bullet last knew about
+			uint32_t  _syncedTransformVersion;
 
 			PhysicsBase();
 
@@ -110,8 +167,9 @@ namespace Gameplay {
 			void ToJsonBase(nlohmann::json& output) const;
 			void FromJsonBase(const nlohmann::json& input);
 
-			// Handles adding a collider to our compound shape
-			void _AddColliderToShape(ICollider* collider);
+			// Re-creates our shape from our colliders, if rescale is true all collider shapes will be
+			// re-acquired (or rescaled in place if they aren't shared), otherwise only the dirty ones will be
+			void _RebuildShape(bool rescale = false);
 
 			// Handles resolving any dirty state stuff for our object
 			bool _HandleShapeDirty();
@@ -122,8 +180,15 @@ namespace Gameplay {
 			void _CopyGameobjectTransformTo(btTransform& transform);
 			void _CopyGameobjectTransformFrom(const btTransform& transform);
 
+			// Checks if game code has moved our game object since we last exchanged transforms with bullet
+			bool _HasGameObjectMoved() const;
+			// Records that bullet and our game object agree on the current transform
+			void _MarkTransformSynced();
+
 			// Gets the bullet broadphase proxy that we can use for clearing collisions
 			virtual btBroadphaseProxy* _GetBroadphaseHandle() = 0;
+			// Gets the bullet object that our shape is attached to, or nullptr if it has not been created
+			virtual btCollisionObject* _GetCollisionObject() = 0;
 
 			static int _editorSelectedColliderType;
 		};
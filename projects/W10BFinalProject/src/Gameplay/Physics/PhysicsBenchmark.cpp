@@ -0,0 +1,126 @@
+#include "Gameplay/Physics/PhysicsBenchmark.h"
+
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include <btBulletDynamicsCommon.h>
+
+#include "Logging.h"
+
+namespace Gameplay::Physics {
+	PhysicsBenchmarkSettings::PhysicsBenchmarkSettings() :
+		Backends()
+	{
+		for (BroadphaseType broadphase : { BroadphaseType::Dbvt, BroadphaseType::AxisSweep }) {
+			for (bool multithreaded : { false, true }) {
+				PhysicsSettings backend;
+				backend.Broadphase    = broadphase;
+				backend.Multithreaded = multithreaded;
+				Backends.push_back(backend);
+			}
+		}
+	}
+
+	std::vector<PhysicsBenchmarkResult> PhysicsBenchmark::Run(const PhysicsBenchmarkSettings& settings) {
+		std::vector<PhysicsBenchmarkResult> results;
+		results.reserve(settings.Backends.size());
+		for (const PhysicsSettings& backend : settings.Backends) {
+			results.push_back(_RunCase(settings, backend));
+		}
+		return results;
+	}
+
+	void PhysicsBenchmark::LogResults(const PhysicsBenchmarkSettings& settings, const std::vector<PhysicsBenchmarkResult>& results) {
+		LOG_INFO("Physics benchmark results ({} bodies, {} steps at {} Hz):", settings.NumBodies, settings.NumSteps, settings.StepRate);
+		LOG_INFO("  {:>10} {:>8} {:>12} {:>12} {:>8}", "Broadphase", "Threads", "Avg (ms)", "Max (ms)", "Active");
+		for (const PhysicsBenchmarkResult& result : results) {
+			LOG_INFO("  {:>10} {:>8} {:>12.3f} {:>12.3f} {:>8}", ~result.Backend.Broadphase, result.NumThreads, result.AverageStepMs, result.MaxStepMs, result.NumActive);
+		}
+	}
+
+	PhysicsBenchmarkResult PhysicsBenchmark::_RunCase(const PhysicsBenchmarkSettings& settings, const PhysicsSettings& backendSettings) {
+		PhysicsBackend backend(backendSettings);
+		btDynamicsWorld* world = backend.GetWorld();
+		world->setGravity(btVector3(0.0f, 0.0f, -9.81f));
+
+		// A floor and 4 walls to keep the pile together
+		const float halfSize = settings.ArenaSize * 0.5f;
+		btBoxShape floorShape(btVector3(halfSize, halfSize, 0.5f));
+		btBoxShape wallShape(btVector3(halfSize, 0.5f, 10.0f));
+		std::vector<std::unique_ptr<btRigidBody>> statics;
+		statics.push_back(std::make_unique<btRigidBody>(0.0f, nullptr, &floorShape));
+		statics.back()->setWorldTransform(btTransform(btQuaternion::getIdentity(), btVector3(0.0f, 0.0f, -0.5f)));
+		for (int ix = 0; ix < 4; ix++) {
+			const float angle = ix * SIMD_HALF_PI;
+			statics.push_back(std::make_unique<btRigidBody>(0.0f, nullptr, &wallShape));
+			statics.back()->setWorldTransform(btTransform(
+				btQuaternion(btVector3(0.0f, 0.0f, 1.0f), angle),
+				btVector3(btSin(angle), btCos(angle), 0.0f) * (halfSize + 0.5f) + btVector3(0.0f, 0.0f, 10.0f)
+			));
+		}
+		for (const auto& body : statics) {
+			world->addRigidBody(body.get());
+		}
+
+		// Stack the bodies in layers of evenly spaced columns, alternating boxes and spheres so that
+		// we get a mix of collision algorithms
+		btBoxShape    boxShape(btVector3(0.5f, 0.5f, 0.5f));
+		btSphereShape sphereShape(0.5f);
+		btVector3 boxInertia, sphereInertia;
+		boxShape.calculateLocalInertia(1.0f, boxInertia);
+		sphereShape.calculateLocalInertia(1.0f, sphereInertia);
+
+		const float spacing = 1.2f;
+		const int   perRow  = std::max(static_cast<int>((settings.ArenaSize - spacing) / spacing), 1);
+		std::vector<std::unique_ptr<btRigidBody>> bodies;
+		bodies.reserve(settings.NumBodies);
+		for (int ix = 0; ix < settings.NumBodies; ix++) {
+			const int column = ix % perRow;
+			const int row    = (ix / perRow) % perRow;
+			const int layer  = ix / (perRow * perRow);
+			const btVector3 position(
+				(column - (perRow - 1) * 0.5f) * spacing,
+				(row - (perRow - 1) * 0.5f) * spacing,
+				1.0f + layer * spacing
+			);
+
+			const bool isBox = ix % 2 == 0;
+			btRigidBody::btRigidBodyConstructionInfo info(1.0f, nullptr, isBox ? static_cast<btCollisionShape*>(&boxShape) : &sphereShape, isBox ? boxInertia : sphereInertia);
+			info.m_startWorldTransform.setOrigin(position);
+			bodies.push_back(std::make_unique<btRigidBody>(info));
+			world->addRigidBody(bodies.back().get());
+		}
+
+		// Time each step individually, so we can find the worst spikes as well as the average
+		const float timeStep = 1.0f / settings.StepRate;
+		double totalMs = 0.0;
+		double maxMs = 0.0;
+		for (int ix = 0; ix < settings.NumSteps; ix++) {
+			auto start = std::chrono::high_resolution_clock::now();
+			world->stepSimulation(timeStep, 1, timeStep);
+			auto end = std::chrono::high_resolution_clock::now();
+
+			const double stepMs = std::chrono::duration<double, std::milli>(end - start).count();
+			totalMs += stepMs;
+			maxMs = std::max(maxMs, stepMs);
+		}
+
+		PhysicsBenchmarkResult result;
+		result.Backend       = backendSettings;
+		result.NumThreads    = backendSettings.Multithreaded ? btGetTaskScheduler()->getNumThreads() : 1;
+		result.AverageStepMs = static_cast<float>(totalMs / std::max(settings.NumSteps, 1));
+		result.MaxStepMs     = static_cast<float>(maxMs);
+		result.NumActive     = static_cast<int>(std::count_if(bodies.begin(), bodies.end(), [](const std::unique_ptr<btRigidBody>& body) {
+			return body->isActive();
+		}));
+
+		// The world needs to let go of the bodies before they're destroyed
+		for (const auto& body : bodies) {
+			world->removeRigidBody(body.get());
+		}
+		for (const auto& body : statics) {
+			world->removeRigidBody(body.get());
+		}
+		return result;
+	}
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <vector>
+
+#include "Gameplay/Physics/PhysicsBackend.h"
+
+namespace Gameplay::Physics {
+	/// <summary>
+	/// Configures the pile of bodies and the backends used by the physics benchmark
+	/// </summary>
+	struct PhysicsBenchmarkSettings {
+		/// <summary>
+		/// The backends to run the benchmark with, by default every broadphase with and without multithreading
+		/// </summary>
+		std::vector<PhysicsSettings> Backends;
+		/// <summary>
+		/// The number of bodies to drop into the arena, alternating between boxes and spheres
+		/// </summary>
+		int   NumBodies = 4000;
+		/// <summary>
+		/// The number of physics steps to time
+		/// </summary>
+		int   NumSteps  = 300;
+		/// <summary>
+		/// The physics tick rate, in steps per second
+		/// </summary>
+		float StepRate  = 60.0f;
+		/// <summary>
+		/// The width of the walled arena that the bodies are dropped into, in meters
+		/// </summary>
+		float ArenaSize = 40.0f;
+
+		PhysicsBenchmarkSettings();
+	};
+
+	/// <summary>
+	/// The timings from running the benchmark with a single backend
+	/// </summary>
+	struct PhysicsBenchmarkResult {
+		PhysicsSettings Backend;
+		int             NumThreads;
+		// The average time taken by a single step, in milliseconds
+		float           AverageStepMs;
+		// The longest time taken by a single step, in milliseconds
+		float           MaxStepMs;
+		// The number of bodies that were still awake at the end of the run
+		int             NumActive;
+	};
+
+	/// <summary>
+	/// A headless stress test that drops thousands of bodies into a walled arena in an isolated physics
+	/// world, and times how long each step takes. Runs once for each backend, so that broadphases and
+	/// threading can be compared on the same machine
+	/// </summary>
+	class PhysicsBenchmark {
+	public:
+		/// <summary>
+		/// Runs the benchmark once for each backend in the settings
+		/// </summary>
+		/// <param name="settings">The settings for the benchmark</param>
+		/// <returns>The timings for each backend</returns>
+		static std::vector<PhysicsBenchmarkResult> Run(const PhysicsBenchmarkSettings& settings = PhysicsBenchmarkSettings());
+
+		/// <summary>
+		/// Writes a table of results to the log
+		/// </summary>
+		/// <param name="settings">The settings that the benchmark was run with</param>
+		/// <param name="results">The results to log</param>
+		static void LogResults(const PhysicsBenchmarkSettings& settings, const std::vector<PhysicsBenchmarkResult>& results);
+
+	protected:
+		PhysicsBenchmark() = default;
+		~PhysicsBenchmark() = default;
+
+		static PhysicsBenchmarkResult _RunCase(const PhysicsBenchmarkSettings& settings, const PhysicsSettings& backend);
+	};
+}
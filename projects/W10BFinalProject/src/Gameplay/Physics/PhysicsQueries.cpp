@@ -0,0 +1,368 @@
+#include "Gameplay/Physics/PhysicsQueries.h"
+
+#include <BulletCollision/BroadphaseCollision/btDbvtBroadphase.h>
+#include <BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h>
+#include <BulletCollision/CollisionDispatch/btManifoldResult.h>
+#include <LinearMath/btAabbUtil2.h>
+
+#include "Gameplay/Physics/PhysicsBase.h"
+#include "Gameplay/Physics/CollisionShapeCache.h"
+#include "Utils/GlmBulletConversions.h"
+#include "Utils/ThreadPool.h"
+
+namespace Gameplay::Physics {
+	namespace {
+		// Tests a broadphase proxy against a query's group and mask, the same way bullet tests two proxies
+		bool PassesFilter(const btBroadphaseProxy* proxy, int group, int mask) {
+			return (proxy->m_collisionFilterGroup & mask) != 0 && (group & proxy->m_collisionFilterMask) != 0;
+		}
+
+		// Gets the physics component from a bullet object's user pointer
+		std::shared_ptr<PhysicsBase> GetComponent(const btCollisionObject* object) {
+			std::weak_ptr<IComponent>* component = reinterpret_cast<std::weak_ptr<IComponent>*>(object->getUserPointer());
+			return component != nullptr ? std::dynamic_pointer_cast<PhysicsBase>(component->lock()) : nullptr;
+		}
+
+		// Adapts a lambda to the DBVT's collision policy
+		template <typename Func>
+		struct LeafPolicy : public btDbvt::ICollide {
+			Func& Callback;
+			int   Group;
+			int   Mask;
+
+			LeafPolicy(Func& callback, int group, int mask) : Callback(callback), Group(group), Mask(mask) { }
+
+			virtual void Process(const btDbvtNode* leaf) override {
+				btBroadphaseProxy* proxy = reinterpret_cast<btBroadphaseProxy*>(leaf->data);
+				if (PassesFilter(proxy, Group, Mask)) {
+					Callback(reinterpret_cast<btCollisionObject*>(proxy->m_clientObject));
+				}
+			}
+		};
+
+		// Records whether the narrowphase found any penetrating points between two objects
+		struct OverlapResult : public btManifoldResult {
+			bool IsOverlapping = false;
+
+			OverlapResult(const btCollisionObjectWrapper* a, const btCollisionObjectWrapper* b) : btManifoldResult(a, b) { }
+
+			virtual void addContactPoint(const btVector3& /*normalOnBInWorld*/, const btVector3& /*pointInWorld*/, btScalar depth) override {
+				IsOverlapping |= depth <= 0.0f;
+			}
+		};
+
+		// Fills in a query hit from bullet's results
+		void FillHit(QueryHit& hit, const btCollisionObject* object, const btVector3& point, const btVector3& normal, float fraction) {
+			hit.Hit      = true;
+			hit.Body     = GetComponent(object);
+			hit.Point    = ToGlm(point);
+			hit.Normal   = glm::normalize(ToGlm(normal));
+			hit.Fraction = fraction;
+		}
+	}
+
+	int PhysicsQueryRunner::GrainSize = 16;
+
+	/// <summary>
+	/// The scratch memory for a single thread running queries
+	/// </summary>
+	struct PhysicsQueryRunner::WorkerContext {
+		// The narrowphase allocates from pools owned by the dispatcher and config, so each thread needs its own
+		btDefaultCollisionConfiguration         Config;
+		btCollisionDispatcher                   Dispatcher;
+		btDispatcherInfo                        DispatchInfo;
+		// The stack for walking the broadphase trees
+		btAlignedObjectArray<const btDbvtNode*> Stack;
+
+		WorkerContext() : Config(), Dispatcher(&Config), DispatchInfo(), Stack() { }
+	};
+
+	QueryShape QueryShape::Sphere(float radius) {
+		QueryShape result;
+		result.Type = ColliderType::Sphere;
+		result.Params = glm::vec4(radius, 0.0f, 0.0f, 0.0f);
+		return result;
+	}
+
+	QueryShape QueryShape::Box(const glm::vec3& halfExtents, const glm::quat& rotation) {
+		QueryShape result;
+		result.Type = ColliderType::Box;
+		result.Params = glm::vec4(halfExtents, 0.0f);
+		result.Rotation = rotation;
+		return result;
+	}
+
+	QueryShape QueryShape::Capsule(float radius, float height, const glm::quat& rotation) {
+		QueryShape result;
+		result.Type = ColliderType::Capsule;
+		result.Params = glm::vec4(radius, height, 0.0f, 0.0f);
+		result.Rotation = rotation;
+		return result;
+	}
+
+	PhysicsQueryBatch::PhysicsQueryBatch() :
+		_raycasts(),
+		_raycastHits(),
+		_sweeps(),
+		_sweepHits(),
+		_overlaps(),
+		_overlapResults()
+	{ }
+
+	void PhysicsQueryBatch::Clear() {
+		_raycasts.clear();
+		_raycastHits.clear();
+		_sweeps.clear();
+		_sweepHits.clear();
+		_overlaps.clear();
+		_overlapResults.clear();
+	}
+
+	size_t PhysicsQueryBatch::AddRaycast(const glm::vec3& from, const glm::vec3& to, int group, int mask) {
+		_raycasts.push_back({ from, to, group, mask });
+		_raycastHits.emplace_back();
+		return _raycasts.size() - 1;
+	}
+
+	size_t PhysicsQueryBatch::AddSweep(const QueryShape& shape, const glm::vec3& from, const glm::vec3& to, int group, int mask) {
+		_sweeps.push_back({ shape, from, to, group, mask });
+		_sweepHits.emplace_back();
+		return _sweeps.size() - 1;
+	}
+
+	size_t PhysicsQueryBatch::AddOverlap(const QueryShape& shape, const glm::vec3& position, size_t maxResults, int group, int mask) {
+		_overlaps.push_back({ shape, position, group, mask, _overlapResults.size(), maxResults, 0 });
+		_overlapResults.resize(_overlapResults.size() + maxResults);
+		return _overlaps.size() - 1;
+	}
+
+	const QueryHit& PhysicsQueryBatch::GetRaycastHit(size_t index) const {
+		return _raycastHits[index];
+	}
+
+	const QueryHit& PhysicsQueryBatch::GetSweepHit(size_t index) const {
+		return _sweepHits[index];
+	}
+
+	size_t PhysicsQueryBatch::GetOverlapCount(size_t index) const {
+		return _overlaps[index].NumResults;
+	}
+
+	const std::shared_ptr<PhysicsBase>& PhysicsQueryBatch::GetOverlap(size_t index, size_t resultIndex) const {
+		return _overlapResults[_overlaps[index].FirstResult + resultIndex];
+	}
+
+	size_t PhysicsQueryBatch::GetQueryCount() const {
+		return _raycasts.size() + _sweeps.size() + _overlaps.size();
+	}
+
+	PhysicsQueryRunner::PhysicsQueryRunner() :
+		_workers(),
+		_shapes(),
+		_prevShapes(),
+		_world(nullptr),
+		_broadphase(nullptr)
+	{ }
+
+	PhysicsQueryRunner::~PhysicsQueryRunner() = default;
+
+	void PhysicsQueryRunner::Run(btCollisionWorld* world, btDbvtBroadphase* broadphase, PhysicsQueryBatch& batch) {
+		ThreadPool& pool = ThreadPool::Get();
+
+		// Scratch memory is created up front, since the workers can't safely resize the list
+		while (_workers.size() < static_cast<size_t>(pool.GetThreadCount())) {
+			_workers.push_back(std::make_unique<WorkerContext>());
+		}
+
+		// The shape cache isn't thread safe, so we grab all our shapes before we start. We keep the shapes
+		// from the last batch alive until now, so that shapes that are queried every frame stay cached
+		_prevShapes.swap(_shapes);
+		_shapes.clear();
+		auto acquireShape = [&](const QueryShape& shape) {
+			_shapes.push_back(CollisionShapeCache::Get(shape.Type, shape.Params, glm::vec3(1.0f), [&]() -> btCollisionShape* {
+				switch (shape.Type) {
+					case ColliderType::Box:     return new btBoxShape(btVector3(shape.Params.x, shape.Params.y, shape.Params.z));
+					case ColliderType::Capsule: return new btCapsuleShapeZ(shape.Params.x, shape.Params.y);
+					default:                    return new btSphereShape(shape.Params.x);
+				}
+			}));
+		};
+		for (const PhysicsQueryBatch::Sweep& sweep : batch._sweeps) {
+			acquireShape(sweep.Shape);
+		}
+		for (const PhysicsQueryBatch::Overlap& overlap : batch._overlaps) {
+			acquireShape(overlap.Shape);
+		}
+		_prevShapes.clear();
+
+		_world = world;
+		_broadphase = broadphase;
+
+		// Queries are laid out as raycasts, then sweeps, then overlaps
+		const int numRaycasts = static_cast<int>(batch._raycasts.size());
+		const int numSweeps   = static_cast<int>(batch._sweeps.size());
+		pool.ParallelFor(static_cast<int>(batch.GetQueryCount()), GrainSize, [&](int begin, int end, int threadIndex) {
+			WorkerContext& context = *_workers[threadIndex];
+			for (int ix = begin; ix < end; ix++) {
+				if (ix < numRaycasts) {
+					_Raycast(context, batch, ix);
+				} else if (ix < numRaycasts + numSweeps) {
+					_Sweep(context, batch, ix - numRaycasts);
+				} else {
+					_Overlap(context, batch, ix - numRaycasts - numSweeps);
+				}
+			}
+		});
+
+		_world = nullptr;
+		_broadphase = nullptr;
+	}
+
+	template <typename Func>
+	void PhysicsQueryRunner::_ForEachCandidate(WorkerContext& context, const btVector3& aabbMin, const btVector3& aabbMax, int group, int mask, Func callback) {
+		if (_broadphase != nullptr) {
+			// Walk both the dynamic and static trees of the broadphase
+			LeafPolicy<Func> policy(callback, group, mask);
+			const btDbvtVolume volume = btDbvtVolume::FromMM(aabbMin, aabbMax);
+			_broadphase->m_sets[0].collideTVNoStackAlloc(_broadphase->m_sets[0].m_root, volume, context.Stack, policy);
+			_broadphase->m_sets[1].collideTVNoStackAlloc(_broadphase->m_sets[1].m_root, volume, context.Stack, policy);
+		} else {
+			// Without a tree to walk, we test against the bounds of every object
+			const btCollisionObjectArray& objects = _world->getCollisionObjectArray();
+			for (int ix = 0; ix < objects.size(); ix++) {
+				const btBroadphaseProxy* proxy = objects[ix]->getBroadphaseHandle();
+				if (proxy != nullptr && PassesFilter(proxy, group, mask) && TestAabbAgainstAabb2(aabbMin, aabbMax, proxy->m_aabbMin, proxy->m_aabbMax)) {
+					callback(objects[ix]);
+				}
+			}
+		}
+	}
+
+	void PhysicsQueryRunner::_Raycast(WorkerContext& context, PhysicsQueryBatch& batch, size_t index) {
+		const PhysicsQueryBatch::Raycast& query = batch._raycasts[index];
+		QueryHit& hit = batch._raycastHits[index];
+		hit = QueryHit();
+
+		const btVector3 from = ToBt(query.From);
+		const btVector3 to   = ToBt(query.To);
+		const btVector3 ray  = to - from;
+		if (ray.fuzzyZero()) {
+			return;
+		}
+
+		btTransform fromTransform, toTransform;
+		fromTransform.setIdentity();
+		fromTransform.setOrigin(from);
+		toTransform.setIdentity();
+		toTransform.setOrigin(to);
+
+		btCollisionWorld::ClosestRayResultCallback result(from, to);
+		result.m_collisionFilterGroup = query.Group;
+		result.m_collisionFilterMask  = query.Mask;
+		auto testObject = [&](btCollisionObject* object) {
+			btCollisionWorld::rayTestSingle(fromTransform, toTransform, object, object->getCollisionShape(), object->getWorldTransform(), result);
+		};
+
+		if (_broadphase != nullptr) {
+			// Same setup that the DBVT broadphase uses for it's own ray tests
+			const btVector3 direction = ray.normalized();
+			btVector3 inverse;
+			unsigned int signs[3];
+			for (int axis = 0; axis < 3; axis++) {
+				inverse[axis] = direction[axis] == 0.0f ? BT_LARGE_FLOAT : 1.0f / direction[axis];
+				signs[axis]   = inverse[axis] < 0.0f;
+			}
+			const btScalar length = direction.dot(ray);
+			const btVector3 zero(0.0f, 0.0f, 0.0f);
+
+			LeafPolicy<decltype(testObject)> policy(testObject, query.Group, query.Mask);
+			for (int set = 0; set < 2; set++) {
+				_broadphase->m_sets[set].rayTestInternal(_broadphase->m_sets[set].m_root, from, to, inverse, signs, length, zero, zero, context.Stack, policy);
+			}
+		} else {
+			const btCollisionObjectArray& objects = _world->getCollisionObjectArray();
+			for (int ix = 0; ix < objects.size(); ix++) {
+				const btBroadphaseProxy* proxy = objects[ix]->getBroadphaseHandle();
+				btScalar param = 1.0f;
+				btVector3 normal;
+				if (proxy != nullptr && PassesFilter(proxy, query.Group, query.Mask) && btRayAabb(from, to, proxy->m_aabbMin, proxy->m_aabbMax, param, normal)) {
+					testObject(objects[ix]);
+				}
+			}
+		}
+
+		if (result.hasHit()) {
+			FillHit(hit, result.m_collisionObject, result.m_hitPointWorld, result.m_hitNormalWorld, result.m_closestHitFraction);
+		}
+	}
+
+	void PhysicsQueryRunner::_Sweep(WorkerContext& context, PhysicsQueryBatch& batch, size_t index) {
+		const PhysicsQueryBatch::Sweep& query = batch._sweeps[index];
+		QueryHit& hit = batch._sweepHits[index];
+		hit = QueryHit();
+
+		const btConvexShape* shape = static_cast<const btConvexShape*>(_shapes[index].get());
+		const btTransform fromTransform(ToBt(query.Shape.Rotation), ToBt(query.From));
+		const btTransform toTransform(ToBt(query.Shape.Rotation), ToBt(query.To));
+
+		// Our candidates are everything touching the bounds of the whole sweep
+		btVector3 fromMin, fromMax, toMin, toMax;
+		shape->getAabb(fromTransform, fromMin, fromMax);
+		shape->getAabb(toTransform, toMin, toMax);
+		fromMin.setMin(toMin);
+		fromMax.setMax(toMax);
+
+		btCollisionWorld::ClosestConvexResultCallback result(fromTransform.getOrigin(), toTransform.getOrigin());
+		result.m_collisionFilterGroup = query.Group;
+		result.m_collisionFilterMask  = query.Mask;
+		_ForEachCandidate(context, fromMin, fromMax, query.Group, query.Mask, [&](btCollisionObject* object) {
+			btCollisionWorld::objectQuerySingle(shape, fromTransform, toTransform, object, object->getCollisionShape(), object->getWorldTransform(), result, 0.0f);
+		});
+
+		if (result.hasHit()) {
+			FillHit(hit, result.m_hitCollisionObject, result.m_hitPointWorld, result.m_hitNormalWorld, result.m_closestHitFraction);
+		}
+	}
+
+	void PhysicsQueryRunner::_Overlap(WorkerContext& context, PhysicsQueryBatch& batch, size_t index) {
+		PhysicsQueryBatch::Overlap& query = batch._overlaps[index];
+		query.NumResults = 0;
+
+		const btCollisionShape* shape = _shapes[batch._sweeps.size() + index].get();
+		btCollisionObject queryObject;
+		queryObject.setCollisionShape(const_cast<btCollisionShape*>(shape));
+		queryObject.setWorldTransform(btTransform(ToBt(query.Shape.Rotation), ToBt(query.Position)));
+
+		btVector3 aabbMin, aabbMax;
+		shape->getAabb(queryObject.getWorldTransform(), aabbMin, aabbMax);
+
+		_ForEachCandidate(context, aabbMin, aabbMax, query.Group, query.Mask, [&](btCollisionObject* object) {
+			if (query.NumResults >= query.MaxResults) {
+				return;
+			}
+
+			// Run the narrowphase between our shape and the object, the same way that bullet's contact tests do
+			btCollisionObjectWrapper wrapA(nullptr, shape, &queryObject, queryObject.getWorldTransform(), -1, -1);
+			btCollisionObjectWrapper wrapB(nullptr, object->getCollisionShape(), object, object->getWorldTransform(), -1, -1);
+			btCollisionAlgorithm* algorithm = context.Dispatcher.findAlgorithm(&wrapA, &wrapB, nullptr, BT_CLOSEST_POINT_ALGORITHMS);
+			if (algorithm == nullptr) {
+				return;
+			}
+
+			OverlapResult overlap(&wrapA, &wrapB);
+			algorithm->processCollision(&wrapA, &wrapB, context.DispatchInfo, &overlap);
+			algorithm->~btCollisionAlgorithm();
+			context.Dispatcher.freeCollisionAlgorithm(algorithm);
+
+			if (overlap.IsOverlapping) {
+				batch._overlapResults[query.FirstResult + query.NumResults] = GetComponent(object);
+				query.NumResults++;
+			}
+		});
+
+		// Clear out any results left over from the last time the batch was run
+		for (size_t ix = query.NumResults; ix < query.MaxResults; ix++) {
+			batch._overlapResults[query.FirstResult + ix] = nullptr;
+		}
+	}
+}
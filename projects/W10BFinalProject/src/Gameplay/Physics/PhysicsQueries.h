@@ -0,0 +1,193 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <GLM/glm.hpp>
+#include <GLM/gtc/quaternion.hpp>
+#include <btBulletCollisionCommon.h>
+
+#include "Gameplay/Physics/ICollider.h"
+
+class btDbvtBroadphase;
+
+namespace Gameplay::Physics {
+	class PhysicsBase;
+
+	/// <summary>
+	/// Describes a convex shape to use for sweeps and overlap tests. The parameters match those of the
+	/// collider with the same type, so query shapes are shared with colliders through the shape cache
+	/// </summary>
+	struct QueryShape {
+		ColliderType Type     = ColliderType::Sphere;
+		glm::vec4    Params   = glm::vec4(0.5f, 0.0f, 0.0f, 0.0f);
+		glm::quat    Rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+
+		static QueryShape Sphere(float radius);
+		static QueryShape Box(const glm::vec3& halfExtents, const glm::quat& rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+		static QueryShape Capsule(float radius, float height, const glm::quat& rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+	};
+
+	/// <summary>
+	/// The closest thing that a raycast or sweep ran into
+	/// </summary>
+	struct QueryHit {
+		// True if the query hit anything
+		bool                         Hit      = false;
+		// The physics object that was hit, may be nullptr if the object isn't from a component
+		std::shared_ptr<PhysicsBase> Body     = nullptr;
+		// The point that was hit, in world space
+		glm::vec3                    Point    = glm::vec3(0.0f);
+		// The surface normal at the hit point, in world space
+		glm::vec3                    Normal   = glm::vec3(0.0f);
+		// How far along the query the hit occured, between 0 and 1
+		float                        Fraction = 1.0f;
+	};
+
+	/// <summary>
+	/// A batch of raycasts, shape sweeps and overlap tests to run against the physics world together.
+	/// Results are stored in buffers owned by the batch, which keep their memory between uses, so a
+	/// batch can be cleared and re-filled every frame without allocating
+	///
+	/// All queries take a collision group and mask, which are tested against objects in the same way
+	/// as bullet tests two bodies against each other
+	/// </summary>
+	class PhysicsQueryBatch {
+	public:
+		PhysicsQueryBatch();
+		~PhysicsQueryBatch() = default;
+
+		/// <summary>
+		/// Removes all queries and results from the batch, keeping the memory for re-use
+		/// </summary>
+		void Clear();
+
+		/// <summary>
+		/// Adds a raycast to the batch
+		/// </summary>
+		/// <param name="from">The start of the ray, in world space</param>
+		/// <param name="to">The end of the ray, in world space</param>
+		/// <returns>The index of the raycast, for use with GetRaycastHit</returns>
+		size_t AddRaycast(const glm::vec3& from, const glm::vec3& to, int group = -1, int mask = -1);
+		/// <summary>
+		/// Adds a convex shape sweep to the batch
+		/// </summary>
+		/// <param name="shape">The shape to sweep</param>
+		/// <param name="from">The position to start the sweep from, in world space</param>
+		/// <param name="to">The position to end the sweep at, in world space</param>
+		/// <returns>The index of the sweep, for use with GetSweepHit</returns>
+		size_t AddSweep(const QueryShape& shape, const glm::vec3& from, const glm::vec3& to, int group = -1, int mask = -1);
+		/// <summary>
+		/// Adds an overlap test to the batch, which finds all objects touching a shape
+		/// </summary>
+		/// <param name="shape">The shape to test</param>
+		/// <param name="position">The position of the shape, in world space</param>
+		/// <param name="maxResults">The maximum number of objects to find, extra objects will be ignored</param>
+		/// <returns>The index of the overlap, for use with GetOverlapCount and GetOverlap</returns>
+		size_t AddOverlap(const QueryShape& shape, const glm::vec3& position, size_t maxResults = 8, int group = -1, int mask = -1);
+
+		/// <summary>
+		/// Gets the result of a raycast, only valid once the batch has been run
+		/// </summary>
+		const QueryHit& GetRaycastHit(size_t index) const;
+		/// <summary>
+		/// Gets the result of a sweep, only valid once the batch has been run
+		/// </summary>
+		const QueryHit& GetSweepHit(size_t index) const;
+		/// <summary>
+		/// Gets the number of objects that an overlap test found, only valid once the batch has been run
+		/// </summary>
+		size_t GetOverlapCount(size_t index) const;
+		/// <summary>
+		/// Gets one of the objects that an overlap test found
+		/// </summary>
+		/// <param name="index">The index of the overlap test</param>
+		/// <param name="resultIndex">The index of the result, should be less than GetOverlapCount</param>
+		const std::shared_ptr<PhysicsBase>& GetOverlap(size_t index, size_t resultIndex) const;
+
+		/// <summary>
+		/// Gets the total number of queries in the batch
+		/// </summary>
+		size_t GetQueryCount() const;
+
+	protected:
+		friend class PhysicsQueryRunner;
+
+		struct Raycast {
+			glm::vec3 From;
+			glm::vec3 To;
+			int       Group;
+			int       Mask;
+		};
+		struct Sweep {
+			QueryShape Shape;
+			glm::vec3  From;
+			glm::vec3  To;
+			int        Group;
+			int        Mask;
+		};
+		struct Overlap {
+			QueryShape Shape;
+			glm::vec3  Position;
+			int        Group;
+			int        Mask;
+			// The range of our results buffer that this overlap can write to
+			size_t     FirstResult;
+			size_t     MaxResults;
+			size_t     NumResults;
+		};
+
+		std::vector<Raycast>  _raycasts;
+		std::vector<QueryHit> _raycastHits;
+		std::vector<Sweep>    _sweeps;
+		std::vector<QueryHit> _sweepHits;
+		std::vector<Overlap>  _overlaps;
+		std::vector<std::shared_ptr<PhysicsBase>> _overlapResults;
+	};
+
+	/// <summary>
+	/// Runs batches of physics queries against a collision world, spreading the queries across the
+	/// shared thread pool. Bullet's own world queries share scratch memory between calls, so we walk
+	/// the broadphase and run the narrowphase ourselves, with separate scratch memory for each thread
+	/// </summary>
+	class PhysicsQueryRunner {
+	public:
+		PhysicsQueryRunner();
+		~PhysicsQueryRunner();
+
+		PhysicsQueryRunner(const PhysicsQueryRunner& other) = delete;
+		PhysicsQueryRunner& operator=(const PhysicsQueryRunner& other) = delete;
+
+		/// <summary>
+		/// Runs all queries in the batch, storing the results in the batch. The world must not be
+		/// stepped or modified while the queries are running
+		/// </summary>
+		/// <param name="world">The world to query</param>
+		/// <param name="broadphase">The world's broadphase if it's a DBVT, or nullptr to test against every object</param>
+		/// <param name="batch">The batch of queries to run</param>
+		void Run(btCollisionWorld* world, btDbvtBroadphase* broadphase, PhysicsQueryBatch& batch);
+
+		/// <summary>
+		/// The smallest number of queries that will be handed to a single thread
+		/// </summary>
+		static int GrainSize;
+
+	protected:
+		struct WorkerContext;
+
+		std::vector<std::unique_ptr<WorkerContext>>    _workers;
+		// Holds on to the shapes for the sweeps and overlaps, so that they stay in the shape cache between batches
+		std::vector<std::shared_ptr<btCollisionShape>> _shapes;
+		std::vector<std::shared_ptr<btCollisionShape>> _prevShapes;
+
+		// The world we're running queries against, only set while a batch is running
+		btCollisionWorld*  _world;
+		btDbvtBroadphase*  _broadphase;
+
+		// Invokes the callback for every object whose bounds touch the given bounds and passes the filter
+		template <typename Func>
+		void _ForEachCandidate(WorkerContext& context, const btVector3& aabbMin, const btVector3& aabbMax, int group, int mask, Func callback);
+
+		void _Raycast(WorkerContext& context, PhysicsQueryBatch& batch, size_t index);
+		void _Sweep(WorkerContext& context, PhysicsQueryBatch& batch, size_t index);
+		void _Overlap(WorkerContext& context, PhysicsQueryBatch& batch, size_t index);
+	};
+}
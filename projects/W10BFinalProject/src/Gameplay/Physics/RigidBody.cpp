@@ -12,6 +12,60 @@
 #include "Utils/GlmBulletConversions.h"
 
 namespace Gameplay::Physics {
+	RigidBodyMotionState::RigidBodyMotionState(const btTransform& transform) :
+		btMotionState(),
+		Transform(transform),
+		HasMoved(false)
+	{ }
+
+	void RigidBodyMotionState::getWorldTransform(btTransform& worldTrans) const {
+		worldTrans = Transform;
+	}
+
+	void RigidBodyMotionState::setWorldTransform(const btTransform& worldTrans) {
+		Transform = worldTrans;
+		HasMoved = true;
+	}
+
+	void CcdSettings::SizeFromShape(const btCollisionShape* shape) {
+		btTransform identity;
+		identity.setIdentity();
+		btVector3 min, max;
+		shape->getAabb(identity, min, max);
+
+		// The AABB includes the collision margin, which we don't want to count towards the size
+		const btVector3 extents = max - min;
+		const float halfSize = glm::min(extents.x(), glm::min(extents.y(), extents.z())) * 0.5f - shape->getMargin();
+
+		// Bullet recommends keeping the swept sphere slightly inside of the body
+		MotionThreshold   = glm::max(halfSize, 0.001f);
+		SweptSphereRadius = MotionThreshold * 0.8f;
+	}
+
+	void CcdSettings::ApplyTo(btRigidBody* body) const {
+		// A threshold of 0 disables CCD in bullet
+		body->setCcdMotionThreshold(Enabled ? MotionThreshold : 0.0f);
+		body->setCcdSweptSphereRadius(Enabled ? SweptSphereRadius : 0.0f);
+	}
+
+	CcdSettings CcdSettings::FromJson(const nlohmann::json& blob) {
+		CcdSettings result;
+		result.Enabled           = JsonGet(blob, "enabled", result.Enabled);
+		result.AutoSize          = JsonGet(blob, "auto_size", result.AutoSize);
+		result.MotionThreshold   = JsonGet(blob, "motion_threshold", result.MotionThreshold);
+		result.SweptSphereRadius = JsonGet(blob, "swept_sphere_radius", result.SweptSphereRadius);
+		return result;
+	}
+
+	nlohmann::json CcdSettings::ToJson() const {
+		return {
+			{ "enabled",             Enabled },
+			{ "auto_size",           AutoSize },
+			{ "motion_threshold",    MotionThreshold },
+			{ "swept_sphere_radius", SweptSphereRadius }
+		};
+	}
+
 	RigidBody::RigidBody(RigidBodyType type) :
 		PhysicsBase(),
 		_type(type),
@@ -21,13 +75,23 @@ namespace Gameplay::Physics {
 		_motionState(nullptr),
 		_linearDamping(0.0f),
 		_angularDamping(0.005f),
+		_restitution(0.0f),
+		_friction(0.5f),
+		_isSurfaceDirty(true),
+		_ccd(CcdSettings()),
+		_isCcdDirty(false),
 		_inertia(btVector3()),
 		_linearVelocity(btVector3(0, 0, 0)),
 		_linearVelocityDirty(false),
 		_angularVelocity(btVector3(0, 0, 0)),
 		_angularVelocityDirty(false),
 		_angularFactor(btVector3(1,1,1)),
-		_angularFactorDirty(false)
+		_angularFactorDirty(false),
+		_isTypeDirty(false),
+		_queuedForce(btVector3(0, 0, 0)),
+		_queuedTorque(btVector3(0, 0, 0)),
+		_queuedImpulse(btVector3(0, 0, 0)),
+		_queuedTorqueImpulse(btVector3(0, 0, 0))
 	{ }
 
 	RigidBody::~RigidBody() {
@@ -54,25 +118,18 @@ namespace Gameplay::Physics {
 	}
 
 	glm::vec3 RigidBody::GetTotalForce() const {
-		glm::vec3 retVec3;
-		btVector3 tForce = _body->getTotalForce();
-		retVec3 = glm::vec3(tForce.getX(), tForce.getY(), tForce.getZ());
-		return retVec3;
+		// Bullet clears it's forces after every step, so the only forces on the body are our queued ones
+		return ToGlm(_queuedForce);
 	}
 
 	glm::vec3 RigidBody::GetVelocity() const {
-		btVector3 bodyVeloL = _body->getLinearVelocity();
-		btVector3 bodyVeloA = _body->getAngularVelocity();
-		return glm::vec3(bodyVeloL.getX() + bodyVeloA.getX(),
-			bodyVeloL.getY() + bodyVeloA.getY(),
-			bodyVeloL.getZ() + bodyVeloA.getZ());
+		// We keep copies of bullet's velocities from the last step, so we don't need to touch the body
+		return ToGlm(_linearVelocity + _angularVelocity);
 	}
 
 	void RigidBody::resetVelocity() {
-		btVector3 zeroVelo;
-		zeroVelo.setValue(btScalar(0.0), btScalar(0.0), btScalar(0.0));
-		_body->setAngularVelocity(zeroVelo);
-		_body->setLinearVelocity(zeroVelo);
+		SetLinearVelocity(glm::vec3(0.0f));
+		SetAngularVelocity(glm::vec3(0.0f));
 	}
 
 	void RigidBody::SetLinearDamping(float value) {
@@ -93,6 +150,24 @@ namespace Gameplay::Physics {
 		return _angularDamping;
 	}
 
+	void RigidBody::SetRestitution(float value) {
+		_restitution = value;
+		_isSurfaceDirty = true;
+	}
+
+	float RigidBody::GetRestitution() const {
+		return _restitution;
+	}
+
+	void RigidBody::SetFriction(float value) {
+		_friction = value;
+		_isSurfaceDirty = true;
+	}
+
+	float RigidBody::GetFriction() const {
+		return _friction;
+	}
+
 	void RigidBody::SetLinearVelocity(const glm::vec3& value)
 	{
 		_linearVelocity = ToBt(value);
@@ -123,32 +198,43 @@ namespace Gameplay::Physics {
 	}
 
 	void RigidBody::ApplyForce(const glm::vec3& worldForce) {
-		_body->applyCentralForce(ToBt(worldForce));
+		_queuedForce += ToBt(worldForce);
 	}
 
 	void RigidBody::ApplyForce(const glm::vec3& worldForce, const glm::vec3& localOffset) {
-		_body->applyForce(ToBt(worldForce), ToBt(localOffset));
+		// Same as bullet's applyForce, an offset force is a central force plus a torque
+		_queuedForce += ToBt(worldForce);
+		_queuedTorque += ToBt(glm::cross(localOffset, worldForce));
 	}
 
 	void RigidBody::ApplyImpulse(const glm::vec3& worldForce) {
-		_body->applyCentralImpulse(ToBt(worldForce));
+		_queuedImpulse += ToBt(worldForce);
 	}
 
 	void RigidBody::ApplyImpulse(const glm::vec3& worldForce, const glm::vec3& localOffset) {
-		_body->applyImpulse(ToBt(worldForce), ToBt(localOffset));
+		_queuedImpulse += ToBt(worldForce);
+		_queuedTorqueImpulse += ToBt(glm::cross(localOffset, worldForce));
 	}
 
 	void RigidBody::ApplyTorque(const glm::vec3& worldTorque) {
-		_body->applyTorque(ToBt(worldTorque));
+		_queuedTorque += ToBt(worldTorque);
 	}
 
 	void RigidBody::ApplyTorqueImpulse(const glm::vec3& worldTorque) {
-		_body->applyTorqueImpulse(ToBt(worldTorque));
+		_queuedTorqueImpulse += ToBt(worldTorque);
 	}
 
 	void RigidBody::SetType(RigidBodyType type) {
 		_type = type;
-		if (_body != nullptr) {
+		// Only dynamic bodies use CCD
+		_isCcdDirty = true;
+		// The body may be in use by the physics thread, so we wait for the next step to update bullet
+		_isTypeDirty = _body != nullptr;
+	}
+
+	void RigidBody::_HandleTypeDirty() {
+		if (_isTypeDirty) {
+			_isTypeDirty = false;
 			// Remove any static or kinematic flags for the object
 			int flags = _body->getCollisionFlags() & ~btCollisionObject::CF_STATIC_OBJECT;
 			flags = _body->getCollisionFlags() & ~btCollisionObject::CF_KINEMATIC_OBJECT;
@@ -166,41 +252,104 @@ namespace Gameplay::Physics {
 				_body->setCollisionFlags(flags);
 				_body->setGravity(_scene->GetPhysicsWorld()->getGravity());
 			}
+			_body->activate(true);
 		}
 	}
 
+	void RigidBody::_ApplyQueuedForces() {
+		// Bullet ignores forces on static and kinematic bodies anyways
+		const bool hasForces = !_queuedForce.isZero() || !_queuedTorque.isZero() || !_queuedImpulse.isZero() || !_queuedTorqueImpulse.isZero();
+		if (_type == RigidBodyType::Dynamic && hasForces) {
+			// Bullet won't wake a sleeping body when applying forces, so we do it ourselves
+			_body->activate(true);
+			_body->applyCentralForce(_queuedForce);
+			_body->applyTorque(_queuedTorque);
+			_body->applyCentralImpulse(_queuedImpulse);
+			_body->applyTorqueImpulse(_queuedTorqueImpulse);
+		}
+		_queuedForce         = btVector3(0, 0, 0);
+		_queuedTorque        = btVector3(0, 0, 0);
+		_queuedImpulse       = btVector3(0, 0, 0);
+		_queuedTorqueImpulse = btVector3(0, 0, 0);
+	}
+
 	RigidBodyType RigidBody::GetType() const {
 		return _type;
 	}
 
-	void RigidBody::PhysicsPreStep(float dt) {
+	void RigidBody::SetCcdSettings(const CcdSettings& settings) {
+		_ccd = settings;
+		_isCcdDirty = true;
+	}
+
+	const CcdSettings& RigidBody::GetCcdSettings() const {
+		return _ccd;
+	}
+
+	bool RigidBody::PhysicsPreStep(float dt) {
 		// Update any dirty state that may have changed
 		_HandleStateDirty();
+		// Velocity changes are applied first, so that resetting velocity and then applying an impulse works
+		_ApplyQueuedForces();
 
-		if (_type != RigidBodyType::Static) {		
-			btTransform transform;
-			_CopyGameobjectTransformTo(transform);
+		// Statics never move, and we leave everything else alone unless game code has moved it, so
+		// that bullet is free to put resting bodies to sleep
+		if (_type == RigidBodyType::Static || !_HasGameObjectMoved()) {
+			return false;
+		}
 
-			// Copy to body and to it's motion state
-			if (_type == RigidBodyType::Dynamic) {
-				_body->setWorldTransform(transform);
-			} else {
-				// Kinematics prefer to be driven my motion state for some reason :|
-				_body->getMotionState()->setWorldTransform(transform);
-			}
+		btTransform transform;
+		_CopyGameobjectTransformTo(transform);
+
+		// Kinematics are driven by their motion state, bullet works out their velocity from how it changes
+		_motionState->Transform = transform;
+		if (_type == RigidBodyType::Dynamic) {
+			// Teleport the body, including the transform that bullet interpolates from
+			_body->setWorldTransform(transform);
+			_body->setInterpolationWorldTransform(transform);
+		}
+		// Bullet won't move a sleeping body, or update it's bounds
+		_body->activate(true);
+		// The world only refreshes the bounds of active bodies during the step, so update ours now so that a
+		// teleported body doesn't sit in the broadphase at it's old position. Kinematics read their transform
+		// from the motion state at the start of the step, and get their bounds updated then
+		if (_type == RigidBodyType::Dynamic) {
+			_scene->GetPhysicsWorld()->updateSingleAabb(_body);
 		}
+
+		_MarkTransformSynced();
+		return true;
 	}
 
-	void RigidBody::PhysicsPostStep(float dt) {
+	bool RigidBody::PhysicsPostStep(float dt) {
 		// Kinematics are driven externally and statics don't move, so only need to get data out for dynamics!
-		if (_type == RigidBodyType::Dynamic) {
-			btTransform transform = _body->getWorldTransform();
-			_CopyGameobjectTransformFrom(transform);
+		if (_type != RigidBodyType::Dynamic) {
+			return false;
+		}
 
-			// Store a copy of our velocities
+		// Store a copy of our velocities, unless game code has already set new ones for the next step
+		if (!_linearVelocityDirty) {
 			_linearVelocity = _body->getLinearVelocity();
+		}
+		if (!_angularVelocityDirty) {
 			_angularVelocity = _body->getAngularVelocity();
 		}
+
+		// Bullet only hands out transforms for bodies that are awake
+		if (!_motionState->HasMoved) {
+			return false;
+		}
+		_motionState->HasMoved = false;
+
+		// If game code has moved the object since the step started (ex: while the world was
+		// stepping in the background), keep it's position so it gets sent to bullet next step
+		if (_HasGameObjectMoved()) {
+			return false;
+		}
+
+		_CopyGameobjectTransformFrom(_motionState->Transform);
+		_MarkTransformSynced();
+		return true;
 	}
 
 	void RigidBody::Awake() {
@@ -214,32 +363,34 @@ namespace Gameplay::Physics {
 			collider->Awake(context);
 		}
 
-		// Create our compound shape and add all colliders
-		_shape = new btCompoundShape(true, _colliders.size());
-		_shape->setLocalScaling(ToBt(context->GetScale()));
-		for (auto& collider : _colliders) {
-			_AddColliderToShape(collider.get());
-		}
+		// Create our shape from all of our colliders
+		_RebuildShape();
 		_isShapeDirty = false;
 
-		// Update inertia
-		_shape->calculateLocalInertia(_mass, _inertia);
+		// Update inertia, only dynamic bodies need it (and concave shapes don't support it)
+		if (_type == RigidBodyType::Dynamic) {
+			_shape->calculateLocalInertia(_mass, _inertia);
+		} else {
+			_inertia = btVector3(0.0f, 0.0f, 0.0f);
+		}
 		_isMassDirty = false;
 
-		// Create a default motion state instance for tracking the bodies motion
-		_motionState = new btDefaultMotionState();
-
 		// Get the object's starting transform, create a bullet representation for it
 		btTransform transform; 
 		transform.setIdentity();
 		transform.setOrigin(ToBt(context->GetPosition()));
 		transform.setRotation(ToBt(context->GetRotation()));
-		_motionState->setWorldTransform(transform);
+
+		// Create a motion state that bullet will hand our transforms to as the body moves
+		_motionState = new RigidBodyMotionState(transform);
+		_MarkTransformSynced();
 
 		// Create the bullet rigidbody and add it to the physics scene
 		_body = new btRigidBody(_mass, _motionState, _shape, _inertia);
 		// Add a pointer to our own weak reference to allow getting this component as a shared_ptr later
 		_body->setUserPointer(&SelfRef());
+		// Let the scene's event pipeline know which events we want
+		ContactEventDispatcher::SetEventFlags(_body, _eventFlags);
 
 		_scene->GetPhysicsWorld()->addRigidBody(_body);
 
@@ -252,8 +403,10 @@ namespace Gameplay::Physics {
 			_body->setGravity(btVector3(0.0f, 0.0f, 0.0f));
 			_body->setCollisionFlags(_body->getCollisionFlags() | btCollisionObject::CF_KINEMATIC_OBJECT);
 		}
-	
-		_body->setActivationState(DISABLE_DEACTIVATION);
+
+		// Set up continuous collision detection if we need it
+		_isCcdDirty = true;
+		_HandleCcdDirty();
 
 		// Copy over group and mask info
 		_body->getBroadphaseProxy()->m_collisionFilterGroup = _collisionGroup;
@@ -263,6 +416,23 @@ namespace Gameplay::Physics {
 	void RigidBody::RenderImGui()
 	{
 		_isMassDirty |= LABEL_LEFT(ImGui::DragFloat, "Mass", &_mass, 0.1f, 0.0f);
+		_isSurfaceDirty |= LABEL_LEFT(ImGui::DragFloat, "Restitution", &_restitution, 0.01f, 0.0f, 1.0f);
+		_isSurfaceDirty |= LABEL_LEFT(ImGui::DragFloat, "Friction   ", &_friction, 0.01f, 0.0f);
+
+		// Continuous collision detection settings, the sizes are calculated for us when auto-sizing
+		_isCcdDirty |= LABEL_LEFT(ImGui::Checkbox, "CCD      ", &_ccd.Enabled);
+		if (_ccd.Enabled) {
+			ImGui::Indent();
+			_isCcdDirty |= LABEL_LEFT(ImGui::Checkbox, "Auto Size", &_ccd.AutoSize);
+			if (_ccd.AutoSize) {
+				ImGui::Text("Threshold: %.3f  Radius: %.3f", _ccd.MotionThreshold, _ccd.SweptSphereRadius);
+			} else {
+				_isCcdDirty |= LABEL_LEFT(ImGui::DragFloat, "Threshold", &_ccd.MotionThreshold, 0.01f, 0.0f);
+				_isCcdDirty |= LABEL_LEFT(ImGui::DragFloat, "Radius   ", &_ccd.SweptSphereRadius, 0.01f, 0.0f);
+			}
+			ImGui::Unindent();
+		}
+
 		_RenderImGuiBase();
 	}
 
@@ -273,6 +443,9 @@ namespace Gameplay::Physics {
 		result["mass"] = _mass;
 		result["linear_damping"] = _linearDamping;
 		result["angular_damping"] = _angularDamping;
+		result["restitution"] = _restitution;
+		result["friction"] = _friction;
+		result["ccd"] = _ccd.ToJson();
 		// Write out base physics data
 		ToJsonBase(result);
 		return result;
@@ -285,23 +458,32 @@ namespace Gameplay::Physics {
 		result->_mass = data["mass"];
 		result->_linearDamping  = data["linear_damping"];
 		result->_angularDamping = data["angular_damping"];
+		result->_restitution    = JsonGet(data, "restitution", result->_restitution);
+		result->_friction       = JsonGet(data, "friction", result->_friction);
+		if (data.contains("ccd")) {
+			result->_ccd = CcdSettings::FromJson(data["ccd"]);
+		}
 		// Read out base physics data
 		result->FromJsonBase(data);
 		return result;
 	}
 
 	void RigidBody::_HandleStateDirty() {
+		_HandleTypeDirty();
+
 		// Only dynamic bodies have velocities
 		if (_type == RigidBodyType::Dynamic) {
-			// If outside code has changed our velocity, send that to Bullet
+			// If outside code has changed our velocity, send that to Bullet (and wake the body so it will move)
 			if (_linearVelocityDirty) {
 				_body->setLinearVelocity(_linearVelocity);
+				_body->activate(true);
 				_linearVelocityDirty = false;
 			}
 
 			// If outside code has changed our angular velocity, send that to Bullet
 			if (_angularVelocityDirty) {
 				_body->setAngularVelocity(_angularVelocity);
+				_body->activate(true);
 				_angularVelocityDirty = false;
 			}
 
@@ -313,7 +495,14 @@ namespace Gameplay::Physics {
 		}
 
 		// If one of our colliders has changed, replace it's shape with it's
-		_isMassDirty |= _HandleShapeDirty();
+		if (_HandleShapeDirty()) {
+			_isMassDirty = true;
+			// The new shape may not be resting on anything anymore
+			_body->activate(true);
+			// Our CCD size depends on our shape
+			_isCcdDirty |= _ccd.AutoSize;
+		}
+		_HandleCcdDirty();
 
 		// Handle updating our group or mask if they've changed
 		_HandleGroupDirty();
@@ -324,21 +513,49 @@ namespace Gameplay::Physics {
 			_isDampingDirty = false;
 		}
 
+		// Same for our surface properties, which the solver reads whenever it resolves one of our contacts
+		if (_isSurfaceDirty) {
+			_body->setRestitution(_restitution);
+			_body->setFriction(_friction);
+			_isSurfaceDirty = false;
+		}
+
 		// If the mass has changed, we need to notify bullet
 		if (_isMassDirty) {
 			// Static bodies don't have mass or inertia
 			if (_type != RigidBodyType::Static) {
 				// Recalulcate our inertia properties and send to bullet
-				_shape->calculateLocalInertia(_mass, _inertia);
+				if (_type == RigidBodyType::Dynamic) {
+					_shape->calculateLocalInertia(_mass, _inertia);
+				}
 				_body->setMassProps(_mass, _inertia);
 			}
 			_isMassDirty = false;
 		}
 	}
 
+	void RigidBody::_HandleCcdDirty() {
+		if (_isCcdDirty) {
+			// CCD is only needed for bodies that are moved by the simulation
+			CcdSettings settings = _ccd;
+			settings.Enabled &= _type == RigidBodyType::Dynamic;
+			if (settings.Enabled && _ccd.AutoSize) {
+				_ccd.SizeFromShape(_shape);
+				settings.MotionThreshold   = _ccd.MotionThreshold;
+				settings.SweptSphereRadius = _ccd.SweptSphereRadius;
+			}
+			settings.ApplyTo(_body);
+			_isCcdDirty = false;
+		}
+	}
+
 	btBroadphaseProxy* RigidBody::_GetBroadphaseHandle() {
 		return _body != nullptr ? _body->getBroadphaseProxy() : nullptr;
 	}
 
+	btCollisionObject* RigidBody::_GetCollisionObject() {
+		return _body;
+	}
+
 }
 
@@ -24,6 +24,66 @@ ENUM(RigidBodyType, int,
 namespace Gameplay { class Scene; }
 
 namespace Gameplay::Physics {
+	/// <summary>
+	/// Configures continuous collision detection (CCD) for a body. When a body moves further than the
+	/// motion threshold in a single step, bullet sweeps a sphere along its path to find collisions that
+	/// would otherwise be missed, allowing fast moving bodies to hit thin objects
+	/// </summary>
+	struct CcdSettings {
+		/// <summary>
+		/// True if CCD should be used for the body, only applies to dynamic bodies
+		/// </summary>
+		bool  Enabled           = false;
+		/// <summary>
+		/// True if the threshold and radius should be calculated from the body's collider bounds
+		/// </summary>
+		bool  AutoSize          = true;
+		/// <summary>
+		/// How far the body needs to move in a single step before CCD is used, in meters
+		/// </summary>
+		float MotionThreshold   = 0.0f;
+		/// <summary>
+		/// The radius of the sphere that is swept along the body's path, should fit inside the body
+		/// </summary>
+		float SweptSphereRadius = 0.0f;
+
+		/// <summary>
+		/// Calculates the motion threshold and swept sphere radius from the bounds of a shape, so that
+		/// CCD kicks in when the body moves more than half of its thinnest dimension in a step
+		/// </summary>
+		/// <param name="shape">The shape to size the settings from</param>
+		void SizeFromShape(const btCollisionShape* shape);
+
+		/// <summary>
+		/// Applies these settings to a bullet rigid body
+		/// </summary>
+		void ApplyTo(btRigidBody* body) const;
+
+		static CcdSettings FromJson(const nlohmann::json& blob);
+		nlohmann::json ToJson() const;
+	};
+
+	/// <summary>
+	/// Holds the transform that is shared between a rigid body and bullet. Bullet only writes to
+	/// the motion states of bodies that are awake, and may do so from the physics thread (or from
+	/// several threads with the multithreaded world), so all we do here is store the transform and
+	/// flag it. The game object is updated from it on the main thread in PhysicsPostStep
+	/// </summary>
+	ATTRIBUTE_ALIGNED16(struct) RigidBodyMotionState : public btMotionState {
+		BT_DECLARE_ALIGNED_ALLOCATOR();
+
+		// The last transform that was set by either bullet or the rigid body
+		btTransform Transform;
+		// True if bullet has moved the body since the rigid body last read the transform
+		bool        HasMoved;
+
+		RigidBodyMotionState(const btTransform& transform);
+		virtual ~RigidBodyMotionState() = default;
+
+		virtual void getWorldTransform(btTransform& worldTrans) const override;
+		virtual void setWorldTransform(const btTransform& worldTrans) override;
+	};
+
 	/// <summary>
 	/// A rigid body is a static, kinematic, or dynamic body that represents a collision object
 	/// within our physics scene
@@ -45,15 +105,18 @@ namespace Gameplay::Physics {
 		/// </summary>
 		float GetMass() const;
 		/// <summary>
-		/// Gets the total force of an object
+		/// Gets the total force that has been applied to the object since the last physics step
 		/// </summary>
 		glm::vec3 GetTotalForce() const;
 
 		/// <summary>
-		/// Gets the velocity of the object
+		/// Gets the velocity of the object, as of the last physics step
 		/// </summary>
 		glm::vec3 GetVelocity() const;
 
+		/// <summary>
+		/// Stops the object's linear and angular motion at the start of the next physics step
+		/// </summary>
 		void resetVelocity();
 
 
@@ -83,6 +146,28 @@ namespace Gameplay::Physics {
 		/// </summary>
 		float GetAngularDamping() const;
 
+		/// <summary>
+		/// Sets how bouncy this body is when the solver resolves a contact, where 0 loses all of the
+		/// velocity along the contact normal and 1 keeps all of it. Bullet multiplies the restitution
+		/// of both bodies in a contact, so both need a non-zero restitution to bounce
+		/// </summary>
+		/// <param name="value">The new restitution, default 0</param>
+		void SetRestitution(float value);
+		/// <summary>
+		/// Gets the restitution (ie bounciness) of this body
+		/// </summary>
+		float GetRestitution() const;
+
+		/// <summary>
+		/// Sets the friction of this body's surface, bullet multiplies the friction of both bodies in a contact
+		/// </summary>
+		/// <param name="value">The new friction, default 0.5f</param>
+		void SetFriction(float value);
+		/// <summary>
+		/// Gets the friction of this body's surface
+		/// </summary>
+		float GetFriction() const;
+
 		/// <summary>
 		/// Sets the linear velocity for this body. If called before Awake,
 		/// will set the body's initial velocity
@@ -121,6 +206,10 @@ namespace Gameplay::Physics {
 		/// <summary>
 		/// Applies a force in world space to this object, this would be used
 		/// if you want to apply a force every frame on an object
+		/// 
+		/// Forces, torques and impulses are queued up and handed to bullet at the start
+		/// of the next physics step (after any velocity changes), so they are safe to
+		/// apply while the world is stepping in the background
 		/// </summary>
 		/// <param name="worldForce">The force in world space and Newtons</param>
 		void ApplyForce(const glm::vec3& worldForce);
@@ -164,18 +253,30 @@ namespace Gameplay::Physics {
 		/// </summary>
 		RigidBodyType GetType() const;
 
+		/// <summary>
+		/// Sets the continuous collision detection settings for this body, only
+		/// dynamic bodies will use CCD
+		/// </summary>
+		/// <param name="settings">The new CCD settings for the body</param>
+		void SetCcdSettings(const CcdSettings& settings);
+		/// <summary>
+		/// Gets the continuous collision detection settings for this body. If the settings
+		/// are auto-sized, this will contain the calculated threshold and radius
+		/// </summary>
+		const CcdSettings& GetCcdSettings() const;
+
 		/// <summary>
 		/// Invoked for each RigidBody before the physics world is stepped forward a frame,
 		/// handles body initialization, shape changes, mass changes, etc...
 		/// </summary>
 		/// <param name="dt">The time in seconds since the last frame</param>
-		virtual void PhysicsPreStep(float dt) override;
+		virtual bool PhysicsPreStep(float dt) override;
 		/// <summary>
 		/// Invoked for each RigidBody after the physics world is stepped forward a frame,
 		/// handles copying transform to the OpenGL state
 		/// </summary>
 		/// <param name="dt">The time in seconds since the last frame</param>
-		virtual void PhysicsPostStep(float dt) override;
+		virtual bool PhysicsPostStep(float dt) override;
 
 		// Inherited from IComponent
 		virtual void Awake() override;
@@ -199,9 +300,18 @@ namespace Gameplay::Physics {
 		float _linearDamping;
 		mutable bool _isDampingDirty;
 
+		// The surface properties that the solver uses when resolving our contacts
+		float        _restitution;
+		float        _friction;
+		mutable bool _isSurfaceDirty;
+
+		// Continuous collision detection for fast moving bodies
+		CcdSettings  _ccd;
+		mutable bool _isCcdDirty;
+
 		// Our bullet state stuff
 		btRigidBody*     _body;
-		btMotionState*   _motionState;
+		RigidBodyMotionState* _motionState;
 		btVector3        _inertia;
 		btVector3        _linearVelocity;
 		bool             _linearVelocityDirty;
@@ -209,10 +319,24 @@ namespace Gameplay::Physics {
 		bool             _angularVelocityDirty;
 		btVector3        _angularFactor;
 		bool             _angularFactorDirty;
+		bool             _isTypeDirty;
+
+		// Forces and impulses from game code, sent to bullet at the start of the next step
+		btVector3        _queuedForce;
+		btVector3        _queuedTorque;
+		btVector3        _queuedImpulse;
+		btVector3        _queuedTorqueImpulse;
 
 		// Handles resolving any dirty state stuff for our object
 		void _HandleStateDirty();
+		// Sends our CCD settings to bullet if they've changed, re-sizing them if needed
+		void _HandleCcdDirty();
+		// Updates bullet's collision flags and gravity for the body if our type has changed
+		void _HandleTypeDirty();
+		// Hands any queued forces and impulses to bullet
+		void _ApplyQueuedForces();
 
 		virtual btBroadphaseProxy* _GetBroadphaseHandle() override;
+		virtual btCollisionObject* _GetCollisionObject() override;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,169 @@
+#include "Gameplay/Physics/TriangleMeshCache.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <BulletCollision/CollisionShapes/btOptimizedBvh.h>
+
+#include "Logging.h"
+#include "Utils/GlmBulletConversions.h"
+
+namespace Gameplay::Physics {
+	namespace {
+		// Identifies our BVH files, and lets us ignore files from older versions of the format
+		const uint32_t BVH_FILE_MAGIC   = 0x20485642; // "BVH "
+		const uint32_t BVH_FILE_VERSION = 1;
+	}
+
+	std::string TriangleMeshCache::CacheDirectory = "cache/bvh/";
+	std::unordered_map<uint64_t, TriangleMeshBvh::Sptr> TriangleMeshCache::_shapes;
+
+	TriangleMeshBvh::~TriangleMeshBvh() {
+		// The shape needs to go first, since it references the BVH and the mesh
+		delete Shape;
+		Shape = nullptr;
+		if (BvhBuffer != nullptr) {
+			LoadedBvh->~btOptimizedBvh();
+			btAlignedFree(BvhBuffer);
+			BvhBuffer = nullptr;
+			LoadedBvh = nullptr;
+		}
+	}
+
+	TriangleMeshBvh::Sptr TriangleMeshCache::Get(const MeshResource::Sptr& mesh) {
+		if (mesh == nullptr) {
+			return nullptr;
+		}
+
+		// Meshes that weren't baked by the resource (ex: the optimized OBJ loader) have no stored hash,
+		// so we have to fall back to hashing their geometry
+		MeshGeometry::Sptr geometry = nullptr;
+		uint64_t geometryHash = mesh->GetGeometryHash();
+		if (geometryHash == 0) {
+			geometry = mesh->GetGeometry();
+			if (geometry == nullptr) {
+				return nullptr;
+			}
+			geometryHash = geometry->Hash;
+		}
+
+		// If another collider has already requested this mesh, share it
+		auto it = _shapes.find(geometryHash);
+		if (it != _shapes.end()) {
+			return it->second;
+		}
+
+		// Only now do we need the geometry, which may mean re-loading the mesh if it wasn't kept
+		if (geometry == nullptr) {
+			geometry = mesh->GetGeometry();
+		}
+		if (geometry == nullptr || geometry->GetTriangleCount() == 0) {
+			return nullptr;
+		}
+
+		// The bullet triangle mesh may have already been created for this mesh resource
+		if (mesh->BulletTriMesh == nullptr) {
+			// Create the bullet physics triangle mesh, using 32 bit indices
+			btTriangleMesh* triMesh = new btTriangleMesh(true, false);
+			triMesh->preallocateVertices(static_cast<int>(geometry->Positions.size()));
+			triMesh->preallocateIndices(static_cast<int>(geometry->GetTriangleCount() * 3));
+			for (const glm::vec3& pos : geometry->Positions) {
+				triMesh->findOrAddVertex(ToBt(pos), false);
+			}
+			for (size_t ix = 0; ix < geometry->GetTriangleCount() * 3; ix += 3) {
+				triMesh->addTriangleIndices(geometry->Indices[ix], geometry->Indices[ix + 1], geometry->Indices[ix + 2]);
+			}
+			mesh->BulletTriMesh = std::shared_ptr<btTriangleMesh>(triMesh);
+		}
+
+		TriangleMeshBvh::Sptr result = std::make_shared<TriangleMeshBvh>();
+		result->Mesh = mesh->BulletTriMesh;
+
+		std::stringstream filename;
+		filename << CacheDirectory << std::hex << std::setw(16) << std::setfill('0') << geometry->Hash << ".bvh";
+
+		// Try loading the BVH from disk, otherwise build it and save it for next time
+		if (!_LoadFromFile(filename.str(), geometry->Hash, *result)) {
+			result->Shape = new btBvhTriangleMeshShape(result->Mesh.get(), true, true);
+			LOG_TRACE("Built BVH for mesh {:016x} ({} triangles)", geometry->Hash, geometry->GetTriangleCount());
+			_SaveToFile(filename.str(), geometry->Hash, result->Shape->getOptimizedBvh());
+		}
+
+		_shapes[geometry->Hash] = result;
+		return result;
+	}
+
+	void TriangleMeshCache::Clear() {
+		_shapes.clear();
+	}
+
+	bool TriangleMeshCache::_LoadFromFile(const std::string& filename, uint64_t key, TriangleMeshBvh& result) {
+		std::ifstream file(filename, std::ios::in | std::ios::binary);
+		if (!file.is_open()) {
+			return false;
+		}
+
+		uint32_t magic = 0, version = 0, size = 0;
+		uint64_t fileKey = 0;
+		file.read(reinterpret_cast<char*>(&magic), sizeof(uint32_t));
+		file.read(reinterpret_cast<char*>(&version), sizeof(uint32_t));
+		file.read(reinterpret_cast<char*>(&fileKey), sizeof(uint64_t));
+		file.read(reinterpret_cast<char*>(&size), sizeof(uint32_t));
+		if (!file || magic != BVH_FILE_MAGIC || version != BVH_FILE_VERSION || fileKey != key || size == 0) {
+			LOG_WARN("Ignoring out of date or invalid BVH cache file \"{}\"", filename);
+			return false;
+		}
+
+		// Bullet de-serializes the BVH in place, so the buffer needs to be aligned and outlive the shape
+		void* buffer = btAlignedAlloc(size, 16);
+		file.read(reinterpret_cast<char*>(buffer), size);
+		if (!file) {
+			LOG_WARN("BVH cache file \"{}\" is truncated, rebuilding", filename);
+			btAlignedFree(buffer);
+			return false;
+		}
+
+		btOptimizedBvh* bvh = btOptimizedBvh::deSerializeInPlace(buffer, size, false);
+		if (bvh == nullptr) {
+			LOG_WARN("Failed to de-serialize BVH cache file \"{}\", rebuilding", filename);
+			btAlignedFree(buffer);
+			return false;
+		}
+
+		result.BvhBuffer = buffer;
+		result.LoadedBvh = bvh;
+		result.Shape = new btBvhTriangleMeshShape(result.Mesh.get(), true, false);
+		result.Shape->setOptimizedBvh(bvh);
+		return true;
+	}
+
+	void TriangleMeshCache::_SaveToFile(const std::string& filename, uint64_t key, btOptimizedBvh* bvh) {
+		if (bvh == nullptr) {
+			return;
+		}
+
+		uint32_t size = bvh->calculateSerializeBufferSize();
+		void* buffer = btAlignedAlloc(size, 16);
+		if (!bvh->serializeInPlace(buffer, size, false)) {
+			LOG_WARN("Failed to serialize BVH for \"{}\"", filename);
+			btAlignedFree(buffer);
+			return;
+		}
+
+		std::error_code error;
+		std::filesystem::create_directories(std::filesystem::path(filename).parent_path(), error);
+
+		std::ofstream file(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+		if (file.is_open()) {
+			file.write(reinterpret_cast<const char*>(&BVH_FILE_MAGIC), sizeof(uint32_t));
+			file.write(reinterpret_cast<const char*>(&BVH_FILE_VERSION), sizeof(uint32_t));
+			file.write(reinterpret_cast<const char*>(&key), sizeof(uint64_t));
+			file.write(reinterpret_cast<const char*>(&size), sizeof(uint32_t));
+			file.write(reinterpret_cast<const char*>(buffer), size);
+		} else {
+			LOG_WARN("Failed to open BVH cache file \"{}\" for writing", filename);
+		}
+		btAlignedFree(buffer);
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <unordered_map>
+#include <btBulletCollisionCommon.h>
+
+#include "Gameplay/MeshResource.h"
+
+class btOptimizedBvh;
+
+namespace Gameplay::Physics {
+	/// <summary>
+	/// An unscaled BVH triangle mesh shape, along with the data it depends on. Colliders share these by
+	/// wrapping them in a btScaledBvhTriangleMeshShape
+	/// </summary>
+	struct TriangleMeshBvh {
+		typedef std::shared_ptr<TriangleMeshBvh> Sptr;
+
+		~TriangleMeshBvh();
+
+		/// <summary>
+		/// The triangle mesh that the shape was built from
+		/// </summary>
+		std::shared_ptr<btTriangleMesh> Mesh = nullptr;
+		/// <summary>
+		/// The unscaled shape, should not be modified since it is shared
+		/// </summary>
+		btBvhTriangleMeshShape*         Shape = nullptr;
+		/// <summary>
+		/// If the BVH was loaded from disk, stores the aligned buffer that it was de-serialized into
+		/// </summary>
+		void*                           BvhBuffer = nullptr;
+		btOptimizedBvh*                 LoadedBvh = nullptr;
+	};
+
+	/// <summary>
+	/// Builds and stores BVH triangle mesh shapes for meshes. The quantized BVH is written to disk so
+	/// that it can be loaded directly the next time the game is run, instead of being re-built
+	/// </summary>
+	class TriangleMeshCache {
+	public:
+		/// <summary>
+		/// The directory that BVH files are stored in
+		/// </summary>
+		static std::string CacheDirectory;
+
+		/// <summary>
+		/// Gets the BVH triangle mesh for the given mesh, loading it from disk or building it if needed
+		/// </summary>
+		/// <param name="mesh">The mesh to get the shape for</param>
+		/// <returns>The shared shape for the mesh, or nullptr if the mesh has no geometry</returns>
+		static TriangleMeshBvh::Sptr Get(const MeshResource::Sptr& mesh);
+
+		/// <summary>
+		/// Removes all the shapes stored in memory, shapes that are still in use by colliders will not be freed
+		/// </summary>
+		static void Clear();
+
+	protected:
+		TriangleMeshCache() = default;
+		~TriangleMeshCache() = default;
+
+		static std::unordered_map<uint64_t, TriangleMeshBvh::Sptr> _shapes;
+
+		static bool _LoadFromFile(const std::string& filename, uint64_t key, TriangleMeshBvh& result);
+		static void _SaveToFile(const std::string& filename, uint64_t key, btOptimizedBvh* bvh);
+	};
+}
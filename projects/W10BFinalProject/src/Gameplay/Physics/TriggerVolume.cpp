@@ -13,7 +13,8 @@ namespace Gameplay::Physics {
 		PhysicsBase(),
 		_ghost(nullptr)
 	{
-
+		// Triggers always need to know what is overlapping them
+		_eventFlags = PhysicsEventFlags::Overlap;
 	}
 
 	TriggerVolume::~TriggerVolume() {
@@ -23,115 +24,52 @@ namespace Gameplay::Physics {
 		}
 	}
 
-	void TriggerVolume::PhysicsPreStep(float dt) {
+	bool TriggerVolume::PhysicsPreStep(float dt) {
 		// Update any dirty state that may have changed
 		_HandleShapeDirty();
 		_HandleGroupDirty();
 
+		// Only need to touch the ghost if game code has moved us
+		if (!_HasGameObjectMoved()) {
+			return false;
+		}
+
 		// Copy our transform info from OpenGL
-		GameObject* context = GetGameObject();
 		btTransform transform;
 		_CopyGameobjectTransformTo(transform);
-
 		_ghost->setWorldTransform(transform);
+		// Move the ghost in the broadphase as well, so overlaps are found at the new position this step
+		_scene->GetPhysicsWorld()->updateSingleAabb(_ghost);
+		_MarkTransformSynced();
+		return true;
 	}
 
-	void TriggerVolume::PhysicsPostStep(float dt) {
-		// This will store all the objects inside the trigger this frame
-		std::vector<std::weak_ptr<RigidBody>> thisFrameCollision;
-
-		// Get all our collisions from from the world
-		_scene->GetPhysicsWorld()->getDispatcher()->dispatchAllCollisionPairs(_ghost->getOverlappingPairCache(), _scene->GetPhysicsWorld()->getDispatchInfo(), _scene->GetPhysicsWorld()->getDispatcher());
-		btBroadphasePairArray& collisionPairs = _ghost->getOverlappingPairCache()->getOverlappingPairArray();
-
-		// Determine how many objects are intersecting the volume
-		const int numObjects=collisionPairs.size();
-		thisFrameCollision.reserve(numObjects);
-
-		// Will store our contact manifolds, can be static to be shared between frames and instances
-		static btManifoldArray	m_manifoldArray;
-
-		// Iterate over all the objects that we're colliding with
-		for (int i = 0; i < numObjects; ++i) {
-			// resize the number of manifolds to zero for everything we collide with
-			m_manifoldArray.resize(0);
-
-			// Get the btCollisionObject that we're colliding with
-			btCollisionObject *obj = _ghost->getOverlappingObject(i);
-
-			// Get the contact pair and resolve contact manifolds
-			btBroadphasePair* pair = &collisionPairs[i];
-			if (pair != nullptr && pair->m_algorithm != nullptr) {
-				pair->m_algorithm->getAllContactManifolds(m_manifoldArray);
-			} else {
-				continue;
-			}
-
-			// Iterate over all the contact manifolds and check if any of them have contacts
-			bool hasCollision = false;
-			for (int j=0; j < m_manifoldArray.size(); j++) {
-				btPersistentManifold* manifold = m_manifoldArray[j];
-				if (manifold != nullptr && manifold->getNumContacts() > 0) {
-					hasCollision = true;
-					break;
-				}
-			}
-
-			// If we have contacts and the object's group matches our mask (since this isn't filtered for us)
-			if (hasCollision && (obj->getBroadphaseHandle()->m_collisionFilterGroup & _collisionMask)) {
-				// Make sure the internal type is a bullet rigid body (no trigger-trigger interactions)
-				if (obj->getInternalType() == btCollisionObject::CO_RIGID_BODY) {
-					// Get the collision object as a btRigidBody
-					const btRigidBody *body = (const btRigidBody *)obj;
-
-					// Make sure that the object is not a kinematic or static object (note: you may want
-					// to modify this behaviour depending on your game)
-					if ((body->getCollisionFlags() & btCollisionObject::CF_STATIC_OBJECT)    == 0 &&
-						(body->getCollisionFlags() & btCollisionObject::CF_KINEMATIC_OBJECT) == 0) {
-
-						// Extract the weak pointer that we stored in all our rigidbody user pointers
-						std::weak_ptr<IComponent> rawPtr = *reinterpret_cast<std::weak_ptr<IComponent>*>(body->getUserPointer());
-						// Cast lock the raw pointer and cast up to a RigidBody
-						std::shared_ptr<RigidBody> physicsPtr = std::dynamic_pointer_cast<RigidBody>(rawPtr.lock());
-
-						// As long as we got a pointer out, we can proceed to try and invoke
-						if (physicsPtr != nullptr) {
-							// Add the object to the known collisions for this frame
-							thisFrameCollision.push_back(physicsPtr);
-
-							// Check to see if the object has been added to our object cache
-							auto& it = std::find_if(_currentCollisions.begin(), _currentCollisions.end(), [&](const std::weak_ptr<RigidBody>& item) {
-								return item.lock() == physicsPtr;
-							});
-
-							// If the object is NOT in the cache, we invoke all the callbacks
-							if (it == _currentCollisions.end()) {
-								physicsPtr->GetGameObject()->OnEnteredTrigger(std::dynamic_pointer_cast<TriggerVolume>(SelfRef().lock()));
-								GetGameObject()->OnTriggerVolumeEntered(physicsPtr);
-							}
-						}
-					}
-				}
-
-			}
+	void TriggerVolume::OnContactEvent(ContactEventType type, const std::shared_ptr<PhysicsBase>& other) {
+		// We only care about objects entering or leaving the volume
+		if (type == ContactEventType::Stay) {
+			return;
 		}
-	
-		// Compare our current frame list to the previous frame to see if anything has left
-		for (auto& weakPtr : _currentCollisions) {
-			// Search the the current list to see if the item still exists
-			auto& it = std::find_if(thisFrameCollision.begin(), thisFrameCollision.end(), [&](const std::weak_ptr<RigidBody>& item) {
-				return item.lock() == weakPtr.lock();
-			});
-
-			// If the item no longer exists in the list, we need to invoke exit callbacks
-			if (it == thisFrameCollision.end()) {
-				weakPtr.lock()->GetGameObject()->OnLeavingTrigger(std::dynamic_pointer_cast<TriggerVolume>(SelfRef().lock()));
-				GetGameObject()->OnTriggerVolumeLeaving(weakPtr.lock());
-			}
+
+		// Make sure the object is a rigid body (no trigger-trigger interactions)
+		RigidBody::Sptr body = std::dynamic_pointer_cast<RigidBody>(other);
+		if (body == nullptr) {
+			return;
 		}
 
-		// Load the contents of the current collision items into the cache
-		_currentCollisions.swap(thisFrameCollision);
+		// Make sure the object's group matches our mask (since this isn't filtered for us), and that it
+		// is not a kinematic or static object (note: you may want to modify this behaviour depending on your game)
+		if ((body->GetCollisionGroup() & _collisionMask) == 0 || body->GetType() != RigidBodyType::Dynamic) {
+			return;
+		}
+
+		TriggerVolume::Sptr self = std::dynamic_pointer_cast<TriggerVolume>(SelfRef().lock());
+		if (type == ContactEventType::Begin) {
+			body->GetGameObject()->OnEnteredTrigger(self);
+			GetGameObject()->OnTriggerVolumeEntered(body);
+		} else {
+			body->GetGameObject()->OnLeavingTrigger(self);
+			GetGameObject()->OnTriggerVolumeLeaving(body);
+		}
 	}
 
 	void TriggerVolume::Awake() {
@@ -145,23 +83,22 @@ namespace Gameplay::Physics {
 			collider->Awake(context);
 		}
 
-		// Create our compound shape and add all colliders
-		_shape = new btCompoundShape(true, _colliders.size());
-		_shape->setLocalScaling(ToBt(context->GetScale()));
-		for (auto& collider : _colliders) {
-			_AddColliderToShape(collider.get());
-		}
+		// Create our shape from all of our colliders
+		_RebuildShape();
+		_isShapeDirty = false;
 
 		// Create the ghost object
 		_ghost = new btPairCachingGhostObject();
 		_ghost->setCollisionShape(_shape);
 		_ghost->setUserPointer(&SelfRef());
+		ContactEventDispatcher::SetEventFlags(_ghost, _eventFlags);
 		_ghost->setCollisionFlags(_ghost->getCollisionFlags() | btCollisionObject::CF_NO_CONTACT_RESPONSE);
 
 		// Get the transform and send it to the ghost
 		btTransform transform;
 		_CopyGameobjectTransformTo(transform);
 		_ghost->setWorldTransform(transform);
+		_MarkTransformSynced();
 
 		// Add the object to the scene
 		_scene->GetPhysicsWorld()->addCollisionObject(_ghost);
@@ -190,5 +127,9 @@ namespace Gameplay::Physics {
 	btBroadphaseProxy* TriggerVolume::_GetBroadphaseHandle() {
 		return _ghost != nullptr ? _ghost->getBroadphaseHandle() : nullptr;
 	}
+
+	btCollisionObject* TriggerVolume::_GetCollisionObject() {
+		return _ghost;
+	}
 }
 
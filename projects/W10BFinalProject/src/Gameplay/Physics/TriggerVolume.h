@@ -23,13 +23,12 @@ namespace Gameplay::Physics {
 		/// handles body initialization, shape changes, mass changes, etc...
 		/// </summary>
 		/// <param name="dt">The time in seconds since the last frame</param>
-		virtual void PhysicsPreStep(float dt) override;
+		virtual bool PhysicsPreStep(float dt) override;
+
 		/// <summary>
-		/// Invoked for each RigidBody after the physics world is stepped forward a frame,
-		/// handles copying transform to the OpenGL state
+		/// Invokes the trigger events on gameobjects when dynamic rigid bodies enter or leave the volume
 		/// </summary>
-		/// <param name="dt">The time in seconds since the last frame</param>
-		virtual void PhysicsPostStep(float dt) override;
+		virtual void OnContactEvent(ContactEventType type, const std::shared_ptr<PhysicsBase>& other) override;
 
 		// Inherited from IComponent
 
@@ -42,9 +41,8 @@ namespace Gameplay::Physics {
 	protected:
 		btPairCachingGhostObject*   _ghost;
 
-		std::vector<std::weak_ptr<RigidBody>> _currentCollisions;
-
 		virtual btBroadphaseProxy* _GetBroadphaseHandle() override;
+		virtual btCollisionObject* _GetCollisionObject() override;
 
 	};
 }
\ No newline at end of file
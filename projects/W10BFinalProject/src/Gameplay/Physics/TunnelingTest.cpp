@@ -0,0 +1,86 @@
+#include "Gameplay/Physics/TunnelingTest.h"
+
+#include <memory>
+#include <btBulletDynamicsCommon.h>
+
+#include "Logging.h"
+#include "Gameplay/Physics/RigidBody.h"
+
+namespace Gameplay::Physics {
+	std::vector<TunnelingTestResult> TunnelingTest::Run(const TunnelingTestSettings& settings) {
+		std::vector<TunnelingTestResult> results;
+		results.reserve(settings.Speeds.size() * settings.StepRates.size() * 2);
+		for (float stepRate : settings.StepRates) {
+			for (float speed : settings.Speeds) {
+				for (bool useCcd : { false, true }) {
+					TunnelingTestResult result;
+					result.Speed    = speed;
+					result.StepRate = stepRate;
+					result.UseCcd   = useCcd;
+					result.Tunneled = _RunCase(settings, speed, stepRate, useCcd);
+					results.push_back(result);
+				}
+			}
+		}
+		return results;
+	}
+
+	void TunnelingTest::LogResults(const std::vector<TunnelingTestResult>& results) {
+		LOG_INFO("Tunneling test results:");
+		LOG_INFO("  {:>8} {:>8} {:>5} {:>10}", "Speed", "Rate", "CCD", "Result");
+		int ccdFailures = 0;
+		for (const TunnelingTestResult& result : results) {
+			LOG_INFO("  {:>8.1f} {:>8.1f} {:>5} {:>10}", result.Speed, result.StepRate, result.UseCcd ? "on" : "off", result.Tunneled ? "TUNNELED" : "ok");
+			if (result.UseCcd && result.Tunneled) {
+				ccdFailures++;
+			}
+		}
+		if (ccdFailures > 0) {
+			LOG_WARN("{} CCD case(s) tunneled through the wall", ccdFailures);
+		}
+	}
+
+	bool TunnelingTest::_RunCase(const TunnelingTestSettings& settings, float speed, float stepRate, bool useCcd) {
+		// Each case gets its own world, so that cases can't affect each other
+		std::unique_ptr<btDefaultCollisionConfiguration>     config     = std::make_unique<btDefaultCollisionConfiguration>();
+		std::unique_ptr<btCollisionDispatcher>               dispatcher = std::make_unique<btCollisionDispatcher>(config.get());
+		std::unique_ptr<btDbvtBroadphase>                    broadphase = std::make_unique<btDbvtBroadphase>();
+		std::unique_ptr<btSequentialImpulseConstraintSolver> solver     = std::make_unique<btSequentialImpulseConstraintSolver>();
+		std::unique_ptr<btDiscreteDynamicsWorld>             world      = std::make_unique<btDiscreteDynamicsWorld>(dispatcher.get(), broadphase.get(), solver.get(), config.get());
+		world->setGravity(btVector3(0.0f, 0.0f, 0.0f));
+
+		// A thin static wall at the origin, facing along the X axis
+		btBoxShape wallShape(btVector3(settings.WallThickness * 0.5f, 10.0f, 10.0f));
+		btRigidBody wall(0.0f, nullptr, &wallShape);
+		world->addRigidBody(&wall);
+
+		// A puck fired along the X axis towards the wall
+		btCylinderShapeZ bodyShape(btVector3(settings.BodyRadius, settings.BodyRadius, settings.BodyHeight * 0.5f));
+		btVector3 inertia(0.0f, 0.0f, 0.0f);
+		bodyShape.calculateLocalInertia(1.0f, inertia);
+		btDefaultMotionState motionState(btTransform(btQuaternion::getIdentity(), btVector3(-settings.Distance, 0.0f, 0.0f)));
+		btRigidBody body(1.0f, &motionState, &bodyShape, inertia);
+		body.setActivationState(DISABLE_DEACTIVATION);
+		body.setLinearVelocity(btVector3(speed, 0.0f, 0.0f));
+		world->addRigidBody(&body);
+
+		// Use the same sizing that our rigid bodies use
+		CcdSettings ccd;
+		ccd.Enabled = useCcd;
+		ccd.SizeFromShape(&bodyShape);
+		ccd.ApplyTo(&body);
+
+		// Step for long enough that the body would be well past the wall if nothing stopped it
+		const float timeStep = 1.0f / stepRate;
+		const int numSteps = static_cast<int>(settings.Distance * 2.0f / (speed * timeStep)) + 2;
+		for (int ix = 0; ix < numSteps; ix++) {
+			world->stepSimulation(timeStep, 1, timeStep);
+		}
+
+		const bool tunneled = body.getWorldTransform().getOrigin().x() > 0.0f;
+
+		world->removeRigidBody(&body);
+		world->removeRigidBody(&wall);
+		return tunneled;
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <vector>
+
+namespace Gameplay::Physics {
+	/// <summary>
+	/// Configures the bodies and sweep used by the tunneling test
+	/// </summary>
+	struct TunnelingTestSettings {
+		/// <summary>
+		/// The speeds to fire the body at the wall with, in m/s
+		/// </summary>
+		std::vector<float> Speeds        = { 10.0f, 25.0f, 50.0f, 100.0f, 200.0f };
+		/// <summary>
+		/// The physics tick rates to test with, in steps per second
+		/// </summary>
+		std::vector<float> StepRates     = { 30.0f, 60.0f, 120.0f };
+		/// <summary>
+		/// The thickness of the wall that the body is fired at, in meters
+		/// </summary>
+		float              WallThickness = 0.05f;
+		/// <summary>
+		/// The radius of the puck shaped body that is fired at the wall
+		/// </summary>
+		float              BodyRadius    = 0.5f;
+		/// <summary>
+		/// The height of the puck shaped body that is fired at the wall
+		/// </summary>
+		float              BodyHeight    = 0.2f;
+		/// <summary>
+		/// How far from the wall the body starts
+		/// </summary>
+		float              Distance      = 5.0f;
+	};
+
+	/// <summary>
+	/// The result of firing a single body at the wall
+	/// </summary>
+	struct TunnelingTestResult {
+		float Speed;
+		float StepRate;
+		bool  UseCcd;
+		// True if the body ended up on the other side of the wall
+		bool  Tunneled;
+	};
+
+	/// <summary>
+	/// A headless test that fires bodies at thin walls in an isolated physics world across a sweep of
+	/// velocities and step rates, both with and without CCD, and reports which combinations tunnel
+	/// through the wall. Useful for checking that our CCD settings hold up before lowering the tick rate
+	/// </summary>
+	class TunnelingTest {
+	public:
+		/// <summary>
+		/// Runs every combination of speed and step rate from the settings, with and without CCD
+		/// </summary>
+		/// <param name="settings">The settings for the test</param>
+		/// <returns>The results for each combination</returns>
+		static std::vector<TunnelingTestResult> Run(const TunnelingTestSettings& settings = TunnelingTestSettings());
+
+		/// <summary>
+		/// Writes a table of results to the log, and warns if any CCD cases tunneled
+		/// </summary>
+		/// <param name="results">The results to log</param>
+		static void LogResults(const std::vector<TunnelingTestResult>& results);
+
+	protected:
+		TunnelingTest() = default;
+		~TunnelingTest() = default;
+
+		static bool _RunCase(const TunnelingTestSettings& settings, float speed, float stepRate, bool useCcd);
+	};
+}
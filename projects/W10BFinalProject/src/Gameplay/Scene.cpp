@@ -12,6 +12,7 @@
 #include "Graphics/DebugDraw.h"
 #include "Graphics/TextureCube.h"
 #include "Graphics/VertexArrayObject.h"
+#include "Graphics/GlState.h"
 
 namespace Gameplay {
 	Scene::Scene() :
@@ -21,6 +22,14 @@ namespace Gameplay {
 		IsPlaying(false),
 		MainCamera(nullptr),
 		DefaultMaterial(nullptr),
+		_physicsSettings(),
+		_physicsBackend(nullptr),
+		_physicsWorld(nullptr),
+		_physicsStep(),
+		_isStepPending(false),
+		_pendingStepDt(0.0f),
+		_syncStats(),
+		_bulletDebugDraw(nullptr),
 		_isAwake(false),
 		_filePath(""),
 		_skyboxShader(nullptr),
@@ -39,8 +48,11 @@ namespace Gameplay {
 	}
 
 	Scene::~Scene() {
+		// Objects will be pulling themselves out of the world, so we can't have a step running
+		_WaitForPhysics();
 		_objects.clear();
 		_CleanupPhysics();
+		delete _bulletDebugDraw;
 	}
 
 	void Scene::SetPhysicsDebugDrawMode(BulletDebugMode mode) {
@@ -135,31 +147,78 @@ namespace Gameplay {
 	}
 
 	void Scene::DoPhysics(float dt) {
+		// Make sure the last step has been handed out before we send anything new to the world
+		SyncPhysics();
+
+		_PhysicsPreStep(dt);
+
+		if (IsPlaying) {
+			if (_physicsSettings.AsyncStep) {
+				// Only the world is touched by the job, our objects get the results in SyncPhysics. The step has
+				// to run on the shared pool, since bullet's per-thread data is sized for that pool's threads
+				// and a thread from outside it would index past the end when the world is multithreaded
+				btDynamicsWorld* world = _physicsWorld;
+				_physicsStep = ThreadPool::Get().Enqueue([world, dt]() {
+					world->stepSimulation(dt, 15);
+				});
+				_isStepPending = true;
+				_pendingStepDt = dt;
+			} else {
+				_physicsWorld->stepSimulation(dt, 15);
+				_PhysicsPostStep(dt);
+			}
+		}
+	}
+
+	void Scene::SyncPhysics() {
+		_WaitForPhysics();
+		if (_isStepPending) {
+			_isStepPending = false;
+			_PhysicsPostStep(_pendingStepDt);
+		}
+	}
+
+	const Physics::TransformSyncStats& Scene::GetTransformSyncStats() const {
+		return _syncStats;
+	}
+
+	void Scene::_WaitForPhysics() const {
+		if (_physicsStep.valid()) {
+			_physicsStep.get();
+		}
+	}
+
+	void Scene::_PhysicsPreStep(float dt) {
+		_syncStats.Pushed = 0;
+		_syncStats.PushSkipped = 0;
 		ComponentManager::Each<Gameplay::Physics::RigidBody>([=](const std::shared_ptr<Gameplay::Physics::RigidBody>& body) {
-			body->PhysicsPreStep(dt);
+			(body->PhysicsPreStep(dt) ? _syncStats.Pushed : _syncStats.PushSkipped)++;
 		});
 		ComponentManager::Each<Gameplay::Physics::TriggerVolume>([=](const std::shared_ptr<Gameplay::Physics::TriggerVolume>& body) {
-			body->PhysicsPreStep(dt);
+			(body->PhysicsPreStep(dt) ? _syncStats.Pushed : _syncStats.PushSkipped)++;
 		});
+	}
 
-		if (IsPlaying) {
+	void Scene::_PhysicsPostStep(float dt) {
+		_syncStats.Pulled = 0;
+		_syncStats.PullSkipped = 0;
+		ComponentManager::Each<Gameplay::Physics::RigidBody>([=](const std::shared_ptr<Gameplay::Physics::RigidBody>& body) {
+			(body->PhysicsPostStep(dt) ? _syncStats.Pulled : _syncStats.PullSkipped)++;
+		});
+		// Trigger volumes are never moved by bullet, so there's nothing to pull back for them
 
-			_physicsWorld->stepSimulation(dt, 15);
-
-			ComponentManager::Each<Gameplay::Physics::RigidBody>([=](const std::shared_ptr<Gameplay::Physics::RigidBody>& body) {
-				body->PhysicsPostStep(dt);
-			});
-			ComponentManager::Each<Gameplay::Physics::TriggerVolume>([=](const std::shared_ptr<Gameplay::Physics::TriggerVolume>& body) {
-				body->PhysicsPostStep(dt);
-			});
-			if (_bulletDebugDraw->getDebugMode() != btIDebugDraw::DBG_NoDebug) {
-				_physicsWorld->debugDrawWorld();
-				DebugDrawer::Get().FlushAll();
-			}
+		// Find all the contacts from this step, and send events to any objects that want them
+		_contactEvents.ProcessWorld(_physicsWorld);
+
+		if (_bulletDebugDraw->getDebugMode() != btIDebugDraw::DBG_NoDebug) {
+			_physicsWorld->debugDrawWorld();
+			DebugDrawer::Get().FlushAll();
 		}
 	}
 
 	void Scene::Update(float dt) {
+		// Hand out the results of any step that ran while the last frame was rendering
+		SyncPhysics();
 		_FlushDeleteQueue();
 		if (IsPlaying) {
 			for (auto& obj : _objects) {
@@ -206,12 +265,96 @@ namespace Gameplay {
 	}
 
 	btDynamicsWorld* Scene::GetPhysicsWorld() const {
+		_WaitForPhysics();
 		return _physicsWorld;
 	}
 
+	void Scene::RunPhysicsQueries(Physics::PhysicsQueryBatch& batch) {
+		_WaitForPhysics();
+		_queryRunner.Run(_physicsWorld, _physicsBackend->GetDbvtBroadphase(), batch);
+	}
+
+	void Scene::SetPhysicsSettings(const Physics::PhysicsSettings& settings) {
+		// Collect the last step before we change anything
+		SyncPhysics();
+		if (!settings.RequiresRebuild(_physicsSettings)) {
+			_physicsSettings = settings;
+			return;
+		}
+
+		// Pull everything out of the old world, remembering the filters they were added with
+		struct MovedObject {
+			btCollisionObject* Object;
+			int                Group;
+			int                Mask;
+		};
+		std::vector<MovedObject> objects;
+		btCollisionObjectArray& worldObjects = _physicsWorld->getCollisionObjectArray();
+		objects.reserve(worldObjects.size());
+		for (int ix = worldObjects.size() - 1; ix >= 0; ix--) {
+			btCollisionObject* object = worldObjects[ix];
+			btBroadphaseProxy* proxy = object->getBroadphaseHandle();
+			objects.push_back({ object, proxy->m_collisionFilterGroup, proxy->m_collisionFilterMask });
+
+			btRigidBody* body = btRigidBody::upcast(object);
+			if (body != nullptr) {
+				_physicsWorld->removeRigidBody(body);
+			} else {
+				_physicsWorld->removeCollisionObject(object);
+			}
+		}
+
+		// Contacts are tracked by broadphase ID, which won't survive the move
+		_CleanupPhysics();
+		_physicsSettings = settings;
+		_InitPhysics();
+
+		// Add them back in the order that they were originally added
+		for (auto it = objects.rbegin(); it != objects.rend(); it++) {
+			btRigidBody* body = btRigidBody::upcast(it->Object);
+			if (body != nullptr) {
+				_physicsWorld->addRigidBody(body, it->Group, it->Mask);
+			} else {
+				_physicsWorld->addCollisionObject(it->Object, it->Group, it->Mask);
+			}
+		}
+		LOG_INFO("Rebuilt physics world ({}, {}) with {} objects", ~_physicsSettings.Broadphase, _physicsSettings.Multithreaded ? "multithreaded" : "single threaded", objects.size());
+	}
+
+	const Physics::PhysicsSettings& Scene::GetPhysicsSettings() const {
+		return _physicsSettings;
+	}
+
+	Physics::QueryHit Scene::Raycast(const glm::vec3& from, const glm::vec3& to, int group, int mask) {
+		_singleQuery.Clear();
+		_singleQuery.AddRaycast(from, to, group, mask);
+		RunPhysicsQueries(_singleQuery);
+		return _singleQuery.GetRaycastHit(0);
+	}
+
+	Physics::QueryHit Scene::PickFromScreen(const glm::vec2& screenPos, float maxDistance, int mask) {
+		if (MainCamera == nullptr || Window == nullptr) {
+			return Physics::QueryHit();
+		}
+
+		int width, height;
+		glfwGetWindowSize(Window, &width, &height);
+		if (width == 0 || height == 0) {
+			return Physics::QueryHit();
+		}
+
+		glm::vec3 origin, end;
+		MainCamera->ScreenPointToRay(screenPos, glm::vec2(width, height), origin, end);
+		return Raycast(origin, origin + glm::normalize(end - origin) * maxDistance, -1, mask);
+	}
+
 	Scene::Sptr Scene::FromJson(const nlohmann::json& data)
 	{
 		Scene::Sptr result = std::make_shared<Scene>();
+		// Build the physics world before any objects are loaded, so they don't need to be moved
+		if (data.contains("physics")) {
+			result->SetPhysicsSettings(Physics::PhysicsSettings::FromJson(data["physics"]));
+		}
 		result->DefaultMaterial = ResourceManager::Get<Material>(Guid(data["default_material"]));
 
 		if (data.contains("ambient")) {
@@ -254,6 +397,7 @@ namespace Gameplay {
 		blob["default_material"] = DefaultMaterial ? DefaultMaterial->GetGUID().str() : "null";
 
 		blob["ambient"] = GlmToJson(GetAmbientLight());
+		blob["physics"] = _physicsSettings.ToJson();
 
 		blob["skybox"] = nlohmann::json();
 		blob["skybox"]["mesh"] = _skyboxMesh ? _skyboxMesh->GetGUID().str() : "null";
@@ -309,32 +453,23 @@ namespace Gameplay {
 	}
 
 	void Scene::_InitPhysics() {
-		_collisionConfig = new btDefaultCollisionConfiguration();
-		_collisionDispatcher = new btCollisionDispatcher(_collisionConfig);
-		_broadphaseInterface = new btDbvtBroadphase();
-		_ghostCallback = new btGhostPairCallback();
-		_broadphaseInterface->getOverlappingPairCache()->setInternalGhostPairCallback(_ghostCallback);
-		_constraintSolver = new btSequentialImpulseConstraintSolver();
-		_physicsWorld = new btDiscreteDynamicsWorld(
-			_collisionDispatcher,
-			_broadphaseInterface,
-			_constraintSolver,
-			_collisionConfig
-		);
+		_physicsBackend = std::make_unique<Physics::PhysicsBackend>(_physicsSettings);
+		_physicsWorld = _physicsBackend->GetWorld();
 		_physicsWorld->setGravity(ToBt(_gravity));
-		// TODO bullet debug drawing
-		_bulletDebugDraw = new BulletDebugDraw();
+		// The debug drawer outlives the world, so that the draw mode is kept if the world is rebuilt
+		if (_bulletDebugDraw == nullptr) {
+			_bulletDebugDraw = new BulletDebugDraw();
+			_bulletDebugDraw->setDebugMode(btIDebugDraw::DBG_NoDebug);
+		}
 		_physicsWorld->setDebugDrawer(_bulletDebugDraw);
-		_bulletDebugDraw->setDebugMode(btIDebugDraw::DBG_NoDebug);
 	}
 
 	void Scene::_CleanupPhysics() {
-		delete _physicsWorld;
-		delete _constraintSolver;
-		delete _broadphaseInterface;
-		delete _ghostCallback;
-		delete _collisionDispatcher;
-		delete _collisionConfig;
+		_WaitForPhysics();
+		_isStepPending = false;
+		_contactEvents.Clear();
+		_physicsBackend = nullptr;
+		_physicsWorld = nullptr;
 	}
 
 
@@ -366,25 +501,37 @@ namespace Gameplay {
 
 	void Scene::DrawSkybox()
 	{
+		// The skybox is just left out until it's shader has finished compiling
 		if (_skyboxShader != nullptr &&
+			_skyboxShader->IsReady() &&
 			_skyboxMesh != nullptr &&
 			_skyboxMesh->Mesh != nullptr &&
 			_skyboxTexture != nullptr &&
 			MainCamera != nullptr) {
 			
-			glDepthMask(false);
-			glDisable(GL_CULL_FACE);
-			glDepthFunc(GL_LEQUAL);
+			// The skybox is drawn at the far plane without writing depth, and we see it from the inside
+			const DepthState prevDepth = GlState::GetDepthState();
+			const CullState prevCull = GlState::GetCullState();
+			DepthState depth = prevDepth;
+			depth.WriteEnabled = false;
+			depth.Func = GL_LEQUAL;
+			CullState cull = prevCull;
+			cull.Enabled = false;
+			GlState::SetDepthState(depth);
+			GlState::SetCullState(cull);
+
+			// Handles are interned once, after that setting the uniform doesn't need any string lookups
+			static const UniformHandle viewHandle = "u_View"_uniform;
+			static const UniformHandle rotationHandle = "u_EnvironmentRotation"_uniform;
 
 			_skyboxShader->Bind();
-			_skyboxShader->SetUniformMatrix("u_View", MainCamera->GetProjection() * glm::mat4(glm::mat3(MainCamera->GetView())));
-			_skyboxShader->SetUniformMatrix("u_EnvironmentRotation", _skyboxRotation);
+			_skyboxShader->SetUniformMatrix(viewHandle, MainCamera->GetProjection() * glm::mat4(glm::mat3(MainCamera->GetView())));
+			_skyboxShader->SetUniformMatrix(rotationHandle, _skyboxRotation);
 			_skyboxTexture->Bind(0);
 			_skyboxMesh->Mesh->Draw();
 
-			glDepthFunc(GL_LESS);
-			glEnable(GL_CULL_FACE);
-			glDepthMask(true);
+			GlState::SetDepthState(prevDepth);
+			GlState::SetCullState(prevCull);
 
 		}
 	}
@@ -7,8 +7,13 @@
 #include "Gameplay/Light.h"
 
 #include "Physics/BulletDebugDraw.h"
+#include "Gameplay/Physics/ContactEvents.h"
+#include "Gameplay/Physics/PhysicsBase.h"
+#include "Gameplay/Physics/PhysicsQueries.h"
+#include "Gameplay/Physics/PhysicsBackend.h"
 
 #include "Graphics/UniformBuffer.h"
+#include "Utils/ThreadPool.h"
 
 struct GLFWwindow;
 
@@ -34,6 +39,7 @@ namespace Gameplay {
 	public:
 		typedef std::shared_ptr<Scene> Sptr;
 
+		// Must match LIGHT_BLOCK_SIZE in fragments/multiple_point_lights.glsl
 		static const int MAX_LIGHTS = 10;
 		static const int LIGHT_UBO_BINDING = 2;
 
@@ -125,9 +131,27 @@ namespace Gameplay {
 		/// should be called after Update in the main loop
 		/// 
 		/// Only invokes events if IsPlaying is true
+		/// 
+		/// If the physics settings have AsyncStep enabled, the step will be started as a
+		/// job on the shared thread pool and this will return right away. The results will be handed
+		/// to our objects the next time SyncPhysics is called
 		/// </summary>
 		/// <param name="dt">The time in seconds since the last frame</param>
 		void DoPhysics(float dt);
+		/// <summary>
+		/// Waits for a physics step running in the background to finish, then copies the
+		/// results to our objects and sends out contact events on this thread. Does nothing
+		/// if there is no step to collect
+		/// 
+		/// This is called at the start of Update and DoPhysics, so usually doesn't need to be
+		/// called manually
+		/// </summary>
+		void SyncPhysics();
+		/// <summary>
+		/// Gets how many physics objects had their transforms exchanged with their game objects
+		/// during the last physics update, and how many were skipped since they hadn't moved
+		/// </summary>
+		const Physics::TransformSyncStats& GetTransformSyncStats() const;
 
 		/// <summary>
 		/// Performs updates on all enabled components and gameobjects in the
@@ -164,10 +188,43 @@ namespace Gameplay {
 		void DrawSkybox();
 
 		/// <summary>
-		/// Gets the scene's Bullet physics world
+		/// Gets the scene's Bullet physics world. This will wait for any step running in the
+		/// background, so the world is always safe to modify
 		/// </summary>
 		btDynamicsWorld* GetPhysicsWorld() const;
 
+		/// <summary>
+		/// Changes how the scene's physics world is built. If the settings are different from the current
+		/// ones, the world is rebuilt and all objects in the old world are moved to the new one
+		/// </summary>
+		/// <param name="settings">The new physics settings for the scene</param>
+		void SetPhysicsSettings(const Physics::PhysicsSettings& settings);
+		/// <summary>
+		/// Gets the settings that the scene's physics world was built with
+		/// </summary>
+		const Physics::PhysicsSettings& GetPhysicsSettings() const;
+
+		/// <summary>
+		/// Runs a batch of raycasts, sweeps and overlap tests against the physics world, spread
+		/// across worker threads. Should not be called while the world is being stepped
+		/// </summary>
+		/// <param name="batch">The batch of queries to run, results will be stored in the batch</param>
+		void RunPhysicsQueries(Physics::PhysicsQueryBatch& batch);
+		/// <summary>
+		/// Casts a single ray into the physics world, and returns the closest hit. When doing many
+		/// queries, use RunPhysicsQueries instead
+		/// </summary>
+		/// <param name="from">The start of the ray, in world space</param>
+		/// <param name="to">The end of the ray, in world space</param>
+		Physics::QueryHit Raycast(const glm::vec3& from, const glm::vec3& to, int group = -1, int mask = -1);
+		/// <summary>
+		/// Finds the physics object under a point on the screen, using the main camera
+		/// </summary>
+		/// <param name="screenPos">The point on the screen in pixels, ex: the mouse position</param>
+		/// <param name="maxDistance">The furthest distance from the camera to pick objects</param>
+		/// <param name="mask">The collision groups to pick from</param>
+		Physics::QueryHit PickFromScreen(const glm::vec2& screenPos, float maxDistance = 1000.0f, int mask = -1);
+
 		/// <summary>
 		/// Loads a scene from a JSON blob
 		/// </summary>
@@ -194,18 +251,26 @@ namespace Gameplay {
 		GameObject::Sptr GetObjectByIndex(int index) const;
 
 	protected:
-		// Bullet physics stuff world
+		// Configures how our physics world is built
+		Physics::PhysicsSettings  _physicsSettings;
+		// Owns the bullet world, and all the bits and pieces that it's built from
+		std::unique_ptr<Physics::PhysicsBackend> _physicsBackend;
+		// Bullet physics stuff world, owned by the backend
 		btDynamicsWorld*          _physicsWorld;
-		// Our bullet physics configuration
-		btCollisionConfiguration* _collisionConfig; 
-		// Handles dispatching collisions between objects
-		btCollisionDispatcher*    _collisionDispatcher;
-		// Provides rough broadphase (AABB) checks to improve performance
-		btBroadphaseInterface*    _broadphaseInterface;
-		// Resolves contraints (ex: hinge constraints, angle axis, etc...)
-		btConstraintSolver*       _constraintSolver;
-		// this is what allows us to get our pairs from the trigger volumes
-		btGhostPairCallback*      _ghostCallback;
+		// The step running on the shared thread pool, if any
+		mutable std::future<void> _physicsStep;
+		// True if a step has been started, but it's results haven't been sent to our objects yet
+		bool                      _isStepPending;
+		// The time step of the pending step
+		float                     _pendingStepDt;
+		// Tracks how many bodies needed their transforms synced during the last update
+		Physics::TransformSyncStats _syncStats;
+		// Sends contact and overlap events to physics objects after each step
+		Physics::ContactEventDispatcher _contactEvents;
+		// Runs batches of raycasts, sweeps and overlaps against our physics world
+		Physics::PhysicsQueryRunner     _queryRunner;
+		// Re-used for single queries, so they don't need to allocate
+		Physics::PhysicsQueryBatch      _singleQuery;
 
 		BulletDebugDraw* _bulletDebugDraw;
 
@@ -266,6 +331,18 @@ namespace Gameplay {
 		/// Handles cleaning up bullet physics for this scene
 		/// </summary>
 		void _CleanupPhysics();
+		/// <summary>
+		/// Blocks until the physics thread has finished stepping the world, without touching our objects
+		/// </summary>
+		void _WaitForPhysics() const;
+		/// <summary>
+		/// Sends our objects' state to the physics world before a step
+		/// </summary>
+		void _PhysicsPreStep(float dt);
+		/// <summary>
+		/// Copies the results of a step to our objects, and sends out contact events
+		/// </summary>
+		void _PhysicsPostStep(float dt);
 
 		void _FlushDeleteQueue();
 	};
@@ -1,4 +1,5 @@
 #include "Graphics/DebugDraw.h"
+#include "Graphics/GlState.h"
 
 DebugDrawer::DebugDrawer() :
 	_colorStack(std::stack<glm::vec3>()),
@@ -17,6 +18,17 @@ DebugDrawer::DebugDrawer() :
 	_trisVAO = VertexArrayObject::Create();
 	_trisVAO->AddVertexBuffer(_trisVBO, VertexPosCol::V_DECL);
 
+	if (StreamingBuffer::IsSupported()) {
+		// Enough room for a few full batches of each per frame
+		_linesStream = std::make_shared<StreamingBuffer>(BufferType::Vertex, LINE_BATCH_SIZE * 2 * sizeof(VertexPosCol) * 4);
+		_linesStreamVAO = VertexArrayObject::Create();
+		_linesStreamVAO->AddVertexBuffer(_linesStream, VertexPosCol::V_DECL);
+
+		_trisStream = std::make_shared<StreamingBuffer>(BufferType::Vertex, TRI_BATCH_SIZE * 3 * sizeof(VertexPosCol) * 4);
+		_trisStreamVAO = VertexArrayObject::Create();
+		_trisStreamVAO->AddVertexBuffer(_trisStream, VertexPosCol::V_DECL);
+	}
+
 	_colorStack.push(glm::vec3(1.0f));
 	_transformStack.push(glm::mat4(1.0f));
 }
@@ -68,19 +80,8 @@ void DebugDrawer::DrawLine(const glm::vec3& p1, const glm::vec3& p2, const glm::
 void DebugDrawer::FlushLines()
 {
 	if (_lineOffset > 0) {
-		__Shader->Bind();
-		__Shader->SetUniformMatrix("u_MVP", _viewProjection * _transformStack.top());
-		int restorePoint = 0;
-		glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &restorePoint);
-		VertexArrayObject::Unbind();
-		_linesVBO->LoadData<VertexPosCol>(_lineBuffer, LINE_BATCH_SIZE * 2);
-		_linesVAO->Bind();
-		_linesVAO->Draw(DrawMode::LineList);
-		_linesVAO->Unbind();
+		_DrawBatch(_lineBuffer, _lineOffset, _linesStream, _linesStreamVAO, _linesVBO, _linesVAO);
 		_lineOffset = 0;
-		if (restorePoint != 0) {
-			glBindVertexArray(restorePoint);
-		}
 	}
 }
 
@@ -111,19 +112,8 @@ void DebugDrawer::DrawTri(const glm::vec3& p1, const glm::vec3& p2, const glm::v
 void DebugDrawer::FlushTris()
 {
 	if (_triangleOffset > 0) {
-		__Shader->Bind();
-		__Shader->SetUniformMatrix("u_MVP", _viewProjection * _transformStack.top());
-		int restorePoint = 0;
-		glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &restorePoint);
-		VertexArrayObject::Unbind();
-		_trisVBO->LoadData<VertexPosCol>(_triBuffer, TRI_BATCH_SIZE * 3);
-		_trisVAO->Bind();
-		_trisVAO->Draw(DrawMode::LineList);
-		_trisVAO->Unbind();
+		_DrawBatch(_triBuffer, _triangleOffset, _trisStream, _trisStreamVAO, _trisVBO, _trisVAO);
 		_triangleOffset = 0;
-		if (restorePoint != 0) {
-			glBindVertexArray(restorePoint);
-		}
 	}
 }
 
@@ -133,6 +123,31 @@ void DebugDrawer::FlushAll()
 	FlushTris();
 }
 
+void DebugDrawer::_DrawBatch(const VertexPosCol* vertices, size_t count, const StreamingBuffer::Sptr& stream, const VertexArrayObject::Sptr& streamVao, const VertexBuffer::Sptr& vbo, const VertexArrayObject::Sptr& vao)
+{
+	static const UniformHandle mvpHandle = "u_MVP"_uniform;
+
+	__Shader->Bind();
+	__Shader->SetUniformMatrix(mvpHandle, _viewProjection * _transformStack.top());
+	// The state tracker already knows what's bound, so we don't need to query GL to restore it
+	GLuint restorePoint = GlState::GetVertexArray();
+
+	// Aligning to the vertex size lets us point the draw at our slot with the first vertex
+	size_t offset = 0;
+	void* slot = stream != nullptr ? stream->Allocate(count * sizeof(VertexPosCol), sizeof(VertexPosCol), offset) : nullptr;
+	if (slot != nullptr) {
+		memcpy(slot, vertices, count * sizeof(VertexPosCol));
+		streamVao->Bind();
+		glDrawArrays(GL_LINES, static_cast<GLint>(offset / sizeof(VertexPosCol)), static_cast<GLsizei>(count));
+	} else {
+		vbo->LoadData<VertexPosCol>(vertices, count);
+		vao->Bind();
+		glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(count));
+	}
+
+	GlState::BindVertexArray(restorePoint);
+}
+
 void DebugDrawer::SetViewProjection(const glm::mat4& viewProjection)
 {
 	_viewProjection = viewProjection;
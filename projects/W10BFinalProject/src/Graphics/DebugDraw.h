@@ -3,6 +3,7 @@
 #include <stack>
 #include "Graphics/VertexTypes.h"
 #include "Graphics/Shader.h"
+#include "Graphics/StreamingBuffer.h"
 
 /// <summary>
 /// Utility class for drawing lines and triangles in an immediate mode style
@@ -143,6 +144,16 @@ protected:
 	VertexBuffer::Sptr _trisVBO;
 	VertexArrayObject::Sptr _trisVAO;
 
+	// When supported, batches are written straight into persistently mapped buffers instead, the
+	// VBOs above are only used when a frame runs out of streaming space
+	StreamingBuffer::Sptr _linesStream;
+	VertexArrayObject::Sptr _linesStreamVAO;
+	StreamingBuffer::Sptr _trisStream;
+	VertexArrayObject::Sptr _trisStreamVAO;
+
+	// Uploads a batch of vertices and draws them as lines
+	void _DrawBatch(const VertexPosCol* vertices, size_t count, const StreamingBuffer::Sptr& stream, const VertexArrayObject::Sptr& streamVao, const VertexBuffer::Sptr& vbo, const VertexArrayObject::Sptr& vao);
+
 	inline static DebugDrawer* __Instance = nullptr;
 	inline static Shader::Sptr __Shader = nullptr;
 };
\ No newline at end of file
@@ -0,0 +1,307 @@
+#include "Graphics/GeometryArena.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "Logging.h"
+
+namespace {
+	// The capacity that new arenas start with, they'll grow as meshes are added
+	const uint32_t INITIAL_VERTEX_CAPACITY = 16384;
+	const uint32_t INITIAL_INDEX_CAPACITY  = 65536;
+
+	bool IsSameAttribute(const BufferAttribute& a, const BufferAttribute& b) {
+		return a.Slot == b.Slot && a.Size == b.Size && a.Type == b.Type && a.Normalized == b.Normalized &&
+			a.Stride == b.Stride && a.Offset == b.Offset;
+	}
+
+	bool IsSameLayout(const VertexArrayObject::VertexDeclaration& a, const VertexArrayObject::VertexDeclaration& b) {
+		return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), IsSameAttribute);
+	}
+
+	// Only meshes that are drawn from a single vertex buffer with indices can live in an arena
+	bool CanUseArena(const VertexArrayObject::Sptr& mesh) {
+		return mesh != nullptr && mesh->GetVertexBuffers().size() == 1 && mesh->GetIndexBuffer() != nullptr &&
+			mesh->GetIndexBuffer()->GetElementType() != IndexType::Unknown && !mesh->GetVertexBuffers()[0].Attributes.empty();
+	}
+}
+
+GeometryArena* GeometryArena::Register(const VertexArrayObject::Sptr& mesh) {
+	if (!CanUseArena(mesh)) {
+		return nullptr;
+	}
+
+	for (const Sptr& arena : __Arenas) {
+		if (arena->IsCompatible(mesh)) {
+			return arena->Add(mesh) ? arena.get() : nullptr;
+		}
+	}
+
+	Sptr arena = std::make_shared<GeometryArena>(mesh->GetVertexBuffers()[0].Attributes, mesh->GetIndexBuffer()->GetElementType());
+	__Arenas.push_back(arena);
+	return arena->Add(mesh) ? arena.get() : nullptr;
+}
+
+GeometryArena* GeometryArena::Find(const VertexArrayObject* mesh, MeshRange& range) {
+	for (const Sptr& arena : __Arenas) {
+		if (arena->TryGetRange(mesh, range)) {
+			return arena.get();
+		}
+	}
+	return nullptr;
+}
+
+void GeometryArena::DefragmentAll() {
+	for (const Sptr& arena : __Arenas) {
+		arena->Defragment();
+	}
+}
+
+void GeometryArena::Cleanup() {
+	__Arenas.clear();
+}
+
+GeometryArena::GeometryArena(const VertexArrayObject::VertexDeclaration& layout, IndexType indexType) :
+	_layout(layout),
+	_indexType(indexType),
+	_stride(layout[0].Stride),
+	_indexSize(GetIndexTypeSize(indexType)),
+	_vertices(nullptr),
+	_indices(nullptr),
+	_instanceBase(nullptr),
+	_vao(nullptr),
+	_vertexSpace(),
+	_indexSpace(),
+	_vertexBlocks(),
+	_meshes()
+{
+	// With a divisor larger than any instance count, every instance of a draw reads the element at
+	// the draw's base instance, so we just need to store the index of each element
+	std::vector<float> instanceBases(MAX_BASE_INSTANCE);
+	for (int ix = 0; ix < MAX_BASE_INSTANCE; ix++) {
+		instanceBases[ix] = static_cast<float>(ix);
+	}
+	_instanceBase = VertexBuffer::Create(BufferUsage::StaticDraw);
+	_instanceBase->LoadData(instanceBases.data(), instanceBases.size());
+
+	_Rebuild(INITIAL_VERTEX_CAPACITY, INITIAL_INDEX_CAPACITY);
+}
+
+bool GeometryArena::IsCompatible(const VertexArrayObject::Sptr& mesh) const {
+	return CanUseArena(mesh) && mesh->GetIndexBuffer()->GetElementType() == _indexType &&
+		IsSameLayout(mesh->GetVertexBuffers()[0].Attributes, _layout);
+}
+
+bool GeometryArena::Add(const VertexArrayObject::Sptr& mesh) {
+	if (!IsCompatible(mesh)) {
+		return false;
+	}
+
+	// The mesh may already be here, or a destroyed mesh may have lived at the same address
+	auto existing = _meshes.find(mesh.get());
+	if (existing != _meshes.end()) {
+		if (existing->second.Mesh.lock() == mesh) {
+			return true;
+		}
+		_Remove(mesh.get());
+	}
+
+	const std::shared_ptr<IBuffer>& source = mesh->GetVertexBuffers()[0].Buffer;
+	auto block = _vertexBlocks.find(source.get());
+	if (block != _vertexBlocks.end() && block->second.Source.expired()) {
+		_CollectGarbage();
+		block = _vertexBlocks.end();
+	}
+
+	// Meshes sharing a vertex buffer only need their indices copied
+	const uint32_t vertexCount = block == _vertexBlocks.end() ? static_cast<uint32_t>(source->GetTotalSize() / _stride) : 0;
+	const uint32_t indexCount = static_cast<uint32_t>(mesh->GetIndexBuffer()->GetElementCount());
+	uint32_t vertexOffset = 0;
+	uint32_t indexOffset = 0;
+	if (!_Reserve(vertexCount, indexCount, vertexOffset, indexOffset)) {
+		return false;
+	}
+
+	if (vertexCount > 0) {
+		glCopyNamedBufferSubData(source->GetHandle(), _vertices->GetHandle(), 0, vertexOffset * _stride, vertexCount * _stride);
+		VertexBlock newBlock;
+		newBlock.Source = source;
+		newBlock.Vertices = { vertexOffset, vertexCount };
+		newBlock.RefCount = 0;
+		block = _vertexBlocks.emplace(source.get(), newBlock).first;
+	}
+	block->second.RefCount++;
+
+	glCopyNamedBufferSubData(mesh->GetIndexBuffer()->GetHandle(), _indices->GetHandle(), 0, indexOffset * _indexSize, indexCount * _indexSize);
+	MeshEntry entry;
+	entry.Mesh = mesh;
+	entry.VertexSource = source.get();
+	entry.Indices = { indexOffset, indexCount };
+	_meshes[mesh.get()] = entry;
+	return true;
+}
+
+bool GeometryArena::TryGetRange(const VertexArrayObject* mesh, MeshRange& range) const {
+	auto it = _meshes.find(mesh);
+	if (it == _meshes.end() || it->second.Mesh.expired()) {
+		return false;
+	}
+	range.FirstIndex = it->second.Indices.Offset;
+	range.IndexCount = it->second.Indices.Count;
+	range.BaseVertex = static_cast<int32_t>(_vertexBlocks.at(it->second.VertexSource).Vertices.Offset);
+	return true;
+}
+
+void GeometryArena::Defragment() {
+	_CollectGarbage();
+	_Rebuild(_vertexSpace.GetCapacity(), _indexSpace.GetCapacity());
+}
+
+void GeometryArena::_CollectGarbage() {
+	std::vector<const VertexArrayObject*> expired;
+	for (const auto& [key, entry] : _meshes) {
+		if (entry.Mesh.expired()) {
+			expired.push_back(key);
+		}
+	}
+	for (const VertexArrayObject* mesh : expired) {
+		_Remove(mesh);
+	}
+}
+
+void GeometryArena::_Remove(const VertexArrayObject* mesh) {
+	auto it = _meshes.find(mesh);
+	if (it == _meshes.end()) {
+		return;
+	}
+	_indexSpace.Free(it->second.Indices.Offset, it->second.Indices.Count);
+
+	auto block = _vertexBlocks.find(it->second.VertexSource);
+	if (block != _vertexBlocks.end() && --block->second.RefCount <= 0) {
+		_vertexSpace.Free(block->second.Vertices.Offset, block->second.Vertices.Count);
+		_vertexBlocks.erase(block);
+	}
+	_meshes.erase(it);
+}
+
+bool GeometryArena::_Reserve(uint32_t vertexCount, uint32_t indexCount, uint32_t& vertexOffset, uint32_t& indexOffset) {
+	for (int attempt = 0; attempt < 2; attempt++) {
+		bool hasVertices = vertexCount == 0 || _vertexSpace.Allocate(vertexCount, vertexOffset);
+		bool hasIndices = hasVertices && _indexSpace.Allocate(indexCount, indexOffset);
+		if (hasVertices && hasIndices) {
+			return true;
+		}
+		if (hasVertices && vertexCount > 0) {
+			_vertexSpace.Free(vertexOffset, vertexCount);
+		}
+		if (attempt > 0) {
+			break;
+		}
+
+		// If there's enough free space in total then compacting will make room, otherwise we need to grow
+		_CollectGarbage();
+		uint32_t vertexCapacity = _vertexSpace.GetCapacity();
+		uint32_t indexCapacity = _indexSpace.GetCapacity();
+		if (_vertexSpace.GetFreeCount() < vertexCount) {
+			vertexCapacity = std::max(vertexCapacity * 2, vertexCapacity - _vertexSpace.GetFreeCount() + vertexCount);
+		}
+		if (_indexSpace.GetFreeCount() < indexCount) {
+			indexCapacity = std::max(indexCapacity * 2, indexCapacity - _indexSpace.GetFreeCount() + indexCount);
+		}
+		_Rebuild(vertexCapacity, indexCapacity);
+	}
+
+	LOG_WARN("Failed to allocate {} vertices and {} indices in geometry arena", vertexCount, indexCount);
+	return false;
+}
+
+void GeometryArena::_Rebuild(uint32_t vertexCapacity, uint32_t indexCapacity) {
+	VertexBuffer::Sptr vertices = VertexBuffer::Create(BufferUsage::StaticDraw);
+	vertices->LoadData(nullptr, _stride, vertexCapacity);
+	IndexBuffer::Sptr indices = IndexBuffer::Create(BufferUsage::StaticDraw);
+	indices->LoadData(nullptr, _indexSize, indexCapacity, _indexType);
+
+	// Pack everything at the start of the new buffers, in whatever order the maps give us
+	uint32_t vertexHead = 0;
+	for (auto& [source, block] : _vertexBlocks) {
+		if (block.Vertices.Count > 0) {
+			glCopyNamedBufferSubData(_vertices->GetHandle(), vertices->GetHandle(), block.Vertices.Offset * _stride, vertexHead * _stride, block.Vertices.Count * _stride);
+		}
+		block.Vertices.Offset = vertexHead;
+		vertexHead += block.Vertices.Count;
+	}
+	uint32_t indexHead = 0;
+	for (auto& [mesh, entry] : _meshes) {
+		if (entry.Indices.Count > 0) {
+			glCopyNamedBufferSubData(_indices->GetHandle(), indices->GetHandle(), entry.Indices.Offset * _indexSize, indexHead * _indexSize, entry.Indices.Count * _indexSize);
+		}
+		entry.Indices.Offset = indexHead;
+		indexHead += entry.Indices.Count;
+	}
+
+	_vertices = vertices;
+	_indices = indices;
+	_vertexSpace.Reset(vertexCapacity, vertexHead);
+	_indexSpace.Reset(indexCapacity, indexHead);
+
+	_vao = VertexArrayObject::Create();
+	_vao->AddVertexBuffer(_vertices, _layout);
+	_vao->SetIndexBuffer(_indices);
+	_vao->SetVDecl(_layout);
+
+	// Feed the base instance to the shader, see the constructor for how this works
+	_vao->AddVertexBuffer(_instanceBase, {
+		BufferAttribute(INSTANCE_BASE_SLOT, 1, AttributeType::Float, sizeof(float), 0, AttribUsage::User3)
+	}, std::numeric_limits<GLuint>::max());
+}
+
+void GeometryArena::FreeList::Reset(uint32_t capacity, uint32_t used) {
+	_capacity = capacity;
+	_free.clear();
+	if (used < capacity) {
+		_free.push_back({ used, capacity - used });
+	}
+}
+
+bool GeometryArena::FreeList::Allocate(uint32_t count, uint32_t& offset) {
+	for (auto it = _free.begin(); it != _free.end(); it++) {
+		if (it->Count >= count) {
+			offset = it->Offset;
+			it->Offset += count;
+			it->Count -= count;
+			if (it->Count == 0) {
+				_free.erase(it);
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+void GeometryArena::FreeList::Free(uint32_t offset, uint32_t count) {
+	if (count == 0) {
+		return;
+	}
+
+	// Insert in order, then merge with the neighbours on either side
+	auto it = std::lower_bound(_free.begin(), _free.end(), offset, [](const Span& span, uint32_t value) {
+		return span.Offset < value;
+	});
+	it = _free.insert(it, { offset, count });
+	if (it + 1 != _free.end() && it->Offset + it->Count == (it + 1)->Offset) {
+		it->Count += (it + 1)->Count;
+		_free.erase(it + 1);
+	}
+	if (it != _free.begin() && (it - 1)->Offset + (it - 1)->Count == it->Offset) {
+		(it - 1)->Count += it->Count;
+		_free.erase(it);
+	}
+}
+
+uint32_t GeometryArena::FreeList::GetFreeCount() const {
+	uint32_t result = 0;
+	for (const Span& span : _free) {
+		result += span.Count;
+	}
+	return result;
+}
@@ -0,0 +1,176 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <unordered_map>
+
+#include "Graphics/VertexArrayObject.h"
+
+/// <summary>
+/// Matches the layout that glMultiDrawElementsIndirect reads each draw from
+/// </summary>
+/// <see>https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glMultiDrawElementsIndirect.xhtml</see>
+struct DrawElementsIndirectCommand {
+	GLuint Count;
+	GLuint InstanceCount;
+	GLuint FirstIndex;
+	GLint  BaseVertex;
+	GLuint BaseInstance;
+};
+
+/// <summary>
+/// Large shared vertex and index buffers that meshes with the same vertex layout and index type are
+/// copied into, so that they can all be drawn from a single VAO. Since everything lives in the same
+/// buffers, many meshes can be drawn with a single call to glMultiDrawElementsIndirect
+///
+/// Meshes keep their own VAOs as well, so that they can still be drawn on their own. Space is handed
+/// out with a first fit free list, and the arena is compacted when it gets too fragmented to fit new
+/// meshes, or grown when there really isn't enough room
+///
+/// The arena VAO also feeds the draw's base instance to the vertex shader (see INSTANCE_BASE_SLOT), since
+/// gl_InstanceID does not include it
+/// </summary>
+class GeometryArena {
+public:
+	typedef std::shared_ptr<GeometryArena> Sptr;
+
+	/// <summary>
+	/// The vertex attribute slot that receives the base instance of the current draw, must match
+	/// inInstanceBase in fragments/vs_common.glsl
+	/// </summary>
+	static const GLuint INSTANCE_BASE_SLOT = 15;
+	/// <summary>
+	/// The largest base instance that can be passed to the shader
+	/// </summary>
+	static const int MAX_BASE_INSTANCE = 1024;
+
+	/// <summary>
+	/// Where a mesh's indices and vertices live within an arena
+	/// </summary>
+	struct MeshRange {
+		uint32_t FirstIndex;
+		uint32_t IndexCount;
+		int32_t  BaseVertex;
+	};
+
+	/// <summary>
+	/// Copies a mesh into the arena for it's vertex layout and index type, creating the arena if needed.
+	/// Only meshes with a single vertex buffer and an index buffer can be added
+	/// </summary>
+	/// <param name="mesh">The mesh to add</param>
+	/// <returns>The arena that the mesh was added to, or nullptr if it can't be added to an arena</returns>
+	static GeometryArena* Register(const VertexArrayObject::Sptr& mesh);
+	/// <summary>
+	/// Finds the arena that a mesh was registered with
+	/// </summary>
+	/// <param name="mesh">The mesh to search for</param>
+	/// <param name="range">Will be set to the mesh's range within the arena</param>
+	/// <returns>The arena containing the mesh, or nullptr if it is not in an arena</returns>
+	static GeometryArena* Find(const VertexArrayObject* mesh, MeshRange& range);
+	/// <summary>
+	/// Releases space used by destroyed meshes and compacts every arena
+	/// </summary>
+	static void DefragmentAll();
+	/// <summary>
+	/// Destroys all arenas, should be called before the GL context is destroyed
+	/// </summary>
+	static void Cleanup();
+
+	GeometryArena(const VertexArrayObject::VertexDeclaration& layout, IndexType indexType);
+	~GeometryArena() = default;
+
+	GeometryArena(const GeometryArena& other) = delete;
+	GeometryArena& operator=(const GeometryArena& other) = delete;
+
+	/// <summary>
+	/// Copies a mesh's vertices and indices into this arena. Meshes that share a vertex buffer (ex: LODs)
+	/// will share their vertices in the arena as well
+	/// </summary>
+	/// <param name="mesh">The mesh to add, must match this arena's layout and index type</param>
+	/// <returns>True if the mesh was added</returns>
+	bool Add(const VertexArrayObject::Sptr& mesh);
+	/// <summary>
+	/// Gets the range of a mesh within this arena
+	/// </summary>
+	/// <param name="mesh">The mesh to search for</param>
+	/// <param name="range">Will be set to the mesh's range within the arena</param>
+	/// <returns>True if the mesh is in this arena</returns>
+	bool TryGetRange(const VertexArrayObject* mesh, MeshRange& range) const;
+	/// <summary>
+	/// Releases space used by destroyed meshes, and moves everything to the start of the buffers
+	/// </summary>
+	void Defragment();
+
+	/// <summary>
+	/// Checks whether a mesh could be stored in this arena
+	/// </summary>
+	bool IsCompatible(const VertexArrayObject::Sptr& mesh) const;
+
+	/// <summary>
+	/// Gets the VAO that draws from this arena's buffers
+	/// </summary>
+	const VertexArrayObject::Sptr& GetVao() const { return _vao; }
+	/// <summary>
+	/// Gets the type of indices stored in this arena
+	/// </summary>
+	IndexType GetIndexType() const { return _indexType; }
+
+protected:
+	// A range of space in one of the buffers, in elements
+	struct Span {
+		uint32_t Offset;
+		uint32_t Count;
+	};
+
+	// A first fit allocator over a range of elements, free spans are kept sorted by offset
+	class FreeList {
+	public:
+		void Reset(uint32_t capacity, uint32_t used = 0);
+		bool Allocate(uint32_t count, uint32_t& offset);
+		void Free(uint32_t offset, uint32_t count);
+		uint32_t GetCapacity() const { return _capacity; }
+		uint32_t GetFreeCount() const;
+	protected:
+		uint32_t          _capacity = 0;
+		std::vector<Span> _free;
+	};
+
+	// The vertices copied from a source vertex buffer, shared by all meshes that use the buffer
+	struct VertexBlock {
+		std::weak_ptr<IBuffer> Source;
+		Span                   Vertices;
+		int                    RefCount;
+	};
+
+	// A mesh's indices within the arena, and the source buffer that it's vertices came from
+	struct MeshEntry {
+		std::weak_ptr<VertexArrayObject> Mesh;
+		const IBuffer*                   VertexSource;
+		Span                             Indices;
+	};
+
+	VertexArrayObject::VertexDeclaration _layout;
+	IndexType                            _indexType;
+	size_t                               _stride;
+	size_t                               _indexSize;
+
+	VertexBuffer::Sptr      _vertices;
+	IndexBuffer::Sptr       _indices;
+	VertexBuffer::Sptr      _instanceBase;
+	VertexArrayObject::Sptr _vao;
+	FreeList                _vertexSpace;
+	FreeList                _indexSpace;
+
+	std::unordered_map<const IBuffer*, VertexBlock>           _vertexBlocks;
+	std::unordered_map<const VertexArrayObject*, MeshEntry>   _meshes;
+
+	inline static std::vector<Sptr> __Arenas;
+
+	// Drops any meshes and vertex blocks whose source has been destroyed, freeing their space
+	void _CollectGarbage();
+	// Removes a single mesh from the arena, releasing it's vertex block if nothing else uses it
+	void _Remove(const VertexArrayObject* mesh);
+	// Moves everything into new buffers with the given capacities, packed at the start
+	void _Rebuild(uint32_t vertexCapacity, uint32_t indexCapacity);
+	// Allocates space for the given number of vertices and indices, compacting or growing as needed
+	bool _Reserve(uint32_t vertexCount, uint32_t indexCount, uint32_t& vertexOffset, uint32_t& indexOffset);
+};
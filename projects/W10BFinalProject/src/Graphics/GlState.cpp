@@ -0,0 +1,158 @@
+#include "GlState.h"
+
+void GlState::UseProgram(GLuint program) {
+	if (__Track(__program, program)) {
+		glUseProgram(program);
+	}
+}
+
+void GlState::BindVertexArray(GLuint vao) {
+	if (__Track(__vertexArray, vao)) {
+		glBindVertexArray(vao);
+	}
+}
+
+void GlState::BindTexture(int unit, GLuint texture) {
+	if (__Track(__Slot(__textures, unit, UNKNOWN), texture)) {
+		glBindTextureUnit(unit, texture);
+	}
+}
+
+void GlState::BindSampler(int unit, GLuint sampler) {
+	if (__Track(__Slot(__samplers, unit, UNKNOWN), sampler)) {
+		glBindSampler(unit, sampler);
+	}
+}
+
+void GlState::BindUniformBuffer(int slot, GLuint buffer) {
+	UniformBinding binding;
+	binding.Buffer = buffer;
+	if (__Track(__Slot(__uniformBuffers, slot, UniformBinding()), binding)) {
+		glBindBufferBase(GL_UNIFORM_BUFFER, slot, buffer);
+	}
+}
+
+void GlState::BindUniformBufferRange(int slot, GLuint buffer, size_t offset, size_t size) {
+	UniformBinding binding;
+	binding.Buffer = buffer;
+	binding.Offset = offset;
+	binding.Size = size;
+	if (__Track(__Slot(__uniformBuffers, slot, UniformBinding()), binding)) {
+		glBindBufferRange(GL_UNIFORM_BUFFER, slot, buffer, offset, size);
+	}
+}
+
+void GlState::SetDepthState(const DepthState& state) {
+	if (__depthKnown && state == __depth) {
+		__frameStats.Skipped++;
+		return;
+	}
+
+	// Only send the parts of the block that actually changed
+	if (!__depthKnown || state.TestEnabled != __depth.TestEnabled) {
+		state.TestEnabled ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
+		__frameStats.Issued++;
+	}
+	if (!__depthKnown || state.WriteEnabled != __depth.WriteEnabled) {
+		glDepthMask(state.WriteEnabled);
+		__frameStats.Issued++;
+	}
+	if (!__depthKnown || state.Func != __depth.Func) {
+		glDepthFunc(state.Func);
+		__frameStats.Issued++;
+	}
+	__depth = state;
+	__depthKnown = true;
+}
+
+void GlState::SetBlendState(const BlendState& state) {
+	if (__blendKnown && state == __blend) {
+		__frameStats.Skipped++;
+		return;
+	}
+
+	if (!__blendKnown || state.Enabled != __blend.Enabled) {
+		state.Enabled ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+		__frameStats.Issued++;
+	}
+	if (!__blendKnown || state.SrcFactor != __blend.SrcFactor || state.DstFactor != __blend.DstFactor) {
+		glBlendFunc(state.SrcFactor, state.DstFactor);
+		__frameStats.Issued++;
+	}
+	__blend = state;
+	__blendKnown = true;
+}
+
+void GlState::SetCullState(const CullState& state) {
+	if (__cullKnown && state == __cull) {
+		__frameStats.Skipped++;
+		return;
+	}
+
+	if (!__cullKnown || state.Enabled != __cull.Enabled) {
+		state.Enabled ? glEnable(GL_CULL_FACE) : glDisable(GL_CULL_FACE);
+		__frameStats.Issued++;
+	}
+	if (!__cullKnown || state.Face != __cull.Face) {
+		glCullFace(state.Face);
+		__frameStats.Issued++;
+	}
+	__cull = state;
+	__cullKnown = true;
+}
+
+void GlState::ReleaseProgram(GLuint program) {
+	// A deleted program stays in use until something else is bound, but it's name can be reused
+	if (__program == program) {
+		__program = UNKNOWN;
+	}
+}
+
+void GlState::ReleaseVertexArray(GLuint vao) {
+	// Deleting a bound VAO reverts the binding to 0
+	if (__vertexArray == vao) {
+		__vertexArray = 0;
+	}
+}
+
+void GlState::ReleaseTexture(GLuint texture) {
+	// Deleting a texture unbinds it from every unit
+	for (GLuint& bound : __textures) {
+		if (bound == texture) {
+			bound = 0;
+		}
+	}
+}
+
+void GlState::ReleaseSampler(GLuint sampler) {
+	for (GLuint& bound : __samplers) {
+		if (bound == sampler) {
+			bound = 0;
+		}
+	}
+}
+
+void GlState::ReleaseBuffer(GLuint buffer) {
+	// We forget about any slots using the buffer, so they get re-bound even if the name is reused
+	for (UniformBinding& binding : __uniformBuffers) {
+		if (binding.Buffer == buffer) {
+			binding = UniformBinding();
+		}
+	}
+}
+
+void GlState::Invalidate() {
+	__program = UNKNOWN;
+	__vertexArray = UNKNOWN;
+	__textures.clear();
+	__samplers.clear();
+	__uniformBuffers.clear();
+	__depthKnown = false;
+	__blendKnown = false;
+	__cullKnown = false;
+}
+
+void GlState::EndFrame() {
+	__lastFrameStats = __frameStats;
+	__frameStats = GlStateStats();
+}
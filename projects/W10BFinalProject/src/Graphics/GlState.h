@@ -0,0 +1,172 @@
+#pragma once
+#include <glad/glad.h>
+#include <vector>
+#include <climits>
+
+/// <summary>
+/// Depth testing and depth writing state
+/// </summary>
+struct DepthState {
+	bool   TestEnabled  = false;
+	bool   WriteEnabled = true;
+	GLenum Func         = GL_LESS;
+
+	bool operator==(const DepthState& other) const {
+		return TestEnabled == other.TestEnabled && WriteEnabled == other.WriteEnabled && Func == other.Func;
+	}
+	bool operator!=(const DepthState& other) const { return !(*this == other); }
+};
+
+/// <summary>
+/// Color blending state
+/// </summary>
+struct BlendState {
+	bool   Enabled   = false;
+	GLenum SrcFactor = GL_ONE;
+	GLenum DstFactor = GL_ZERO;
+
+	bool operator==(const BlendState& other) const {
+		return Enabled == other.Enabled && SrcFactor == other.SrcFactor && DstFactor == other.DstFactor;
+	}
+	bool operator!=(const BlendState& other) const { return !(*this == other); }
+};
+
+/// <summary>
+/// Face culling state
+/// </summary>
+struct CullState {
+	bool   Enabled = false;
+	GLenum Face    = GL_BACK;
+
+	bool operator==(const CullState& other) const {
+		return Enabled == other.Enabled && Face == other.Face;
+	}
+	bool operator!=(const CullState& other) const { return !(*this == other); }
+};
+
+/// <summary>
+/// The number of GL state changes that were sent to the driver, and the number that were skipped
+/// because the state was already set
+/// </summary>
+struct GlStateStats {
+	int Issued  = 0;
+	int Skipped = 0;
+};
+
+/// <summary>
+/// Keeps a CPU side copy of the GL state that we change most often, so that binds and state changes
+/// that wouldn't change anything can be skipped instead of going through the driver
+///
+/// Our wrappers (Shader, VertexArrayObject, ITexture, the uniform buffers) all go through this, so
+/// anything that changes this state directly needs to call Invalidate afterwards. ImGui restores the
+/// state it changes, so it's safe to use alongside the tracker
+/// </summary>
+class GlState {
+public:
+	/// <summary>
+	/// Binds a shader program, equivalent to glUseProgram
+	/// </summary>
+	static void UseProgram(GLuint program);
+	/// <summary>
+	/// Binds a vertex array object, equivalent to glBindVertexArray
+	/// </summary>
+	static void BindVertexArray(GLuint vao);
+	/// <summary>
+	/// Binds a texture to a texture unit, equivalent to glBindTextureUnit
+	/// </summary>
+	static void BindTexture(int unit, GLuint texture);
+	/// <summary>
+	/// Binds a sampler object to a texture unit, equivalent to glBindSampler
+	/// </summary>
+	static void BindSampler(int unit, GLuint sampler);
+	/// <summary>
+	/// Binds an entire buffer to a uniform buffer slot, equivalent to glBindBufferBase
+	/// </summary>
+	static void BindUniformBuffer(int slot, GLuint buffer);
+	/// <summary>
+	/// Binds a range of a buffer to a uniform buffer slot, equivalent to glBindBufferRange
+	/// </summary>
+	static void BindUniformBufferRange(int slot, GLuint buffer, size_t offset, size_t size);
+
+	static void SetDepthState(const DepthState& state);
+	static void SetBlendState(const BlendState& state);
+	static void SetCullState(const CullState& state);
+
+	static GLuint GetProgram() { return __program; }
+	static GLuint GetVertexArray() { return __vertexArray; }
+	static const DepthState& GetDepthState() { return __depth; }
+	static const BlendState& GetBlendState() { return __blend; }
+	static const CullState& GetCullState() { return __cull; }
+
+	// These should be called when GL objects are deleted, since their names may be reused
+	static void ReleaseProgram(GLuint program);
+	static void ReleaseVertexArray(GLuint vao);
+	static void ReleaseTexture(GLuint texture);
+	static void ReleaseSampler(GLuint sampler);
+	static void ReleaseBuffer(GLuint buffer);
+
+	/// <summary>
+	/// Forgets all cached state, so that the next change of each piece of state is always sent
+	/// </summary>
+	static void Invalidate();
+
+	/// <summary>
+	/// Marks the end of the frame, the counters for this frame are moved to GetStats and reset
+	/// </summary>
+	static void EndFrame();
+	/// <summary>
+	/// Gets the number of issued and skipped state changes from the last frame
+	/// </summary>
+	static const GlStateStats& GetStats() { return __lastFrameStats; }
+
+protected:
+	// Used for state that we don't know the value of, so that the next change is always sent
+	static constexpr GLuint UNKNOWN = UINT_MAX;
+
+	struct UniformBinding {
+		GLuint Buffer = UNKNOWN;
+		size_t Offset = 0;
+		// 0 if the entire buffer is bound
+		size_t Size   = 0;
+
+		bool operator==(const UniformBinding& other) const {
+			return Buffer == other.Buffer && Offset == other.Offset && Size == other.Size;
+		}
+	};
+
+	inline static GLuint                      __program = UNKNOWN;
+	inline static GLuint                      __vertexArray = UNKNOWN;
+	inline static std::vector<GLuint>         __textures;
+	inline static std::vector<GLuint>         __samplers;
+	inline static std::vector<UniformBinding> __uniformBuffers;
+
+	inline static DepthState __depth;
+	inline static BlendState __blend;
+	inline static CullState  __cull;
+	inline static bool       __depthKnown = false;
+	inline static bool       __blendKnown = false;
+	inline static bool       __cullKnown = false;
+
+	inline static GlStateStats __frameStats;
+	inline static GlStateStats __lastFrameStats;
+
+	// Updates a cached value, returns true if it changed and the GL call needs to be made
+	template <typename T>
+	static bool __Track(T& cached, const T& value) {
+		if (cached == value) {
+			__frameStats.Skipped++;
+			return false;
+		}
+		cached = value;
+		__frameStats.Issued++;
+		return true;
+	}
+	// Gets the cache entry for a slot, growing the cache with unknown entries if needed
+	template <typename T>
+	static T& __Slot(std::vector<T>& cache, int slot, const T& unknown) {
+		if (slot >= (int)cache.size()) {
+			cache.resize(slot + 1, unknown);
+		}
+		return cache[slot];
+	}
+};
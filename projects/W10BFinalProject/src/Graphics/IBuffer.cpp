@@ -1,4 +1,5 @@
 #include "IBuffer.h"
+#include "GlState.h"
 
 IBuffer::IBuffer(BufferType type, BufferUsage usage) :
 	_elementCount(0),
@@ -12,6 +13,7 @@ IBuffer::IBuffer(BufferType type, BufferUsage usage) :
 
 IBuffer::~IBuffer() {
 	if (_handle != 0) {
+		GlState::ReleaseBuffer(_handle);
 		glDeleteBuffers(1, &_handle);
 		_handle = 0;
 	}
@@ -34,5 +36,9 @@ void IBuffer::UnBind(BufferType type) {
 }
 
 void IBuffer::UnBind(BufferType type, int slot) {
-	glBindBufferBase((GLenum)type, slot, 0);
+	if (type == BufferType::Uniform) {
+		GlState::BindUniformBuffer(slot, 0);
+	} else {
+		glBindBufferBase((GLenum)type, slot, 0);
+	}
 }
@@ -8,7 +8,8 @@
 enum class BufferType {
 	Vertex = GL_ARRAY_BUFFER,
 	Index = GL_ELEMENT_ARRAY_BUFFER,
-	Uniform = GL_UNIFORM_BUFFER
+	Uniform = GL_UNIFORM_BUFFER,
+	DrawIndirect = GL_DRAW_INDIRECT_BUFFER
 };
 
 /// <summary>
@@ -1,4 +1,5 @@
 #include "ITexture.h"
+#include "GlState.h"
 
 ITexture::Limits ITexture::__limits = ITexture::Limits();
 bool ITexture::__isStaticInit = false;
@@ -20,6 +21,8 @@ void ITexture::_Recreate()
 }
 
 ITexture::~ITexture() {
+	// Deleting a texture unbinds it from all units, so we need to forget about those bindings
+	GlState::ReleaseTexture(_handle);
 	if (glIsTexture(_handle)) {
 		glDeleteTextures(1, &_handle);
 		_handle = 0;
@@ -29,12 +32,12 @@ ITexture::~ITexture() {
 void ITexture::Bind(int slot) {
 	if (_handle != 0) {
 		// Instead of glActiveTexture + glBindTexture, we can one line it now :D
-		glBindTextureUnit(slot, _handle); 
+		GlState::BindTexture(slot, _handle); 
 	}
 }
 
 void ITexture::Unbind(int slot) {
-	glBindTextureUnit(slot, 0);
+	GlState::BindTexture(slot, 0);
 }
 
 void ITexture::Clear(const glm::vec4& color) {
@@ -37,7 +37,7 @@ public:
 	virtual ~ITexture();
 
 	/// <summary>
-	/// Binds this texture to the given texture slot
+	/// Binds this texture to the given texture slot, does nothing if it is already bound there
 	/// </summary>
 	/// <param name="slot">The slot to bind, 0 &lt;= slot &lt; MAX_TEXTURE_UNITS</param>
 	virtual void Bind(int slot);
@@ -3,20 +3,31 @@
 #include <fstream>
 #include <sstream>
 #include <filesystem>
+#include <algorithm>
+#include <cstring>
 
 #include "Utils/FileHelpers.h"
+#include "Graphics/GlState.h"
+
+// GL_KHR_parallel_shader_compile isn't part of our GLAD loader, so we declare what we need here. The
+// ARB version of the extension uses the same values
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR           0x91B1
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
 
 Shader::Shader() : 
 	IResource(),
 	// We zero out all of our members so we don't have garbage data in our class
-	_handle(0)
+	_handle(0),
+	_status(ShaderStatus::Empty)
 {
 	_handle = glCreateProgram();
 }
 
 Shader::Shader(const std::unordered_map<ShaderPartType, std::string>& filePaths) :
 	IResource(),
-	_handle(0)
+	_handle(0),
+	_status(ShaderStatus::Empty)
 {
 	_handle = glCreateProgram();
 	for (auto& [type, path] : filePaths) {
@@ -26,7 +37,19 @@ Shader::Shader(const std::unordered_map<ShaderPartType, std::string>& filePaths)
 }
 
 Shader::~Shader() {
+	// If we never finished compiling, we still own the shader parts
+	auto it = std::find(__PendingCompiles.begin(), __PendingCompiles.end(), this);
+	if (it != __PendingCompiles.end()) {
+		__PendingCompiles.erase(it);
+	}
+	for (auto& [type, id] : _handles) {
+		if (id != 0) {
+			glDeleteShader(id);
+		}
+	}
+
 	if (_handle != 0) {
+		GlState::ReleaseProgram(_handle);
 		glDeleteProgram(_handle);
 		_handle = 0;
 	}
@@ -40,6 +63,30 @@ bool Shader::LoadShaderPart(const char* source, ShaderPartType type) {
 	glShaderSource(handle, 1, &source, nullptr);
 	glCompileShader(handle);
 
+	// In a batch, we don't wait on the result here, any errors will be reported when the program is finished
+	if (__CompileBatchDepth == 0 && !_CheckPartStatus(handle, type)) {
+		// Delete the broken shader result
+		glDeleteShader(handle);
+		handle = 0;
+
+		return false;
+	}
+
+	// If we're overwriting, warn and clean up the old program before we store
+	if (_handles[type] != 0) {
+		LOG_WARN("Another shader has been attached to this slot, overwriting");
+		glDeleteShader(_handles[type]);
+	}
+	_handles[type] = handle;
+
+	// Store info about where we got this data from
+	_fileSourceMap[type].IsFilePath = false;
+	_fileSourceMap[type].Source = source;
+
+	return true;
+}
+
+bool Shader::_CheckPartStatus(GLuint handle, ShaderPartType type) {
 	// Get the compilation status for the shader part
 	GLint status = 0;
 	glGetShaderiv(handle, GL_COMPILE_STATUS, &status);
@@ -56,28 +103,11 @@ bool Shader::LoadShaderPart(const char* source, ShaderPartType type) {
 		glGetShaderInfoLog(handle, logSize, &logSize, log);
 
 		// Dump error log
-		LOG_ERROR("Failed to compile shader part:\n{}", log);
+		LOG_ERROR("Failed to compile {} shader part:\n{}", ~type, log);
 
 		// Clean up our log memory
 		delete[] log;
-
-		// Delete the broken shader result
-		glDeleteShader(handle);
-		handle = 0;
-
-		return false;
-	}
-
-	// If we're overwriting, warn and clean up the old program before we store
-	if (_handles[type] != 0) {
-		LOG_WARN("Another shader has been attached to this slot, overwriting");
-		glDeleteShader(_handles[type]);
 	}
-	_handles[type] = handle;
-
-	// Store info about where we got this data from
-	_fileSourceMap[type].IsFilePath = false;
-	_fileSourceMap[type].Source = source;
 
 	return status != GL_FALSE;
 }
@@ -116,6 +146,24 @@ bool Shader::Link() {
 
 	// Perform linking
 	glLinkProgram(_handle);
+	_status = ShaderStatus::Compiling;
+
+	// In a batch, we check the results once the driver is done with them (see PollCompiles)
+	if (__CompileBatchDepth > 0) {
+		__PendingCompiles.push_back(this);
+		return true;
+	}
+
+	return _FinishLink();
+}
+
+bool Shader::_FinishLink() {
+	// Parts from a batch haven't been checked yet, so we report their errors here
+	for (auto& [type, id] : _handles) {
+		if (id != 0 && !_CheckPartStatus(id, type) && _fileSourceMap[type].IsFilePath) {
+			LOG_ERROR("Source File: {}", _fileSourceMap[type].Source);
+		}
+	}
 
 	// Remove shader parts to save space (we can do this since we only needed the shader parts to compile an actual shader program)
 	for (auto& [type, id] : _handles) { 
@@ -153,17 +201,84 @@ bool Shader::Link() {
 	// Perform our uniform introspection to see what uniforms are in the shader
 	_Introspect();
 
+	_status = status != GL_FALSE ? ShaderStatus::Ready : ShaderStatus::Failed;
 	return status != GL_FALSE;
 }
 
+void Shader::WaitForCompile() {
+	auto it = std::find(__PendingCompiles.begin(), __PendingCompiles.end(), this);
+	if (it != __PendingCompiles.end()) {
+		__PendingCompiles.erase(it);
+		_FinishLink();
+	}
+}
+
+bool Shader::InitParallelCompile(GLADloadproc loader) {
+	const char* threadFunc = nullptr;
+	GLint extensionCount = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+	for (GLint ix = 0; ix < extensionCount && threadFunc == nullptr; ix++) {
+		const char* name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, ix));
+		if (strcmp(name, "GL_KHR_parallel_shader_compile") == 0) {
+			threadFunc = "glMaxShaderCompilerThreadsKHR";
+		} else if (strcmp(name, "GL_ARB_parallel_shader_compile") == 0) {
+			threadFunc = "glMaxShaderCompilerThreadsARB";
+		}
+	}
+
+	__ParallelCompileSupported = threadFunc != nullptr;
+	if (__ParallelCompileSupported) {
+		// Let the driver use as many threads as it likes
+		PFNGLMAXSHADERCOMPILERTHREADSKHRPROC maxThreads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)loader(threadFunc);
+		if (maxThreads != nullptr) {
+			maxThreads(0xFFFFFFFF);
+		}
+		LOG_INFO("Parallel shader compilation is supported");
+	} else {
+		LOG_INFO("Parallel shader compilation is not supported, batched shaders will be finished one per frame");
+	}
+	return __ParallelCompileSupported;
+}
+
+void Shader::BeginCompileBatch() {
+	__CompileBatchDepth++;
+}
+
+void Shader::EndCompileBatch() {
+	LOG_ASSERT(__CompileBatchDepth > 0, "EndCompileBatch called without a matching BeginCompileBatch!");
+	__CompileBatchDepth--;
+}
+
+void Shader::PollCompiles() {
+	bool finishedOne = false;
+	for (auto it = __PendingCompiles.begin(); it != __PendingCompiles.end();) {
+		Shader* shader = *it;
+		if (__ParallelCompileSupported) {
+			// Querying the completion status never blocks
+			GLint complete = GL_FALSE;
+			glGetProgramiv(shader->_handle, GL_COMPLETION_STATUS_KHR, &complete);
+			if (complete == GL_FALSE) {
+				it++;
+				continue;
+			}
+		} else if (finishedOne) {
+			break;
+		}
+
+		it = __PendingCompiles.erase(it);
+		shader->_FinishLink();
+		finishedOne = true;
+	}
+}
+
 void Shader::Bind() {
-	// Simply calls glUseProgram with our shader handle
-	glUseProgram(_handle);
+	// Goes through the state tracker, so re-binding the current program is free
+	GlState::UseProgram(_handle);
 }
 
 void Shader::Unbind() {
 	// We unbind a shader program by using the default program (0)
-	glUseProgram(0);
+	GlState::UseProgram(0);
 }
 
 void Shader::SetUniformMatrix(int location, const glm::mat3* value, int count, bool transposed) {
@@ -302,18 +417,14 @@ void Shader::SetUniform(int location, ShaderDataType type, void* data, int count
 	}
 }
 
-int Shader::__GetUniformLocation(const std::string& name) {
-	// Since the default constructor for UniformInfo sets location to -1,
-	// we can simply index the map and if it doesn't exist, the default
-	// will be used
-	return _uniforms[name].Location;
-}
-
 nlohmann::json Shader::ToJson() const {
 	nlohmann::json result;
 	for (auto& [key, value] : _fileSourceMap) {
 		result[~key][value.IsFilePath ? "path" : "source"] = value.Source;
 	}
+	if (!_keywords.empty()) {
+		result["keywords"] = _keywords;
+	}
 	return result;
 
 }
@@ -337,15 +448,84 @@ Shader::Sptr Shader::FromJson(const nlohmann::json& data) {
 		}
 	}
 	result->Link();
+	if (data.contains("keywords") && data["keywords"].is_array()) {
+		result->DeclareKeywords(data["keywords"].get<std::vector<std::string>>());
+	}
 	return result;
 }
 
+void Shader::DeclareKeywords(const std::vector<std::string>& keywords) {
+	LOG_ASSERT(keywords.size() <= MAX_KEYWORDS, "Shaders can only have up to {} keywords!", MAX_KEYWORDS);
+	_keywords = keywords;
+	// The bits in the existing variants may mean something else now
+	_variants.clear();
+}
+
+Shader::KeywordMask Shader::GetKeywordMask(const std::string& keyword) const {
+	auto it = std::find(_keywords.begin(), _keywords.end(), keyword);
+	return it != _keywords.end() ? (KeywordMask)1 << (it - _keywords.begin()) : 0;
+}
+
+Shader::Sptr Shader::GetVariant(KeywordMask keywords) {
+	// Ignore any bits that don't have a keyword
+	if (_keywords.size() < MAX_KEYWORDS) {
+		keywords &= ((KeywordMask)1 << _keywords.size()) - 1;
+	}
+	if (keywords == 0) {
+		return shared_from_this();
+	}
+
+	auto it = _variants.find(keywords);
+	if (it != _variants.end()) {
+		return it->second;
+	}
+
+	// Build up the block of defines for the keywords, "NAME=VALUE" keywords become "#define NAME VALUE"
+	std::string defines;
+	for (size_t ix = 0; ix < _keywords.size(); ix++) {
+		if (keywords & ((KeywordMask)1 << ix)) {
+			const std::string& keyword = _keywords[ix];
+			const size_t split = keyword.find('=');
+			defines += "#define " + keyword.substr(0, split) + " " + (split != std::string::npos ? keyword.substr(split + 1) : "1") + "\n";
+		}
+	}
+
+	// The variant is compiled in a batch, so materials will use the fallback shader until it's ready
+	Shader::Sptr variant = Shader::Create();
+	BeginCompileBatch();
+	for (auto& [type, source] : _fileSourceMap) {
+		std::string code = source.IsFilePath ? FileHelpers::ReadResolveIncludes(source.Source) : source.Source;
+
+		// Defines need to go after the #version directive, which has to be the first thing in the shader
+		size_t insertAt = 0;
+		size_t version = code.find("#version");
+		if (version != std::string::npos) {
+			insertAt = code.find('\n', version);
+			insertAt = insertAt != std::string::npos ? insertAt + 1 : code.size();
+		}
+		// Reset the line counter after the defines, so compile errors still point at the right line of the source
+		const size_t line = std::count(code.begin(), code.begin() + insertAt, '\n') + 1;
+		code.insert(insertAt, defines + "#line " + std::to_string(line) + "\n");
+
+		variant->LoadShaderPart(code.c_str(), type);
+	}
+	variant->Link();
+	EndCompileBatch();
+
+	LOG_TRACE("Compiling shader variant with keywords:\n{}", defines);
+	_variants[keywords] = variant;
+	return variant;
+}
+
 void Shader::_Introspect() {
 	_IntrospectUniforms();
 	_IntrospectUnifromBlocks();
 }
 
 void Shader::_IntrospectUniforms() {
+	_uniforms.clear();
+	_handleLocations.clear();
+
 	// Query the program for how many active uniforms we have
 	int numInputs = 0;
 	glGetProgramInterfaceiv(_handle, GL_UNIFORM, GL_ACTIVE_RESOURCES, &numInputs);
@@ -391,6 +571,13 @@ void Shader::_IntrospectUniforms() {
 
 		// Store the uniform info
 		_uniforms[e.Name] = e;
+
+		// Resolve the uniform's handle so that lookups by handle are just an array access
+		const int id = UniformHandle(e.Name).GetId();
+		if (id >= (int)_handleLocations.size()) {
+			_handleLocations.resize(id + 1, -1);
+		}
+		_handleLocations[id] = e.Location;
 	}
 }
 
@@ -449,17 +636,21 @@ void Shader::_IntrospectUnifromBlocks() {
 				GL_NAME_LENGTH,
 				GL_TYPE,
 				GL_ARRAY_SIZE,
-				GL_OFFSET
+				GL_OFFSET,
+				GL_ARRAY_STRIDE,
+				GL_MATRIX_STRIDE
 			};
 			// Query data from the program
-			int props[4];
-			glGetProgramResourceiv(_handle, GL_UNIFORM, activeVars[v], 4, pNames, 4, NULL, props);
+			int props[6];
+			glGetProgramResourceiv(_handle, GL_UNIFORM, activeVars[v], 6, pNames, 6, NULL, props);
 
 			// Store properties into the UniformInfo
 			UniformInfo var = UniformInfo();
 			var.Type = FromGLShaderDataType(props[1]);
 			var.Location = props[3];
 			var.ArraySize = props[2];
+			var.ArrayStride = props[4];
+			var.MatrixStride = props[5];
 
 			// Get the uniform name
 			var.Name.resize(props[0] - 1);
@@ -490,14 +681,18 @@ void Shader::BindUniformBlockToSlot(const std::string& name, int uboSlot)
 	}
 }
 
+const Shader::UniformBlockInfo* Shader::FindUniformBlock(const std::string& name) const {
+	auto it = _uniformBlocks.find(name);
+	return it != _uniformBlocks.end() ? &it->second : nullptr;
+}
+
 bool Shader::FindUniform(const std::string& name, UniformInfo* out) {
-	for (auto& [key, uniform] : _uniforms) {
-		if (uniform.Name == name) {
-			if (out != nullptr) {
-				*out = uniform;
-			}
-			return true;
-		}
+	auto it = _uniforms.find(name);
+	if (it == _uniforms.end()) {
+		return false;
+	}
+	if (out != nullptr) {
+		*out = it->second;
 	}
-	return false;
+	return true;
 }
@@ -9,6 +9,7 @@
 #include <EnumToString.h>
 #include "Utils/ResourceManager/IResource.h"
 #include "Graphics/GlEnums.h"
+#include "Graphics/UniformHandle.h"
 
 // We can use an enum to make our code more readable and restrict
 // values to only ones we want to accept
@@ -21,13 +22,32 @@ ENUM(ShaderPartType, GLint,
 	 Unknown      = GL_NONE // Usually good practice to have an "unknown" or "none" state for enums
 );
 
+// Where a shader program is in it's compilation
+ENUM(ShaderStatus, uint8_t,
+	 Empty     = 0, // Nothing has been linked yet
+	 Compiling = 1, // Submitted as part of a batch, and waiting on the driver
+	 Ready     = 2,
+	 Failed    = 3
+);
+
 /// <summary>
 /// This class will wrap around an OpenGL shader program
+/// 
+/// Shaders can also declare a set of keywords, which are turned into #defines to compile variants of
+/// the shader. Variants are compiled the first time they are requested, and cached by the bitmask of
+/// the keywords that they were compiled with
 /// </summary>
-class Shader final : public IResource
+class Shader final : public IResource, public std::enable_shared_from_this<Shader>
 {
 public:
 	typedef std::shared_ptr<Shader> Sptr;
+	// A bitmask of keywords, where each bit is the index of a keyword in the shader's declaration
+	typedef uint32_t KeywordMask;
+
+	/// <summary>
+	/// The most keywords that a shader can declare
+	/// </summary>
+	static const int MAX_KEYWORDS = 32;
 
 	static inline Sptr Create() {
 		return std::make_shared<Shader>();
@@ -45,14 +65,20 @@ public:
 	struct UniformInfo {
 		ShaderDataType Type;
 		int            ArraySize;
+		// For uniforms in a block, this is the offset from the start of the block in bytes
 		int            Location;
 		std::string    Name;
+		// The byte strides between array elements and matrix columns, only set for uniforms in a block
+		int            ArrayStride;
+		int            MatrixStride;
 
 		UniformInfo() :
 			Type(ShaderDataType::None),
 			ArraySize(0),
 			Location(-1),
-			Name("") {}
+			Name(""),
+			ArrayStride(0),
+			MatrixStride(0) {}
 	};
 
 	/// <summary>
@@ -100,10 +126,54 @@ public:
 
 	/// <summary>
 	/// Links the vertex and fragment shader, and allows this shader program to be used
+	/// If a compile batch is open, the link is only submitted, and the result will be available once
+	/// the shader's status is Ready or Failed
 	/// </summary>
-	/// <returns>True if the linking was successful, false if otherwise</returns>
+	/// <returns>True if the linking was successful (or submitted), false if otherwise</returns>
 	bool Link();
 
+	/// <summary>
+	/// Gets where this shader is in it's compilation
+	/// </summary>
+	ShaderStatus GetStatus() const { return _status; }
+	/// <summary>
+	/// Returns true if this shader has finished linking successfully, and can be used for drawing
+	/// </summary>
+	bool IsReady() const { return _status == ShaderStatus::Ready; }
+	/// <summary>
+	/// Blocks until this shader has finished compiling, if it was submitted as part of a batch
+	/// </summary>
+	void WaitForCompile();
+
+	/// <summary>
+	/// Loads GL_KHR_parallel_shader_compile (or the ARB version) if the driver supports it, should be
+	/// called once after GLAD has been initialized. Our GLAD loader doesn't include the extension, so
+	/// we need to load it ourselves
+	/// </summary>
+	/// <param name="loader">The function used to load GL functions (ex: glfwGetProcAddress)</param>
+	/// <returns>True if the driver supports parallel shader compilation</returns>
+	static bool InitParallelCompile(GLADloadproc loader);
+	/// <summary>
+	/// Starts a compile batch. Until the batch is ended, shader parts and programs are submitted to
+	/// the driver without waiting on their results, so that the driver can compile all of them at
+	/// the same time. Batches may be nested
+	/// </summary>
+	static void BeginCompileBatch();
+	/// <summary>
+	/// Ends a compile batch, the shaders in the batch will become ready as PollCompiles sees them finish
+	/// </summary>
+	static void EndCompileBatch();
+	/// <summary>
+	/// Finishes any shaders that the driver is done compiling, should be called once per frame.
+	/// If the driver doesn't support parallel compilation, checking a shader will block, so only
+	/// one shader will be finished per call
+	/// </summary>
+	static void PollCompiles();
+	/// <summary>
+	/// Gets the number of shaders that are still waiting on the driver
+	/// </summary>
+	static size_t GetPendingCompileCount() { return __PendingCompiles.size(); }
+
 	/// <summary>
 	/// Binds this shader for use
 	/// </summary>
@@ -118,11 +188,41 @@ public:
 	/// </summary>
 	GLuint GetHandle() const { return _handle; }
 
+	/// <summary>
+	/// Declares the keywords that variants of this shader can be compiled with. Keywords can be a
+	/// name (ex: "TOON_SHADING"), which is defined as 1, or a name with a value (ex: "MAX_LIGHTS=4").
+	/// Changing the keywords will drop any variants that have already been compiled
+	/// </summary>
+	/// <param name="keywords">The keywords for the shader, up to MAX_KEYWORDS</param>
+	void DeclareKeywords(const std::vector<std::string>& keywords);
+	/// <summary>
+	/// Gets the keywords that this shader has declared
+	/// </summary>
+	const std::vector<std::string>& GetKeywords() const { return _keywords; }
+	/// <summary>
+	/// Gets the bit for a keyword, or 0 if the shader has not declared it
+	/// </summary>
+	KeywordMask GetKeywordMask(const std::string& keyword) const;
+	/// <summary>
+	/// Gets the variant of this shader with the given keywords defined, compiling it if this is the
+	/// first time that it has been requested. The variant is compiled in a batch, so it may not be
+	/// ready right away
+	/// </summary>
+	/// <param name="keywords">The bitmask of keywords to define, a mask of 0 is this shader</param>
+	/// <returns>The shader variant</returns>
+	Shader::Sptr GetVariant(KeywordMask keywords);
+
 	virtual nlohmann::json ToJson() const override;
 	static Shader::Sptr FromJson(const nlohmann::json& data);
 
 public:
 	bool FindUniform(const std::string& name, UniformInfo* out);
+	/// <summary>
+	/// Gets the layout of a uniform block in this shader
+	/// </summary>
+	/// <param name="name">The name of the block to search for</param>
+	/// <returns>The block's info, or nullptr if the shader has no active block with that name</returns>
+	const UniformBlockInfo* FindUniformBlock(const std::string& name) const;
 
 	void SetUniformMatrix(int location, const glm::mat3* value, int count = 1, bool transposed = false);
 	void SetUniformMatrix(int location, const glm::mat4* value, int count = 1, bool transposed = false);
@@ -149,39 +249,65 @@ public:
 	/// <param name="transposed"True if matrices should be transposed</param>
 	void SetUniform(int location, ShaderDataType type, void* data, int count = 1, bool transposed = false);
 
+	/// <summary>
+	/// Gets the location of a uniform from it's handle, this is just an array lookup
+	/// </summary>
+	/// <param name="handle">The interned name of the uniform</param>
+	/// <returns>The uniform's location, or -1 if this shader does not have the uniform</returns>
+	int GetUniformLocation(const UniformHandle& handle) const {
+		const int id = handle.GetId();
+		return id >= 0 && id < (int)_handleLocations.size() ? _handleLocations[id] : -1;
+	}
+
 	template <typename T>
-	void SetUniform(const std::string& name, const T& value) {
-		int location = __GetUniformLocation(name);
+	void SetUniform(const UniformHandle& handle, const T& value) {
+		int location = GetUniformLocation(handle);
 		if (location != -1) {
 			SetUniform(location, &value, 1);
 		} else {
-			LOG_WARN("Ignoring uniform \"{}\"", name);
+			LOG_WARN("Ignoring uniform \"{}\"", handle.GetName());
 		}
 	}
 	template <typename T>
-	void SetUniform(const std::string& name, const T* values, int count = 1) {
-		int location = __GetUniformLocation(name);
+	void SetUniform(const UniformHandle& handle, const T* values, int count = 1) {
+		int location = GetUniformLocation(handle);
 		if (location != -1) {
-			SetUniform(location, &values, count);
+			SetUniform(location, values, count);
 		} else {
-			LOG_WARN("Ignoring uniform \"{}\"", name);
+			LOG_WARN("Ignoring uniform \"{}\"", handle.GetName());
 		}
 	}
 	template <typename T>
-	void SetUniformMatrix(const std::string& name, const T& value, bool transposed = false) {
-		int location = __GetUniformLocation(name);
+	void SetUniformMatrix(const UniformHandle& handle, const T& value, bool transposed = false) {
+		int location = GetUniformLocation(handle);
 		if (location != -1) {
 			SetUniformMatrix(location, &value, 1, transposed);
 		} else {
-			LOG_WARN("Ignoring uniform \"{}\"", name);
+			LOG_WARN("Ignoring uniform \"{}\"", handle.GetName());
 		}
 	}
+
+	// String versions of the above, these intern the name on every call so prefer handles for anything
+	// that gets called every frame
+	template <typename T>
+	void SetUniform(const std::string& name, const T& value) {
+		SetUniform(UniformHandle(name), value);
+	}
+	template <typename T>
+	void SetUniform(const std::string& name, const T* values, int count = 1) {
+		SetUniform(UniformHandle(name), values, count);
+	}
+	template <typename T>
+	void SetUniformMatrix(const std::string& name, const T& value, bool transposed = false) {
+		SetUniformMatrix(UniformHandle(name), value, transposed);
+	}
 	
 	void BindUniformBlockToSlot(const std::string& name, int uboSlot);
 
 protected:
 	// Stores the shader program handle
 	GLuint _handle;
+	ShaderStatus _status;
 
 	// Stores all the handles to our shaders until we
 	// are ready to compile them into a program
@@ -190,6 +316,8 @@ protected:
 	// Map access to look up uniform locations and blocks
 	std::unordered_map<std::string, UniformInfo> _uniforms;
 	std::unordered_map<std::string, UniformBlockInfo> _uniformBlocks;
+	// Uniform locations indexed by UniformHandle ID, filled in during introspection
+	std::vector<int> _handleLocations;
 
 	// Stores information about the source of our shader parts
 	// EX: if a VS shader is loaded from a file, will contain
@@ -200,6 +328,24 @@ protected:
 	};
 	std::unordered_map<ShaderPartType, ShaderSource> _fileSourceMap;
 
+	// The keywords that variants can be compiled with, and the variants that have been compiled so far
+	std::vector<std::string> _keywords;
+	std::unordered_map<KeywordMask, Shader::Sptr> _variants;
+
+	// Shaders that have been linked in a batch, but that we haven't checked the results of
+	inline static std::vector<Shader*> __PendingCompiles;
+	inline static int  __CompileBatchDepth = 0;
+	inline static bool __ParallelCompileSupported = false;
+
+	/// <summary>
+	/// Checks the compile status of a shader part, logging the errors if it failed
+	/// </summary>
+	bool _CheckPartStatus(GLuint handle, ShaderPartType type);
+	/// <summary>
+	/// Checks the results of the link, cleans up the shader parts, and performs introspection
+	/// </summary>
+	bool _FinishLink();
+
 	/// <summary>
 	/// Performs program introspection, where we examine the uniforms that
 	/// the program contains
@@ -214,6 +360,4 @@ protected:
 	/// fed data from a uniform buffer
 	/// </summary>
 	void _IntrospectUnifromBlocks();
-
-	int __GetUniformLocation(const std::string& name);
 };
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include "StreamingBuffer.h"
+#include "Logging.h"
+
+uint64_t StreamingBuffer::_frameNumber = 0;
+GLsync   StreamingBuffer::_frameFences[FRAMES_IN_FLIGHT] = { nullptr };
+
+StreamingBuffer::StreamingBuffer(BufferType type, size_t regionSize) :
+	IBuffer(type, BufferUsage::StreamDraw),
+	_regionSize(regionSize),
+	_mappedData(nullptr),
+	_head(0),
+	_lastFrame(_frameNumber)
+{
+	// Immutable storage is required for persistent mapping, coherent means that our writes will be
+	// visible to the GPU without needing to flush them
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	const size_t size = _regionSize * FRAMES_IN_FLIGHT;
+	glNamedBufferStorage(_handle, size, nullptr, flags);
+	_mappedData = static_cast<uint8_t*>(glMapNamedBufferRange(_handle, 0, size, flags));
+	LOG_ASSERT(_mappedData != nullptr, "Failed to map streaming buffer");
+
+	_elementSize = 1;
+	_elementCount = size;
+}
+
+StreamingBuffer::~StreamingBuffer() {
+	if (_handle != 0 && _mappedData != nullptr) {
+		glUnmapNamedBuffer(_handle);
+		_mappedData = nullptr;
+	}
+}
+
+void* StreamingBuffer::Allocate(size_t size, size_t alignment, size_t& offset) {
+	// The first allocation in a new frame starts from the beginning of the region
+	if (_lastFrame != _frameNumber) {
+		_lastFrame = _frameNumber;
+		_head = 0;
+	}
+
+	// Align the offset from the start of the buffer, since that's what gets bound
+	alignment = alignment > 0 ? alignment : 1;
+	const size_t regionStart = _GetRegionStart();
+	const size_t start = (regionStart + _head + alignment - 1) / alignment * alignment - regionStart;
+	if (start + size > _regionSize) {
+		return nullptr;
+	}
+	_head = start + size;
+	offset = regionStart + start;
+	return _mappedData + offset;
+}
+
+size_t StreamingBuffer::GetFrameUsage() const {
+	return _lastFrame == _frameNumber ? _head : 0;
+}
+
+bool StreamingBuffer::IsSupported() {
+	return GLAD_GL_VERSION_4_4;
+}
+
+void StreamingBuffer::EndFrame() {
+	// Fence off the commands that used this frame's regions
+	int index = _frameNumber % FRAMES_IN_FLIGHT;
+	if (_frameFences[index] != nullptr) {
+		glDeleteSync(_frameFences[index]);
+	}
+	_frameFences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	// Wait for the GPU to be done with the regions we're about to reuse, this should almost never
+	// block unless we're more than FRAMES_IN_FLIGHT frames ahead of the GPU
+	_frameNumber++;
+	index = _frameNumber % FRAMES_IN_FLIGHT;
+	if (_frameFences[index] != nullptr) {
+		GLenum result = glClientWaitSync(_frameFences[index], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		while (result == GL_TIMEOUT_EXPIRED) {
+			result = glClientWaitSync(_frameFences[index], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		}
+		glDeleteSync(_frameFences[index]);
+		_frameFences[index] = nullptr;
+	}
+}
+
+void StreamingBuffer::Uninitialize() {
+	for (GLsync& fence : _frameFences) {
+		if (fence != nullptr) {
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "IBuffer.h"
+#include <memory>
+#include <stdexcept>
+
+/// <summary>
+/// A buffer for data that is rewritten every frame, backed by persistently mapped storage so that
+/// we can write straight into GPU visible memory without going through glNamedBufferSubData
+///
+/// The buffer is split into a region for each frame in flight, and each frame hands out slots from
+/// it's region with a simple linear allocator. A fence is placed at the end of every frame, and the
+/// region is only reused once the GPU has passed the fence from the last time it was used, so we never
+/// write over data that is still being read
+///
+/// Call StreamingBuffer::EndFrame once per frame, after all of the frame's draw calls have been issued
+/// </summary>
+class StreamingBuffer : public IBuffer {
+public:
+	typedef std::shared_ptr<StreamingBuffer> Sptr;
+
+	/// <summary>
+	/// The number of frames that can be in flight at once, and the number of regions in each buffer
+	/// </summary>
+	static const int FRAMES_IN_FLIGHT = 3;
+
+	/// <summary>
+	/// Creates a new streaming buffer
+	/// </summary>
+	/// <param name="type">The type of buffer, only used when binding the whole buffer</param>
+	/// <param name="regionSize">The number of bytes that can be allocated in a single frame</param>
+	StreamingBuffer(BufferType type, size_t regionSize);
+	virtual ~StreamingBuffer();
+
+	// Streaming buffers are written with Allocate instead
+	inline void LoadData(const void* /*data*/, size_t /*elementSize*/, size_t /*elementCount*/) override {
+		throw std::runtime_error("Streaming buffers must be written with Allocate");
+	}
+
+	/// <summary>
+	/// Allocates a slot in this frame's region. The slot stays valid until the end of the frame
+	/// </summary>
+	/// <param name="size">The size of the slot in bytes</param>
+	/// <param name="alignment">The alignment of the slot's offset, in bytes</param>
+	/// <param name="offset">Will be set to the offset of the slot from the start of the buffer</param>
+	/// <returns>A pointer to write the slot's data to, or nullptr if there is no room left this frame</returns>
+	void* Allocate(size_t size, size_t alignment, size_t& offset);
+
+	/// <summary>
+	/// Gets the number of bytes that can be allocated in a single frame
+	/// </summary>
+	size_t GetRegionSize() const { return _regionSize; }
+	/// <summary>
+	/// Gets the number of bytes that have been allocated this frame
+	/// </summary>
+	size_t GetFrameUsage() const;
+
+	/// <summary>
+	/// Checks whether the GL context supports persistently mapped buffers
+	/// </summary>
+	static bool IsSupported();
+	/// <summary>
+	/// Gets the number of frames that have been completed so far
+	/// </summary>
+	static uint64_t GetFrameNumber() { return _frameNumber; }
+	/// <summary>
+	/// Marks the end of a frame's draw calls, fencing off this frame's regions and waiting until the
+	/// GPU is done with the regions that the next frame will use
+	/// </summary>
+	static void EndFrame();
+	/// <summary>
+	/// Releases the frame fences, should be called before the GL context is destroyed
+	/// </summary>
+	static void Uninitialize();
+
+protected:
+	size_t   _regionSize;
+	uint8_t* _mappedData;
+	// The linear allocator's position in the current region
+	size_t   _head;
+	// The frame that the allocator was last reset in
+	uint64_t _lastFrame;
+
+	// The number of frames that have been completed, used to select the region and reset allocators
+	static uint64_t _frameNumber;
+	// One fence per frame in flight, signalled when the GPU is done with that frame's commands
+	static GLsync   _frameFences[FRAMES_IN_FLIGHT];
+
+	// Gets the offset of the current frame's region
+	size_t _GetRegionStart() const { return (_frameNumber % FRAMES_IN_FLIGHT) * _regionSize; }
+};
@@ -1,5 +1,6 @@
 #include "UniformBuffer.h"
 #include "Logging.h"
+#include "GlState.h"
 
 AbstractUniformBuffer::~AbstractUniformBuffer() {
 	delete[] _rawData;
@@ -7,7 +8,12 @@ AbstractUniformBuffer::~AbstractUniformBuffer() {
 
 AbstractUniformBuffer::AbstractUniformBuffer(size_t sizeInBytes, BufferUsage usage /*= BufferUsage::DynamicDraw*/) :
 	IBuffer(BufferType::Uniform, usage),
-	_rawData(nullptr)
+	_rawData(nullptr),
+	_stream(nullptr),
+	_streamOffset(0),
+	_streamFrame(UINT64_MAX),
+	_streamAlignment(256),
+	_boundSlot(-1)
 {
 	_rawData = new uint8_t[sizeInBytes];
 	_size = sizeInBytes;
@@ -21,15 +27,59 @@ void AbstractUniformBuffer::LoadData(const void* data, size_t elementSize, size_
 	// Copy data from the data given to our internal buffer
 	memcpy(_rawData, data, dataSize);
 	// Upload data to the OpenGL buffer
-	glNamedBufferSubData(_handle, 0, dataSize, _rawData);
+	_Upload(dataSize);
 }
 
 void AbstractUniformBuffer::Bind() const {
-	glBindBufferBase(GL_UNIFORM_BUFFER, 0, _handle);
+	Bind(0);
 }
 
 void AbstractUniformBuffer::Bind(int slot) const
 {
-	glBindBufferBase(GL_UNIFORM_BUFFER, slot, _handle);
+	_boundSlot = slot;
+	if (_streamFrame == UINT64_MAX) {
+		GlState::BindUniformBuffer(slot, _handle);
+		return;
+	}
+
+	// Streamed data gets overwritten a few frames after it was written, so if we haven't been
+	// updated this frame we need to stream our data again before we can use it
+	if (_streamFrame != StreamingBuffer::GetFrameNumber()) {
+		const_cast<AbstractUniformBuffer*>(this)->_Upload(_size);
+		return;
+	}
+	GlState::BindUniformBufferRange(slot, _stream->GetHandle(), _streamOffset, _size);
+}
+
+void AbstractUniformBuffer::EnableStreaming(int updatesPerFrame) {
+	if (_stream != nullptr || !StreamingBuffer::IsSupported()) {
+		return;
+	}
+
+	GLint alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	if (alignment > 0) {
+		_streamAlignment = static_cast<size_t>(alignment);
+	}
+	const size_t slotSize = (_size + _streamAlignment - 1) / _streamAlignment * _streamAlignment;
+	_stream = std::make_shared<StreamingBuffer>(BufferType::Uniform, slotSize * updatesPerFrame);
+}
+
+void AbstractUniformBuffer::_Upload(size_t size) {
+	void* slot = _stream != nullptr ? _stream->Allocate(_size, _streamAlignment, _streamOffset) : nullptr;
+	if (slot != nullptr) {
+		// Always stream the whole block, since the rest of it won't be in the new slot otherwise
+		memcpy(slot, _rawData, _size);
+		_streamFrame = StreamingBuffer::GetFrameNumber();
+	} else {
+		// We've run out of streaming space this frame (or aren't streaming), so fall back to a regular upload. If
+		// our data was streamed, the buffer may be stale so we need to upload all of it
+		glNamedBufferSubData(_handle, 0, _streamFrame == UINT64_MAX ? size : _size, _rawData);
+		_streamFrame = UINT64_MAX;
+	}
+
+	if (_stream != nullptr && _boundSlot >= 0) {
+		Bind(_boundSlot);
+	}
 }
 
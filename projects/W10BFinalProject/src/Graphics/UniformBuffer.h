@@ -1,5 +1,6 @@
 #pragma once
 #include "IBuffer.h"
+#include "StreamingBuffer.h"
 #include <memory>
 
 /// <summary>
@@ -41,10 +42,31 @@ public :
 	/// <param name="slot">The buffer binding slot to bind to</param>
 	void Bind(int slot) const;
 
+	/// <summary>
+	/// Opts this buffer in to writing it's updates into a persistently mapped streaming buffer,
+	/// rather than re-uploading into the same buffer. Best for buffers that are updated every frame.
+	/// Since every update moves the data, updates will re-bind the buffer to the last slot it was bound to
+	/// </summary>
+	/// <param name="updatesPerFrame">The number of times the buffer can be updated per frame before falling back to regular uploads</param>
+	void EnableStreaming(int updatesPerFrame = 4);
+
 protected:
 	// Will contain the backing data store for the buffer
 	uint8_t* _rawData;
 	size_t   _size;
+
+	// The streaming buffer that updates are written to, if streaming is enabled
+	StreamingBuffer::Sptr _stream;
+	// The offset of the latest update in the streaming buffer
+	size_t   _streamOffset;
+	// The frame that the latest update was streamed in, or -1 if the last update was a regular upload
+	uint64_t _streamFrame;
+	size_t   _streamAlignment;
+	// The slot that this buffer was last bound to, so that we can re-bind after an update moves the data
+	mutable int _boundSlot;
+
+	// Sends size bytes of the raw data to the GPU, and re-binds the buffer if the data has moved
+	void _Upload(size_t size);
 };
 
 /// <summary>
@@ -107,6 +129,6 @@ public:
 	/// a resync with the GL side buffer
 	/// </summary>
 	void Update() {
-		glNamedBufferSubData(_handle, 0, sizeof(Structure), _rawData);
+		_Upload(sizeof(Structure));
 	}
 };
@@ -0,0 +1,46 @@
+#include "UniformHandle.h"
+#include <unordered_map>
+#include <vector>
+#include "Logging.h"
+
+namespace {
+	// These are function statics so that handles can safely be created during static initialization
+	std::unordered_map<uint32_t, int>& GetIds() {
+		static std::unordered_map<uint32_t, int> ids;
+		return ids;
+	}
+	std::vector<std::string>& GetNames() {
+		static std::vector<std::string> names;
+		return names;
+	}
+}
+
+UniformHandle::UniformHandle(const UniformName& name) :
+	_id(__Intern(name.Hash, name.Name, name.Length))
+{ }
+
+UniformHandle::UniformHandle(const std::string& name) :
+	_id(__Intern(HashUniformName(name.c_str(), name.length()), name.c_str(), name.length()))
+{ }
+
+const std::string& UniformHandle::GetName() const {
+	static const std::string invalid = "<invalid>";
+	return _id >= 0 ? GetNames()[_id] : invalid;
+}
+
+int UniformHandle::__Intern(uint32_t hash, const char* name, size_t length) {
+	std::unordered_map<uint32_t, int>& ids = GetIds();
+	std::vector<std::string>& names = GetNames();
+
+	auto it = ids.find(hash);
+	if (it != ids.end()) {
+		LOG_ASSERT(names[it->second].compare(0, std::string::npos, name, length) == 0,
+			"Uniform name hash collision between \"{}\" and \"{}\"", names[it->second], std::string(name, length));
+		return it->second;
+	}
+
+	const int id = static_cast<int>(names.size());
+	names.emplace_back(name, length);
+	ids[hash] = id;
+	return id;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+/// <summary>
+/// Hashes a string with 32 bit FNV-1a, usable at compile time
+/// </summary>
+constexpr uint32_t HashUniformName(const char* str, size_t length) {
+	uint32_t hash = 2166136261u;
+	for (size_t ix = 0; ix < length; ix++) {
+		hash ^= static_cast<uint8_t>(str[ix]);
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+/// <summary>
+/// A uniform name with it's hash computed up front, create these with the _uniform literal
+/// ex: "u_View"_uniform
+/// </summary>
+struct UniformName {
+	uint32_t    Hash;
+	const char* Name;
+	size_t      Length;
+
+	constexpr UniformName(const char* name, size_t length) :
+		Hash(HashUniformName(name, length)),
+		Name(name),
+		Length(length) { }
+};
+
+constexpr UniformName operator""_uniform(const char* name, size_t length) {
+	return UniformName(name, length);
+}
+
+/// <summary>
+/// An interned uniform name. Every unique name is given a small integer ID the first time that it's
+/// seen, and shaders keep a table of uniform locations indexed by that ID which is filled in when they
+/// are linked. Looking up a location with a handle is a simple array access, so handles should be
+/// created once and kept around rather than created every frame
+/// </summary>
+class UniformHandle {
+public:
+	/// <summary>
+	/// Creates an invalid handle, which never resolves to a uniform
+	/// </summary>
+	UniformHandle() : _id(-1) { }
+	/// <summary>
+	/// Interns a name that was hashed at compile time
+	/// </summary>
+	UniformHandle(const UniformName& name);
+	/// <summary>
+	/// Interns a name that needs to be hashed at runtime
+	/// </summary>
+	explicit UniformHandle(const std::string& name);
+
+	/// <summary>
+	/// Gets the ID of this handle, or -1 if it is invalid
+	/// </summary>
+	int GetId() const { return _id; }
+	/// <summary>
+	/// Returns true if this handle refers to an interned name
+	/// </summary>
+	bool IsValid() const { return _id >= 0; }
+	/// <summary>
+	/// Gets the name that this handle was interned from
+	/// </summary>
+	const std::string& GetName() const;
+
+	bool operator==(const UniformHandle& other) const { return _id == other._id; }
+	bool operator!=(const UniformHandle& other) const { return _id != other._id; }
+
+protected:
+	int _id;
+
+	// Finds or assigns the ID for a name
+	static int __Intern(uint32_t hash, const char* name, size_t length);
+};
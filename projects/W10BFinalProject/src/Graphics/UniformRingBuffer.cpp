@@ -0,0 +1,103 @@
+#include "UniformRingBuffer.h"
+#include "Logging.h"
+#include "GlState.h"
+
+namespace {
+	size_t AlignUp(size_t value, size_t alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+UniformRingBuffer::UniformRingBuffer(size_t frameCapacity, size_t bindSize, int frameCount) :
+	IBuffer(BufferType::Uniform, BufferUsage::DynamicDraw),
+	_frameCapacity(0),
+	_bindSize(bindSize),
+	_frameCount(frameCount),
+	_frameIndex(0),
+	_alignment(256),
+	_staging(),
+	_stream(nullptr),
+	_streamBase(SIZE_MAX)
+{
+	// Every slot we bind needs to start on a multiple of the alignment, so regions must as well
+	GLint alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	if (alignment > 0) {
+		_alignment = static_cast<size_t>(alignment);
+	}
+
+	_frameCapacity = AlignUp(frameCapacity, _alignment);
+	_AllocateStorage();
+}
+
+void UniformRingBuffer::BeginFrame() {
+	_frameIndex = (_frameIndex + 1) % _frameCount;
+	_staging.clear();
+}
+
+void* UniformRingBuffer::Allocate(size_t size, size_t& offset) {
+	offset = AlignUp(_staging.size(), _alignment);
+	_staging.resize(offset + size);
+	return _staging.data() + offset;
+}
+
+void UniformRingBuffer::Upload() {
+	_streamBase = SIZE_MAX;
+	if (_staging.empty()) {
+		return;
+	}
+
+	if (_stream != nullptr) {
+		// The last slot may be smaller than the bind size, so we leave room for a full bind after it
+		const size_t size = AlignUp(_staging.size(), _alignment) + AlignUp(_bindSize, _alignment);
+		void* dest = _stream->Allocate(size, _alignment, _streamBase);
+		if (dest == nullptr) {
+			// The old streaming buffer gets released once the GPU is done with it, so we can just swap it out
+			size_t capacity = _stream->GetRegionSize();
+			while (capacity < size) {
+				capacity *= 2;
+			}
+			LOG_INFO("Growing streaming uniform ring buffer from {} to {} bytes per frame", _stream->GetRegionSize(), capacity);
+			_stream = std::make_shared<StreamingBuffer>(BufferType::Uniform, capacity);
+			dest = _stream->Allocate(size, _alignment, _streamBase);
+		}
+		memcpy(dest, _staging.data(), _staging.size());
+		return;
+	}
+
+	// If we've run out of room, grow the buffer before uploading. Nothing has been bound from this
+	// frame yet, and the older frames are done with, so we can simply throw out the old storage
+	if (_staging.size() > _frameCapacity) {
+		size_t capacity = _frameCapacity;
+		while (capacity < _staging.size()) {
+			capacity *= 2;
+		}
+		LOG_INFO("Growing uniform ring buffer from {} to {} bytes per frame", _frameCapacity, capacity);
+		_frameCapacity = capacity;
+		_AllocateStorage();
+	}
+
+	glNamedBufferSubData(_handle, _GetRegionStart(), _staging.size(), _staging.data());
+}
+
+void UniformRingBuffer::BindRange(int slot, size_t offset) const {
+	if (_streamBase != SIZE_MAX) {
+		GlState::BindUniformBufferRange(slot, _stream->GetHandle(), _streamBase + offset, _bindSize);
+		return;
+	}
+	GlState::BindUniformBufferRange(slot, _handle, _GetRegionStart() + offset, _bindSize);
+}
+
+void UniformRingBuffer::EnableStreaming() {
+	if (_stream == nullptr && StreamingBuffer::IsSupported()) {
+		_stream = std::make_shared<StreamingBuffer>(BufferType::Uniform, _frameCapacity + AlignUp(_bindSize, _alignment));
+	}
+}
+
+void UniformRingBuffer::_AllocateStorage() {
+	// The last slot in the last region may be smaller than the bind size, so we pad the end of the buffer
+	const size_t size = _frameCapacity * _frameCount + AlignUp(_bindSize, _alignment);
+	glNamedBufferData(_handle, size, nullptr, (GLenum)_usage);
+	_elementSize = 1;
+	_elementCount = size;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include "IBuffer.h"
+#include "StreamingBuffer.h"
+#include <memory>
+#include <vector>
+#include <stdexcept>
+
+/// <summary>
+/// A large uniform buffer that per-object data for a whole frame is packed into, with each
+/// allocation aligned so that it can be bound on it's own with glBindBufferRange
+///
+/// The buffer is split into a region for each frame in flight, so that we never write over
+/// data that the GPU may still be reading from a previous frame. Everything that is written
+/// in a frame is uploaded in a single call to Upload
+/// </summary>
+class UniformRingBuffer : public IBuffer {
+public:
+	typedef std::shared_ptr<UniformRingBuffer> Sptr;
+
+	/// <summary>
+	/// Creates a new ring buffer
+	/// </summary>
+	/// <param name="frameCapacity">The initial number of bytes available each frame, will grow as needed</param>
+	/// <param name="bindSize">The number of bytes that will be bound for each allocation, space is left at the end of the buffer so that binds never run past it</param>
+	/// <param name="frameCount">The number of frames that can be in flight at once</param>
+	UniformRingBuffer(size_t frameCapacity, size_t bindSize, int frameCount = 3);
+	virtual ~UniformRingBuffer() = default;
+
+	// Ring buffers are written with Allocate and Upload instead
+	inline void LoadData(const void* /*data*/, size_t /*elementSize*/, size_t /*elementCount*/) override {
+		throw std::runtime_error("Ring buffers must be written with Allocate");
+	}
+
+	/// <summary>
+	/// Moves on to the next frame's region and discards everything that was allocated last frame
+	/// </summary>
+	void BeginFrame();
+	/// <summary>
+	/// Allocates an aligned slot in this frame's region, the slot can be written to until the next
+	/// call to Allocate or Upload
+	/// </summary>
+	/// <param name="size">The size of the slot in bytes</param>
+	/// <param name="offset">Will be set to the offset of the slot, to be passed to BindRange</param>
+	/// <returns>A pointer to write the slot's data to</returns>
+	void* Allocate(size_t size, size_t& offset);
+	/// <summary>
+	/// Uploads every slot allocated this frame in a single update. If the frame outgrew the buffer,
+	/// the buffer will be reallocated to fit
+	/// </summary>
+	void Upload();
+	/// <summary>
+	/// Binds a slot to a uniform buffer binding point. Binds the bind size given on construction, so
+	/// the shader's block can be larger than what was allocated
+	/// </summary>
+	/// <param name="slot">The uniform buffer binding slot to bind to</param>
+	/// <param name="offset">The offset of the slot, as returned by Allocate</param>
+	void BindRange(int slot, size_t offset) const;
+
+	/// <summary>
+	/// Opts this buffer in to uploading into a persistently mapped streaming buffer, which is fenced
+	/// so that we never need to wait on the driver to synchronize our updates
+	/// </summary>
+	void EnableStreaming();
+
+	/// <summary>
+	/// Gets the number of bytes that were allocated this frame
+	/// </summary>
+	size_t GetFrameUsage() const { return _staging.size(); }
+	/// <summary>
+	/// Gets the number of bytes available to each frame before the buffer needs to grow
+	/// </summary>
+	size_t GetFrameCapacity() const { return _frameCapacity; }
+
+protected:
+	size_t               _frameCapacity;
+	size_t               _bindSize;
+	int                  _frameCount;
+	int                  _frameIndex;
+	size_t               _alignment;
+	// The CPU side copy of this frame's data, sent to the GPU in one go in Upload
+	std::vector<uint8_t> _staging;
+
+	// The streaming buffer that frames are copied into, if streaming is enabled
+	StreamingBuffer::Sptr _stream;
+	// Where this frame's data starts in the streaming buffer, or SIZE_MAX if it was uploaded normally
+	size_t               _streamBase;
+
+	// Allocates the GPU storage for every frame region, plus the padding for the last bind
+	void _AllocateStorage();
+	// Gets the offset in the buffer where the current frame's region starts
+	size_t _GetRegionStart() const { return _frameIndex * _frameCapacity; }
+};
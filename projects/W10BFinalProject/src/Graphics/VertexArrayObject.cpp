@@ -2,66 +2,144 @@
 #include "IndexBuffer.h"
 #include "VertexBuffer.h"
 #include "Logging.h"
+#include "GlState.h"
+
+VertexArrayObject::SharedLayout::SharedLayout(const std::vector<Binding>& bindings) :
+	Bindings(bindings),
+	Handle(0),
+	AttachedBuffers(bindings.size(), 0),
+	AttachedIndexBuffer(0)
+{
+	glCreateVertexArrays(1, &Handle);
+
+	// The formats only need to be set up once, buffers are attached to the binding indices when meshes are bound
+	for (size_t ix = 0; ix < Bindings.size(); ix++) {
+		const GLuint bindingIndex = static_cast<GLuint>(ix);
+		for (const BufferAttribute& attrib : Bindings[ix].Attributes) {
+			glEnableVertexArrayAttrib(Handle, attrib.Slot);
+			glVertexArrayAttribFormat(Handle, attrib.Slot, attrib.Size, (GLenum)attrib.Type, attrib.Normalized, attrib.Offset);
+			glVertexArrayAttribBinding(Handle, attrib.Slot, bindingIndex);
+		}
+		if (Bindings[ix].Divisor != 0) {
+			glVertexArrayBindingDivisor(Handle, bindingIndex, Bindings[ix].Divisor);
+		}
+	}
+}
+
+VertexArrayObject::SharedLayout::~SharedLayout() {
+	if (Handle != 0) {
+		GlState::ReleaseVertexArray(Handle);
+		glDeleteVertexArrays(1, &Handle);
+		Handle = 0;
+	}
+}
+
+bool VertexArrayObject::SharedLayout::Matches(const std::vector<Binding>& bindings) const {
+	if (bindings.size() != Bindings.size()) {
+		return false;
+	}
+	for (size_t ix = 0; ix < bindings.size(); ix++) {
+		const Binding& a = Bindings[ix];
+		const Binding& b = bindings[ix];
+		if (a.Stride != b.Stride || a.Divisor != b.Divisor || a.Attributes.size() != b.Attributes.size()) {
+			return false;
+		}
+		// The usage hint doesn't affect the GL state, so meshes with different usages can still share
+		for (size_t jx = 0; jx < a.Attributes.size(); jx++) {
+			const BufferAttribute& x = a.Attributes[jx];
+			const BufferAttribute& y = b.Attributes[jx];
+			if (x.Slot != y.Slot || x.Size != y.Size || x.Type != y.Type || x.Normalized != y.Normalized || x.Offset != y.Offset) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
 
 VertexArrayObject::VertexArrayObject() :
 	_indexBuffer(nullptr),
-	_handle(0),
+	_vertexBuffers(std::vector<VertexBufferBinding>()),
+	_dequantizeTransform(glm::mat4(1.0f)),
 	_vertexCount(0),
 	_elementCount(0),
-	_vertexBuffers(std::vector<VertexBufferBinding>())
+	_layout(nullptr)
 {
-	glCreateVertexArrays(1, &_handle);
+	_AcquireLayout();
 }
 
 VertexArrayObject::~VertexArrayObject()
 {
-	if (_handle != 0) {
-		glDeleteVertexArrays(1, &_handle);
-		_handle = 0;
+	// Our buffers may be deleted after this, and their names re-used, so the shared VAO needs to forget them
+	for (size_t ix = 0; ix < _vertexBuffers.size(); ix++) {
+		if (_layout->AttachedBuffers[ix] == _vertexBuffers[ix].Buffer->GetHandle()) {
+			_layout->AttachedBuffers[ix] = 0;
+		}
+	}
+	if (_indexBuffer != nullptr && _layout->AttachedIndexBuffer == _indexBuffer->GetHandle()) {
+		_layout->AttachedIndexBuffer = 0;
 	}
 }
 
 void VertexArrayObject::SetIndexBuffer(const IndexBuffer::Sptr& ibo) {
 	// TODO: What if we already have a buffer? should we delete it? who owns the buffer?
 	_indexBuffer = ibo;
-	Bind();
 	if (_indexBuffer != nullptr) {
-		_indexBuffer->Bind();
 		_elementCount = _indexBuffer->GetElementCount();
 	}
 	else {
-		IndexBuffer::Unbind();
 		_elementCount = _vertexCount;
 	}
-	Unbind();
 }
 
-void VertexArrayObject::AddVertexBuffer(const VertexBuffer::Sptr& buffer, const std::vector<BufferAttribute>& attributes) {
+void VertexArrayObject::AddVertexBuffer(const std::shared_ptr<IBuffer>& buffer, const std::vector<BufferAttribute>& attributes, GLuint divisor) {
 	if (_vertexBuffers.size() == 0) {
 		_vertexCount = buffer->GetElementCount();
 		if (_indexBuffer == nullptr) {
 			_elementCount = _vertexCount;
 		}
-	} else if (buffer->GetElementCount() != _vertexCount) {
+	} else if (divisor == 0 && buffer->GetElementCount() != _vertexCount) {
 		LOG_WARN("Buffer element count does not match vertex count of this VAO!!!");
 	}
 
 	VertexBufferBinding binding;
 	binding.Buffer = buffer;
 	binding.Attributes = attributes;
+	binding.Divisor = divisor;
 	_vertexBuffers.push_back(binding);
 
+	_AcquireLayout();
+}
 
-	Bind();
-	buffer->Bind();
-	for (const BufferAttribute& attrib : attributes) {
-		glEnableVertexArrayAttrib(_handle, attrib.Slot);
-		glVertexAttribPointer(attrib.Slot, attrib.Size, (GLenum)attrib.Type, attrib.Normalized, attrib.Stride,
-							  (void*)attrib.Offset);
+void VertexArrayObject::_AcquireLayout() {
+	std::vector<SharedLayout::Binding> bindings;
+	bindings.reserve(_vertexBuffers.size());
+	for (const VertexBufferBinding& buffer : _vertexBuffers) {
+		SharedLayout::Binding binding;
+		binding.Stride = buffer.Attributes.size() > 0 ? buffer.Attributes[0].Stride : 0;
+		binding.Divisor = buffer.Divisor;
+		binding.Attributes = buffer.Attributes;
+		bindings.push_back(binding);
 	}
-	Unbind();
+
+	// Search for an existing layout, dropping any that have been released along the way
+	for (auto it = __Layouts.begin(); it != __Layouts.end();) {
+		std::shared_ptr<SharedLayout> layout = it->lock();
+		if (layout == nullptr) {
+			it = __Layouts.erase(it);
+			continue;
+		}
+		if (layout->Matches(bindings)) {
+			_layout = layout;
+			return;
+		}
+		it++;
+	}
+
+	_layout = std::make_shared<SharedLayout>(bindings);
+	__Layouts.push_back(_layout);
 }
 
+// The VAO is left bound after drawing, so drawing the same mesh again doesn't need to re-bind it
 void VertexArrayObject::Draw(DrawMode mode) {
 	Bind();
 	if (_indexBuffer == nullptr) {
@@ -69,15 +147,37 @@ void VertexArrayObject::Draw(DrawMode mode) {
 	} else {
 		glDrawElements((GLenum)mode, _elementCount, (GLenum)_indexBuffer->GetElementType(), nullptr);
 	}
-	Unbind();
+}
+
+void VertexArrayObject::DrawInstanced(int instanceCount, DrawMode mode) {
+	Bind();
+	if (_indexBuffer == nullptr) {
+		glDrawArraysInstanced((GLenum)mode, 0, _elementCount, instanceCount);
+	} else {
+		glDrawElementsInstanced((GLenum)mode, _elementCount, (GLenum)_indexBuffer->GetElementType(), nullptr, instanceCount);
+	}
 }
 
 void VertexArrayObject::Bind() {
-	glBindVertexArray(_handle);
+	GlState::BindVertexArray(_layout->Handle);
+
+	// Swap in our buffers if another mesh with the same layout was the last to use the VAO
+	for (size_t ix = 0; ix < _vertexBuffers.size(); ix++) {
+		const GLuint buffer = _vertexBuffers[ix].Buffer->GetHandle();
+		if (_layout->AttachedBuffers[ix] != buffer) {
+			glVertexArrayVertexBuffer(_layout->Handle, static_cast<GLuint>(ix), buffer, 0, _layout->Bindings[ix].Stride);
+			_layout->AttachedBuffers[ix] = buffer;
+		}
+	}
+	const GLuint indexBuffer = _indexBuffer != nullptr ? _indexBuffer->GetHandle() : 0;
+	if (_layout->AttachedIndexBuffer != indexBuffer) {
+		glVertexArrayElementBuffer(_layout->Handle, indexBuffer);
+		_layout->AttachedIndexBuffer = indexBuffer;
+	}
 }
 
 void VertexArrayObject::Unbind() {
-	glBindVertexArray(0);
+	GlState::BindVertexArray(0);
 }
 
 void VertexArrayObject::SetVDecl(const VertexDeclaration& vDecl) {
@@ -4,6 +4,7 @@
 #include <vector>
 #include <memory>
 #include <EnumToString.h>
+#include <GLM/glm.hpp>
 
 #include "VertexBuffer.h"
 #include "IndexBuffer.h"
@@ -44,6 +45,9 @@ ENUM(AttributeType, GLenum,
 	UInt    = GL_UNSIGNED_INT,
 	Float   = GL_FLOAT,
 	Double  = GL_DOUBLE,
+	HalfFloat      = GL_HALF_FLOAT,
+	Int2101010Rev  = GL_INT_2_10_10_10_REV,  // Packed signed 10:10:10:2, size must be 4
+	UInt2101010Rev = GL_UNSIGNED_INT_2_10_10_10_REV, // Packed unsigned 10:10:10:2, size must be 4
 	Unknown = GL_NONE
 );
 
@@ -102,7 +106,12 @@ struct BufferAttribute {
 };
 
 /// <summary>
-/// The Vertex Array Object wraps around an OpenGL VAO and basically represents all of the data for a mesh
+/// The Vertex Array Object basically represents all of the data for a mesh
+/// 
+/// Meshes that have the same vertex layout share a single OpenGL VAO, with the attribute formats set up
+/// once using glVertexArrayAttribFormat and glVertexArrayAttribBinding. Binding a mesh binds the shared
+/// VAO and only swaps the buffers that are attached to it, so drawing many meshes with the same
+/// layout never needs to switch VAOs
 /// </summary>
 class VertexArrayObject final
 {
@@ -123,8 +132,10 @@ public:
 
 	// Helper structure to store a buffer and the attributes
 	struct VertexBufferBinding {
-		VertexBuffer::Sptr Buffer;
+		std::shared_ptr<IBuffer> Buffer;
 		std::vector<BufferAttribute> Attributes;
+		// The instance divisor for this buffer, 0 for per-vertex data
+		GLuint Divisor;
 	};
 	
 public:
@@ -150,7 +161,8 @@ public:
 	/// </summary>
 	/// <param name="buffer">The buffer to add (note, does not take ownership, you will still need to delete later)</param>
 	/// <param name="attributes">A list of vertex attributes that will be fed by this buffer</param>
-	void AddVertexBuffer(const VertexBuffer::Sptr& buffer, const std::vector<BufferAttribute>& attributes);
+	/// <param name="divisor">The instance divisor for the buffer, leave as 0 for per-vertex data</param>
+	void AddVertexBuffer(const std::shared_ptr<IBuffer>& buffer, const std::vector<BufferAttribute>& attributes, GLuint divisor = 0);
 
 	/// <summary>
 	/// Gets the buffer binding that has an attribute with the given usage
@@ -159,11 +171,23 @@ public:
 	/// <param name="usage">The attribute usage hint to search for</param>
 	/// <returns>A const pointer to the binding, or nullptr if none is found</returns>
 	const VertexBufferBinding* GetBufferBinding(AttribUsage usage);
+	/// <summary>
+	/// Gets all of the vertex buffers that are attached to this VAO
+	/// </summary>
+	const std::vector<VertexBufferBinding>& GetVertexBuffers() const { return _vertexBuffers; }
 
 	void Draw(DrawMode mode = DrawMode::TriangleList);
+	/// <summary>
+	/// Draws several copies of this VAO in a single draw call, shaders can use gl_InstanceID
+	/// to tell the copies apart
+	/// </summary>
+	/// <param name="instanceCount">The number of instances to draw</param>
+	/// <param name="mode">The primitive type to draw</param>
+	void DrawInstanced(int instanceCount, DrawMode mode = DrawMode::TriangleList);
 
 	/// <summary>
-	/// Binds this VAO as the source of data for draw operations
+	/// Binds this VAO as the source of data for draw operations, attaching this mesh's buffers to
+	/// the shared VAO if another mesh was using it
 	/// </summary>
 	void Bind();
 	/// <summary>
@@ -172,15 +196,46 @@ public:
 	static void Unbind();
 
 	/// <summary>
-	/// Returns the underlying OpenGL handle that this class is wrapping around
+	/// Returns the underlying OpenGL VAO, note that this is shared with all meshes that have the same layout
 	/// </summary>
-	GLuint GetHandle() const { return _handle; }
+	GLuint GetHandle() const { return _layout->Handle; }
 
 	void SetVDecl(const VertexDeclaration& vDecl);
 	const VertexDeclaration& GetVDecl();
 
+	/// <summary>
+	/// Sets the transform that maps this mesh's vertex positions back into object space, used by
+	/// meshes with quantized positions. Should be applied before the model matrix when rendering
+	/// </summary>
+	/// <param name="transform">The dequantization transform for the mesh</param>
+	void SetDequantizeTransform(const glm::mat4& transform) { _dequantizeTransform = transform; }
+	/// <summary>
+	/// Gets the transform that maps this mesh's vertex positions back into object space, will be
+	/// identity for meshes that do not use quantized positions
+	/// </summary>
+	const glm::mat4& GetDequantizeTransform() const { return _dequantizeTransform; }
+
 protected:
-	
+	// An OpenGL VAO that is shared by all VAOs with the same buffer layout
+	struct SharedLayout {
+		struct Binding {
+			GLsizei Stride;
+			GLuint  Divisor;
+			std::vector<BufferAttribute> Attributes;
+		};
+		std::vector<Binding> Bindings;
+
+		GLuint Handle;
+		// The buffers that are currently attached to the GL VAO, so we only swap them when they change
+		std::vector<GLuint> AttachedBuffers;
+		GLuint AttachedIndexBuffer;
+
+		SharedLayout(const std::vector<Binding>& bindings);
+		~SharedLayout();
+
+		bool Matches(const std::vector<Binding>& bindings) const;
+	};
+
 	// The index buffer bound to this VAO
 	IndexBuffer::Sptr _indexBuffer;
 	// The vertex buffers bound to this VAO
@@ -190,9 +245,18 @@ protected:
 	// defined in VertexTypes.cpp
 	VertexDeclaration _vDecl;
 
+	// Maps quantized vertex positions back into object space
+	glm::mat4 _dequantizeTransform;
+
 	uint32_t _vertexCount;
 	uint32_t _elementCount;
 
-	// The underlying OpenGL handle that this class is wrapping around
-	GLuint _handle;
+	// The shared GL VAO for our current buffer layout
+	std::shared_ptr<SharedLayout> _layout;
+
+	// All of the layouts that are currently in use, released when the last VAO using them is deleted
+	inline static std::vector<std::weak_ptr<SharedLayout>> __Layouts;
+
+	// Finds or creates the shared layout for our current vertex buffers
+	void _AcquireLayout();
 };
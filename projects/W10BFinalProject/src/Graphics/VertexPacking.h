@@ -0,0 +1,93 @@
+#pragma once
+#include <cstdint>
+#include <GLM/glm.hpp>
+#include <GLM/gtc/packing.hpp>
+#include <GLM/gtc/matrix_transform.hpp>
+#include <GLM/gtc/type_precision.hpp>
+#include <EnumToString.h>
+
+/// <summary>
+/// The vertex layouts that meshes can be baked into
+/// </summary>
+ENUM(VertexFormat, int,
+	Full      = 0, // VertexPosNormTexCol, 48 bytes per vertex
+	Packed    = 1, // VertexPackedPosNormTexCol, 24 bytes per vertex
+	Quantized = 2  // VertexQuantizedPosNormTexCol, 20 bytes per vertex
+);
+
+/// <summary>
+/// Describes how positions in a mesh were quantized into the 0-65535 range, and how to
+/// get back to object space
+/// </summary>
+struct PositionQuantization {
+	// The minimum corner of the mesh's bounding box
+	glm::vec3 Offset = glm::vec3(0.0f);
+	// The size of the mesh's bounding box along each axis
+	glm::vec3 Scale  = glm::vec3(1.0f);
+
+	/// <summary>
+	/// Creates a quantization that covers the given bounding box
+	/// </summary>
+	static PositionQuantization FromBounds(const glm::vec3& min, const glm::vec3& max) {
+		PositionQuantization result;
+		result.Offset = min;
+		// Avoid dividing by zero for flat meshes (ex: planes)
+		result.Scale = glm::max(max - min, glm::vec3(1e-6f));
+		return result;
+	}
+
+	/// <summary>
+	/// Maps an object space position into the normalized 16 bit range
+	/// </summary>
+	glm::u16vec4 Quantize(const glm::vec3& position) const {
+		glm::vec3 normalized = glm::clamp((position - Offset) / Scale, 0.0f, 1.0f);
+		return glm::u16vec4(glm::round(normalized * 65535.0f), 0);
+	}
+
+	/// <summary>
+	/// Gets the matrix that maps normalized positions back into object space, this should
+	/// be applied before the model matrix when rendering
+	/// </summary>
+	glm::mat4 GetDequantizeTransform() const {
+		return glm::scale(glm::translate(glm::mat4(1.0f), Offset), Scale);
+	}
+};
+
+/// <summary>
+/// Packs a normalized vector into the GL_INT_2_10_10_10_REV format
+/// </summary>
+inline uint32_t PackNormal(const glm::vec3& normal) {
+	return glm::packSnorm3x10_1x2(glm::vec4(normal, 0.0f));
+}
+/// <summary>
+/// Unpacks a vector stored in the GL_INT_2_10_10_10_REV format
+/// </summary>
+inline glm::vec3 UnpackNormal(uint32_t packed) {
+	return glm::vec3(glm::unpackSnorm3x10_1x2(packed));
+}
+
+/// <summary>
+/// Packs a 2 component vector into 2 half floats (GL_HALF_FLOAT)
+/// </summary>
+inline uint32_t PackHalf2(const glm::vec2& value) {
+	return glm::packHalf2x16(value);
+}
+/// <summary>
+/// Unpacks 2 half floats into a 2 component vector
+/// </summary>
+inline glm::vec2 UnpackHalf2(uint32_t packed) {
+	return glm::unpackHalf2x16(packed);
+}
+
+/// <summary>
+/// Packs an RGBA color into 4 normalized unsigned bytes
+/// </summary>
+inline uint32_t PackColorRGBA8(const glm::vec4& color) {
+	return glm::packUnorm4x8(color);
+}
+/// <summary>
+/// Unpacks an RGBA color stored as 4 normalized unsigned bytes
+/// </summary>
+inline glm::vec4 UnpackColorRGBA8(uint32_t packed) {
+	return glm::unpackUnorm4x8(packed);
+}
@@ -5,6 +5,8 @@ VertexPosCol* VPC = nullptr;
 VertexPosNormCol* VPNC = nullptr;
 VertexPosNormTex* VPNT = nullptr;
 VertexPosNormTexCol* VPNTC = nullptr;
+VertexPackedPosNormTexCol* VPPNTC = nullptr;
+VertexQuantizedPosNormTexCol* VQPNTC = nullptr;
 
 const std::vector<BufferAttribute> VertexPosCol::V_DECL = {
 	BufferAttribute(0, 3, AttributeType::Float, sizeof(VertexPosCol), (size_t)&VPC->Position, AttribUsage::Position),
@@ -26,4 +28,16 @@ const std::vector<BufferAttribute> VertexPosNormTexCol::V_DECL = {
 	BufferAttribute(2, 3, AttributeType::Float, sizeof(VertexPosNormTexCol), (size_t)&VPNTC->Normal, AttribUsage::Normal),
 	BufferAttribute(3, 2, AttributeType::Float, sizeof(VertexPosNormTexCol), (size_t)&VPNTC->UV, AttribUsage::Texture),
 };
+const std::vector<BufferAttribute> VertexPackedPosNormTexCol::V_DECL = {
+	BufferAttribute(0, 3, AttributeType::Float, sizeof(VertexPackedPosNormTexCol), (size_t)&VPPNTC->Position, AttribUsage::Position),
+	BufferAttribute(1, 4, AttributeType::UByte, sizeof(VertexPackedPosNormTexCol), (size_t)&VPPNTC->Color, AttribUsage::Color, true),
+	BufferAttribute(2, 4, AttributeType::Int2101010Rev, sizeof(VertexPackedPosNormTexCol), (size_t)&VPPNTC->Normal, AttribUsage::Normal, true),
+	BufferAttribute(3, 2, AttributeType::HalfFloat, sizeof(VertexPackedPosNormTexCol), (size_t)&VPPNTC->UV, AttribUsage::Texture),
+};
+const std::vector<BufferAttribute> VertexQuantizedPosNormTexCol::V_DECL = {
+	BufferAttribute(0, 3, AttributeType::UShort, sizeof(VertexQuantizedPosNormTexCol), (size_t)&VQPNTC->Position, AttribUsage::Position, true),
+	BufferAttribute(1, 4, AttributeType::UByte, sizeof(VertexQuantizedPosNormTexCol), (size_t)&VQPNTC->Color, AttribUsage::Color, true),
+	BufferAttribute(2, 4, AttributeType::Int2101010Rev, sizeof(VertexQuantizedPosNormTexCol), (size_t)&VQPNTC->Normal, AttribUsage::Normal, true),
+	BufferAttribute(3, 2, AttributeType::HalfFloat, sizeof(VertexQuantizedPosNormTexCol), (size_t)&VQPNTC->UV, AttribUsage::Texture),
+};
 #pragma warning(pop)
\ No newline at end of file
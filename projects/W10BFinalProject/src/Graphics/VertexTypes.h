@@ -2,6 +2,7 @@
 
 #include <GLM/glm.hpp>
 #include "VertexArrayObject.h"
+#include "VertexPacking.h"
 
 
 struct VertexPosCol {
@@ -58,4 +59,69 @@ struct VertexPosNormTexCol {
 		Position({ x, y, z }), Normal({ nX, nY, nZ }), UV({ u, v }), Color({r, g, b, a}) {}
 
 	static const std::vector<BufferAttribute> V_DECL;
+};
+
+/// <summary>
+/// A compact version of VertexPosNormTexCol, with a 10:10:10:2 normal, half float UVs
+/// and an RGBA8 color, at half the size of the full float version
+/// </summary>
+struct VertexPackedPosNormTexCol {
+	glm::vec3 Position;
+	uint32_t  Normal;
+	uint32_t  UV;
+	uint32_t  Color;
+
+	VertexPackedPosNormTexCol() : Position(glm::vec3(0.0f)), Normal(PackNormal(glm::vec3(0.0f))), UV(PackHalf2(glm::vec2(0.0f))), Color(PackColorRGBA8(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f))) {}
+	VertexPackedPosNormTexCol(const glm::vec3& pos, const glm::vec3& norm, const glm::vec2& uv, const glm::vec4& col) :
+		Position(pos), Normal(PackNormal(norm)), UV(PackHalf2(uv)), Color(PackColorRGBA8(col)) {}
+
+	/// <summary>
+	/// Converts a full float vertex into the packed format, positions are not quantized. The quantization
+	/// is ignored, it's only taken so that MeshBuilder can pack any of the compact formats the same way
+	/// </summary>
+	static VertexPackedPosNormTexCol Pack(const VertexPosNormTexCol& vertex, const PositionQuantization& /*quantization*/) {
+		return VertexPackedPosNormTexCol(vertex.Position, vertex.Normal, vertex.UV, vertex.Color);
+	}
+	/// <summary>
+	/// Converts this vertex back into the full float format
+	/// </summary>
+	VertexPosNormTexCol Unpack(const PositionQuantization& /*quantization*/) const {
+		return VertexPosNormTexCol(Position, UnpackNormal(Normal), UnpackHalf2(UV), UnpackColorRGBA8(Color));
+	}
+
+	static constexpr bool IsQuantized = false;
+	static const std::vector<BufferAttribute> V_DECL;
+};
+
+/// <summary>
+/// The most compact vertex format, extends VertexPackedPosNormTexCol by storing positions as
+/// normalized 16 bit integers within the mesh's bounds. Meshes using this format need their
+/// dequantization transform applied before the model matrix
+/// </summary>
+struct VertexQuantizedPosNormTexCol {
+	glm::u16vec4 Position; // W is unused, and keeps the rest of the vertex 4 byte aligned
+	uint32_t     Normal;
+	uint32_t     UV;
+	uint32_t     Color;
+
+	VertexQuantizedPosNormTexCol() : Position(glm::u16vec4(0)), Normal(PackNormal(glm::vec3(0.0f))), UV(PackHalf2(glm::vec2(0.0f))), Color(PackColorRGBA8(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f))) {}
+	VertexQuantizedPosNormTexCol(const glm::u16vec4& pos, const glm::vec3& norm, const glm::vec2& uv, const glm::vec4& col) :
+		Position(pos), Normal(PackNormal(norm)), UV(PackHalf2(uv)), Color(PackColorRGBA8(col)) {}
+
+	/// <summary>
+	/// Converts a full float vertex into the quantized format
+	/// </summary>
+	static VertexQuantizedPosNormTexCol Pack(const VertexPosNormTexCol& vertex, const PositionQuantization& quantization) {
+		return VertexQuantizedPosNormTexCol(quantization.Quantize(vertex.Position), vertex.Normal, vertex.UV, vertex.Color);
+	}
+	/// <summary>
+	/// Converts this vertex back into the full float format
+	/// </summary>
+	VertexPosNormTexCol Unpack(const PositionQuantization& quantization) const {
+		glm::vec3 pos = quantization.Offset + (glm::vec3(Position) / 65535.0f) * quantization.Scale;
+		return VertexPosNormTexCol(pos, UnpackNormal(Normal), UnpackHalf2(UV), UnpackColorRGBA8(Color));
+	}
+
+	static constexpr bool IsQuantized = true;
+	static const std::vector<BufferAttribute> V_DECL;
 };
\ No newline at end of file
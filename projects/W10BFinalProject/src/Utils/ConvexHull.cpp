@@ -0,0 +1,415 @@
+#include "Utils/ConvexHull.h"
+
+#include <algorithm>
+#include <numeric>
+#include <cfloat>
+
+#include "Logging.h"
+#include "Utils/JsonGlmHelpers.h"
+
+ConvexHullSettings ConvexHullSettings::FromJson(const nlohmann::json& blob) {
+	ConvexHullSettings result;
+	result.MaxVertices  = JsonGet(blob, "max_vertices", result.MaxVertices);
+	result.Decompose    = JsonGet(blob, "decompose", result.Decompose);
+	result.MaxHulls     = JsonGet(blob, "max_hulls", result.MaxHulls);
+	result.MaxConcavity = JsonGet(blob, "max_concavity", result.MaxConcavity);
+	return result;
+}
+
+nlohmann::json ConvexHullSettings::ToJson() const {
+	return {
+		{ "max_vertices",  MaxVertices },
+		{ "decompose",     Decompose },
+		{ "max_hulls",     MaxHulls },
+		{ "max_concavity", MaxConcavity }
+	};
+}
+
+namespace {
+	/// <summary>
+	/// A triangle on the hull being built, along with the points that are still outside of it
+	/// </summary>
+	struct HullFace {
+		uint32_t   V[3];
+		glm::dvec3 Normal;
+		double     Offset;
+		bool       Alive;
+		// Points that are in front of this face and not yet on the hull
+		std::vector<uint32_t> Outside;
+		// The point in Outside that is furthest from the face
+		uint32_t   Furthest;
+		double     FurthestDistance;
+
+		double Distance(const glm::dvec3& point) const {
+			return glm::dot(Normal, point) - Offset;
+		}
+	};
+
+	HullFace MakeFace(const std::vector<glm::dvec3>& points, uint32_t a, uint32_t b, uint32_t c) {
+		HullFace result;
+		result.V[0] = a;
+		result.V[1] = b;
+		result.V[2] = c;
+		glm::dvec3 normal = glm::cross(points[b] - points[a], points[c] - points[a]);
+		double length = glm::length(normal);
+		result.Normal = length > 0.0 ? normal / length : glm::dvec3(0.0);
+		result.Offset = glm::dot(result.Normal, points[a]);
+		result.Alive = true;
+		result.Furthest = 0;
+		result.FurthestDistance = 0.0;
+		return result;
+	}
+
+	/// <summary>
+	/// Assigns a point to the first face in the range that it is in front of, returns false if the point is inside all of them
+	/// </summary>
+	bool AssignPoint(std::vector<HullFace>& faces, size_t firstFace, const std::vector<glm::dvec3>& points, uint32_t point, double epsilon) {
+		for (size_t ix = firstFace; ix < faces.size(); ix++) {
+			HullFace& face = faces[ix];
+			if (!face.Alive) {
+				continue;
+			}
+			double distance = face.Distance(points[point]);
+			if (distance > epsilon) {
+				face.Outside.push_back(point);
+				if (distance > face.FurthestDistance) {
+					face.FurthestDistance = distance;
+					face.Furthest = point;
+				}
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/// <summary>
+	/// Gets the signed volume of the tetrahedron formed by a triangle and the given origin
+	/// </summary>
+	double TetrahedronVolume(const glm::dvec3& origin, const glm::dvec3& a, const glm::dvec3& b, const glm::dvec3& c) {
+		return glm::dot(a - origin, glm::cross(b - origin, c - origin)) / 6.0;
+	}
+}
+
+ConvexHullResult ConvexHull::Compute(const std::vector<glm::vec3>& points, int maxVertices) {
+	ConvexHullResult result;
+	if (points.empty()) {
+		return result;
+	}
+
+	std::vector<glm::dvec3> pts(points.begin(), points.end());
+
+	// Find the extreme points along each axis
+	uint32_t extremes[6] = { 0, 0, 0, 0, 0, 0 };
+	for (uint32_t ix = 1; ix < pts.size(); ix++) {
+		for (int axis = 0; axis < 3; axis++) {
+			if (pts[ix][axis] < pts[extremes[axis * 2]][axis]) {
+				extremes[axis * 2] = ix;
+			}
+			if (pts[ix][axis] > pts[extremes[axis * 2 + 1]][axis]) {
+				extremes[axis * 2 + 1] = ix;
+			}
+		}
+	}
+	glm::dvec3 size = glm::dvec3(pts[extremes[1]].x - pts[extremes[0]].x, pts[extremes[3]].y - pts[extremes[2]].y, pts[extremes[5]].z - pts[extremes[4]].z);
+	double epsilon = 1e-7 * (size.x + size.y + size.z);
+
+	// Build the initial tetrahedron from the two most distant extremes, the point furthest from the line
+	// between them, and the point furthest from the plane of those three
+	uint32_t a = extremes[0], b = extremes[1];
+	double bestDistance = -1.0;
+	for (int ix = 0; ix < 6; ix++) {
+		for (int iy = ix + 1; iy < 6; iy++) {
+			double distance = glm::length(pts[extremes[ix]] - pts[extremes[iy]]);
+			if (distance > bestDistance) {
+				bestDistance = distance;
+				a = extremes[ix];
+				b = extremes[iy];
+			}
+		}
+	}
+	uint32_t c = a;
+	bestDistance = epsilon;
+	glm::dvec3 lineDir = pts[b] - pts[a];
+	lineDir = bestDistance < glm::length(lineDir) ? glm::normalize(lineDir) : glm::dvec3(0.0);
+	for (uint32_t ix = 0; ix < pts.size(); ix++) {
+		glm::dvec3 offset = pts[ix] - pts[a];
+		double distance = glm::length(offset - lineDir * glm::dot(offset, lineDir));
+		if (distance > bestDistance) {
+			bestDistance = distance;
+			c = ix;
+		}
+	}
+	uint32_t d = a;
+	if (c != a) {
+		glm::dvec3 planeNormal = glm::normalize(glm::cross(pts[b] - pts[a], pts[c] - pts[a]));
+		bestDistance = epsilon;
+		for (uint32_t ix = 0; ix < pts.size(); ix++) {
+			double distance = glm::abs(glm::dot(pts[ix] - pts[a], planeNormal));
+			if (distance > bestDistance) {
+				bestDistance = distance;
+				d = ix;
+			}
+		}
+	}
+
+	// The points are all on a line, the hull is just the two ends
+	if (c == a) {
+		result.Vertices.push_back(points[a]);
+		if (b != a) {
+			result.Vertices.push_back(points[b]);
+		}
+		return result;
+	}
+	// The points are all on a plane, so there's no volume to build faces around. We find the outline
+	// of the points in the plane instead (Andrew's monotone chain), which is enough for bullet to build
+	// a flat convex shape
+	if (d == a) {
+		glm::dvec3 normal = glm::normalize(glm::cross(pts[b] - pts[a], pts[c] - pts[a]));
+		glm::dvec3 tangent = glm::normalize(glm::cross(normal, lineDir));
+		std::vector<std::pair<glm::dvec2, uint32_t>> projected(pts.size());
+		for (uint32_t ix = 0; ix < pts.size(); ix++) {
+			glm::dvec3 offset = pts[ix] - pts[a];
+			projected[ix] = std::make_pair(glm::dvec2(glm::dot(offset, lineDir), glm::dot(offset, tangent)), ix);
+		}
+		std::sort(projected.begin(), projected.end(), [](const auto& l, const auto& r) {
+			return l.first.x < r.first.x || (l.first.x == r.first.x && l.first.y < r.first.y);
+		});
+		auto turn = [](const glm::dvec2& o, const glm::dvec2& p, const glm::dvec2& q) {
+			return (p.x - o.x) * (q.y - o.y) - (p.y - o.y) * (q.x - o.x);
+		};
+		std::vector<std::pair<glm::dvec2, uint32_t>> outline(projected.size() * 2);
+		size_t count = 0;
+		for (size_t ix = 0; ix < projected.size(); ix++) {
+			while (count >= 2 && turn(outline[count - 2].first, outline[count - 1].first, projected[ix].first) <= epsilon * epsilon) {
+				count--;
+			}
+			outline[count++] = projected[ix];
+		}
+		for (size_t ix = projected.size() - 1, lower = count + 1; ix > 0; ix--) {
+			while (count >= lower && turn(outline[count - 2].first, outline[count - 1].first, projected[ix - 1].first) <= epsilon * epsilon) {
+				count--;
+			}
+			outline[count++] = projected[ix - 1];
+		}
+		for (size_t ix = 0; ix + 1 < count; ix++) {
+			result.Vertices.push_back(points[outline[ix].second]);
+		}
+		return result;
+	}
+
+	// Create the faces of the tetrahedron, making sure they all face away from the opposite vertex
+	std::vector<HullFace> faces;
+	const uint32_t tetra[4][4] = { { a, b, c, d }, { a, b, d, c }, { a, c, d, b }, { b, c, d, a } };
+	for (int ix = 0; ix < 4; ix++) {
+		HullFace face = MakeFace(pts, tetra[ix][0], tetra[ix][1], tetra[ix][2]);
+		if (face.Distance(pts[tetra[ix][3]]) > 0.0) {
+			face = MakeFace(pts, tetra[ix][0], tetra[ix][2], tetra[ix][1]);
+		}
+		faces.push_back(face);
+	}
+	for (uint32_t ix = 0; ix < pts.size(); ix++) {
+		if (ix != a && ix != b && ix != c && ix != d) {
+			AssignPoint(faces, 0, pts, ix, epsilon);
+		}
+	}
+
+	std::vector<uint32_t> onHull(pts.size(), 0);
+	std::vector<std::pair<uint32_t, uint32_t>> visibleEdges;
+	std::vector<std::pair<uint32_t, uint32_t>> horizon;
+	std::vector<uint32_t> orphans;
+	size_t vertexCount = 4;
+
+	while (maxVertices <= 0 || vertexCount < (size_t)maxVertices) {
+		// Grow the hull towards the point that is furthest from it
+		size_t source = faces.size();
+		for (size_t ix = 0; ix < faces.size(); ix++) {
+			if (faces[ix].Alive && !faces[ix].Outside.empty() && (source == faces.size() || faces[ix].FurthestDistance > faces[source].FurthestDistance)) {
+				source = ix;
+			}
+		}
+		if (source == faces.size()) {
+			break;
+		}
+		uint32_t eye = faces[source].Furthest;
+
+		// Remove every face that can see the new point, the edges that are only used by one of the removed
+		// faces form the horizon that we need to connect the point to
+		visibleEdges.clear();
+		orphans.clear();
+		for (HullFace& face : faces) {
+			if (face.Alive && face.Distance(pts[eye]) > epsilon) {
+				face.Alive = false;
+				for (int ie = 0; ie < 3; ie++) {
+					visibleEdges.push_back(std::make_pair(face.V[ie], face.V[(ie + 1) % 3]));
+				}
+				orphans.insert(orphans.end(), face.Outside.begin(), face.Outside.end());
+				face.Outside.clear();
+				face.Outside.shrink_to_fit();
+			}
+		}
+		horizon.clear();
+		std::vector<std::pair<uint32_t, uint32_t>> sortedEdges = visibleEdges;
+		std::sort(sortedEdges.begin(), sortedEdges.end());
+		for (const auto& edge : visibleEdges) {
+			if (!std::binary_search(sortedEdges.begin(), sortedEdges.end(), std::make_pair(edge.second, edge.first))) {
+				horizon.push_back(edge);
+			}
+		}
+
+		size_t firstNewFace = faces.size();
+		for (const auto& edge : horizon) {
+			faces.push_back(MakeFace(pts, edge.first, edge.second, eye));
+		}
+		for (uint32_t point : orphans) {
+			if (point != eye) {
+				AssignPoint(faces, firstNewFace, pts, point, epsilon);
+			}
+		}
+
+		// Adding a point can bury existing vertices, so count the vertices that are still referenced
+		std::fill(onHull.begin(), onHull.end(), 0);
+		vertexCount = 0;
+		for (const HullFace& face : faces) {
+			if (face.Alive) {
+				for (uint32_t index : face.V) {
+					vertexCount += onHull[index]++ == 0 ? 1 : 0;
+				}
+			}
+		}
+
+		// Compact the face list every now and then so we aren't always iterating over dead faces
+		if (faces.size() > 64 && faces.size() > firstNewFace * 2) {
+			faces.erase(std::remove_if(faces.begin(), faces.end(), [](const HullFace& face) { return !face.Alive; }), faces.end());
+		}
+	}
+
+	// Output the live faces, with the vertices in the order they are first referenced
+	std::vector<uint32_t> remap(pts.size(), UINT32_MAX);
+	for (const HullFace& face : faces) {
+		if (face.Alive) {
+			for (uint32_t index : face.V) {
+				if (remap[index] == UINT32_MAX) {
+					remap[index] = static_cast<uint32_t>(result.Vertices.size());
+					result.Vertices.push_back(points[index]);
+				}
+				result.Indices.push_back(remap[index]);
+			}
+		}
+	}
+	return result;
+}
+
+std::vector<ConvexHullResult> ConvexHull::Decompose(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const ConvexHullSettings& settings) {
+	struct Part {
+		std::vector<uint32_t> Triangles;
+		ConvexHullResult      Hull;
+		double                Concavity;
+	};
+
+	// Builds the hull for a piece of the mesh, and estimates how much of the hull is empty space by comparing
+	// the hull's volume to the volume enclosed by the triangles. Pieces that have been cut open will have their
+	// volume slightly underestimated, which only makes us more likely to split them further
+	auto buildPart = [&](Part& part) {
+		std::vector<uint32_t> used;
+		used.reserve(part.Triangles.size() * 3);
+		for (uint32_t tri : part.Triangles) {
+			used.push_back(indices[tri * 3]);
+			used.push_back(indices[tri * 3 + 1]);
+			used.push_back(indices[tri * 3 + 2]);
+		}
+		std::sort(used.begin(), used.end());
+		used.erase(std::unique(used.begin(), used.end()), used.end());
+		std::vector<glm::vec3> points;
+		points.reserve(used.size());
+		glm::dvec3 center = glm::dvec3(0.0);
+		for (uint32_t index : used) {
+			points.push_back(positions[index]);
+			center += glm::dvec3(positions[index]);
+		}
+		center /= (double)std::max<size_t>(used.size(), 1);
+
+		part.Hull = Compute(points, settings.MaxVertices);
+		double hullVolume = GetVolume(part.Hull);
+		double meshVolume = 0.0;
+		for (uint32_t tri : part.Triangles) {
+			meshVolume += TetrahedronVolume(center, positions[indices[tri * 3]], positions[indices[tri * 3 + 1]], positions[indices[tri * 3 + 2]]);
+		}
+		meshVolume = glm::clamp(glm::abs(meshVolume), 0.0, hullVolume);
+		part.Concavity = hullVolume > 0.0 ? (hullVolume - meshVolume) / hullVolume : 0.0;
+	};
+
+	std::vector<Part> parts(1);
+	parts[0].Triangles.resize(indices.size() / 3);
+	std::iota(parts[0].Triangles.begin(), parts[0].Triangles.end(), 0);
+	buildPart(parts[0]);
+
+	while (settings.Decompose && parts.size() < (size_t)std::max(settings.MaxHulls, 1)) {
+		// Find the most concave piece, ties go to the earliest piece so the result is deterministic
+		size_t worst = 0;
+		for (size_t ix = 1; ix < parts.size(); ix++) {
+			if (parts[ix].Concavity > parts[worst].Concavity) {
+				worst = ix;
+			}
+		}
+		if (parts[worst].Concavity <= settings.MaxConcavity || parts[worst].Triangles.size() < 2) {
+			break;
+		}
+
+		// Try splitting the triangles by their centroids at a few points along each axis, and keep the
+		// split that results in the least total hull volume
+		const std::vector<uint32_t>& triangles = parts[worst].Triangles;
+		std::vector<glm::vec3> centroids(triangles.size());
+		for (size_t ix = 0; ix < triangles.size(); ix++) {
+			uint32_t tri = triangles[ix];
+			centroids[ix] = (positions[indices[tri * 3]] + positions[indices[tri * 3 + 1]] + positions[indices[tri * 3 + 2]]) / 3.0f;
+		}
+
+		Part bestLeft, bestRight;
+		float bestVolume = FLT_MAX;
+		std::vector<size_t> order(triangles.size());
+		for (int axis = 0; axis < 3; axis++) {
+			std::iota(order.begin(), order.end(), 0);
+			std::stable_sort(order.begin(), order.end(), [&](size_t l, size_t r) {
+				return centroids[l][axis] < centroids[r][axis];
+			});
+			for (int quarter = 1; quarter < 4; quarter++) {
+				size_t split = std::max<size_t>(order.size() * quarter / 4, 1);
+				Part left, right;
+				for (size_t ix = 0; ix < order.size(); ix++) {
+					(ix < split ? left : right).Triangles.push_back(triangles[order[ix]]);
+				}
+				buildPart(left);
+				buildPart(right);
+				float volume = GetVolume(left.Hull) + GetVolume(right.Hull);
+				if (volume < bestVolume) {
+					bestVolume = volume;
+					bestLeft = std::move(left);
+					bestRight = std::move(right);
+				}
+			}
+		}
+		parts[worst] = std::move(bestLeft);
+		parts.push_back(std::move(bestRight));
+	}
+
+	std::vector<ConvexHullResult> result;
+	result.reserve(parts.size());
+	for (Part& part : parts) {
+		if (!part.Hull.Vertices.empty()) {
+			result.push_back(std::move(part.Hull));
+		}
+	}
+	return result;
+}
+
+float ConvexHull::GetVolume(const ConvexHullResult& hull) {
+	if (hull.Vertices.empty()) {
+		return 0.0f;
+	}
+	glm::dvec3 origin = hull.Vertices[0];
+	double result = 0.0;
+	for (size_t ix = 0; ix + 2 < hull.Indices.size(); ix += 3) {
+		result += TetrahedronVolume(origin, hull.Vertices[hull.Indices[ix]], hull.Vertices[hull.Indices[ix + 1]], hull.Vertices[hull.Indices[ix + 2]]);
+	}
+	return static_cast<float>(glm::abs(result));
+}
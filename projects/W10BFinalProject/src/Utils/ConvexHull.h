@@ -0,0 +1,75 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <GLM/glm.hpp>
+#include "json.hpp"
+
+/// <summary>
+/// Configures how convex hulls are generated for a mesh
+/// </summary>
+struct ConvexHullSettings {
+	/// <summary>
+	/// The maximum number of vertices in each hull, 0 for no limit
+	/// </summary>
+	int   MaxVertices  = 32;
+	/// <summary>
+	/// True if the mesh should be split into multiple convex pieces
+	/// </summary>
+	bool  Decompose    = false;
+	/// <summary>
+	/// The maximum number of hulls to split a mesh into when decomposing
+	/// </summary>
+	int   MaxHulls     = 8;
+	/// <summary>
+	/// The ratio of a hull's volume that may be empty space before it is split further when decomposing
+	/// </summary>
+	float MaxConcavity = 0.1f;
+
+	static ConvexHullSettings FromJson(const nlohmann::json& blob);
+	nlohmann::json ToJson() const;
+};
+
+/// <summary>
+/// A convex hull stored as a triangle list with outward facing (counter-clockwise) winding
+/// </summary>
+struct ConvexHullResult {
+	std::vector<glm::vec3> Vertices;
+	std::vector<uint32_t>  Indices;
+};
+
+/// <summary>
+/// Generates convex hulls from point clouds and triangle meshes
+/// </summary>
+class ConvexHull
+{
+public:
+	/// <summary>
+	/// Calculates the convex hull of a set of points using quickhull (Barber, Dobkin and Huhdanpaa, 1996)
+	///
+	/// When a vertex limit is given, the hull is grown from the furthest remaining point each step and
+	/// stops once the limit is reached, which gives a good approximation that sits just inside the full hull.
+	/// Flat or degenerate inputs will return their extreme points without any faces
+	/// </summary>
+	/// <param name="points">The points to calculate the hull for</param>
+	/// <param name="maxVertices">The maximum number of vertices in the result, 0 for no limit</param>
+	static ConvexHullResult Compute(const std::vector<glm::vec3>& points, int maxVertices = 0);
+
+	/// <summary>
+	/// Approximates a triangle mesh with one or more convex hulls. If settings.Decompose is set, the most
+	/// concave piece is repeatedly split in half along it's longest axis until every piece is within
+	/// MaxConcavity, or MaxHulls is reached
+	/// </summary>
+	/// <param name="positions">The positions of the vertices in the mesh</param>
+	/// <param name="indices">The indices of the triangle list</param>
+	/// <param name="settings">The settings to use for hull generation</param>
+	static std::vector<ConvexHullResult> Decompose(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const ConvexHullSettings& settings);
+
+	/// <summary>
+	/// Calculates the volume enclosed by a convex hull
+	/// </summary>
+	static float GetVolume(const ConvexHullResult& hull);
+
+protected:
+	ConvexHull() = default;
+	~ConvexHull() = default;
+};
@@ -1,6 +1,10 @@
 #pragma once
 #include <vector>
+#include <limits>
 #include "Graphics/VertexArrayObject.h"
+#include "Graphics/VertexTypes.h"
+#include "Utils/MeshOptimizer.h"
+#include "Logging.h"
 
 /// <summary>
 /// A utility class that lets us add vertices and indices, then bake it into a final mesh, using interleaved
@@ -13,7 +17,8 @@ class MeshBuilder
 public:
 	MeshBuilder() :
 		_vertices(std::vector<VertType>()),
-		_indices(std::vector<uint32_t>()) {}
+		_indices(std::vector<uint32_t>()),
+		_dequantizeTransform(glm::mat4(1.0f)) {}
 	~MeshBuilder() = default;
 
 	/// <summary>
@@ -116,6 +121,121 @@ public:
 	/// </summary>
 	size_t GetTriangleCount() const { return _indices.size() > 0 ? _indices.size() / 3 : _vertices.size() / 3; }
 
+	/// <summary>
+	/// Runs the CPU-side optimization passes enabled in settings over this mesh, re-ordering
+	/// triangles and vertices to reduce vertex shading and fetch costs. Does nothing for
+	/// meshes without an index buffer
+	/// </summary>
+	/// <param name="settings">The settings for the optimization passes</param>
+	/// <param name="before">If non-null, will receive the vertex cache stats before optimizing</param>
+	/// <param name="after">If non-null, will receive the vertex cache stats after optimizing</param>
+	void Optimize(const MeshOptimizationSettings& settings, MeshCacheStats* before = nullptr, MeshCacheStats* after = nullptr) {
+		if (_indices.size() < 3) {
+			return;
+		}
+
+		MeshCacheStats initial = MeshOptimizer::AnalyzeVertexCache(_indices.data(), _indices.size(), _vertices.size(), settings.CacheSize);
+
+		if (settings.OptimizeVertexCache) {
+			std::vector<size_t> clusters;
+			MeshOptimizer::OptimizeVertexCache(_indices.data(), _indices.size(), _vertices.size(), settings.CacheSize, settings.OptimizeOverdraw ? &clusters : nullptr);
+
+			if (settings.OptimizeOverdraw) {
+				std::vector<glm::vec3> positions;
+				positions.reserve(_vertices.size());
+				for (const VertType& vert : _vertices) {
+					positions.push_back(vert.Position);
+				}
+				MeshOptimizer::OptimizeOverdraw(_indices.data(), _indices.size(), positions, clusters, settings.CacheSize, settings.OverdrawThreshold);
+			}
+		}
+
+		if (settings.OptimizeVertexFetch) {
+			size_t vertexCount = 0;
+			std::vector<uint32_t> remap = MeshOptimizer::OptimizeVertexFetch(_indices.data(), _indices.size(), _vertices.size(), vertexCount);
+
+			// Shuffle the vertices into their new slots, dropping any that were never referenced
+			std::vector<VertType> vertices(vertexCount);
+			for (size_t ix = 0; ix < _vertices.size(); ix++) {
+				if (remap[ix] != MeshOptimizer::UNUSED_VERTEX) {
+					vertices[remap[ix]] = _vertices[ix];
+				}
+			}
+			_vertices.swap(vertices);
+		}
+
+		MeshCacheStats final = MeshOptimizer::AnalyzeVertexCache(_indices.data(), _indices.size(), _vertices.size(), settings.CacheSize);
+		LOG_TRACE("Optimized mesh ({} vertices, {} triangles): ACMR {} -> {}, ATVR {} -> {}", _vertices.size(), _indices.size() / 3, initial.ACMR, final.ACMR, initial.ATVR, final.ATVR);
+
+		if (before != nullptr) { *before = initial; }
+		if (after != nullptr)  { *after  = final; }
+	}
+
+	/// <summary>
+	/// Runs the optimization pass (if enabled in settings), then creates and returns a
+	/// VertexArrayObject from the resulting data
+	/// </summary>
+	/// <param name="settings">The settings for the optimization passes</param>
+	/// <returns>A VertexArrayObject</returns>
+	VertexArrayObject::Sptr Bake(const MeshOptimizationSettings& settings) {
+		if (settings.Enabled) {
+			Optimize(settings);
+		}
+		return Bake();
+	}
+
+	/// <summary>
+	/// Converts this mesh into a new mesh using a packed vertex type. The packed type must provide a static
+	/// Pack(const VertType&, const PositionQuantization&) function and an IsQuantized flag. For quantized types,
+	/// positions will be mapped to the bounds of this mesh, and the resulting VAO will have a dequantization transform
+	/// </summary>
+	/// <typeparam name="PackedType">The vertex type to convert to</typeparam>
+	/// <returns>A mesh builder with the converted vertices and the same indices</returns>
+	template <typename PackedType>
+	MeshBuilder<PackedType> Pack() const {
+		PositionQuantization quantization;
+		if (PackedType::IsQuantized && _vertices.size() > 0) {
+			glm::vec3 min = _vertices[0].Position;
+			glm::vec3 max = _vertices[0].Position;
+			for (const VertType& vert : _vertices) {
+				min = glm::min(min, vert.Position);
+				max = glm::max(max, vert.Position);
+			}
+			quantization = PositionQuantization::FromBounds(min, max);
+		}
+
+		MeshBuilder<PackedType> result;
+		result._vertices.reserve(_vertices.size());
+		for (const VertType& vert : _vertices) {
+			result._vertices.push_back(PackedType::Pack(vert, quantization));
+		}
+		result._indices = _indices;
+		result._dequantizeTransform = PackedType::IsQuantized ? quantization.GetDequantizeTransform() : glm::mat4(1.0f);
+		return result;
+	}
+
+	/// <summary>
+	/// Runs the optimization pass (if enabled in settings), then bakes the mesh using the given vertex format,
+	/// converting the vertices if required. Only valid for meshes made of VertexPosNormTexCol
+	/// </summary>
+	/// <param name="settings">The settings for the optimization passes</param>
+	/// <param name="format">The vertex layout to upload the mesh with</param>
+	/// <returns>A VertexArrayObject</returns>
+	VertexArrayObject::Sptr Bake(const MeshOptimizationSettings& settings, VertexFormat format) {
+		if (settings.Enabled) {
+			Optimize(settings);
+		}
+		switch (format) {
+			case VertexFormat::Packed:
+				return Pack<VertexPackedPosNormTexCol>().Bake();
+			case VertexFormat::Quantized:
+				return Pack<VertexQuantizedPosNormTexCol>().Bake();
+			case VertexFormat::Full:
+			default:
+				return Bake();
+		}
+	}
+
 	/// <summary>
 	/// Creates and returns a VertexArraybject from the current data
 	/// </summary>
@@ -126,21 +246,41 @@ public:
 
 		IndexBuffer::Sptr ebo = nullptr;
 		if (_indices.size() > 0) {
-			ebo = IndexBuffer::Create();
-			ebo->LoadData(GetIndexDataPtr(), _indices.size());
+			ebo = BakeIndices(GetIndexDataPtr(), _indices.size(), _vertices.size());
 		}
 
-		// Create VAO and attach the buffers
+		// Create VAO and attach the buffers, meshes with the same vertex type will share the same GL VAO
+		// and only swap buffers when they are bound
 		VertexArrayObject::Sptr result = VertexArrayObject::Create();
 		result->AddVertexBuffer(vbo, VertType::V_DECL);
 		result->SetIndexBuffer(ebo);
 
 		// Store our vertex type in the VAO's vertex declaration
 		result->SetVDecl(VertType::V_DECL);
+		result->SetDequantizeTransform(_dequantizeTransform);
 
 		return result;
 	}
 	
+	/// <summary>
+	/// Creates an index buffer from a set of indices, using 16 bit indices if all the vertices
+	/// can be addressed by them
+	/// </summary>
+	/// <param name="indices">The indices to upload</param>
+	/// <param name="indexCount">The number of indices to upload</param>
+	/// <param name="vertexCount">The number of vertices referenced by the indices</param>
+	static IndexBuffer::Sptr BakeIndices(const uint32_t* indices, size_t indexCount, size_t vertexCount) {
+		IndexBuffer::Sptr result = IndexBuffer::Create();
+		// If all our vertices can be addressed with 16 bits, we can halve the size of the index buffer
+		if (vertexCount <= std::numeric_limits<uint16_t>::max()) {
+			std::vector<uint16_t> shortIndices(indices, indices + indexCount);
+			result->LoadData(shortIndices.data(), shortIndices.size());
+		} else {
+			result->LoadData(indices, indexCount);
+		}
+		return result;
+	}
+
 	/// <summary>
 	/// Gets a pointer to the underlying vertex data in the mesh, valid only
 	/// until another call to AddVertex
@@ -158,7 +298,10 @@ public:
 	
 protected:
 	friend class MeshFactory;
+	template <typename> friend class MeshBuilder;
 	
 	std::vector<VertType> _vertices;
 	std::vector<uint32_t> _indices;
+	// Only used by vertex types with quantized positions
+	glm::mat4             _dequantizeTransform;
 };
@@ -0,0 +1,253 @@
+#include "Utils/MeshOptimizer.h"
+
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+
+#include "Logging.h"
+#include "Utils/JsonGlmHelpers.h"
+
+MeshOptimizationSettings MeshOptimizationSettings::FromJson(const nlohmann::json& blob) {
+	MeshOptimizationSettings result;
+	result.Enabled             = JsonGet(blob, "enabled", result.Enabled);
+	result.OptimizeVertexCache = JsonGet(blob, "vertex_cache", result.OptimizeVertexCache);
+	result.OptimizeOverdraw    = JsonGet(blob, "overdraw", result.OptimizeOverdraw);
+	result.OptimizeVertexFetch = JsonGet(blob, "vertex_fetch", result.OptimizeVertexFetch);
+	result.CacheSize           = JsonGet(blob, "cache_size", result.CacheSize);
+	result.OverdrawThreshold   = JsonGet(blob, "overdraw_threshold", result.OverdrawThreshold);
+	return result;
+}
+
+nlohmann::json MeshOptimizationSettings::ToJson() const {
+	return {
+		{ "enabled",            Enabled },
+		{ "vertex_cache",       OptimizeVertexCache },
+		{ "overdraw",           OptimizeOverdraw },
+		{ "vertex_fetch",       OptimizeVertexFetch },
+		{ "cache_size",         CacheSize },
+		{ "overdraw_threshold", OverdrawThreshold }
+	};
+}
+
+MeshCacheStats MeshOptimizer::AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, int cacheSize) {
+	MeshCacheStats result;
+	if (indexCount == 0 || vertexCount == 0) {
+		return result;
+	}
+
+	// We simulate a FIFO cache by storing the time that each vertex entered the cache, a vertex is
+	// in the cache if less than cacheSize vertices have been transformed since it was added
+	std::vector<size_t> cacheTime(vertexCount, 0);
+	size_t timestamp = cacheSize + 1;
+	size_t transformed = 0;
+
+	for (size_t ix = 0; ix < indexCount; ix++) {
+		uint32_t index = indices[ix];
+		if (timestamp - cacheTime[index] > (size_t)cacheSize) {
+			cacheTime[index] = timestamp++;
+			transformed++;
+		}
+	}
+
+	result.ACMR = (float)transformed / (float)(indexCount / 3);
+	result.ATVR = (float)transformed / (float)vertexCount;
+	return result;
+}
+
+void MeshOptimizer::OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, int cacheSize, std::vector<size_t>* clusters) {
+	size_t triCount = indexCount / 3;
+	if (triCount == 0 || vertexCount == 0) {
+		return;
+	}
+
+	// Build our vertex -> triangle adjacency, stored as offsets into a single flat array
+	std::vector<uint32_t> live(vertexCount, 0);
+	for (size_t ix = 0; ix < triCount * 3; ix++) {
+		live[indices[ix]]++;
+	}
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		adjacencyOffsets[ix + 1] = adjacencyOffsets[ix] + live[ix];
+	}
+	std::vector<uint32_t> adjacency(adjacencyOffsets[vertexCount]);
+	std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (size_t ix = 0; ix < triCount * 3; ix++) {
+		adjacency[fill[indices[ix]]++] = static_cast<uint32_t>(ix / 3);
+	}
+
+	std::vector<size_t>   cacheTime(vertexCount, 0);
+	std::vector<bool>     emitted(triCount, false);
+	std::vector<uint32_t> deadEnd;
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> result;
+	result.reserve(triCount * 3);
+	deadEnd.reserve(triCount * 3);
+
+	size_t timestamp = cacheSize + 1;
+	size_t cursor = 1;
+	int64_t fanningVertex = 0;
+
+	if (clusters != nullptr) {
+		clusters->clear();
+		clusters->push_back(0);
+	}
+
+	while (fanningVertex >= 0) {
+		candidates.clear();
+
+		// Emit every remaining triangle around the fanning vertex
+		for (uint32_t ix = adjacencyOffsets[fanningVertex]; ix < adjacencyOffsets[fanningVertex + 1]; ix++) {
+			uint32_t tri = adjacency[ix];
+			if (emitted[tri]) {
+				continue;
+			}
+			for (int iv = 0; iv < 3; iv++) {
+				uint32_t vert = indices[tri * 3 + iv];
+				result.push_back(vert);
+				deadEnd.push_back(vert);
+				candidates.push_back(vert);
+				live[vert]--;
+				if (timestamp - cacheTime[vert] > (size_t)cacheSize) {
+					cacheTime[vert] = timestamp++;
+				}
+			}
+			emitted[tri] = true;
+		}
+
+		// Select the candidate that will remain in the cache the longest once it's triangles have been emitted
+		int64_t best = -1;
+		int64_t bestPriority = -1;
+		for (uint32_t vert : candidates) {
+			if (live[vert] > 0) {
+				int64_t priority = 0;
+				if (timestamp - cacheTime[vert] + 2 * live[vert] <= (size_t)cacheSize) {
+					priority = timestamp - cacheTime[vert];
+				}
+				if (priority > bestPriority) {
+					bestPriority = priority;
+					best = vert;
+				}
+			}
+		}
+
+		// If none of our candidates have any triangles left, we've hit a dead end and need to jump
+		// somewhere else in the mesh, which will flush the cache
+		if (best == -1) {
+			while (!deadEnd.empty()) {
+				uint32_t vert = deadEnd.back();
+				deadEnd.pop_back();
+				if (live[vert] > 0) {
+					best = vert;
+					break;
+				}
+			}
+			while (best == -1 && cursor < vertexCount) {
+				if (live[cursor] > 0) {
+					best = cursor;
+				}
+				cursor++;
+			}
+
+			// Record where the jump happened so the overdraw pass can treat these as independent clusters
+			if (best != -1 && clusters != nullptr && clusters->back() != result.size()) {
+				clusters->push_back(result.size());
+			}
+		}
+
+		fanningVertex = best;
+	}
+
+	LOG_ASSERT(result.size() == triCount * 3, "Vertex cache optimization dropped triangles!");
+	memcpy(indices, result.data(), result.size() * sizeof(uint32_t));
+}
+
+void MeshOptimizer::OptimizeOverdraw(uint32_t* indices, size_t indexCount, const std::vector<glm::vec3>& positions, const std::vector<size_t>& clusters, int cacheSize, float threshold) {
+	if (clusters.size() <= 1 || indexCount < 3) {
+		return;
+	}
+
+	size_t triIndexCount = (indexCount / 3) * 3;
+	MeshCacheStats original = AnalyzeVertexCache(indices, triIndexCount, positions.size(), cacheSize);
+
+	// Find the area weighted centroid of the whole mesh
+	glm::vec3 meshCentroid = glm::vec3(0.0f);
+	float meshArea = 0.0f;
+	for (size_t ix = 0; ix < triIndexCount; ix += 3) {
+		const glm::vec3& a = positions[indices[ix]];
+		const glm::vec3& b = positions[indices[ix + 1]];
+		const glm::vec3& c = positions[indices[ix + 2]];
+		float area = glm::length(glm::cross(b - a, c - a));
+		meshCentroid += (a + b + c) * (area / 3.0f);
+		meshArea += area;
+	}
+	meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : meshCentroid;
+
+	// Score each cluster based on how far it is from the center of the mesh along it's average normal,
+	// clusters that face outwards and sit on the outside of the mesh tend to occlude the rest of it
+	struct ClusterInfo {
+		size_t Start;
+		size_t End;
+		float  Score;
+	};
+	std::vector<ClusterInfo> info;
+	info.reserve(clusters.size());
+	for (size_t ix = 0; ix < clusters.size(); ix++) {
+		ClusterInfo cluster;
+		cluster.Start = clusters[ix];
+		cluster.End   = ix + 1 < clusters.size() ? clusters[ix + 1] : triIndexCount;
+
+		glm::vec3 centroid = glm::vec3(0.0f);
+		glm::vec3 normal   = glm::vec3(0.0f);
+		float area = 0.0f;
+		for (size_t it = cluster.Start; it < cluster.End; it += 3) {
+			const glm::vec3& a = positions[indices[it]];
+			const glm::vec3& b = positions[indices[it + 1]];
+			const glm::vec3& c = positions[indices[it + 2]];
+			glm::vec3 cross = glm::cross(b - a, c - a);
+			float triArea = glm::length(cross);
+			centroid += (a + b + c) * (triArea / 3.0f);
+			normal += cross;
+			area += triArea;
+		}
+		centroid = area > 0.0f ? centroid / area : centroid;
+		float normalLength = glm::length(normal);
+		normal = normalLength > 0.0f ? normal / normalLength : normal;
+
+		cluster.Score = glm::dot(centroid - meshCentroid, normal);
+		info.push_back(cluster);
+	}
+
+	// Stable sort so that the result is deterministic for clusters with equal scores
+	std::stable_sort(info.begin(), info.end(), [](const ClusterInfo& a, const ClusterInfo& b) {
+		return a.Score > b.Score;
+	});
+
+	std::vector<uint32_t> result;
+	result.reserve(indexCount);
+	for (const ClusterInfo& cluster : info) {
+		result.insert(result.end(), indices + cluster.Start, indices + cluster.End);
+	}
+
+	// Only keep the new order if we haven't given up too much of our vertex cache efficiency
+	MeshCacheStats reordered = AnalyzeVertexCache(result.data(), result.size(), positions.size(), cacheSize);
+	if (reordered.ACMR <= original.ACMR * threshold) {
+		memcpy(indices, result.data(), result.size() * sizeof(uint32_t));
+	}
+}
+
+std::vector<uint32_t> MeshOptimizer::OptimizeVertexFetch(uint32_t* indices, size_t indexCount, size_t vertexCount, size_t& outVertexCount) {
+	std::vector<uint32_t> remap(vertexCount, UNUSED_VERTEX);
+	uint32_t nextVertex = 0;
+
+	// Vertices are assigned new indices in the order that they are first used
+	for (size_t ix = 0; ix < indexCount; ix++) {
+		uint32_t& mapped = remap[indices[ix]];
+		if (mapped == UNUSED_VERTEX) {
+			mapped = nextVertex++;
+		}
+		indices[ix] = mapped;
+	}
+
+	outVertexCount = nextVertex;
+	return remap;
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <GLM/glm.hpp>
+#include "json.hpp"
+
+/// <summary>
+/// Configures the optional optimization pass that MeshBuilder can run on a mesh
+/// before it is uploaded to the GPU
+/// </summary>
+struct MeshOptimizationSettings {
+	/// <summary>
+	/// True if the optimization pass should run at all
+	/// </summary>
+	bool  Enabled             = false;
+	/// <summary>
+	/// Reorders triangles to improve post-transform vertex cache hits (Tipsify)
+	/// </summary>
+	bool  OptimizeVertexCache = true;
+	/// <summary>
+	/// Reorders clusters of triangles so that outward facing clusters are drawn first,
+	/// requires OptimizeVertexCache
+	/// </summary>
+	bool  OptimizeOverdraw    = true;
+	/// <summary>
+	/// Reorders vertices in the order they are first referenced, and remaps the indices to match
+	/// </summary>
+	bool  OptimizeVertexFetch = true;
+	/// <summary>
+	/// The size of the simulated post-transform cache, in vertices
+	/// </summary>
+	int   CacheSize           = 16;
+	/// <summary>
+	/// How much worse the ACMR is allowed to get (as a ratio) in exchange for a better overdraw order
+	/// </summary>
+	float OverdrawThreshold   = 1.05f;
+
+	static MeshOptimizationSettings FromJson(const nlohmann::json& blob);
+	nlohmann::json ToJson() const;
+};
+
+/// <summary>
+/// Stores the results of simulating a FIFO post-transform cache over a mesh
+/// </summary>
+struct MeshCacheStats {
+	/// <summary>
+	/// Average cache miss ratio, the number of transformed vertices per triangle (between 0.5 and 3, lower is better)
+	/// </summary>
+	float ACMR = 0.0f;
+	/// <summary>
+	/// Average transform to vertex ratio, the number of transformed vertices per unique vertex (1 is optimal)
+	/// </summary>
+	float ATVR = 0.0f;
+};
+
+/// <summary>
+/// Provides CPU-side optimizations for indexed triangle lists
+/// </summary>
+class MeshOptimizer
+{
+public:
+	/// <summary>
+	/// Simulates a FIFO post-transform cache over the given indices and returns the ACMR and ATVR
+	/// </summary>
+	/// <param name="indices">The indices of the triangle list</param>
+	/// <param name="indexCount">The number of indices, should be a multiple of 3</param>
+	/// <param name="vertexCount">The number of vertices referenced by the index buffer</param>
+	/// <param name="cacheSize">The size of the cache to simulate</param>
+	static MeshCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, int cacheSize);
+
+	/// <summary>
+	/// Reorders the triangles in an index buffer to improve vertex cache locality using the Tipsify algorithm
+	/// (Sander, Nehab and Barczak, 2007)
+	/// </summary>
+	/// <param name="indices">The indices to re-order, will be modified in place</param>
+	/// <param name="indexCount">The number of indices, should be a multiple of 3</param>
+	/// <param name="vertexCount">The number of vertices referenced by the index buffer</param>
+	/// <param name="cacheSize">The size of the cache to optimize for</param>
+	/// <param name="clusters">If non-null, will be filled with the index offsets where the cache was flushed, for use by OptimizeOverdraw</param>
+	static void OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount, int cacheSize, std::vector<size_t>* clusters = nullptr);
+
+	/// <summary>
+	/// Re-orders the clusters generated by OptimizeVertexCache such that clusters that are more likely to occlude
+	/// other parts of the mesh are drawn first. If the resulting ACMR exceeds the original by more than the threshold
+	/// the original order is kept
+	/// </summary>
+	/// <param name="indices">The indices to re-order, will be modified in place</param>
+	/// <param name="indexCount">The number of indices, should be a multiple of 3</param>
+	/// <param name="positions">The positions of the vertices in the mesh</param>
+	/// <param name="clusters">The cluster offsets as generated by OptimizeVertexCache</param>
+	/// <param name="cacheSize">The size of the cache used to validate the new ordering</param>
+	/// <param name="threshold">The maximum allowable ratio between the new and old ACMR</param>
+	static void OptimizeOverdraw(uint32_t* indices, size_t indexCount, const std::vector<glm::vec3>& positions, const std::vector<size_t>& clusters, int cacheSize, float threshold);
+
+	/// <summary>
+	/// Generates a remapping table that orders vertices by when they are first referenced by the index buffer, and
+	/// remaps the indices to match. Vertices that are never referenced will map to UNUSED_VERTEX
+	/// </summary>
+	/// <param name="indices">The indices to remap, will be modified in place</param>
+	/// <param name="indexCount">The number of indices</param>
+	/// <param name="vertexCount">The number of vertices referenced by the index buffer</param>
+	/// <param name="outVertexCount">Will be set to the number of vertices that are referenced by the mesh</param>
+	/// <returns>A table mapping old vertex indices to new vertex indices</returns>
+	static std::vector<uint32_t> OptimizeVertexFetch(uint32_t* indices, size_t indexCount, size_t vertexCount, size_t& outVertexCount);
+
+	static constexpr uint32_t UNUSED_VERTEX = 0xFFFFFFFF;
+
+protected:
+	MeshOptimizer() = default;
+	~MeshOptimizer() = default;
+};
@@ -0,0 +1,172 @@
+#include "Utils/MeshOptimizerTest.h"
+
+#include <array>
+#include <algorithm>
+#include <random>
+#include <cstring>
+#include <GLM/gtc/constants.hpp>
+
+#include "Logging.h"
+#include "Utils/MeshOptimizer.h"
+
+namespace {
+	typedef std::array<uint32_t, 3> Triangle;
+
+	/// <summary>
+	/// Builds a closed unit sphere, with a single vertex at each pole so that there are no seams
+	/// </summary>
+	void MakeSphere(int slices, int stacks, std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices) {
+		const float pi = glm::pi<float>();
+		positions.push_back(glm::vec3(0.0f, 0.0f, 1.0f));
+		for (int iy = 1; iy < stacks; iy++) {
+			const float phi = pi * iy / stacks;
+			for (int ix = 0; ix < slices; ix++) {
+				const float theta = 2.0f * pi * ix / slices;
+				positions.push_back(glm::vec3(glm::sin(phi) * glm::cos(theta), glm::sin(phi) * glm::sin(theta), glm::cos(phi)));
+			}
+		}
+		positions.push_back(glm::vec3(0.0f, 0.0f, -1.0f));
+
+		const uint32_t bottom = static_cast<uint32_t>(positions.size() - 1);
+		auto ring = [slices](int stack, int slice) {
+			return static_cast<uint32_t>(1 + (stack - 1) * slices + (slice % slices));
+		};
+		for (int ix = 0; ix < slices; ix++) {
+			indices.insert(indices.end(), { 0, ring(1, ix), ring(1, ix + 1) });
+			for (int iy = 1; iy < stacks - 1; iy++) {
+				indices.insert(indices.end(), { ring(iy, ix), ring(iy + 1, ix), ring(iy + 1, ix + 1) });
+				indices.insert(indices.end(), { ring(iy, ix), ring(iy + 1, ix + 1), ring(iy, ix + 1) });
+			}
+			indices.insert(indices.end(), { ring(stacks - 1, ix), bottom, ring(stacks - 1, ix + 1) });
+		}
+	}
+
+	/// <summary>
+	/// Builds a flat unit grid on the XY plane
+	/// </summary>
+	void MakeGrid(int size, std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices) {
+		for (int iy = 0; iy <= size; iy++) {
+			for (int ix = 0; ix <= size; ix++) {
+				positions.push_back(glm::vec3(ix / (float)size, iy / (float)size, 0.0f));
+			}
+		}
+		for (int iy = 0; iy < size; iy++) {
+			for (int ix = 0; ix < size; ix++) {
+				const uint32_t a = static_cast<uint32_t>(iy * (size + 1) + ix);
+				const uint32_t b = a + 1;
+				const uint32_t c = a + size + 1;
+				const uint32_t d = c + 1;
+				indices.insert(indices.end(), { a, b, d });
+				indices.insert(indices.end(), { a, d, c });
+			}
+		}
+	}
+
+	/// <summary>
+	/// Shuffles the order of the triangles in an index buffer, so that the optimizer has something to fix
+	/// </summary>
+	void ShuffleTriangles(std::vector<uint32_t>& indices, uint32_t seed) {
+		std::vector<Triangle> triangles(indices.size() / 3);
+		memcpy(triangles.data(), indices.data(), triangles.size() * sizeof(Triangle));
+		std::shuffle(triangles.begin(), triangles.end(), std::mt19937(seed));
+		memcpy(indices.data(), triangles.data(), triangles.size() * sizeof(Triangle));
+	}
+
+	/// <summary>
+	/// Gets the triangles of an index buffer in sorted order, each triangle keeps it's winding
+	/// </summary>
+	std::vector<Triangle> SortedTriangles(const std::vector<uint32_t>& indices) {
+		std::vector<Triangle> result(indices.size() / 3);
+		memcpy(result.data(), indices.data(), result.size() * sizeof(Triangle));
+		std::sort(result.begin(), result.end());
+		return result;
+	}
+}
+
+std::vector<MeshOptimizerTestResult> MeshOptimizerTest::Run(const MeshOptimizerTestSettings& settings) {
+	std::vector<MeshOptimizerTestResult> results;
+
+	std::vector<glm::vec3> positions;
+	std::vector<uint32_t>  indices;
+	MakeSphere(settings.SphereSlices, settings.SphereStacks, positions, indices);
+	ShuffleTriangles(indices, settings.Seed);
+	results.push_back(_RunCase("Sphere", positions, indices, settings));
+
+	positions.clear();
+	indices.clear();
+	MakeGrid(settings.GridSize, positions, indices);
+	ShuffleTriangles(indices, settings.Seed);
+	results.push_back(_RunCase("Grid", positions, indices, settings));
+
+	return results;
+}
+
+void MeshOptimizerTest::LogResults(const std::vector<MeshOptimizerTestResult>& results) {
+	LOG_INFO("Mesh optimizer test results:");
+	LOG_INFO("  {:>8} {:>8} {:>8} {:>8} {:>8} {:>10}", "Mesh", "Tris", "Source", "Cache", "Final", "Result");
+	int failures = 0;
+	for (const MeshOptimizerTestResult& result : results) {
+		LOG_INFO("  {:>8} {:>8} {:>8.4f} {:>8.4f} {:>8.4f} {:>10}", result.Name, result.Triangles, result.SourceACMR, result.CacheACMR,
+				 result.FinalACMR, result.Passed() ? "ok" : "FAILED");
+		if (!result.Passed()) {
+			failures++;
+			if (!result.ValidPermutation) {
+				LOG_WARN("  {} lost, duplicated or re-wound triangles while optimizing", result.Name);
+			}
+			if (!result.NoWorseACMR) {
+				LOG_WARN("  {} has a worse ACMR after optimizing", result.Name);
+			}
+			if (!result.ValidRemap) {
+				LOG_WARN("  {} got an invalid vertex fetch remap", result.Name);
+			}
+		}
+	}
+	if (failures > 0) {
+		LOG_WARN("{} mesh(es) failed the optimizer test", failures);
+	}
+}
+
+MeshOptimizerTestResult MeshOptimizerTest::_RunCase(const std::string& name, const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const MeshOptimizerTestSettings& settings) {
+	const std::vector<Triangle> sourceTriangles = SortedTriangles(indices);
+
+	MeshOptimizerTestResult result;
+	result.Name       = name;
+	result.Triangles  = indices.size() / 3;
+	result.SourceACMR = MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), positions.size(), settings.CacheSize).ACMR;
+
+	// Run the passes in the same order that MeshBuilder does
+	std::vector<uint32_t> optimized = indices;
+	std::vector<size_t> clusters;
+	MeshOptimizer::OptimizeVertexCache(optimized.data(), optimized.size(), positions.size(), settings.CacheSize, &clusters);
+	result.CacheACMR = MeshOptimizer::AnalyzeVertexCache(optimized.data(), optimized.size(), positions.size(), settings.CacheSize).ACMR;
+	result.ValidPermutation = SortedTriangles(optimized) == sourceTriangles;
+
+	MeshOptimizer::OptimizeOverdraw(optimized.data(), optimized.size(), positions, clusters, settings.CacheSize, settings.OverdrawThreshold);
+	result.FinalACMR = MeshOptimizer::AnalyzeVertexCache(optimized.data(), optimized.size(), positions.size(), settings.CacheSize).ACMR;
+	result.ValidPermutation &= SortedTriangles(optimized) == sourceTriangles;
+	result.NoWorseACMR = result.CacheACMR <= result.SourceACMR && result.FinalACMR <= result.SourceACMR;
+
+	// Every referenced vertex should get a unique slot below the new vertex count, and the first use of each slot
+	// in the remapped index buffer should come in increasing order
+	std::vector<uint32_t> remapped = optimized;
+	size_t vertexCount = 0;
+	std::vector<uint32_t> remap = MeshOptimizer::OptimizeVertexFetch(remapped.data(), remapped.size(), positions.size(), vertexCount);
+	result.ValidRemap = remap.size() == positions.size() && vertexCount <= positions.size();
+	std::vector<bool> slotUsed(vertexCount, false);
+	for (size_t ix = 0; ix < remap.size() && result.ValidRemap; ix++) {
+		if (remap[ix] != MeshOptimizer::UNUSED_VERTEX) {
+			result.ValidRemap = remap[ix] < vertexCount && !slotUsed[remap[ix]];
+			slotUsed[remap[ix]] = result.ValidRemap;
+		}
+	}
+	uint32_t nextVertex = 0;
+	for (size_t ix = 0; ix < remapped.size() && result.ValidRemap; ix++) {
+		result.ValidRemap = remapped[ix] == remap[optimized[ix]] && remapped[ix] <= nextVertex;
+		if (remapped[ix] == nextVertex) {
+			nextVertex++;
+		}
+	}
+	result.ValidRemap &= nextVertex == vertexCount;
+
+	return result;
+}
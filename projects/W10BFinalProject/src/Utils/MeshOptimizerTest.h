@@ -0,0 +1,81 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <GLM/glm.hpp>
+
+/// <summary>
+/// Configures the meshes and cache parameters used by the mesh optimizer test
+/// </summary>
+struct MeshOptimizerTestSettings {
+	/// <summary>
+	/// The number of segments around the test sphere
+	/// </summary>
+	int      SphereSlices      = 32;
+	/// <summary>
+	/// The number of rings from pole to pole on the test sphere
+	/// </summary>
+	int      SphereStacks      = 16;
+	/// <summary>
+	/// The number of quads along each side of the flat test grid
+	/// </summary>
+	int      GridSize          = 32;
+	/// <summary>
+	/// The size of the simulated post-transform cache, in vertices
+	/// </summary>
+	int      CacheSize         = 16;
+	/// <summary>
+	/// The ACMR ratio passed to the overdraw pass
+	/// </summary>
+	float    OverdrawThreshold = 1.05f;
+	/// <summary>
+	/// The seed used to shuffle the triangles of the test meshes before they are optimized
+	/// </summary>
+	uint32_t Seed              = 1234;
+};
+
+/// <summary>
+/// The result of optimizing a single test mesh
+/// </summary>
+struct MeshOptimizerTestResult {
+	std::string Name;
+	size_t      Triangles;
+	float       SourceACMR;
+	float       CacheACMR;
+	float       FinalACMR;
+	// True if every pass output the same set of triangles (with the same winding) as the input
+	bool        ValidPermutation;
+	// True if the final ACMR is no worse than the ACMR of the input
+	bool        NoWorseACMR;
+	// True if the vertex fetch remap is a bijection onto the referenced vertices, in first-use order
+	bool        ValidRemap;
+
+	bool Passed() const { return ValidPermutation && NoWorseACMR && ValidRemap; }
+};
+
+/// <summary>
+/// A headless test that runs the vertex cache, overdraw and vertex fetch passes over a set of known meshes, and
+/// checks that each pass only re-orders the triangles and that the cache efficiency doesn't regress. Useful for
+/// checking that changes to the optimizer haven't broken meshes that opt in to the optimization pass
+/// </summary>
+class MeshOptimizerTest {
+public:
+	/// <summary>
+	/// Optimizes each of the test meshes with the given settings
+	/// </summary>
+	/// <param name="settings">The settings for the test</param>
+	/// <returns>The results for each test mesh</returns>
+	static std::vector<MeshOptimizerTestResult> Run(const MeshOptimizerTestSettings& settings = MeshOptimizerTestSettings());
+
+	/// <summary>
+	/// Writes a table of results to the log, and warns if any of the meshes failed
+	/// </summary>
+	/// <param name="results">The results to log</param>
+	static void LogResults(const std::vector<MeshOptimizerTestResult>& results);
+
+protected:
+	MeshOptimizerTest() = default;
+	~MeshOptimizerTest() = default;
+
+	static MeshOptimizerTestResult _RunCase(const std::string& name, const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const MeshOptimizerTestSettings& settings);
+};
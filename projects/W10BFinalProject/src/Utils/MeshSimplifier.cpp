@@ -0,0 +1,253 @@
+#include "Utils/MeshSimplifier.h"
+
+#include <algorithm>
+#include <tuple>
+
+#include "Logging.h"
+#include "Utils/JsonGlmHelpers.h"
+
+MeshLodSettings MeshLodSettings::FromJson(const nlohmann::json& blob) {
+	MeshLodSettings result;
+	result.LevelCount      = JsonGet(blob, "levels", result.LevelCount);
+	result.Reduction       = JsonGet(blob, "reduction", result.Reduction);
+	result.MaxError        = JsonGet(blob, "max_error", result.MaxError);
+	result.ScreenSizeStart = JsonGet(blob, "screen_size", result.ScreenSizeStart);
+	return result;
+}
+
+nlohmann::json MeshLodSettings::ToJson() const {
+	return {
+		{ "levels",      LevelCount },
+		{ "reduction",   Reduction },
+		{ "max_error",   MaxError },
+		{ "screen_size", ScreenSizeStart }
+	};
+}
+
+namespace {
+	/// <summary>
+	/// Stores the symmetric 4x4 matrix for the sum of squared distances to a set of planes
+	/// </summary>
+	struct Quadric {
+		double a2 = 0, ab = 0, ac = 0, ad = 0;
+		double b2 = 0, bc = 0, bd = 0;
+		double c2 = 0, cd = 0;
+		double d2 = 0;
+		// The total weight of all the planes, so that the error is the average squared distance
+		double w  = 0;
+
+		static Quadric FromPlane(const glm::dvec3& n, double d, double weight) {
+			Quadric result;
+			result.a2 = n.x * n.x * weight; result.ab = n.x * n.y * weight; result.ac = n.x * n.z * weight; result.ad = n.x * d * weight;
+			result.b2 = n.y * n.y * weight; result.bc = n.y * n.z * weight; result.bd = n.y * d * weight;
+			result.c2 = n.z * n.z * weight; result.cd = n.z * d * weight;
+			result.d2 = d * d * weight;
+			result.w  = weight;
+			return result;
+		}
+
+		Quadric& operator +=(const Quadric& other) {
+			a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+			b2 += other.b2; bc += other.bc; bd += other.bd;
+			c2 += other.c2; cd += other.cd;
+			d2 += other.d2;
+			w  += other.w;
+			return *this;
+		}
+
+		double Evaluate(const glm::dvec3& p) const {
+			double error =
+				a2 * p.x * p.x + 2.0 * ab * p.x * p.y + 2.0 * ac * p.x * p.z + 2.0 * ad * p.x +
+				b2 * p.y * p.y + 2.0 * bc * p.y * p.z + 2.0 * bd * p.y +
+				c2 * p.z * p.z + 2.0 * cd * p.z +
+				d2;
+			return w > 0.0 ? glm::abs(error) / w : 0.0;
+		}
+	};
+
+	struct Collapse {
+		double   Cost;
+		uint32_t From;
+		uint32_t To;
+
+		bool operator <(const Collapse& other) const {
+			return std::tie(Cost, From, To) < std::tie(other.Cost, other.From, other.To);
+		}
+		bool operator ==(const Collapse& other) const {
+			return From == other.From && To == other.To;
+		}
+	};
+}
+
+std::vector<uint32_t> MeshSimplifier::Simplify(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, size_t targetIndexCount, float targetError, float* resultError) {
+	std::vector<uint32_t> result(indices.begin(), indices.begin() + (indices.size() / 3) * 3);
+	size_t vertexCount = positions.size();
+	double errorLimit = (double)targetError * (double)targetError;
+	double maxError = 0.0;
+
+	// Accumulate the area weighted plane quadrics for every vertex
+	std::vector<Quadric> quadrics(vertexCount);
+	for (size_t ix = 0; ix < result.size(); ix += 3) {
+		glm::dvec3 a = positions[result[ix]];
+		glm::dvec3 b = positions[result[ix + 1]];
+		glm::dvec3 c = positions[result[ix + 2]];
+		glm::dvec3 normal = glm::cross(b - a, c - a);
+		double area = glm::length(normal);
+		if (area <= 0.0) {
+			continue;
+		}
+		normal /= area;
+		Quadric q = Quadric::FromPlane(normal, -glm::dot(normal, a), area);
+		quadrics[result[ix]] += q;
+		quadrics[result[ix + 1]] += q;
+		quadrics[result[ix + 2]] += q;
+	}
+
+	// Vertices on an edge that is only used by a single triangle are on either an open border or an
+	// attribute seam (where the OBJ loader has split a vertex), moving them would tear the mesh open
+	std::vector<bool> locked(vertexCount, false);
+	{
+		std::vector<std::pair<uint32_t, uint32_t>> edges;
+		edges.reserve(result.size());
+		for (size_t ix = 0; ix < result.size(); ix += 3) {
+			for (int ie = 0; ie < 3; ie++) {
+				uint32_t a = result[ix + ie];
+				uint32_t b = result[ix + (ie + 1) % 3];
+				edges.push_back(std::make_pair(std::min(a, b), std::max(a, b)));
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+		for (size_t ix = 0; ix < edges.size();) {
+			size_t end = ix + 1;
+			while (end < edges.size() && edges[end] == edges[ix]) {
+				end++;
+			}
+			if (end - ix == 1) {
+				locked[edges[ix].first] = true;
+				locked[edges[ix].second] = true;
+			}
+			ix = end;
+		}
+	}
+
+	std::vector<uint32_t> remap(vertexCount);
+	std::vector<bool>     touched(vertexCount);
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1);
+	std::vector<uint32_t> adjacency;
+	std::vector<Collapse> collapses;
+
+	// Each pass collapses as many independent edges as it can, then rebuilds the index buffer
+	while (result.size() > targetIndexCount) {
+		size_t triCount = result.size() / 3;
+
+		// Build the vertex -> triangle adjacency for this pass
+		std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+		for (uint32_t index : result) {
+			adjacencyOffsets[index + 1]++;
+		}
+		for (size_t ix = 0; ix < vertexCount; ix++) {
+			adjacencyOffsets[ix + 1] += adjacencyOffsets[ix];
+		}
+		adjacency.resize(result.size());
+		std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t ix = 0; ix < result.size(); ix++) {
+			adjacency[fill[result[ix]]++] = static_cast<uint32_t>(ix / 3);
+		}
+
+		// Gather every possible collapse along the mesh edges
+		collapses.clear();
+		for (size_t ix = 0; ix < result.size(); ix += 3) {
+			for (int ie = 0; ie < 3; ie++) {
+				uint32_t a = result[ix + ie];
+				uint32_t b = result[ix + (ie + 1) % 3];
+				Quadric q = quadrics[a];
+				q += quadrics[b];
+				if (!locked[a]) {
+					collapses.push_back({ q.Evaluate(positions[b]), a, b });
+				}
+				if (!locked[b]) {
+					collapses.push_back({ q.Evaluate(positions[a]), b, a });
+				}
+			}
+		}
+		std::sort(collapses.begin(), collapses.end());
+		collapses.erase(std::unique(collapses.begin(), collapses.end()), collapses.end());
+
+		for (size_t ix = 0; ix < vertexCount; ix++) {
+			remap[ix] = static_cast<uint32_t>(ix);
+		}
+		std::fill(touched.begin(), touched.end(), false);
+
+		size_t trianglesToRemove = (result.size() - targetIndexCount) / 3;
+		size_t removed = 0;
+		size_t collapsed = 0;
+
+		for (const Collapse& collapse : collapses) {
+			if (collapse.Cost > errorLimit || removed >= std::max<size_t>(trianglesToRemove, 1)) {
+				break;
+			}
+			if (touched[collapse.From] || touched[collapse.To]) {
+				continue;
+			}
+
+			// Make sure moving the vertex won't flip any of the triangles that remain around it
+			bool valid = true;
+			size_t sharedTriangles = 0;
+			glm::dvec3 target = positions[collapse.To];
+			for (uint32_t it = adjacencyOffsets[collapse.From]; it < adjacencyOffsets[collapse.From + 1] && valid; it++) {
+				const uint32_t* tri = &result[adjacency[it] * 3];
+				if (tri[0] == collapse.To || tri[1] == collapse.To || tri[2] == collapse.To) {
+					sharedTriangles++;
+					continue;
+				}
+				glm::dvec3 before[3], after[3];
+				for (int iv = 0; iv < 3; iv++) {
+					before[iv] = positions[tri[iv]];
+					after[iv] = tri[iv] == collapse.From ? target : before[iv];
+				}
+				glm::dvec3 n0 = glm::cross(before[1] - before[0], before[2] - before[0]);
+				glm::dvec3 n1 = glm::cross(after[1] - after[0], after[2] - after[0]);
+				valid = glm::dot(n0, n1) > 0.0;
+			}
+			if (!valid || sharedTriangles == 0) {
+				continue;
+			}
+
+			// Perform the collapse, and lock down the neighbourhood for the rest of this pass since
+			// our adjacency info is now stale for those vertices
+			remap[collapse.From] = collapse.To;
+			quadrics[collapse.To] += quadrics[collapse.From];
+			for (uint32_t it = adjacencyOffsets[collapse.From]; it < adjacencyOffsets[collapse.From + 1]; it++) {
+				const uint32_t* tri = &result[adjacency[it] * 3];
+				touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = true;
+			}
+			removed += sharedTriangles;
+			collapsed++;
+			maxError = std::max(maxError, collapse.Cost);
+		}
+
+		// Nothing could be collapsed within our error bounds, this is as simple as this mesh gets
+		if (collapsed == 0) {
+			break;
+		}
+
+		// Rebuild the index buffer, dropping any triangles that became degenerate
+		size_t write = 0;
+		for (size_t ix = 0; ix < triCount * 3; ix += 3) {
+			uint32_t a = remap[result[ix]];
+			uint32_t b = remap[result[ix + 1]];
+			uint32_t c = remap[result[ix + 2]];
+			if (a != b && b != c && a != c) {
+				result[write++] = a;
+				result[write++] = b;
+				result[write++] = c;
+			}
+		}
+		result.resize(write);
+	}
+
+	if (resultError != nullptr) {
+		*resultError = static_cast<float>(glm::sqrt(maxError));
+	}
+	return result;
+}
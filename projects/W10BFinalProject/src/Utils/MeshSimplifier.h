@@ -0,0 +1,57 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <GLM/glm.hpp>
+#include "json.hpp"
+
+/// <summary>
+/// Configures how a level of detail chain is generated for a mesh
+/// </summary>
+struct MeshLodSettings {
+	/// <summary>
+	/// The number of LOD levels to generate in addition to the full detail mesh, 0 to disable
+	/// </summary>
+	int   LevelCount      = 0;
+	/// <summary>
+	/// The ratio of triangles to keep from one level to the next
+	/// </summary>
+	float Reduction       = 0.5f;
+	/// <summary>
+	/// The maximum error allowed when simplifying, relative to the radius of the mesh's bounding sphere
+	/// </summary>
+	float MaxError        = 0.05f;
+	/// <summary>
+	/// The projected screen size (as a fraction of the screen height) below which LOD 1 is used, each
+	/// level after that switches at half the size of the previous
+	/// </summary>
+	float ScreenSizeStart = 0.5f;
+
+	static MeshLodSettings FromJson(const nlohmann::json& blob);
+	nlohmann::json ToJson() const;
+};
+
+/// <summary>
+/// Simplifies indexed triangle meshes via quadric error metric edge collapses (Garland and Heckbert, 1997)
+///
+/// Collapses are always onto existing vertices, so the simplified index buffers can share the original
+/// vertex buffer. Vertices on open borders and attribute seams are locked in place to avoid cracks.
+/// Collapses are ordered by error with ties broken by vertex index, so results are deterministic
+/// </summary>
+class MeshSimplifier
+{
+public:
+	/// <summary>
+	/// Reduces the number of triangles in the given index buffer
+	/// </summary>
+	/// <param name="positions">The positions of the vertices in the mesh</param>
+	/// <param name="indices">The indices of the triangle list to simplify</param>
+	/// <param name="targetIndexCount">The number of indices to try and reduce the mesh to</param>
+	/// <param name="targetError">The maximum distance a collapse may move the surface, in object space units</param>
+	/// <param name="resultError">If non-null, will receive the largest error of any collapse that was performed</param>
+	/// <returns>The simplified index buffer, referencing the same vertices</returns>
+	static std::vector<uint32_t> Simplify(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, size_t targetIndexCount, float targetError, float* resultError = nullptr);
+
+protected:
+	MeshSimplifier() = default;
+	~MeshSimplifier() = default;
+};
@@ -0,0 +1,120 @@
+#include "Utils/MeshSimplifierTest.h"
+
+#include <GLM/gtc/constants.hpp>
+
+#include "Logging.h"
+#include "Utils/MeshSimplifier.h"
+
+namespace {
+	/// <summary>
+	/// Builds a closed unit sphere, with a single vertex at each pole so that there are no seams
+	/// </summary>
+	void MakeSphere(int slices, int stacks, std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices) {
+		const float pi = glm::pi<float>();
+		positions.push_back(glm::vec3(0.0f, 0.0f, 1.0f));
+		for (int iy = 1; iy < stacks; iy++) {
+			const float phi = pi * iy / stacks;
+			for (int ix = 0; ix < slices; ix++) {
+				const float theta = 2.0f * pi * ix / slices;
+				positions.push_back(glm::vec3(glm::sin(phi) * glm::cos(theta), glm::sin(phi) * glm::sin(theta), glm::cos(phi)));
+			}
+		}
+		positions.push_back(glm::vec3(0.0f, 0.0f, -1.0f));
+
+		const uint32_t bottom = static_cast<uint32_t>(positions.size() - 1);
+		auto ring = [slices](int stack, int slice) {
+			return static_cast<uint32_t>(1 + (stack - 1) * slices + (slice % slices));
+		};
+		for (int ix = 0; ix < slices; ix++) {
+			indices.insert(indices.end(), { 0, ring(1, ix), ring(1, ix + 1) });
+			for (int iy = 1; iy < stacks - 1; iy++) {
+				indices.insert(indices.end(), { ring(iy, ix), ring(iy + 1, ix), ring(iy + 1, ix + 1) });
+				indices.insert(indices.end(), { ring(iy, ix), ring(iy + 1, ix + 1), ring(iy, ix + 1) });
+			}
+			indices.insert(indices.end(), { ring(stacks - 1, ix), bottom, ring(stacks - 1, ix + 1) });
+		}
+	}
+
+	/// <summary>
+	/// Builds a flat unit grid on the XY plane, all of the interior vertices can be removed for free
+	/// </summary>
+	void MakeGrid(int size, std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices) {
+		for (int iy = 0; iy <= size; iy++) {
+			for (int ix = 0; ix <= size; ix++) {
+				positions.push_back(glm::vec3(ix / (float)size, iy / (float)size, 0.0f));
+			}
+		}
+		for (int iy = 0; iy < size; iy++) {
+			for (int ix = 0; ix < size; ix++) {
+				const uint32_t a = static_cast<uint32_t>(iy * (size + 1) + ix);
+				const uint32_t b = a + 1;
+				const uint32_t c = a + size + 1;
+				const uint32_t d = c + 1;
+				indices.insert(indices.end(), { a, b, d });
+				indices.insert(indices.end(), { a, d, c });
+			}
+		}
+	}
+}
+
+std::vector<MeshSimplifierTestResult> MeshSimplifierTest::Run(const MeshSimplifierTestSettings& settings) {
+	std::vector<MeshSimplifierTestResult> results;
+
+	std::vector<glm::vec3> positions;
+	std::vector<uint32_t>  indices;
+	MakeSphere(settings.SphereSlices, settings.SphereStacks, positions, indices);
+	results.push_back(_RunCase("Sphere", positions, indices, settings, 1.0f));
+
+	positions.clear();
+	indices.clear();
+	MakeGrid(settings.GridSize, positions, indices);
+	results.push_back(_RunCase("Grid", positions, indices, settings, 1.0f));
+
+	return results;
+}
+
+void MeshSimplifierTest::LogResults(const std::vector<MeshSimplifierTestResult>& results) {
+	LOG_INFO("Mesh simplifier test results:");
+	LOG_INFO("  {:>8} {:>8} {:>8} {:>8} {:>8} {:>8} {:>10}", "Mesh", "Source", "Target", "Result", "Error", "Limit", "Result");
+	int failures = 0;
+	for (const MeshSimplifierTestResult& result : results) {
+		LOG_INFO("  {:>8} {:>8} {:>8} {:>8} {:>8.4f} {:>8.4f} {:>10}", result.Name, result.SourceTriangles, result.TargetTriangles, result.ResultTriangles,
+				 result.ResultError, result.TargetError, result.Passed() ? "ok" : "FAILED");
+		if (!result.Passed()) {
+			failures++;
+			if (!result.Deterministic) {
+				LOG_WARN("  {} gave different results when simplified twice", result.Name);
+			}
+			if (!result.ReachedTarget) {
+				LOG_WARN("  {} did not reach the target triangle count", result.Name);
+			}
+			if (!result.WithinError) {
+				LOG_WARN("  {} exceeded the error limit", result.Name);
+			}
+		}
+	}
+	if (failures > 0) {
+		LOG_WARN("{} mesh(es) failed the simplifier test", failures);
+	}
+}
+
+MeshSimplifierTestResult MeshSimplifierTest::_RunCase(const std::string& name, const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const MeshSimplifierTestSettings& settings, float size) {
+	const size_t targetIndexCount = static_cast<size_t>(indices.size() / 3 * settings.Reduction) * 3;
+	const float targetError = settings.MaxError * size;
+
+	float firstError = 0.0f, secondError = 0.0f;
+	std::vector<uint32_t> first  = MeshSimplifier::Simplify(positions, indices, targetIndexCount, targetError, &firstError);
+	std::vector<uint32_t> second = MeshSimplifier::Simplify(positions, indices, targetIndexCount, targetError, &secondError);
+
+	MeshSimplifierTestResult result;
+	result.Name            = name;
+	result.SourceTriangles = indices.size() / 3;
+	result.TargetTriangles = targetIndexCount / 3;
+	result.ResultTriangles = first.size() / 3;
+	result.TargetError     = targetError;
+	result.ResultError     = firstError;
+	result.Deterministic   = first == second && firstError == secondError;
+	result.ReachedTarget   = first.size() <= targetIndexCount;
+	result.WithinError     = firstError <= targetError;
+	return result;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <GLM/glm.hpp>
+
+/// <summary>
+/// Configures the meshes and targets used by the mesh simplifier test
+/// </summary>
+struct MeshSimplifierTestSettings {
+	/// <summary>
+	/// The number of segments around the test sphere
+	/// </summary>
+	int   SphereSlices = 32;
+	/// <summary>
+	/// The number of rings from pole to pole on the test sphere
+	/// </summary>
+	int   SphereStacks = 16;
+	/// <summary>
+	/// The number of quads along each side of the flat test grid
+	/// </summary>
+	int   GridSize     = 16;
+	/// <summary>
+	/// The ratio of triangles that each mesh should be reduced to
+	/// </summary>
+	float Reduction    = 0.25f;
+	/// <summary>
+	/// The maximum error allowed when simplifying, relative to the size of the mesh
+	/// </summary>
+	float MaxError     = 0.1f;
+};
+
+/// <summary>
+/// The result of simplifying a single test mesh
+/// </summary>
+struct MeshSimplifierTestResult {
+	std::string Name;
+	size_t      SourceTriangles;
+	size_t      TargetTriangles;
+	size_t      ResultTriangles;
+	float       TargetError;
+	float       ResultError;
+	// True if simplifying the mesh a second time gave the exact same index buffer
+	bool        Deterministic;
+	// True if the result has no more triangles than the target
+	bool        ReachedTarget;
+	// True if the error of the result is within the target error
+	bool        WithinError;
+
+	bool Passed() const { return Deterministic && ReachedTarget && WithinError; }
+};
+
+/// <summary>
+/// A headless test that simplifies a set of known meshes twice, and checks that both runs give identical
+/// index buffers, and that the results land within the triangle and error targets. Useful for checking
+/// that changes to the simplifier haven't broken the LOD chains that get baked into the mesh cache
+/// </summary>
+class MeshSimplifierTest {
+public:
+	/// <summary>
+	/// Simplifies each of the test meshes with the given settings
+	/// </summary>
+	/// <param name="settings">The settings for the test</param>
+	/// <returns>The results for each test mesh</returns>
+	static std::vector<MeshSimplifierTestResult> Run(const MeshSimplifierTestSettings& settings = MeshSimplifierTestSettings());
+
+	/// <summary>
+	/// Writes a table of results to the log, and warns if any of the meshes failed
+	/// </summary>
+	/// <param name="results">The results to log</param>
+	static void LogResults(const std::vector<MeshSimplifierTestResult>& results);
+
+protected:
+	MeshSimplifierTest() = default;
+	~MeshSimplifierTest() = default;
+
+	static MeshSimplifierTestResult _RunCase(const std::string& name, const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, const MeshSimplifierTestSettings& settings, float size);
+};
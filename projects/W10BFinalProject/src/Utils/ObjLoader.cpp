@@ -6,14 +6,42 @@
 #include <iostream>
 #include <GLFW/glfw3.h>
 #include <filesystem>
+#include <unordered_map>
 
 #include "Utils/StringUtils.h"
 
-VertexArrayObject::Sptr ObjLoader::LoadFromFile(const std::string& filename)
+namespace {
+	/// <summary>
+	/// Hashes a (position, uv, normal) index tuple by packing 21 bits of each index into a single 64 bit key. Indices
+	/// past 2^21 only make the hash collide, the map still compares the full tuple so vertices are never merged by mistake
+	/// </summary>
+	struct VertexKeyHash {
+		size_t operator()(const glm::ivec3& attribs) const {
+			uint64_t key =
+				((uint64_t)(attribs.x & 0x1FFFFF) << 42) |
+				((uint64_t)(attribs.y & 0x1FFFFF) << 21) |
+				((uint64_t)(attribs.z & 0x1FFFFF));
+			return std::hash<uint64_t>()(key);
+		}
+	};
+}
+
+VertexArrayObject::Sptr ObjLoader::LoadFromFile(const std::string& filename, const MeshOptimizationSettings& optimization, VertexFormat format)
+{
+	MeshBuilder<VertexPosNormTexCol> mesh;
+	if (!LoadMeshData(filename, mesh)) {
+		return nullptr;
+	}
+
+	// Upload our vertices and indices to the GPU
+	return mesh.Bake(optimization, format);
+}
+
+bool ObjLoader::LoadMeshData(const std::string& filename, MeshBuilder<VertexPosNormTexCol>& mesh)
 {
 	if (!std::filesystem::exists(filename)) {
 		LOG_WARN("Failed to find OBJ file: \"{}\"", filename);
-		return nullptr;
+		return false;
 	}
 
 	// Open our file in binary mode
@@ -33,6 +61,9 @@ VertexArrayObject::Sptr ObjLoader::LoadFromFile(const std::string& filename)
 	std::vector<glm::vec2> uvs;
 	std::vector<glm::ivec3> vertices;
 
+	// Maps a (position, uv, normal) index tuple to the vertex we've already emitted for it
+	std::unordered_map<glm::ivec3, uint32_t, VertexKeyHash> vertexMap;
+
 	glm::vec3 vecData;
 	glm::ivec3 vertexIndices;
 
@@ -92,45 +123,43 @@ VertexArrayObject::Sptr ObjLoader::LoadFromFile(const std::string& filename)
 				// OBJ format uses 1-based indices
 				vertexIndices -= glm::ivec3(1);
 
-				// add the vertex indices to the list
-				// NOTE: This will create duplicate vertices!
-				// A smarter solution would create a map of what attribute
-				// combos have already been added
+				// add the vertex indices to the list, we'll resolve them to unique vertices once the file is read
 				vertices.push_back(vertexIndices);
 			}
 		}
 	}
 
-	// TODO: Generate mesh from the data we loaded
-	std::vector<VertexPosNormTexCol> vertexData;
+	// Each unique attribute combination becomes a single vertex, every face corner becomes an index
+	vertexMap.reserve(vertices.size());
+	size_t startVertices = mesh.GetVertexCount();
+	size_t startIndices  = mesh.GetIndexCount();
+	mesh.ReserveIndexSpace(vertices.size());
 
 	for (int ix = 0; ix < vertices.size(); ix++) {
 		glm::ivec3 attribs = vertices[ix];
 
+		// If we've seen this combination before, we can just re-use that vertex
+		auto it = vertexMap.find(attribs);
+		if (it != vertexMap.end()) {
+			mesh.AddIndex(it->second);
+			continue;
+		}
+
 		// Extract attributes from lists (except color)
 		glm::vec3 position = positions[attribs.x];
 		glm::vec2 uv       = uvs[attribs.y];
 		glm::vec3 normal   = normals[attribs.z];
 		glm::vec4 color    = glm::vec4(1.0f);
 
-		// Add the vertex to the mesh
-		vertexData.push_back(VertexPosNormTexCol(position, normal, uv, color));
+		// Add the vertex to the mesh and remember it's index for any other corners that share it
+		uint32_t index = mesh.AddVertex(position, normal, uv, color);
+		vertexMap[attribs] = index;
+		mesh.AddIndex(index);
 	}
 
-	// Create a vertex buffer and load all our vertex data
-	VertexBuffer::Sptr vertexBuffer = VertexBuffer::Create();
-	vertexBuffer->LoadData(vertexData.data(), vertexData.size());
-
-	// Create the VAO, and add the vertices
-	VertexArrayObject::Sptr result = VertexArrayObject::Create();
-	result->AddVertexBuffer(vertexBuffer, VertexPosNormTexCol::V_DECL);
-
-	result->SetVDecl(VertexPosNormTexCol::V_DECL);
-	
 	// Calculate and trace out how long it took us to load
 	float endTime = glfwGetTime();
-	LOG_TRACE("Loaded OBJ file \"{}\" in {} seconds ({} vertices, {} indices)", filename, endTime - startTime, vertexData.size(), 0);
+	LOG_TRACE("Loaded OBJ file \"{}\" in {} seconds ({} vertices, {} indices)", filename, endTime - startTime, mesh.GetVertexCount() - startVertices, mesh.GetIndexCount() - startIndices);
 
-	return result;
-	//return VertexArrayObject::Create();
+	return true;
 }
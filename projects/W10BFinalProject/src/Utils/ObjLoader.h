@@ -6,7 +6,21 @@
 class ObjLoader
 {
 public:
-	static VertexArrayObject::Sptr LoadFromFile(const std::string& filename);
+	/// <summary>
+	/// Loads an OBJ file into an indexed VAO, optionally running the mesh optimization pass on it
+	/// </summary>
+	/// <param name="filename">The path to the OBJ file to load</param>
+	/// <param name="optimization">The optimization settings to apply before uploading the mesh</param>
+	/// <param name="format">The vertex layout to upload the mesh with</param>
+	static VertexArrayObject::Sptr LoadFromFile(const std::string& filename, const MeshOptimizationSettings& optimization = MeshOptimizationSettings(), VertexFormat format = VertexFormat::Full);
+
+	/// <summary>
+	/// Loads an OBJ file into a mesh builder without uploading it, allowing for further processing
+	/// </summary>
+	/// <param name="filename">The path to the OBJ file to load</param>
+	/// <param name="mesh">The mesh to append the file's vertices and indices to</param>
+	/// <returns>True if the file was loaded, false if otherwise</returns>
+	static bool LoadMeshData(const std::string& filename, MeshBuilder<VertexPosNormTexCol>& mesh);
 
 protected:
 	ObjLoader() = default;
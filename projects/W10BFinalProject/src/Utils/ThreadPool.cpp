@@ -0,0 +1,133 @@
+#include "Utils/ThreadPool.h"
+
+#include <algorithm>
+
+namespace {
+	// The index of the pool thread that we are running on, or 0 if we're not in a pool
+	thread_local int CurrentThreadIndex = 0;
+}
+
+ThreadPool& ThreadPool::Get() {
+	static ThreadPool instance(-1);
+	return instance;
+}
+
+ThreadPool::Sptr ThreadPool::Create(int numWorkers) {
+	return std::make_shared<ThreadPool>(numWorkers);
+}
+
+ThreadPool::ThreadPool(int numWorkers) :
+	_workers(),
+	_jobs(),
+	_mutex(),
+	_jobAdded(),
+	_isShuttingDown(false)
+{
+	if (numWorkers < 0) {
+		numWorkers = std::max(static_cast<int>(std::thread::hardware_concurrency()) - 1, 1);
+	}
+	_workers.reserve(numWorkers);
+	for (int ix = 0; ix < numWorkers; ix++) {
+		_workers.emplace_back(&ThreadPool::_WorkerMain, this, ix + 1);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_isShuttingDown = true;
+	}
+	_jobAdded.notify_all();
+	for (std::thread& worker : _workers) {
+		worker.join();
+	}
+}
+
+int ThreadPool::GetThreadCount() const {
+	return static_cast<int>(_workers.size()) + 1;
+}
+
+int ThreadPool::GetCurrentThreadIndex() {
+	return CurrentThreadIndex;
+}
+
+std::future<void> ThreadPool::Enqueue(std::function<void()> job) {
+	std::shared_ptr<std::packaged_task<void()>> task = std::make_shared<std::packaged_task<void()>>(std::move(job));
+	std::future<void> result = task->get_future();
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_jobs.emplace_back([task]() { (*task)(); });
+	}
+	_jobAdded.notify_one();
+	return result;
+}
+
+void ThreadPool::ParallelFor(int count, int grainSize, const std::function<void(int begin, int end, int threadIndex)>& body) {
+	if (count <= 0) {
+		return;
+	}
+	grainSize = std::max(grainSize, 1);
+
+	// Split the work into roughly one batch per thread, but no smaller than the grain size
+	const int numBatches = std::min((count + grainSize - 1) / grainSize, GetThreadCount());
+	if (numBatches <= 1 || _workers.empty()) {
+		body(0, count, GetCurrentThreadIndex());
+		return;
+	}
+	const int batchSize = (count + numBatches - 1) / numBatches;
+
+	// The state is shared with the helper jobs, which may not start until after we've returned
+	struct LoopState {
+		std::atomic<int>        NextBatch;
+		std::atomic<int>        BatchesDone;
+		std::mutex              Mutex;
+		std::condition_variable Done;
+	};
+	std::shared_ptr<LoopState> state = std::make_shared<LoopState>();
+	state->NextBatch = 0;
+	state->BatchesDone = 0;
+
+	// Grabs batches until there are none left, the body is only touched while there are batches remaining,
+	// so it is safe for late helpers to run after we've returned
+	auto worker = [state, &body, numBatches, batchSize, count]() {
+		int batch;
+		while ((batch = state->NextBatch.fetch_add(1)) < numBatches) {
+			const int begin = batch * batchSize;
+			body(begin, std::min(begin + batchSize, count), GetCurrentThreadIndex());
+			if (state->BatchesDone.fetch_add(1) + 1 == numBatches) {
+				std::unique_lock<std::mutex> lock(state->Mutex);
+				state->Done.notify_all();
+			}
+		}
+	};
+
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		for (int ix = 1; ix < numBatches; ix++) {
+			_jobs.emplace_back(worker);
+		}
+	}
+	_jobAdded.notify_all();
+
+	// Help out on this thread, then wait for any batches still running on the workers
+	worker();
+	std::unique_lock<std::mutex> lock(state->Mutex);
+	state->Done.wait(lock, [&]() { return state->BatchesDone.load() == numBatches; });
+}
+
+void ThreadPool::_WorkerMain(int threadIndex) {
+	CurrentThreadIndex = threadIndex;
+	while (true) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_jobAdded.wait(lock, [this]() { return _isShuttingDown || !_jobs.empty(); });
+			if (_jobs.empty()) {
+				return;
+			}
+			job = std::move(_jobs.front());
+			_jobs.pop_front();
+		}
+		job();
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <atomic>
+#include <memory>
+
+/// <summary>
+/// A fixed set of worker threads that jobs can be pushed to. Each thread in the pool has an index, with
+/// index 0 reserved for threads outside of the pool, so that per-thread scratch data can be stored in
+/// an array of GetThreadCount() items
+/// </summary>
+class ThreadPool {
+public:
+	typedef std::shared_ptr<ThreadPool> Sptr;
+
+	/// <summary>
+	/// Gets the thread pool that is shared by the whole game, with one less worker than the number of
+	/// hardware threads (since the main thread also participates in parallel loops)
+	/// </summary>
+	static ThreadPool& Get();
+
+	/// <summary>
+	/// Creates a new thread pool with the given number of workers
+	/// </summary>
+	/// <param name="numWorkers">The number of worker threads, or -1 to use one less than the number of hardware threads</param>
+	static Sptr Create(int numWorkers = -1);
+
+	ThreadPool(int numWorkers);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool& other) = delete;
+	ThreadPool& operator=(const ThreadPool& other) = delete;
+
+	/// <summary>
+	/// Gets the number of thread indices that may be passed to parallel loops, which is the number of
+	/// workers plus one for the calling thread
+	/// </summary>
+	int GetThreadCount() const;
+
+	/// <summary>
+	/// Gets the index of the thread that is calling this function, 0 for threads outside of any pool
+	/// </summary>
+	static int GetCurrentThreadIndex();
+
+	/// <summary>
+	/// Pushes a job to the pool, to be run on the next available worker
+	/// </summary>
+	/// <param name="job">The job to run</param>
+	/// <returns>A future that will be ready when the job has finished</returns>
+	std::future<void> Enqueue(std::function<void()> job);
+
+	/// <summary>
+	/// Runs a loop over [0, count) split into batches across the workers and the calling thread, and waits
+	/// for all of the batches to finish. The calling thread always works on the loop as well, so this is safe
+	/// to call from within a job
+	/// </summary>
+	/// <param name="count">The number of items to loop over</param>
+	/// <param name="grainSize">The smallest number of items to hand to a thread at once</param>
+	/// <param name="body">The loop body, invoked with the range of items to process, and the index of the thread processing them</param>
+	void ParallelFor(int count, int grainSize, const std::function<void(int begin, int end, int threadIndex)>& body);
+
+protected:
+	std::vector<std::thread>          _workers;
+	std::deque<std::function<void()>> _jobs;
+	std::mutex                        _mutex;
+	std::condition_variable           _jobAdded;
+	bool                              _isShuttingDown;
+
+	void _WorkerMain(int threadIndex);
+};
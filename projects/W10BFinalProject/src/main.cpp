@@ -27,6 +27,9 @@
 #include "Graphics/Texture2D.h"
 #include "Graphics/TextureCube.h"
 #include "Graphics/VertexTypes.h"
+#include "Graphics/StreamingBuffer.h"
+#include "Graphics/GeometryArena.h"
+#include "Graphics/GlState.h"
 
 // Utilities
 #include "Utils/MeshBuilder.h"
@@ -38,11 +41,14 @@
 #include "Utils/JsonGlmHelpers.h"
 #include "Utils/StringUtils.h"
 #include "Utils/GlmDefines.h"
+#include "Utils/MeshSimplifierTest.h"
+#include "Utils/MeshOptimizerTest.h"
 
 // Gameplay
 #include "Gameplay/Material.h"
 #include "Gameplay/GameObject.h"
 #include "Gameplay/Scene.h"
+#include "Gameplay/InstancedRenderer.h"
 
 // Components
 #include "Gameplay/Components/IComponent.h"
@@ -59,6 +65,8 @@
 #include "Gameplay/Physics/Colliders/SphereCollider.h"
 #include "Gameplay/Physics/Colliders/ConvexMeshCollider.h"
 #include "Gameplay/Physics/TriggerVolume.h"
+#include "Gameplay/Physics/TunnelingTest.h"
+#include "Gameplay/Physics/PhysicsBenchmark.h"
 #include "Graphics/DebugDraw.h"
 #include "Gameplay/Components/TriggerVolumeEnterBehaviour.h"
 #include "Gameplay/Components/SimpleCameraControl.h"
@@ -241,7 +249,9 @@ void CreateScene() {
 	bool loadScene = false;
 	// For now we can use a toggle to generate our scene vs load from file
 	if (loadScene) {
+		Shader::BeginCompileBatch();
 		ResourceManager::LoadManifest("manifest.json");
+		Shader::EndCompileBatch();
 		scene = Scene::Load("scene.json");
 
 		// Call scene awake to start up all of our components
@@ -249,24 +259,17 @@ void CreateScene() {
 		scene->Awake();
 	}
 	else {
-		// This time we'll have 2 different shaders, and share data between both of them using the UBO
-		// This shader will handle reflective materials 
-		Shader::Sptr reflectiveShader = ResourceManager::CreateAsset<Shader>(std::unordered_map<ShaderPartType, std::string>{
-			{ ShaderPartType::Vertex, "shaders/vertex_shaders/basic.glsl" },
-			{ ShaderPartType::Fragment, "shaders/fragment_shaders/frag_environment_reflective.glsl" }
-		});
+		// All of our shaders are compiled in a batch, so the driver can work on them at the same time as
+		// each other and our mesh loading. Materials draw with the fallback shader until they're done
+		Shader::BeginCompileBatch();
 
-		// This shader handles our basic materials without reflections (cause they expensive)
+		// This shader handles our basic materials. Reflections, specular maps and cel shading are keywords
+		// that materials can turn on, which compiles a variant of the shader with just those features
 		Shader::Sptr basicShader = ResourceManager::CreateAsset<Shader>(std::unordered_map<ShaderPartType, std::string>{
 			{ ShaderPartType::Vertex, "shaders/vertex_shaders/basic.glsl" },
 			{ ShaderPartType::Fragment, "shaders/fragment_shaders/frag_blinn_phong_textured.glsl" }
 		});
-
-		// This shader handles our basic materials without reflections (cause they expensive)
-		Shader::Sptr specShader = ResourceManager::CreateAsset<Shader>(std::unordered_map<ShaderPartType, std::string>{
-			{ ShaderPartType::Vertex, "shaders/vertex_shaders/basic.glsl" },
-			{ ShaderPartType::Fragment, "shaders/fragment_shaders/textured_specular.glsl" }
-		});
+		basicShader->DeclareKeywords({ "ENVIRONMENT_REFLECTION", "SPECULAR_MAP", "TOON_SHADING", "MAX_LIGHTS=4" });
 
 
 		///////////////////// NEW SHADERS ////////////////////////////////////////////
@@ -277,12 +280,6 @@ void CreateScene() {
 			{ ShaderPartType::Fragment, "shaders/fragment_shaders/screendoor_transparency.glsl" }
 		});
 
-		// This shader handles our cel shading example
-		Shader::Sptr toonShader = ResourceManager::CreateAsset<Shader>(std::unordered_map<ShaderPartType, std::string>{
-			{ ShaderPartType::Vertex, "shaders/vertex_shaders/basic.glsl" },
-			{ ShaderPartType::Fragment, "shaders/fragment_shaders/toon_shading.glsl" }
-		});
-
 
 		// Load in the meshes
 		//// Table
@@ -339,6 +336,7 @@ void CreateScene() {
 			{ ShaderPartType::Vertex, "shaders/vertex_shaders/skybox_vert.glsl" },
 			{ ShaderPartType::Fragment, "shaders/fragment_shaders/skybox_frag.glsl" }
 		});
+		Shader::EndCompileBatch();
 
 		// Create an empty scene
 		scene = std::make_shared<Scene>();
@@ -354,15 +352,15 @@ void CreateScene() {
 		Material::Sptr material_white = ResourceManager::CreateAsset<Material>(basicShader);
 		{
 			material_white->Name = "White";
-			material_white->Set("u_Material.Diffuse", tex_white);
-			material_white->Set("u_Material.Shininess", 256.0f);
+			material_white->Set("s_Diffuse", tex_white);
+			material_white->Set("u_Shininess", 256.0f);
 		}
 
 		Material::Sptr material_black = ResourceManager::CreateAsset<Material>(basicShader);
 		{
 			material_black->Name = "Black";
-			material_black->Set("u_Material.Diffuse", tex_black);
-			material_black->Set("u_Material.Shininess", 10.0f);
+			material_black->Set("s_Diffuse", tex_black);
+			material_black->Set("u_Shininess", 10.0f);
 		}
 
 
@@ -370,39 +368,39 @@ void CreateScene() {
 		Material::Sptr material_table = ResourceManager::CreateAsset<Material>(basicShader);
 		{
 			material_table->Name = "Table";
-			material_table->Set("u_Material.Diffuse", tex_table);
-			material_table->Set("u_Material.Shininess", 256.0f);
+			material_table->Set("s_Diffuse", tex_table);
+			material_table->Set("u_Shininess", 256.0f);
 		}
 
 		//// Puck
 		Material::Sptr material_puck = ResourceManager::CreateAsset<Material>(basicShader);
 		{
 			material_puck->Name = "Puck";
-			material_puck->Set("u_Material.Diffuse", tex_puck);
-			material_puck->Set("u_Material.Shininess", 256.0f);
+			material_puck->Set("s_Diffuse", tex_puck);
+			material_puck->Set("u_Shininess", 256.0f);
 		}
 
 		//// Paddle
 		Material::Sptr material_paddle = ResourceManager::CreateAsset<Material>(basicShader);
 		{
 			material_paddle->Name = "Paddle";
-			material_paddle->Set("u_Material.Diffuse", tex_paddle_red);
-			material_paddle->Set("u_Material.Shininess", 256.0f);
+			material_paddle->Set("s_Diffuse", tex_paddle_red);
+			material_paddle->Set("u_Shininess", 256.0f);
 		}
 
 		Material::Sptr material_paddle2 = ResourceManager::CreateAsset<Material>(basicShader);
 		{
 			material_paddle2->Name = "Paddle2";
-			material_paddle2->Set("u_Material.Diffuse", tex_paddle_blue);
-			material_paddle2->Set("u_Material.Shininess", 256.0f);
+			material_paddle2->Set("s_Diffuse", tex_paddle_blue);
+			material_paddle2->Set("u_Shininess", 256.0f);
 		}
 
 		//// Edge
 		Material::Sptr material_edge = ResourceManager::CreateAsset<Material>(basicShader);
 		{
 			material_edge->Name = "Edge";
-			material_edge->Set("u_Material.Diffuse", tex_edgeSkin);
-			material_edge->Set("u_Material.Shininess", 256.0f);
+			material_edge->Set("s_Diffuse", tex_edgeSkin);
+			material_edge->Set("u_Shininess", 256.0f);
 		}
 
 		//// Lights ////
@@ -655,6 +653,11 @@ void CreateScene() {
 			RigidBody::Sptr physics = gObj_puck->Add<RigidBody>(RigidBodyType::Dynamic);
 			ICollider::Sptr collider = physics->AddCollider(ConvexMeshCollider::Create());
 
+			// The puck moves fast enough to pass through the edges in a single step, so we need CCD
+			CcdSettings ccd;
+			ccd.Enabled = true;
+			physics->SetCcdSettings(ccd);
+
 			BounceBehaviour::Sptr bounceTrigger = gObj_puck->Add<BounceBehaviour>();
 			//bounceTrigger->rigidOBJ = physics;
 		}
@@ -702,9 +705,8 @@ void CreateScene() {
 			renderer->SetMesh(mesh_edge1);
 			renderer->SetMaterial(material_white);
 
-			TriggerVolume::Sptr volume = gObj_edge1->Add<TriggerVolume>();
 			RigidBody::Sptr physics = gObj_edge1->Add<RigidBody>(RigidBodyType::Static);
-			volume->AddCollider(physics->AddCollider(ConvexMeshCollider::Create()))->SetScale(glm::vec3(2.980f, 1.0f, 3.0f));
+			physics->AddCollider(ConvexMeshCollider::Create())->SetScale(glm::vec3(2.980f, 1.0f, 3.0f));
 		}
 		
 
@@ -723,11 +725,8 @@ void CreateScene() {
 			ICollider::Sptr collider = volume->AddCollider(ConvexMeshCollider::Create());
 			collider->SetScale(glm::vec3(2.980f, 1.0f, 3.0f));*/
 
-			TriggerVolume::Sptr volume = gObj_edge2->Add<TriggerVolume>();
 			RigidBody::Sptr physics = gObj_edge2->Add<RigidBody>(RigidBodyType::Static);
-			volume->AddCollider(
-				physics->AddCollider(ConvexMeshCollider::Create()))->SetScale(glm::vec3(2.980f, 1.0f, 3.0f)
-				);
+			physics->AddCollider(ConvexMeshCollider::Create())->SetScale(glm::vec3(2.980f, 1.0f, 3.0f));
 		}
 		
 
@@ -745,11 +744,8 @@ void CreateScene() {
 			//ICollider::Sptr collider = volume->AddCollider(ConvexMeshCollider::Create());
 			//collider->SetScale(glm::vec3(5.080f, 1.0f, 3.0f));
 
-			TriggerVolume::Sptr volume = gObj_edge3->Add<TriggerVolume>();
 			RigidBody::Sptr physics = gObj_edge3->Add<RigidBody>(RigidBodyType::Static);
-			volume->AddCollider(
-				physics->AddCollider(ConvexMeshCollider::Create()))->SetScale(glm::vec3(5.080f, 1.0f, 3.0f)
-				);
+			physics->AddCollider(ConvexMeshCollider::Create())->SetScale(glm::vec3(5.080f, 1.0f, 3.0f));
 		}
 		GameObject::Sptr gObj_edge4 = scene->CreateGameObject("Edge");
 		{
@@ -765,11 +761,8 @@ void CreateScene() {
 			//ICollider::Sptr collider = volume->AddCollider(ConvexMeshCollider::Create());
 			//collider->SetScale(glm::vec3(5.080f, 1.0f, 3.0f));
 
-			TriggerVolume::Sptr volume = gObj_edge4->Add<TriggerVolume>();
 			RigidBody::Sptr physics = gObj_edge4->Add<RigidBody>(RigidBodyType::Static);
-			volume->AddCollider(
-				physics->AddCollider(ConvexMeshCollider::Create()))->SetScale(glm::vec3(5.080f, 1.0f, 3.0f)
-				);
+			physics->AddCollider(ConvexMeshCollider::Create())->SetScale(glm::vec3(5.080f, 1.0f, 3.0f));
 		}
 		GameObject::Sptr gObj_edge5 = scene->CreateGameObject("Edge");
 		{
@@ -786,11 +779,8 @@ void CreateScene() {
 			//ICollider::Sptr collider = volume->AddCollider(ConvexMeshCollider::Create());
 			//collider->SetScale(glm::vec3(4.430f, 1.0f, 3.0f));
 
-			TriggerVolume::Sptr volume = gObj_edge5->Add<TriggerVolume>();
 			RigidBody::Sptr physics = gObj_edge5->Add<RigidBody>(RigidBodyType::Static);
-			volume->AddCollider(
-				physics->AddCollider(ConvexMeshCollider::Create()))->SetScale(glm::vec3(4.430f, 1.0f, 3.0f)
-				);
+			physics->AddCollider(ConvexMeshCollider::Create())->SetScale(glm::vec3(4.430f, 1.0f, 3.0f));
 		}
 		GameObject::Sptr gObj_edge6 = scene->CreateGameObject("Edge");
 		{
@@ -806,11 +796,8 @@ void CreateScene() {
 			//ICollider::Sptr collider = volume->AddCollider(ConvexMeshCollider::Create());
 			//collider->SetScale(glm::vec3(4.430f, 1.0f, 3.0f));
 
-			TriggerVolume::Sptr volume = gObj_edge6->Add<TriggerVolume>();
 			RigidBody::Sptr physics = gObj_edge6->Add<RigidBody>(RigidBodyType::Static);
-			volume->AddCollider(
-				physics->AddCollider(ConvexMeshCollider::Create()))->SetScale(glm::vec3(4.430f, 1.0f, 3.0f)
-				);
+			physics->AddCollider(ConvexMeshCollider::Create())->SetScale(glm::vec3(4.430f, 1.0f, 3.0f));
 		}
 		GameObject::Sptr gObj_edge7 = scene->CreateGameObject("Edge");
 		{
@@ -827,11 +814,8 @@ void CreateScene() {
 			//ICollider::Sptr collider = volume->AddCollider(ConvexMeshCollider::Create());
 			//collider->SetScale(glm::vec3(4.430f, 1.0f, 3.0f));
 
-			TriggerVolume::Sptr volume = gObj_edge7->Add<TriggerVolume>();
 			RigidBody::Sptr physics = gObj_edge7->Add<RigidBody>(RigidBodyType::Static);
-			volume->AddCollider(
-				physics->AddCollider(ConvexMeshCollider::Create()))->SetScale(glm::vec3(4.430f, 1.0f, 3.0f)
-				);
+			physics->AddCollider(ConvexMeshCollider::Create())->SetScale(glm::vec3(4.430f, 1.0f, 3.0f));
 		}
 		GameObject::Sptr gObj_edge8 = scene->CreateGameObject("Edge");
 		{
@@ -847,11 +831,8 @@ void CreateScene() {
 			//ICollider::Sptr collider = volume->AddCollider(ConvexMeshCollider::Create());
 			//collider->SetScale(glm::vec3(4.430f, 1.0f, 3.0f));
 
-			TriggerVolume::Sptr volume = gObj_edge8->Add<TriggerVolume>();
 			RigidBody::Sptr physics = gObj_edge8->Add<RigidBody>(RigidBodyType::Static);
-			volume->AddCollider(
-				physics->AddCollider(ConvexMeshCollider::Create()))->SetScale(glm::vec3(4.430f, 1.0f, 3.0f)
-				);
+			physics->AddCollider(ConvexMeshCollider::Create())->SetScale(glm::vec3(4.430f, 1.0f, 3.0f));
 		}
 		GameObject::Sptr gObj_edge9 = scene->CreateGameObject("Edge");
 		{
@@ -867,11 +848,8 @@ void CreateScene() {
 			//ICollider::Sptr collider = volume->AddCollider(ConvexMeshCollider::Create());
 			//collider->SetScale(glm::vec3(5.080f, 1.0f, 3.0f));
 
-			TriggerVolume::Sptr volume = gObj_edge9->Add<TriggerVolume>();
 			RigidBody::Sptr physics = gObj_edge9->Add<RigidBody>(RigidBodyType::Static);
-			volume->AddCollider(
-				physics->AddCollider(ConvexMeshCollider::Create()))->SetScale(glm::vec3(5.080f, 1.0f, 3.0f)
-				);
+			physics->AddCollider(ConvexMeshCollider::Create())->SetScale(glm::vec3(5.080f, 1.0f, 3.0f));
 		}
 		GameObject::Sptr gObj_edge10 = scene->CreateGameObject("Edge");
 		{
@@ -887,11 +865,8 @@ void CreateScene() {
 			//ICollider::Sptr collider = volume->AddCollider(ConvexMeshCollider::Create());
 			//collider->SetScale(glm::vec3(5.080f, 1.0f, 3.0f));
 
-			TriggerVolume::Sptr volume = gObj_edge10->Add<TriggerVolume>();
 			RigidBody::Sptr physics = gObj_edge10->Add<RigidBody>(RigidBodyType::Static);
-			volume->AddCollider(
-				physics->AddCollider(ConvexMeshCollider::Create()))->SetScale(glm::vec3(5.080f, 1.0f, 3.0f)
-				);
+			physics->AddCollider(ConvexMeshCollider::Create())->SetScale(glm::vec3(5.080f, 1.0f, 3.0f));
 		}
 		GameObject::Sptr gObj_edge11 = scene->CreateGameObject("Edge");
 		{
@@ -907,11 +882,8 @@ void CreateScene() {
 			//ICollider::Sptr collider = volume->AddCollider(ConvexMeshCollider::Create());
 			//collider->SetScale(glm::vec3(2.980f, 1.0f, 3.0f));
 
-			TriggerVolume::Sptr volume = gObj_edge11->Add<TriggerVolume>();
 			RigidBody::Sptr physics = gObj_edge11->Add<RigidBody>(RigidBodyType::Static);
-			volume->AddCollider(
-				physics->AddCollider(ConvexMeshCollider::Create()))->SetScale(glm::vec3(2.980f, 1.0f, 3.0f)
-				);
+			physics->AddCollider(ConvexMeshCollider::Create())->SetScale(glm::vec3(2.980f, 1.0f, 3.0f));
 		}
 		GameObject::Sptr gObj_edge12 = scene->CreateGameObject("Edge");
 		{
@@ -927,11 +899,13 @@ void CreateScene() {
 			//ICollider::Sptr collider = volume->AddCollider(ConvexMeshCollider::Create());
 			//collider->SetScale(glm::vec3(2.980f, 1.0f, 3.0f));
 
-			TriggerVolume::Sptr volume = gObj_edge12->Add<TriggerVolume>();
 			RigidBody::Sptr physics = gObj_edge12->Add<RigidBody>(RigidBodyType::Static);
-			volume->AddCollider(
-				physics->AddCollider(ConvexMeshCollider::Create()))->SetScale(glm::vec3(2.980f, 1.0f, 3.0f)
-				);
+			physics->AddCollider(ConvexMeshCollider::Create())->SetScale(glm::vec3(2.980f, 1.0f, 3.0f));
+		}
+
+		// The solver bounces the puck off the edges, bullet multiplies our restitution with the puck's
+		for (const Guid& id : edgeID) {
+			scene->FindObjectByGUID(id)->Get<RigidBody>()->SetRestitution(1.0f);
 		}
 
 
@@ -1036,6 +1010,9 @@ int main() {
 	glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
 	glDebugMessageCallback(GlDebugMessage, nullptr);
 
+	// Let the driver compile our shaders on multiple threads if it can
+	Shader::InitParallelCompile((GLADloadproc)glfwGetProcAddress);
+
 	// Initialize our ImGui helper
 	ImGuiHelper::Init(window);
 
@@ -1061,10 +1038,22 @@ int main() {
 	ComponentManager::RegisterType<SimpleCameraControl>();
 	ComponentManager::RegisterType<BounceBehaviour>();
 
+	// Materials draw with this while their shaders are compiling, so it's compiled up front
+	Shader::Sptr fallbackShader = Shader::Create();
+	fallbackShader->LoadShaderPartFromFile("shaders/vertex_shaders/basic.glsl", ShaderPartType::Vertex);
+	fallbackShader->LoadShaderPartFromFile("shaders/fragment_shaders/fallback.glsl", ShaderPartType::Fragment);
+	fallbackShader->Link();
+	Material::SetFallbackShader(fallbackShader);
+
 	// GL states, we'll enable depth testing and backface fulling
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
+	// These go through the state tracker so that it knows our starting state
+	DepthState depthState;
+	depthState.TestEnabled = true;
+	GlState::SetDepthState(depthState);
+	CullState cullState;
+	cullState.Enabled = true;
+	cullState.Face = GL_BACK;
+	GlState::SetCullState(cullState);
 	glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
 
 	// Structure for our frame-level uniforms, matches layout from
@@ -1084,27 +1073,18 @@ int main() {
 	};
 	// This uniform buffer will hold all our frame level uniforms, to be shared between shaders
 	UniformBuffer<FrameLevelUniforms>::Sptr frameUniforms = std::make_shared<UniformBuffer<FrameLevelUniforms>>(BufferUsage::DynamicDraw);
+	// The frame uniforms are rewritten every frame, so we stream them instead of waiting on the driver
+	frameUniforms->EnableStreaming();
 	// The slot that we'll bind our frame level UBO to
 	const int FRAME_UBO_BINDING = 0;
 
-	// Structure for our isntance-level uniforms, matches layout from
-	// fragments/frame_uniforms.glsl
-	// For use with a UBO.
-	struct InstanceLevelUniforms {
-		// Complete MVP
-		glm::mat4 u_ModelViewProjection;
-		// Just the model transform, we'll do worldspace lighting
-		glm::mat4 u_Model;
-		// Normal Matrix for transforming normals
-		glm::mat4 u_NormalMatrix;
-	};
-
-	// This uniform buffer will hold all our instance level uniforms, to be shared between shaders
-	UniformBuffer<InstanceLevelUniforms>::Sptr instanceUniforms = std::make_shared<UniformBuffer<InstanceLevelUniforms>>(BufferUsage::DynamicDraw);
-
 	// The slot that we'll bind our instance level UBO to
 	const int INSTANCE_UBO_BINDING = 1;
 
+	// Groups objects that share a mesh and material into instanced draw calls, see
+	// fragments/frame_uniforms.glsl for the instance data layout
+	InstancedRenderer::Sptr instancedRenderer = std::make_shared<InstancedRenderer>(INSTANCE_UBO_BINDING);
+
 	////////////////////////////////
 	///// SCENE CREATION MOVED /////
 	////////////////////////////////
@@ -1133,6 +1113,9 @@ int main() {
 		glfwPollEvents();
 		ImGuiHelper::StartFrame();
 
+		// Pick up any shaders that the driver has finished compiling
+		Shader::PollCompiles();
+
 		// modify position of these two.... - Justin Lee: "seems location not matter much, so I just place it here."
 		checkIsReseting();
 		scoreCheckReset();
@@ -1189,6 +1172,43 @@ int main() {
 				scene->SetPhysicsDebugDrawMode(physicsDebugMode);
 			}
 			LABEL_LEFT(ImGui::SliderFloat, "Playback Speed:    ", &playbackSpeed, 0.0f, 10.0f);
+			// Fires bodies at thin walls in a separate world, and logs which speeds and tick rates tunnel
+			if (ImGui::Button("Run Tunneling Test")) {
+				TunnelingTest::LogResults(TunnelingTest::Run());
+			}
+			// Lets us swap out the physics backend on the fly, the world will be rebuilt with the current objects
+			PhysicsSettings physicsSettings = scene->GetPhysicsSettings();
+			if (physicsSettings.DrawImGui()) {
+				scene->SetPhysicsSettings(physicsSettings);
+			}
+			const TransformSyncStats& syncStats = scene->GetTransformSyncStats();
+			ImGui::Text("Transforms pushed: %d (skipped %d)", syncStats.Pushed, syncStats.PushSkipped);
+			ImGui::Text("Transforms pulled: %d (skipped %d)", syncStats.Pulled, syncStats.PullSkipped);
+			const InstancedRenderStats& renderStats = instancedRenderer->GetStats();
+			ImGui::Text("Draw calls: %d (%d instances, %d multi-draw commands)", renderStats.DrawCalls, renderStats.Instances, renderStats.MultiDrawCommands);
+			bool multiDraw = instancedRenderer->IsMultiDrawEnabled();
+			if (LABEL_LEFT(ImGui::Checkbox, "Multi-Draw Indirect", &multiDraw)) {
+				instancedRenderer->SetMultiDrawEnabled(multiDraw);
+			}
+			const GlStateStats& stateStats = GlState::GetStats();
+			ImGui::Text("GL state changes: %d (skipped %d)", stateStats.Issued, stateStats.Skipped);
+			ImGui::Text("Shaders compiling: %d", (int)Shader::GetPendingCompileCount());
+			// Drops a few thousand bodies into a separate world for each backend, and logs the step times
+			if (ImGui::Button("Run Physics Benchmark")) {
+				// The benchmark worlds share bullet's task scheduler and the thread pool, so make sure the
+				// scene isn't still stepping in the background
+				scene->SyncPhysics();
+				PhysicsBenchmarkSettings benchmarkSettings;
+				PhysicsBenchmark::LogResults(benchmarkSettings, PhysicsBenchmark::Run(benchmarkSettings));
+			}
+			// Simplifies a few known meshes twice, and logs whether they're deterministic and within their targets
+			if (ImGui::Button("Run Mesh Simplifier Test")) {
+				MeshSimplifierTest::LogResults(MeshSimplifierTest::Run());
+			}
+			// Optimizes a few shuffled meshes, and logs whether the triangles survived and the ACMR improved
+			if (ImGui::Button("Run Mesh Optimizer Test")) {
+				MeshOptimizerTest::LogResults(MeshOptimizerTest::Run());
+			}
 			ImGui::Separator();
 		}
 
@@ -1241,10 +1261,6 @@ int main() {
 			scene->DrawAllGameObjectGUIs();
 		}
 		
-		// The current material that is bound for rendering
-		Material::Sptr currentMat = nullptr;
-		Shader::Sptr shader = nullptr;
-
 		// Bind the skybox texture to a reserved texture slot
 		// See Material.h and Material.cpp for how we're reserving texture slots
 		TextureCube::Sptr environment = scene->GetSkyboxTexture();
@@ -1253,7 +1269,6 @@ int main() {
 		// Here we'll bind all the UBOs to their corresponding slots
 		scene->PreRender();
 		frameUniforms->Bind(FRAME_UBO_BINDING);
-		instanceUniforms->Bind(INSTANCE_UBO_BINDING);
 
 		// Upload frame level uniforms
 		auto& frameData = frameUniforms->GetData();
@@ -1264,7 +1279,9 @@ int main() {
 		frameData.u_Time = static_cast<float>(thisFrame);
 		frameUniforms->Update();
 
-		// Render all our objects
+		// Collect all our objects, they'll be drawn together once we know which ones can be instanced
+		glm::vec3 cameraPos = camera->GetGameObject()->GetPosition();
+		instancedRenderer->Begin(viewProj);
 		ComponentManager::Each<RenderComponent>([&](const RenderComponent::Sptr& renderable) {
 			// Early bail if mesh not set
 			if (renderable->GetMesh() == nullptr) { 
@@ -1281,29 +1298,13 @@ int main() {
 				}
 			}
 
-			// If the material has changed, we need to bind the new shader and set up our material and frame data
-			// Note: This is a good reason why we should be sorting the render components in ComponentManager
-			if (renderable->GetMaterial() != currentMat) {
-				currentMat = renderable->GetMaterial();
-				shader = currentMat->GetShader();
+			// Pick the level of detail based on how large the object is on screen
+			VertexArrayObject::Sptr mesh = renderable->SelectLod(cameraPos, camera->GetProjection());
 
-				shader->Bind();
-				currentMat->Apply();
-			}
-
-			// Grab the game object so we can do some stuff with it
-			GameObject* object = renderable->GetGameObject();
-			 
-			// Use our uniform buffer for our instance level uniforms
-			auto& instanceData = instanceUniforms->GetData();
-			instanceData.u_Model = object->GetTransform();
-			instanceData.u_ModelViewProjection = viewProj * object->GetTransform();
-			instanceData.u_NormalMatrix = glm::mat3(glm::transpose(glm::inverse(object->GetTransform())));
-			instanceUniforms->Update();  
-
-			// Draw the object
-			renderable->GetMesh()->Draw();
+			// Queue the object up, the renderer sorts by material so we only switch shaders when we need to
+			instancedRenderer->Submit(renderable->GetMaterial(), mesh, renderable->GetGameObject()->GetTransform(), renderable->GetInstanceParams());
 		});
+		instancedRenderer->Flush();
 		/// <summary>
 		/// puck interaction
 		/// </summary>
@@ -1440,9 +1441,17 @@ int main() {
 
 		lastFrame = thisFrame;
 		ImGuiHelper::EndFrame();
+		// Fence off this frame's streaming data now that everything has been drawn
+		StreamingBuffer::EndFrame();
+		GlState::EndFrame();
 		glfwSwapBuffers(window);
 	}
 
+	// Release our streaming fences and shared geometry while we still have a context
+	Material::SetFallbackShader(nullptr);
+	StreamingBuffer::Uninitialize();
+	GeometryArena::Cleanup();
+
 	// Clean up the ImGui library
 	ImGuiHelper::Cleanup();
 